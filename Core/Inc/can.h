@@ -6,14 +6,38 @@
 * @brief   Prototype Functions for CAN Driver
 ***********************************************/
 
+#ifndef CAN_H
+#define CAN_H
+
 #include "FreeRTOS.h"
 #include "task.h"
-#include "queue.h"
 
 #include "stm32f415xx.h"
 
+#include <stdint.h>
+
+/* Macros -------------------------------------------------------------------*/
+#ifdef CAN_CAPTURE
+#define CAN_RX_RING_SIZE            (512) // Covers SD write stalls on a saturated bus
+#else
+#define CAN_RX_RING_SIZE            (64) // Must be a power of two
+#endif
+#define CAN_RX_RING_MASK            (CAN_RX_RING_SIZE - 1)
+#define CAN_RX_BATCH                (8) // Frames drained per ring access
+
+#define CAN_TX_QUEUE_SIZE           (16) // Frames waiting for a free mailbox
+#define CAN_TX_MAILBOXES            (3)
+#define CAN_TX_TIMEOUT              (100000) // us a mailbox may stay pending before it is aborted
+
+#define CAN_BITRATE                 (500000) // Bus bit rate in bits/s
+// Bits in a standard data frame without stuff bits, including interframe space
+#define CAN_FRAME_BITS(dlc)         (47 + 8 * (dlc))
+
+#define CAN_FILTER_BANKS            (28) // All banks are assigned to CAN1
+#define CAN_FILTER_MAX_IDS          (CAN_FILTER_BANKS * 4) // 4 IDs per 16-bit list bank
+#define CAN_FILTER_MIN_BLOCK        (4) // Smallest ID range worth a mask entry
+
 extern TaskHandle_t xCAN_Task;
-extern QueueHandle_t canRXQueue;
 
 typedef enum {
     CAN_RTR_Data,
@@ -34,12 +58,84 @@ typedef enum {
     CAN_State_Normal,
 } CAN_State;
 
+/**
+ * @brief CAN Frame as stored in the RX ring
+ * @note Sized and aligned to one 16-byte slot, the same size as a FIFO mailbox
+ */
 typedef struct {
     uint16_t id; // 11-bit ID
     uint8_t dlc; // Data Length Code
-    CAN_RTR rtr; // Remote Transmission Request
+    uint8_t rtr; // Remote Transmission Request (CAN_RTR)
     uint8_t data[8]; // Data Bytes
-} CAN_Frame;
+    uint32_t timestamp; // TIM2 microseconds when the RX interrupt fired
+} __attribute__((aligned(16))) CAN_Frame;
+
+typedef struct {
+    uint32_t queued; // Frames accepted into the TX queue
+    uint32_t rejected; // Frames refused because the TX queue was full
+    uint32_t completed; // Frames acknowledged on the bus
+    uint32_t aborted; // Frames that completed without TXOK (aborted or bus-off)
+    uint32_t timeouts; // Abort requests for frames pending longer than CAN_TX_TIMEOUT
+    uint32_t highWater; // Highest TX queue occupancy seen
+} CAN_TX_Stats;
+
+typedef enum {
+    CAN_LEC_None,
+    CAN_LEC_Stuff,
+    CAN_LEC_Form,
+    CAN_LEC_Ack,
+    CAN_LEC_Bit_Recessive,
+    CAN_LEC_Bit_Dominant,
+    CAN_LEC_CRC,
+    CAN_LEC_Software,
+    CAN_LEC_Count
+} CAN_LEC;
+
+/**
+ * @brief CAN bus health counters
+ * @note Bus load only counts frames this node sends or accepts through its filters
+ */
+typedef struct {
+    uint32_t fifoOverruns[2]; // Frames lost by the hardware FIFOs (FOVR0/FOVR1)
+    uint32_t errorWarning; // Transitions into error warning (TEC or REC >= 96)
+    uint32_t errorPassive; // Transitions into error passive (TEC or REC > 127)
+    uint32_t busOff; // Transitions into bus-off (TEC > 255)
+    uint32_t busOffRecoveries; // Returns to error active after bus-off (ABOM)
+    uint32_t lastErrorCode[CAN_LEC_Count]; // Protocol errors by LEC type
+    uint8_t tec; // Transmit error counter
+    uint8_t rec; // Receive error counter
+    uint16_t busLoad; // Utilisation over the last second in 0.1 % steps
+    uint32_t framesPerSecond; // Frames sent and received over the last second
+} CAN_Bus_Stats;
+
+/**
+ * @brief CAN ID the application wants to receive
+ */
+typedef struct {
+    uint16_t id; // 11-bit ID
+    uint16_t rate; // Expected frames per second, used to balance the FIFOs
+} CAN_Filter_ID;
+
+/**
+ * @brief Register images for the CAN filter banks
+ * @note Computed by CAN_Filter_Alloc and written by CAN_Filters_Init
+ */
+typedef struct {
+    uint8_t banks; // Number of banks in use
+    uint32_t fm1r; // Mode, 1 = identifier list, 0 = identifier mask
+    uint32_t fs1r; // Scale, 0 = dual 16-bit
+    uint32_t ffa1r; // FIFO assignment, 1 = FIFO 1
+    uint32_t fa1r; // Active banks
+    uint32_t fr1[CAN_FILTER_BANKS];
+    uint32_t fr2[CAN_FILTER_BANKS];
+    uint32_t fifoRate[2]; // Expected frames per second routed to each FIFO
+} CAN_Filter_Config;
+
+typedef struct {
+    uint32_t received; // Frames pushed into the RX ring
+    uint32_t overruns; // Frames dropped because the RX ring was full
+    uint32_t highWater; // Highest RX ring occupancy seen
+} CAN_RX_Stats;
 
 /**
  * @brief Initializes CAN1
@@ -50,12 +146,37 @@ typedef struct {
  */
 CAN_Status CAN1_Init();
 
+/**
+ * @brief Pack a set of IDs into filter bank register images
+ * @note Fully subscribed aligned ID ranges use 16-bit mask entries,
+ *       all other IDs use 16-bit list entries
+ * @note IDs are spread over FIFO 0 and FIFO 1 by expected rate
+ * @note Register access free, see can_filter.c
+ * 
+ * @param ids [CAN_Filter_ID*] IDs to accept, cut to 11 bits and sorted in place
+ * @param count [uint8_t] Number of IDs
+ * @param config [CAN_Filter_Config*] Register images to fill
+ * @return CAN_Status CAN_Error if the IDs do not fit in the filter banks
+ */
+CAN_Status CAN_Filter_Alloc(CAN_Filter_ID* ids, uint8_t count, CAN_Filter_Config* config);
+
+/**
+ * @brief Build filter banks that accept every standard frame
+ * @note Even IDs go to FIFO 0 and odd IDs to FIFO 1 to share the load
+ * 
+ * @param config [CAN_Filter_Config*] Register images to fill
+ * @return CAN_Status 
+ */
+CAN_Status CAN_Filter_Accept_All(CAN_Filter_Config* config);
+
 /**
  * @brief Initalize CAN Filters
+ * @note Must be called in initialization mode
  * 
+ * @param config [const CAN_Filter_Config*] Register images from CAN_Filter_Alloc
  * @return CAN_Status 
  */
-CAN_Status CAN_Filters_Init();
+CAN_Status CAN_Filters_Init(const CAN_Filter_Config* config);
 
 /**
  * @brief Start communication on the CAN Bus
@@ -72,13 +193,43 @@ CAN_Status CAN_Start();
 CAN_Status CAN_Stop();
 
 /**
- * @brief Add a CAN frame to the transmit mailbox
+ * @brief Queue a CAN frame for transmission on CAN1 without blocking
+ * @note Frames leave in CAN ID priority order, lowest ID first
+ * @note Task context only, the queue is drained by the TX mailbox empty interrupt
  * 
- * @param CAN [CAN_TypeDef*] CAN Peripheral to receive from
- * @param frame [CAN_Frame*] Frame to transmit
- * @return [CAN_Status] Status of Transmission
+ * @param frame [const CAN_Frame*] Frame to transmit, copied into the queue
+ * @return [CAN_Status] CAN_TX_Req if queued, CAN_Mailbox_Error if the queue is full
+ */
+CAN_Status CAN_Transmit_Async(const CAN_Frame* frame);
+
+/**
+ * @brief Abort transmit mailboxes pending longer than CAN_TX_TIMEOUT
+ * @note Automatic retransmission is on for ISO-TP, so a frame nobody
+ *       acknowledges would hold its mailbox forever. The TX interrupt
+ *       counts the abort and refills the mailbox from the queue.
+ * @note Call periodically from a single task
+ */
+void CAN_TX_Abort_Stale();
+
+/**
+ * @brief Get a copy of the CAN TX queue statistics
+ * 
+ * @param stats [CAN_TX_Stats*] Struct to copy into
  */
-CAN_Status CAN_Transmit(CAN_TypeDef* CAN, CAN_Frame* frame);
+void CAN_Get_TX_Stats(CAN_TX_Stats* stats);
+
+/**
+ * @brief Close the current one second bus load window
+ * @note Call once per second from a single task
+ */
+void CAN_Stats_Update();
+
+/**
+ * @brief Get a copy of the CAN bus health statistics
+ * 
+ * @param stats [CAN_Bus_Stats*] Struct to copy into
+ */
+void CAN_Get_Bus_Stats(CAN_Bus_Stats* stats);
 
 /**
  * @brief Receive a CAN Frame
@@ -87,4 +238,43 @@ CAN_Status CAN_Transmit(CAN_TypeDef* CAN, CAN_Frame* frame);
  * @param frame [CAN_Frame*] Frame struct to receive
  * @return [CAN_Status] Status of Reception
  */
-CAN_Status CAN_Receive(CAN_TypeDef* CAN, CAN_Frame* frame);
\ No newline at end of file
+CAN_Status CAN_Receive(CAN_TypeDef* CAN, CAN_Frame* frame);
+
+/**
+ * @brief Get the next free RX ring slot
+ * @note Producer side, call from the RX ISRs only
+ * 
+ * @return [CAN_Frame*] Slot to fill, NULL if the ring is full (counted as an overrun)
+ */
+CAN_Frame* CAN_RX_Reserve();
+
+/**
+ * @brief Mark the slot from CAN_RX_Reserve as filled
+ * @note Not visible to the consumer until CAN_RX_Publish
+ */
+void CAN_RX_Commit();
+
+/**
+ * @brief Publish committed frames and wake CAN_Task if the ring was empty
+ * @note Call once at the end of each RX interrupt
+ */
+void CAN_RX_Publish();
+
+/**
+ * @brief Drain up to max frames from the CAN RX ring
+ * @note Single consumer only, the RX ISRs are the single producer
+ * 
+ * @param frames [CAN_Frame*] Buffer to copy frames into
+ * @param max [uint16_t] Max number of frames to copy
+ * @return [uint16_t] Number of frames copied
+ */
+uint16_t CAN_RX_Pop_Batch(CAN_Frame* frames, uint16_t max);
+
+/**
+ * @brief Get a copy of the CAN RX ring statistics
+ * 
+ * @param stats [CAN_RX_Stats*] Struct to copy into
+ */
+void CAN_Get_RX_Stats(CAN_RX_Stats* stats);
+
+#endif /* CAN_H */
\ No newline at end of file
@@ -0,0 +1,94 @@
+/************************************************
+* @file    can_capture.h 
+* @author  APBashara
+* @date    10/2026
+* 
+* @brief   Raw CAN Bus Capture to the SD Card
+***********************************************/
+
+#ifndef CAN_CAPTURE_H
+#define CAN_CAPTURE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "can.h"
+
+/* Macros -------------------------------------------------------------------*/
+#define CAN_CAPTURE_MAGIC           (0xCA5E) // First halfword of every block
+#define CAN_CAPTURE_BLOCK_SIZE      (512) // One SD sector per block
+#define CAN_CAPTURE_BLOCKS          (8) // Blocks gathered per f_write
+#define CAN_CAPTURE_SYNC_BLOCKS     (256) // Blocks between f_sync calls (128kB)
+#define CAN_CAPTURE_MAX_FILES       (1000) // CAN000.BIN to CAN999.BIN
+
+/* Structs and Enums --------------------------------------------------------*/
+typedef enum {
+    CAN_CAPTURE_OK,
+    CAN_CAPTURE_ERROR,
+} CAN_Capture_Status;
+
+/**
+ * @brief Header at the start of every 512 byte block
+ * @note Followed by records of a uint16_t delta time in us since the previous
+ *       record (0 for the first), a uint16_t of ID | DLC << 11 | RTR << 15 and
+ *       DLC data bytes. The rest of the block after length bytes is padding.
+ */
+typedef struct {
+    uint16_t magic; // CAN_CAPTURE_MAGIC
+    uint16_t count; // Records in the block
+    uint32_t sequence; // Block number since the file was opened
+    uint32_t timestamp; // TIM2 microseconds of the first record
+    uint16_t length; // Bytes of records after the header
+    uint16_t dropped; // Frames lost to RX ring and hardware FIFO overruns before this block
+} CAN_Capture_Header;
+
+typedef struct {
+    uint32_t frames; // Frames written into blocks
+    uint32_t blocks; // Blocks handed to FatFs
+    uint32_t dropped; // Frames lost to RX ring and hardware FIFO overruns
+    uint32_t writeErrors; // Failed f_write or f_sync calls
+    uint32_t maxWriteTime; // Longest f_write in microseconds
+} CAN_Capture_Stats;
+
+/**
+ * @brief Create the next free CANxxx.BIN file
+ * @note Must be called from a task after the volume is registered with f_mount
+ * 
+ * @return CAN_Capture_Status
+ */
+CAN_Capture_Status CAN_Capture_Init();
+
+/**
+ * @brief Append a received frame to the current block
+ * @note Writes to the card once CAN_CAPTURE_BLOCKS blocks are full
+ * 
+ * @param frame [const CAN_Frame*] Frame popped from the RX ring
+ * @return CAN_Capture_Status CAN_CAPTURE_ERROR if no file is open or the write failed
+ */
+CAN_Capture_Status CAN_Capture_Frame(const CAN_Frame* frame);
+
+/**
+ * @brief Close the current block and write and sync everything gathered so far
+ * @note Call periodically so a quiet bus still reaches the card
+ * 
+ * @return CAN_Capture_Status
+ */
+CAN_Capture_Status CAN_Capture_Flush();
+
+/**
+ * @brief Check if a file is the one the capture is writing
+ * @note FatFs refuses to open it with FR_LOCKED while it is open for writing
+ * 
+ * @param name [const char*] 8.3 name without the volume, any case
+ * @return [bool]
+ */
+bool CAN_Capture_Is_Active(const char* name);
+
+/**
+ * @brief Get a copy of the capture statistics
+ * 
+ * @param stats [CAN_Capture_Stats*] Destination
+ */
+void CAN_Capture_Get_Stats(CAN_Capture_Stats* stats);
+
+#endif /* CAN_CAPTURE_H */
@@ -0,0 +1,125 @@
+/************************************************
+* @file    can_decode.h 
+* @author  APBashara
+* @date    10/2026
+* 
+* @brief   Table Driven CAN Signal Decoder
+***********************************************/
+
+#ifndef CAN_DECODE_H
+#define CAN_DECODE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "can.h"
+
+/* Structs and Enums --------------------------------------------------------*/
+typedef enum {
+    CAN_DECODE_OK,
+    CAN_DECODE_UNKNOWN_ID,
+    CAN_DECODE_ERROR,
+    CAN_DECODE_SHORT, // DLC too short for some signals, those were left as they were
+} CAN_Decode_Status;
+
+typedef enum {
+    CAN_INTEL, // Little endian, start bit is the LSB
+    CAN_MOTOROLA, // Big endian, start bit is the MSB (DBC numbering)
+} CAN_Byte_Order;
+
+typedef enum {
+    CAN_DEST_U8,
+    CAN_DEST_I8,
+    CAN_DEST_U16,
+    CAN_DEST_I16,
+    CAN_DEST_U32,
+    CAN_DEST_I32,
+    CAN_DEST_F32,
+} CAN_Dest_Type;
+
+/**
+ * @brief One signal inside a CAN message
+ * @note Physical value = raw * scale + offset
+ */
+typedef struct {
+    uint8_t startBit; // DBC start bit
+    uint8_t length; // Length in bits (1-64)
+    uint8_t byteOrder; // CAN_Byte_Order
+    uint8_t isSigned; // Raw value is two's complement
+    CAN_Dest_Type destType; // Type of the destination field
+    float scale; // Factor applied to the raw value
+    float offset; // Offset added after scaling
+    void* dest; // Field the physical value is written to
+} CAN_Signal;
+
+/**
+ * @brief All signals carried by one CAN ID
+ */
+typedef struct {
+    uint16_t id; // 11-bit ID
+    uint16_t rate; // Nominal frames per second from the DBC cycle time
+    uint8_t signalCount; // Number of entries in signals
+    const CAN_Signal* signals; // Signals unpacked from this ID
+    uint32_t* timestamp; // Receives the frame timestamp, NULL if unused
+} CAN_Message;
+
+/* Globals ------------------------------------------------------------------*/
+// Message table sorted by ascending ID, defined in can_db.c
+extern const CAN_Message canMessages[];
+extern const uint16_t canMessageCount;
+
+/* Function Prototypes ------------------------------------------------------*/
+
+/**
+ * @brief Check the message table before decoding
+ * @note Table must be sorted by ID without duplicates
+ * 
+ * @return CAN_Decode_Status 
+ */
+CAN_Decode_Status CAN_Decode_Init();
+
+/**
+ * @brief Find the table entry for a CAN ID
+ * @note Binary search over the sorted message table
+ * 
+ * @param id [uint16_t] 11-bit CAN ID
+ * @return [const CAN_Message*] Table entry or NULL if not subscribed
+ */
+const CAN_Message* CAN_Decode_Lookup(uint16_t id);
+
+/**
+ * @brief List the subscribed IDs for the CAN filter allocator
+ * 
+ * @param ids [CAN_Filter_ID*] Buffer to fill
+ * @param max [uint8_t] Size of the buffer
+ * @return [uint8_t] Number of IDs written
+ */
+uint8_t CAN_Decode_Get_IDs(CAN_Filter_ID* ids, uint8_t max);
+
+/**
+ * @brief Get the number of frames decoded for a CAN ID
+ * 
+ * @param id [uint16_t] 11-bit CAN ID
+ * @return [uint32_t] Frames decoded since boot, 0 if not subscribed
+ */
+uint32_t CAN_Decode_Get_Count(uint16_t id);
+
+/**
+ * @brief Get the reception time of the last frame decoded for a CAN ID
+ * 
+ * @param id [uint16_t] 11-bit CAN ID
+ * @return [uint32_t] TIM2 microseconds, 0 if never received or not subscribed
+ */
+uint32_t CAN_Decode_Get_Timestamp(uint16_t id);
+
+/**
+ * @brief Unpack every signal of a frame into its destination field
+ * @note Signals reaching past the frame's DLC are skipped, the mailbox
+ *       bytes beyond it are left over from earlier frames
+ * 
+ * @param frame [const CAN_Frame*] Received frame
+ * @return CAN_Decode_Status CAN_DECODE_SHORT if any signal was skipped
+ */
+CAN_Decode_Status CAN_Decode_Frame(const CAN_Frame* frame);
+
+#endif /* CAN_DECODE_H */
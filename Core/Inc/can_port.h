@@ -0,0 +1,51 @@
+/************************************************
+* @file    can_port.h 
+* @author  APBashara
+* @date    10/2026
+* 
+* @brief   Platform Hooks for the Hardware Independent CAN Code
+* @note    Build with CAN_HOST to run the RX ring and decoder off target
+***********************************************/
+
+#ifndef CAN_PORT_H
+#define CAN_PORT_H
+
+#ifdef CAN_HOST
+
+#include <stdatomic.h>
+
+// Single threaded replay, the consumer polls the ring itself
+#define CAN_PORT_BARRIER()          atomic_thread_fence(memory_order_seq_cst)
+#ifdef CAN_HOST_NOTIFY
+void CAN_Host_Notify_RX(); // Defined by the host test, stands in for the task notification
+#define CAN_PORT_NOTIFY_RX()        CAN_Host_Notify_RX()
+#else
+#define CAN_PORT_NOTIFY_RX()        do { } while (0)
+#endif
+#define CAN_PORT_ENTER_CRITICAL()   do { } while (0)
+#define CAN_PORT_EXIT_CRITICAL()    do { } while (0)
+
+#else
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "stm32f415xx.h"
+
+extern TaskHandle_t xCAN_Task;
+
+#define CAN_PORT_BARRIER()          __DMB()
+#define CAN_PORT_ENTER_CRITICAL()   taskENTER_CRITICAL()
+#define CAN_PORT_EXIT_CRITICAL()    taskEXIT_CRITICAL()
+
+// Only called from the RX ISRs
+#define CAN_PORT_NOTIFY_RX() do { \
+    if (xCAN_Task != NULL) { \
+        BaseType_t xHPW = pdFALSE; \
+        vTaskNotifyGiveFromISR(xCAN_Task, &xHPW); \
+        portYIELD_FROM_ISR(xHPW); \
+    } \
+} while (0)
+
+#endif /* CAN_HOST */
+
+#endif /* CAN_PORT_H */
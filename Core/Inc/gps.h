@@ -6,6 +6,7 @@
 * @brief   Neo-M9N GPS Driver Header
 ***********************************************/
 
+#include <stdbool.h>
 #include <stddef.h>
 #include "i2c.h"
 
@@ -29,6 +30,9 @@
 #define UBX_PVT_CLASS                   (0x01)
 #define UBX_PVT_ID                      (0x07)
 #define UBX_PVT_LEN                     (0x92)
+#define UBX_PVT_ITOW_Pos                (0x00 + UBX_PAYLOAD_Pos)
+#define UBX_PVT_VALID_Pos               (0x0B + UBX_PAYLOAD_Pos)
+#define UBX_PVT_VALID_TIME              (0x02) // validTime, UTC time of day is resolved
 #define UBX_PVT_FIX_Pos                 (0x14 + UBX_PAYLOAD_Pos)
 #define UBX_PVT_LON_Pos                 (0x18 + UBX_PAYLOAD_Pos)
 #define UBX_PVT_LAT_Pos                 (0x1C + UBX_PAYLOAD_Pos)
@@ -63,6 +67,8 @@ typedef struct {
     int32_t latitude;
     int32_t longitude;
     int32_t speed;
+    uint32_t iTOW; // GPS time of week of the solution in ms
+    bool timeValid; // iTOW can be trusted, also without a fix
 } GPS_Data;
 
 /* Function Prototypes ------------------------------------------------------*/
@@ -77,6 +83,7 @@ GPS_Status GPS_Init();
 
 /**
  * @brief Checks for GPS lock and gets the current position and speed
+ * @note The solution time is filled in even with GPS_NO_FIX
  * 
  * @param data [GPS_Data*] Pointer to GPS Data Struct
  * @return GPS_Status
@@ -0,0 +1,96 @@
+/************************************************
+* @file    isotp.h 
+* @author  APBashara
+* @date    10/2026
+* 
+* @brief   ISO 15765-2 (ISO-TP) Transport over CAN1
+***********************************************/
+
+#ifndef ISOTP_H
+#define ISOTP_H
+
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+#include "can.h"
+
+/* Macros -------------------------------------------------------------------*/
+#define ISOTP_RX_ID                 (0x7E0) // Tester to car, also carries our flow control
+#define ISOTP_TX_ID                 (0x7E8) // Car to tester
+#define ISOTP_RX_RATE               (10) // Expected frames per second, for the filter balance
+
+#define ISOTP_MAX_RX                (64) // Largest request accepted, bigger ones get an overflow
+#define ISOTP_MAX_TX                (4095) // Largest message with a 12-bit FF_DL
+#define ISOTP_QUEUE_SIZE            (8) // Frames buffered between CAN_Task and the ISO-TP task
+
+#define ISOTP_BLOCK_SIZE            (0) // Our flow control, 0 = no further flow control
+#define ISOTP_ST_MIN                (0) // Our flow control, no gap needed between frames
+#define ISOTP_TIMEOUT               (1000) // N_Bs and N_Cr in ticks
+#define ISOTP_PADDING               (0xCC) // Fill byte for unused frame data
+
+/* Structs and Enums --------------------------------------------------------*/
+typedef enum {
+    ISOTP_OK,
+    ISOTP_BUSY,
+    ISOTP_ERROR,
+} ISOTP_Status;
+
+typedef struct {
+    uint32_t rxMessages; // Requests reassembled
+    uint32_t txMessages; // Responses fully handed to the CAN TX queue
+    uint32_t rxErrors; // Sequence errors, overflows and N_Cr timeouts
+    uint32_t txErrors; // Overflow flow control and N_Bs timeouts
+    uint32_t dropped; // Frames lost because the ISO-TP queue was full
+} ISOTP_Stats;
+
+/* Function Prototypes ------------------------------------------------------*/
+
+/**
+ * @brief Create the frame queue between CAN_Task and the ISO-TP task
+ * 
+ * @return ISOTP_Status
+ */
+ISOTP_Status ISOTP_Init();
+
+/**
+ * @brief Hand a frame received on ISOTP_RX_ID to the ISO-TP task
+ * @note Called from CAN_Task, never blocks
+ * 
+ * @param frame [const CAN_Frame*] Received frame
+ */
+void ISOTP_Receive_Frame(const CAN_Frame* frame);
+
+/**
+ * @brief Start sending a message on ISOTP_TX_ID
+ * @note The message is copied, ISOTP_Process sends the consecutive frames
+ * 
+ * @param data [const uint8_t*] Message payload
+ * @param length [uint16_t] Payload length, up to ISOTP_MAX_TX
+ * @return ISOTP_Status ISOTP_BUSY if the previous message is still being sent
+ */
+ISOTP_Status ISOTP_Send(const uint8_t* data, uint16_t length);
+
+/**
+ * @brief Run the ISO-TP state machine
+ * @note Blocks up to one tick waiting for frames, call in a loop from one task
+ * 
+ * @param message [uint8_t*] Buffer for a completed request, ISOTP_MAX_RX bytes
+ * @return [uint16_t] Length of a request completed by this call, 0 if none
+ */
+uint16_t ISOTP_Process(uint8_t* message);
+
+/**
+ * @brief Check if a message is still being sent
+ * 
+ * @return [uint8_t] 1 while ISOTP_Send would return ISOTP_BUSY
+ */
+uint8_t ISOTP_TX_Busy();
+
+/**
+ * @brief Get a copy of the ISO-TP statistics
+ * 
+ * @param stats [ISOTP_Stats*] Destination
+ */
+void ISOTP_Get_Stats(ISOTP_Stats* stats);
+
+#endif /* ISOTP_H */
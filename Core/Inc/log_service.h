@@ -0,0 +1,43 @@
+/************************************************
+* @file    log_service.h 
+* @author  APBashara
+* @date    10/2026
+* 
+* @brief   SD Card Log Download Service over ISO-TP
+***********************************************/
+
+#ifndef LOG_SERVICE_H
+#define LOG_SERVICE_H
+
+#include <stdint.h>
+
+#include "isotp.h"
+
+/* Macros -------------------------------------------------------------------*/
+// Requests from the tester, multi-byte fields are little endian
+#define LOG_SERVICE_LIST            (0x01) // index u16 -> size u32, 8.3 name
+#define LOG_SERVICE_OPEN            (0x02) // 8.3 name -> size u32
+#define LOG_SERVICE_READ            (0x03) // offset u32, length u16 -> offset u32, data
+#define LOG_SERVICE_CLOSE           (0x04) // -> nothing
+#define LOG_SERVICE_OFFLOAD         (0x05) // optional 8.3 name -> nothing, sent over the radio
+#define LOG_SERVICE_POSITIVE        (0x40) // Added to the request code on success
+#define LOG_SERVICE_NEGATIVE        (0x7F) // 0x7F, request code, error code
+
+#define LOG_SERVICE_BAD_REQUEST     (0xFF) // Error code for malformed requests
+#define LOG_SERVICE_CAPTURING       (0xFE) // Error code for the file the CAN capture is writing
+#define LOG_SERVICE_MAX_READ        (ISOTP_MAX_TX - 5) // Data bytes per read response
+
+/* Function Prototypes ------------------------------------------------------*/
+
+/**
+ * @brief Handle one request and build the response
+ * @note Other error codes are the FatFs FRESULT of the failed call
+ * 
+ * @param request [const uint8_t*] Request from ISOTP_Process
+ * @param length [uint16_t] Request length
+ * @param response [const uint8_t**] Set to the response, valid until the next call
+ * @return [uint16_t] Response length
+ */
+uint16_t Log_Service_Handle(const uint8_t* request, uint16_t length, const uint8_t** response);
+
+#endif /* LOG_SERVICE_H */
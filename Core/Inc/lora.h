@@ -6,7 +6,12 @@
 * @brief   Prototype Functions for RFM95W Device Driver
 ***********************************************/
 
+#ifndef LORA_H
+#define LORA_H
+
 #include "stm32f415xx.h"
+#include "FreeRTOS.h"
+#include "task.h"
 #include "spi.h"
 #include "rfm95_reg.h"
 #ifndef GPIO_H
@@ -31,12 +36,23 @@
 
 #define LORA_MAX_PAYLOAD_LEN        255 // Max Length of LoRa Packet
 #define LORA_RETRY                  5 // Number of Retries for LoRa Operations
+#define LORA_TX_TIMEOUT             1000 // Ticks to wait for TxDone on DIO0
+#define LORA_IRQ_PRIORITY           14 // Must not be above configMAX_SYSCALL_INTERRUPT_PRIORITY
+#define LORA_SHADOW_SIZE            0x50 // Registers 0x00-0x4F covered by the shadow cache
+
+#define LORA_FSK_BITRATE            300000 // bps, the highest FSK rate of the module
+#define LORA_FSK_FDEV               100000 // Hz, deviation plus half the bit rate fills the 250 kHz RX bandwidth
+#define RFM95_FSTEP                 (RFM95_XOSC_FREQ / 524288) // Frequency synthesizer step
+#define LORA_FSK_PREAMBLE           5 // Bytes
+#define LORA_FSK_MAX_PAYLOAD        63 // Length byte and payload fill the 64 byte FIFO, no refill
+#define LORA_FSK_TX_TIMEOUT         10 // Ticks to wait for PacketSent, a full packet takes 2 ms
 
 /* Structs and Enums --------------------------------------------------------*/
 typedef enum {
     LORA_OK,
     LORA_ERROR,
     LORA_TX_ERROR,
+    LORA_RX_TIMEOUT,
 } LoRa_Status;
 
 typedef enum {
@@ -81,6 +97,37 @@ typedef enum {
     LORA_CR_4_8,
 } LoRa_CR;
 
+/**
+ * @brief Modem settings as last written by the setters
+ */
+typedef struct {
+    LoRa_SF sf;
+    LoRa_BW bw;
+    LoRa_CR cr;
+    uint16_t preamble; // Preamble symbols, not counting the 4.25 sync symbols
+    bool crc; // Payload CRC enabled
+    bool lowDataRate; // LowDataRateOptimize set in RegModemConfig3
+} LoRa_Config;
+
+/**
+ * @brief SPI transactions to the module, one per chip select
+ */
+typedef struct {
+    uint32_t total; // Since Lora_Init
+    uint16_t lastPacket; // Lora_Transmit_Start through Lora_Transmit_Complete of the last packet
+} LoRa_SPI_Stats;
+
+/**
+ * @brief One frame read in RX continuous mode
+ */
+typedef struct {
+    uint8_t data[LORA_MAX_PAYLOAD_LEN];
+    uint8_t length;
+    bool crcError; // Payload CRC failed, only with CRC on
+    int8_t snr; // Quarter dB
+    int16_t rssi; // dBm
+    uint16_t missed; // Frames the module received since the last read that were never read
+} LoRa_RX_Frame;
 
 /* Function Prototypes ------------------------------------------------------*/
 
@@ -93,7 +140,9 @@ LoRa_Status Lora_Init();
 
 /**
  * @brief Set the Spreading Factor for LoRa
+ * @note Written to the module at the next mode change
  * @note If SF is out of range, it will be set to the closest value
+ * @note LowDataRateOptimize follows the symbol time
  * 
  * @param sf [uint8_t] Spreading Factor from 6-12
  * @return LoRa_Status
@@ -102,6 +151,8 @@ LoRa_Status Lora_Set_SF(LoRa_SF sf);
 
 /**
  * @brief Set the Bandwidth for LoRa
+ * @note Written to the module at the next mode change
+ * @note LowDataRateOptimize follows the symbol time
  * 
  * @param bw [uint8_t] Bandwidth in kHz
  * @return LoRa_Status
@@ -118,6 +169,7 @@ LoRa_Status Lora_Set_Power(uint8_t power);
 
 /**
  * @brief Set the Coding Rate for LoRa
+ * @note Written to the module at the next mode change
  * 
  * @param cr [uint8_t] Coding Rate
  * @return LoRa_Status 
@@ -126,6 +178,7 @@ LoRa_Status Lora_Set_CodingRate(LoRa_CR cr);
 
 /**
  * @brief Set or clear the CRC bit in the RegModemConfig2 register
+ * @note Written to the module at the next mode change
  * 
  * @param crc [bool] True to enable CRC, False to disable
  * @return LoRa_Status 
@@ -134,21 +187,71 @@ LoRa_Status Lora_Set_CRC(bool crc);
 
 /**
  * @brief Define length of Preamble for LoRa
+ * @note Written to the module at the next mode change
  * 
  * @param preamble [uint16_t] Length of Preamble
  * @return LoRa_Status 
  */
 LoRa_Status Lora_Set_Preamble(uint16_t preamble);
 
+/**
+ * @brief Get the current modem settings
+ * 
+ * @param config [LoRa_Config*] Destination
+ */
+void Lora_Get_Config(LoRa_Config* config);
+
+/**
+ * @brief Time on air of one packet with the current modem settings
+ * @note Explicit header mode, from the SX1276 datasheet formula
+ * 
+ * @param len [size_t] Payload length in bytes
+ * @return [uint32_t] Airtime in microseconds
+ */
+uint32_t Lora_Get_Airtime(size_t len);
+
 /**
  * @brief Send data buffer over LoRa Connection
  * @note Headers and Preable are handled by the LoRa Module
+ * @note Blocks the calling task, not the CPU, until TxDone
  * 
  * @param data [uint8_t*] Data buffer to send
  * @param len [uint8_t] Length of data
  */
 LoRa_Status Lora_Transmit(uint8_t* data, size_t len);
 
+/**
+ * @brief Load a packet into the FIFO and start transmitting
+ * @note DIO0 is mapped to TxDone, finish with Lora_Transmit_Complete
+ *       from the same task
+ * 
+ * @param data [uint8_t*] Data buffer to send
+ * @param len [size_t] Length of data
+ * @return LoRa_Status 
+ */
+LoRa_Status Lora_Transmit_Start(uint8_t* data, size_t len);
+
+/**
+ * @brief Sleep until the DIO0 interrupt signals TxDone
+ * 
+ * @param timeout [TickType_t] Ticks to wait before giving up
+ * @return LoRa_Status LORA_TX_ERROR if TxDone never came
+ */
+LoRa_Status Lora_Transmit_Complete(TickType_t timeout);
+
+/**
+ * @brief Get the SPI transaction counts
+ * 
+ * @param stats [LoRa_SPI_Stats*] Destination
+ */
+void Lora_Get_SPI_Stats(LoRa_SPI_Stats* stats);
+
+/**
+ * @brief Handle a rising edge on DIO0
+ * @note Called from EXTI9_5_IRQHandler, wakes the task waiting on the radio
+ */
+void Lora_DIO0_IRQHandler();
+
 /**
  * @brief Read data from LoRa Connection
  * 
@@ -156,4 +259,92 @@ LoRa_Status Lora_Transmit(uint8_t* data, size_t len);
  * @param len [uint8_t] Length of data
  * @return LoRa_Status
  */
-LoRa_Status Lora_Receive(uint8_t* data, uint8_t* len);
\ No newline at end of file
+LoRa_Status Lora_Receive(uint8_t* data, uint8_t* len);
+
+/**
+ * @brief Read data from LoRa Connection, giving up after a timeout
+ * @note Packets longer than size are cut to size
+ * 
+ * @param data [uint8_t*] Data buffer to read into
+ * @param size [uint8_t] Size of data buffer
+ * @param len [uint8_t*] Length of data
+ * @param timeout [TickType_t] Ticks to listen, portMAX_DELAY for ever
+ * @return LoRa_Status LORA_RX_TIMEOUT if nothing arrived
+ */
+LoRa_Status Lora_Receive_Timeout(uint8_t* data, uint8_t size, uint8_t* len, TickType_t timeout);
+
+/**
+ * @brief Put the module in RX continuous mode, DIO0 raises on every RxDone
+ * @note Wakes the calling task, the module stays in RX between frames
+ *       until a transmit or Lora_Receive_Timeout takes it out
+ * 
+ * @return LoRa_Status
+ */
+LoRa_Status Lora_RX_Start();
+
+/**
+ * @brief Wait for the next frame in RX continuous mode and read it
+ * @note The FIFO pointers, flags, packet count, SNR and RSSI come in one
+ *       burst, the module keeps receiving into the next FIFO bytes meanwhile
+ * 
+ * @param frame [LoRa_RX_Frame*] Destination
+ * @param timeout [TickType_t] Ticks to wait for a frame
+ * @return LoRa_Status LORA_RX_TIMEOUT if nothing arrived
+ */
+LoRa_Status Lora_RX_Read(LoRa_RX_Frame* frame, TickType_t timeout);
+
+/**
+ * @brief Switch the module to the FSK modem in packet mode
+ * @note Variable length packets with CRC and whitening at LORA_FSK_BITRATE,
+ *       on the LoRa carrier frequency and power. DIO0 raises on PacketSent
+ *       and PayloadReady. The LoRa functions must not be used until
+ *       Lora_FSK_Stop.
+ * 
+ * @return LoRa_Status
+ */
+LoRa_Status Lora_FSK_Start();
+
+/**
+ * @brief Switch back to the LoRa modem with the settings of Lora_Get_Config
+ * 
+ * @return LoRa_Status
+ */
+LoRa_Status Lora_FSK_Stop();
+
+/**
+ * @brief Send one FSK packet and wait for PacketSent
+ * @note Blocks the calling task, not the CPU, the module is left in Standby
+ * 
+ * @param data [const uint8_t*] Payload
+ * @param len [uint8_t] Payload length, at most LORA_FSK_MAX_PAYLOAD
+ * @return LoRa_Status LORA_TX_ERROR if PacketSent never came
+ */
+LoRa_Status Lora_FSK_Transmit(const uint8_t* data, uint8_t len);
+
+/**
+ * @brief Wait for the next FSK packet with a good CRC
+ * @note Enters RX if the module is not there yet and stays in it, packets
+ *       failing the CRC are dropped by the module
+ * 
+ * @param data [uint8_t*] Destination, LORA_FSK_MAX_PAYLOAD bytes
+ * @param len [uint8_t*] Payload length
+ * @param timeout [TickType_t] Ticks to wait for a packet
+ * @return LoRa_Status LORA_RX_TIMEOUT if nothing arrived
+ */
+LoRa_Status Lora_FSK_Receive(uint8_t* data, uint8_t* len, TickType_t timeout);
+
+/**
+ * @brief SNR of the last received packet
+ * 
+ * @return [int8_t] SNR in quarter dB
+ */
+int8_t Lora_Get_Packet_SNR();
+
+/**
+ * @brief RSSI of the last received packet
+ * 
+ * @return [int16_t] RSSI in dBm
+ */
+int16_t Lora_Get_Packet_RSSI();
+
+#endif /* LORA_H */
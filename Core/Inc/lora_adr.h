@@ -0,0 +1,98 @@
+/************************************************
+* @file    lora_adr.h 
+* @author  APBashara
+* @date    10/2026
+* 
+* @brief   Adaptive LoRa Data Rate from Receiver Link Reports
+* @note    The car puts a link request [type][1][step] in a frame, switches
+*          to step once the frame is sent and listens for the report
+*          [type][3][step][snr][-rssi] sent by the receiver at that step
+* @note    Both ends fall back to the most robust step when reports or
+*          frames stop, that is where they find each other again
+***********************************************/
+
+#ifndef LORA_ADR_H
+#define LORA_ADR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+#include "lora.h"
+
+/* Macros -------------------------------------------------------------------*/
+#define LORA_ADR_TYPE               (0x7F) // Sub-packet type of requests and reports
+#define LORA_ADR_REQUEST_LEN        (3) // Request sub-packet with its tag
+#define LORA_ADR_REPORT_LEN         (5) // Report sub-packet with its tag
+#define LORA_ADR_REPORT_PERIOD      (500) // Ticks between link requests
+#define LORA_ADR_TURNAROUND         (10) // Ticks for the receiver to switch and answer, on top of the report airtime
+#define LORA_ADR_MARGIN_DOWN        (3) // dB of link margin under which the car steps to a more robust rate
+#define LORA_ADR_MARGIN_UP          (8) // dB of margin a faster rate must keep before the car steps up
+#define LORA_ADR_UP_REPORTS         (3) // Reports in a row with room to step up before stepping up
+#define LORA_ADR_MAX_LOST           (3) // Reports in a row lost before falling back
+#define LORA_ADR_SNR_SATURATED      (40) // Quarter dB, above this SNR stops tracking signal strength
+
+/* Structs and Enums --------------------------------------------------------*/
+typedef struct {
+    uint8_t step; // Index in the rate ladder, 0 is the fastest
+    int8_t snr; // SNR of the last report in quarter dB
+    int16_t rssi; // RSSI of the last report in dBm
+    uint32_t reports; // Reports received
+    uint32_t lost; // Requests without a report
+    uint32_t changes; // Modem setting changes
+} LoRa_ADR_Stats;
+
+/* Function Prototypes ------------------------------------------------------*/
+
+/**
+ * @brief Start at the fastest step, the settings Lora_Init leaves
+ * 
+ * @param now [TickType_t] Current tick, the first request is one period later
+ */
+void LoRa_ADR_Init(TickType_t now);
+
+/**
+ * @brief Write a link request if one is due
+ * @note The request stays due until LoRa_ADR_Listen, so a frame that
+ *       fails to send is retried with the next one
+ * 
+ * @param now [TickType_t] Current tick
+ * @param out [uint8_t*] Destination, LORA_ADR_REQUEST_LEN bytes
+ * @return [uint8_t] Bytes written, 0 if no request is due
+ */
+uint8_t LoRa_ADR_Request(TickType_t now, uint8_t* out);
+
+/**
+ * @brief Switch to the announced step and wait for the link report
+ * @note Call after a frame carrying a request was sent, blocks for the
+ *       report airtime plus LORA_ADR_TURNAROUND at most
+ * 
+ * @return [bool] True if the modem settings changed
+ */
+bool LoRa_ADR_Listen();
+
+/**
+ * @brief Answer a link request in a received frame
+ * @note Receiver side, call right after the frame arrives so the
+ *       packet SNR and RSSI are those of the frame
+ * 
+ * @param frame [const uint8_t*] Received frame
+ * @param length [uint8_t] Frame length
+ * @return [bool] True if the frame held a request and the report was sent
+ */
+bool LoRa_ADR_Reply(const uint8_t* frame, uint8_t length);
+
+/**
+ * @brief Go to the most robust step
+ * @note Receiver side, call when no frame arrived for a few report periods
+ */
+void LoRa_ADR_Fallback();
+
+/**
+ * @brief Get a copy of the link statistics
+ * 
+ * @param stats [LoRa_ADR_Stats*] Destination
+ */
+void LoRa_ADR_Get_Stats(LoRa_ADR_Stats* stats);
+
+#endif /* LORA_ADR_H */
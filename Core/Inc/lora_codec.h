@@ -0,0 +1,108 @@
+/************************************************
+* @file    lora_codec.h 
+* @author  APBashara
+* @date    10/2026
+* 
+* @brief   Keyframe and Delta Encoding for LoRa Telemetry Packets
+* @note    Keyframe: header, every field bit packed at its schema width
+* @note    Delta: header, zigzag varint of each field minus its keyframe value
+* @note    Header bit 7 marks a keyframe, bits 0-6 are the keyframe sequence,
+*          a delta can only be decoded against the keyframe it names
+***********************************************/
+
+#ifndef LORA_CODEC_H
+#define LORA_CODEC_H
+
+#include <stdint.h>
+
+/* Macros -------------------------------------------------------------------*/
+#define LORA_CODEC_MAX_FIELDS       (10) // Fields per packet schema, with the sequence and sample time
+#define LORA_CODEC_KEY_INTERVAL     (10) // Packets between keyframes, bounds the loss of a dropped keyframe
+#define LORA_CODEC_KEYFRAME         (0x80) // Header flag
+#define LORA_CODEC_SEQUENCE_MSK     (0x7F) // Header keyframe sequence
+
+/* Structs and Enums --------------------------------------------------------*/
+typedef enum {
+    LORA_CODEC_OK,
+    LORA_CODEC_ERROR, // Truncated or malformed payload
+    LORA_CODEC_NO_KEY, // Delta against a keyframe that never arrived
+} LoRa_Codec_Status;
+
+typedef enum {
+    LORA_FIELD_U8,
+    LORA_FIELD_I8,
+    LORA_FIELD_U16,
+    LORA_FIELD_I16,
+    LORA_FIELD_U32,
+    LORA_FIELD_I32,
+    LORA_FIELD_T32, // Timer time (us), coded as U32
+} LoRa_Field_Type;
+
+/**
+ * @brief One field of a packet struct
+ * @note Signed fields are two's complement, values outside bits are
+ *       saturated to the nearest one that fits
+ */
+typedef struct {
+    uint8_t offset; // Byte offset in the packet struct
+    uint8_t type; // LoRa_Field_Type
+    uint8_t bits; // Width in keyframes (1-32)
+} LoRa_Field;
+
+/**
+ * @brief Encoder or decoder state for one packet type
+ */
+typedef struct {
+    uint32_t key[LORA_CODEC_MAX_FIELDS]; // Field values in the last keyframe
+    uint8_t sequence; // Sequence of the last keyframe
+    uint8_t sinceKey; // Packets sent since the last keyframe
+    uint8_t keyed; // A keyframe has been sent
+} LoRa_Codec_State;
+
+/* Function Prototypes ------------------------------------------------------*/
+
+/**
+ * @brief Largest encoding of a packet, the size of a keyframe
+ * 
+ * @param fields [const LoRa_Field*] Packet schema
+ * @param count [uint8_t] Fields in the schema
+ * @return [uint8_t] Bytes including the header
+ */
+uint8_t LoRa_Codec_Max_Length(const LoRa_Field* fields, uint8_t count);
+
+/**
+ * @brief Encode a packet as a keyframe or a delta, whichever is due and smaller
+ * 
+ * @param fields [const LoRa_Field*] Packet schema
+ * @param count [uint8_t] Fields in the schema, up to LORA_CODEC_MAX_FIELDS
+ * @param state [LoRa_Codec_State*] Encoder state for this packet type
+ * @param packet [const uint8_t*] Packet struct
+ * @param out [uint8_t*] Destination, LoRa_Codec_Max_Length bytes
+ * @return [uint8_t] Bytes written
+ */
+uint8_t LoRa_Codec_Encode(const LoRa_Field* fields, uint8_t count, LoRa_Codec_State* state,
+    const uint8_t* packet, uint8_t* out);
+
+/**
+ * @brief Send a keyframe next time, e.g. after the receiver lost sync
+ * 
+ * @param state [LoRa_Codec_State*] Encoder state for the packet type
+ */
+void LoRa_Codec_Resync(LoRa_Codec_State* state);
+
+/**
+ * @brief Decode a keyframe or delta into a packet struct
+ * @note Ground side, fields outside the schema are left as they were
+ * 
+ * @param fields [const LoRa_Field*] Packet schema
+ * @param count [uint8_t] Fields in the schema, up to LORA_CODEC_MAX_FIELDS
+ * @param state [LoRa_Codec_State*] Decoder state for this packet type
+ * @param in [const uint8_t*] Encoded payload
+ * @param length [uint8_t] Payload length
+ * @param packet [uint8_t*] Packet struct to fill
+ * @return LoRa_Codec_Status
+ */
+LoRa_Codec_Status LoRa_Codec_Decode(const LoRa_Field* fields, uint8_t count, LoRa_Codec_State* state,
+    const uint8_t* in, uint8_t length, uint8_t* packet);
+
+#endif /* LORA_CODEC_H */
@@ -0,0 +1,80 @@
+/************************************************
+* @file    lora_fec.h 
+* @author  APBashara
+* @date    10/2026
+* 
+* @brief   XOR Parity Across Groups of LoRa Frames
+* @note    Data frame: [type][2][group][index] then the protected bytes
+* @note    Parity frame: [type][3 + n][group][size][length xor][xor of the
+*          protected bytes of the group, zero padded to the longest]
+* @note    One lost frame per group is rebuilt on the ground without a
+*          return channel, see Tools/lora_fec.py
+***********************************************/
+
+#ifndef LORA_FEC_H
+#define LORA_FEC_H
+
+#include <stdint.h>
+
+#include "lora.h"
+
+/* Macros -------------------------------------------------------------------*/
+#define LORA_FEC_TYPE               (0x7E) // Sub-packet type of the FEC tags
+#define LORA_FEC_HEADER_LEN         (4) // Tag in front of each data frame
+#define LORA_FEC_PARITY_LEN         (5) // Tag and length xor in front of a parity frame
+#define LORA_FEC_MAX_GROUP          (16) // Data frames per parity frame
+#define LORA_FEC_DEFAULT_GROUP      (4) // Code rate 4/5
+
+/* Structs and Enums --------------------------------------------------------*/
+/**
+ * @brief Parity of the group being sent
+ */
+typedef struct {
+    uint8_t parity[LORA_MAX_PAYLOAD_LEN - LORA_FEC_PARITY_LEN]; // Xor of the protected bytes
+    uint8_t parityLength; // Longest protected length in the group
+    uint8_t lengthXor; // Xor of the protected lengths
+    uint8_t size; // Data frames per group, 0 with FEC off
+    uint8_t group; // Group sequence
+    uint8_t index; // Next data frame in the group
+} LoRa_FEC_State;
+
+/* Function Prototypes ------------------------------------------------------*/
+
+/**
+ * @brief Set the code rate, starts a new group
+ * 
+ * @param state [LoRa_FEC_State*] Encoder state
+ * @param size [uint8_t] Data frames per parity frame, 0 to turn FEC off
+ */
+void LoRa_FEC_Init(LoRa_FEC_State* state, uint8_t size);
+
+/**
+ * @brief Write the tag that starts a data frame
+ * 
+ * @param state [LoRa_FEC_State*] Encoder state
+ * @param out [uint8_t*] Destination, LORA_FEC_HEADER_LEN bytes
+ * @return [uint8_t] Bytes written, 0 with FEC off
+ */
+uint8_t LoRa_FEC_Header(const LoRa_FEC_State* state, uint8_t* out);
+
+/**
+ * @brief Fold a sent data frame into the parity
+ * @note Only frames that went on air, so the indexes the ground sees have no gaps
+ * 
+ * @param state [LoRa_FEC_State*] Encoder state
+ * @param frame [const uint8_t*] Frame including its tag
+ * @param length [uint8_t] Frame length, at most LORA_MAX_PAYLOAD_LEN - LORA_FEC_PARITY_LEN + LORA_FEC_HEADER_LEN
+ */
+void LoRa_FEC_Add(LoRa_FEC_State* state, const uint8_t* frame, uint8_t length);
+
+/**
+ * @brief Build the parity frame once the group is complete
+ * @note Starts the next group
+ * 
+ * @param state [LoRa_FEC_State*] Encoder state
+ * @param out [uint8_t*] Destination, LORA_MAX_PAYLOAD_LEN bytes
+ * @return [uint8_t] Frame length, 0 if the group is not complete
+ */
+uint8_t LoRa_FEC_Parity(LoRa_FEC_State* state, uint8_t* out);
+
+#endif /* LORA_FEC_H */
@@ -0,0 +1,67 @@
+/************************************************
+* @file    lora_link.h 
+* @author  APBashara
+* @date    10/2026
+* 
+* @brief   LoRa Receiver Role, Frames to a UART Link
+* @note    Build with LORA_RECEIVER, the module stays in RX continuous mode
+*          and every frame is written to USART2 as one line
+* 
+*          <seconds>.<us> <rssi dBm> <snr quarter dB>: <frame hex>
+* 
+*          which Tools/lora_deagg.py, Tools/lora_stats.py and
+*          Tools/lora_dump.c read as is
+* @note    Lines go through a byte ring the DMA drains at line rate, a
+*          line that does not fit is dropped whole and counted
+* @note    A log offload announced by the car is served in FSK and its
+*          frames written as lines too, see lora_offload.h
+* @note    Sweep points announced by a LORA_SWEEP car are served and
+*          answered here, see lora_sweep.h
+***********************************************/
+
+#ifndef LORA_LINK_H
+#define LORA_LINK_H
+
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+#include "lora_adr.h"
+
+/* Macros -------------------------------------------------------------------*/
+#define LORA_LINK_RING_SIZE         (4096) // Bytes, power of two, 80 ms of the UART at full rate
+#define LORA_LINK_SILENCE           (3 * LORA_ADR_REPORT_PERIOD) // Ticks without a frame before falling back
+
+/* Structs and Enums --------------------------------------------------------*/
+typedef struct {
+    uint32_t frames; // Frames written to the ring
+    uint32_t crcErrors; // Frames failing the payload CRC, not forwarded
+    uint32_t missed; // Frames the module received that were overwritten before the read
+    uint32_t dropped; // Lines that did not fit in the ring
+    uint32_t reports; // Link reports sent back to the car
+    uint16_t ringPeak; // Most bytes waiting in the ring
+} LoRa_Link_Stats;
+
+/* Function Prototypes ------------------------------------------------------*/
+
+/**
+ * @brief Start the link and put the module in RX continuous mode
+ * @note Call after Lora_Init and USART2_DMA_Init, from the task that
+ *       calls LoRa_Link_Run
+ */
+void LoRa_Link_Init();
+
+/**
+ * @brief Forward the next received frame
+ * @note Blocks until a frame arrives or LORA_LINK_SILENCE passes, call in
+ *       a loop from the LoRa task
+ */
+void LoRa_Link_Run();
+
+/**
+ * @brief Get a copy of the link statistics
+ * 
+ * @param stats [LoRa_Link_Stats*] Destination
+ */
+void LoRa_Link_Get_Stats(LoRa_Link_Stats* stats);
+
+#endif /* LORA_LINK_H */
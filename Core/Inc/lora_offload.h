@@ -0,0 +1,146 @@
+/************************************************
+* @file    lora_offload.h 
+* @author  APBashara
+* @date    10/2026
+* 
+* @brief   SD Log Offload over an FSK Burst of the RFM95
+* @note    In the pit lane, or on a log service request, the car announces
+*          [type][1][start] in a LoRa frame, both ends switch to FSK and
+*          the car streams a capture file, then both go back to LoRa
+* @note    FSK frames are [op][u32][data], little endian. The car sends
+*          start (size, 8.3 name), data (offset, bytes) and end (size),
+*          the receiver answers frames with the poll bit with an ack of
+*          the next offset it wants. Go-back-N, the receiver keeps only
+*          in-order data and the car resends from the ack.
+* @note    The receiver role writes every accepted frame as a sub-packet
+*          of type LORA_OFFLOAD_TYPE in its usual lines, see
+*          Tools/lora_offload.py
+***********************************************/
+
+#ifndef LORA_OFFLOAD_H
+#define LORA_OFFLOAD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+#include "lora.h"
+
+/* Macros -------------------------------------------------------------------*/
+#define LORA_OFFLOAD_TYPE           (0x7C) // Sub-packet type of the announcement and of offload lines
+#define LORA_OFFLOAD_START          (0x01) // size u32, 8.3 name
+#define LORA_OFFLOAD_DATA           (0x02) // offset u32, data
+#define LORA_OFFLOAD_END            (0x03) // size u32
+#define LORA_OFFLOAD_ACK            (0x04) // next offset u32, receiver to car
+#define LORA_OFFLOAD_POLL           (0x80) // On a car frame, answer with an ack
+#define LORA_OFFLOAD_HEADER_LEN     (5) // Op and u32 in front of each frame
+#define LORA_OFFLOAD_CHUNK          (LORA_FSK_MAX_PAYLOAD - LORA_OFFLOAD_HEADER_LEN) // File bytes per frame
+#define LORA_OFFLOAD_WINDOW         (16) // Frames sent before polling for an ack
+#define LORA_OFFLOAD_ACK_TIMEOUT    (10) // Ticks to wait for an ack after a poll
+#define LORA_OFFLOAD_MAX_TIMEOUTS   (25) // Polls in a row without progress before the link is given up
+#define LORA_OFFLOAD_TURNAROUND     (20) // Ticks for the receiver to switch to FSK after the announcement
+#define LORA_OFFLOAD_SILENCE        (1000) // Ticks the receiver waits for a frame before going back to LoRa
+#define LORA_OFFLOAD_RETRY          (30000) // Ticks between attempts while nobody answers
+#define LORA_OFFLOAD_ATTEMPTS       (5) // Attempts before a request is dropped
+
+// Pit lane geofence, set for the track, a latitude of 0 turns it off
+#ifndef LORA_OFFLOAD_PIT_LAT
+#define LORA_OFFLOAD_PIT_LAT        (0) // Centre latitude in 1e-7 degrees
+#endif
+#ifndef LORA_OFFLOAD_PIT_LON
+#define LORA_OFFLOAD_PIT_LON        (0) // Centre longitude in 1e-7 degrees
+#endif
+#define LORA_OFFLOAD_PIT_RADIUS     (50) // m
+#define LORA_OFFLOAD_PIT_SPEED      (1000) // mm/s, slower counts as parked
+#define LORA_OFFLOAD_PIT_DWELL      (10000) // Ticks parked in the pit lane before the offload starts
+
+/* Structs and Enums --------------------------------------------------------*/
+typedef enum {
+    LORA_OFFLOAD_OK,
+    LORA_OFFLOAD_ERROR, // No file or the card failed
+    LORA_OFFLOAD_NO_ANSWER, // Nobody acked the start
+    LORA_OFFLOAD_LOST, // Acks stopped during the transfer
+} LoRa_Offload_Status;
+
+typedef struct {
+    uint32_t files; // Transfers completed
+    uint32_t bytes; // File bytes acked
+    uint32_t frames; // FSK frames sent
+    uint32_t resent; // Data frames sent again after a lost ack or frame
+    uint32_t timeouts; // Polls without an ack
+    uint32_t failed; // Attempts that did not complete
+    uint32_t capturing; // Requests refused because the CAN capture is writing the file
+    uint32_t rate; // Bytes per second of the last transfer
+} LoRa_Offload_Stats;
+
+/**
+ * @brief Called with each frame the receiver accepts, as a sub-packet
+ * 
+ * @param data [const uint8_t*] [LORA_OFFLOAD_TYPE][length][frame]
+ * @param length [uint8_t] Sub-packet length
+ * @param ctx [void*] Context given to LoRa_Offload_Serve
+ * @return [bool] False if the frame could not be taken, the car sends it again
+ */
+typedef bool (*LoRa_Offload_Output)(const uint8_t* data, uint8_t length, void* ctx);
+
+/* Function Prototypes ------------------------------------------------------*/
+
+/**
+ * @brief Ask for a file to be offloaded at the next chance
+ * @note Any task, the LoRa task runs the transfer
+ * 
+ * @param name [const char*] 8.3 name, NULL or empty for the newest
+ *             capture file the card will open
+ */
+void LoRa_Offload_Request(const char* name);
+
+/**
+ * @brief Request an offload once the car is parked in the pit lane
+ * @note Call with every GPS fix, fires once per stop
+ * 
+ * @param latitude [int32_t] 1e-7 degrees
+ * @param longitude [int32_t] 1e-7 degrees
+ * @param speed [int32_t] Ground speed in mm/s
+ * @param now [TickType_t] Current tick
+ */
+void LoRa_Offload_Geofence(int32_t latitude, int32_t longitude, int32_t speed, TickType_t now);
+
+/**
+ * @brief Check if a transfer should start now
+ * 
+ * @param now [TickType_t] Current tick
+ * @return [bool]
+ */
+bool LoRa_Offload_Due(TickType_t now);
+
+/**
+ * @brief Announce, run the transfer in FSK and return to LoRa
+ * @note Car side, from the LoRa task while nothing else uses the radio.
+ *       Blocks for the whole transfer, a failed attempt is retried after
+ *       LORA_OFFLOAD_RETRY.
+ * 
+ * @return LoRa_Offload_Status
+ */
+LoRa_Offload_Status LoRa_Offload_Run();
+
+/**
+ * @brief Serve a transfer announced in a received frame
+ * @note Receiver side, blocks until the end frame or LORA_OFFLOAD_SILENCE,
+ *       the module is back in LoRa Standby afterwards
+ * 
+ * @param frame [const uint8_t*] Received LoRa frame
+ * @param length [uint8_t] Frame length
+ * @param output [LoRa_Offload_Output] Called with each accepted frame
+ * @param ctx [void*] Passed to output
+ * @return [bool] True if the frame held an announcement
+ */
+bool LoRa_Offload_Serve(const uint8_t* frame, uint8_t length, LoRa_Offload_Output output, void* ctx);
+
+/**
+ * @brief Get a copy of the offload statistics
+ * 
+ * @param stats [LoRa_Offload_Stats*] Destination
+ */
+void LoRa_Offload_Get_Stats(LoRa_Offload_Stats* stats);
+
+#endif /* LORA_OFFLOAD_H */
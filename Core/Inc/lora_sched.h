@@ -0,0 +1,151 @@
+/************************************************
+* @file    lora_sched.h 
+* @author  APBashara
+* @date    10/2026
+* 
+* @brief   Airtime Budgeted LoRa Packet Scheduler
+* @note    Earliest deadline first, due packets share one radio frame
+* @note    Frame layout is repeated [type][length][payload] sub-packets,
+*          payload is the lora_codec encoding, or the packet without its
+*          ID byte when it has no schema, see Tools/lora_deagg.py
+***********************************************/
+
+#ifndef LORA_SCHED_H
+#define LORA_SCHED_H
+
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+#include "lora.h"
+#include "lora_adr.h"
+#include "lora_codec.h"
+#include "lora_fec.h"
+#include "lora_tdma.h"
+
+/* Macros -------------------------------------------------------------------*/
+#define LORA_SCHED_MAX_PACKETS      (8) // Rate table entries
+#define LORA_SCHED_TX_MARGIN        (5) // Ticks allowed past the computed airtime for TxDone
+#define LORA_SCHED_TAG_LEN          (2) // Type and length bytes in front of each sub-packet
+#define LORA_SCHED_OVERLOAD         (4) // Smallest frames merged into one when the rates outrun the data rate
+#define LORA_SCHED_MAX_PACKET_LEN   (32) // Largest packet struct, including the ID byte
+
+/* Structs and Enums --------------------------------------------------------*/
+typedef enum {
+    LORA_SCHED_OK,
+    LORA_SCHED_ERROR,
+} LoRa_Sched_Status;
+
+/**
+ * @brief One packet type in the rate table
+ * @note Without maxAge data is copied as the packet is encoded, the newest
+ *       values at transmit time go out every period
+ * @note With maxAge the producer publishes each sample, it is copied to
+ *       the packet's TX slot where a newer one replaces it until sent. A
+ *       period without a new sample sends nothing, and a sample older than
+ *       maxAge is dropped instead of sent late.
+ * @note With a schema the scheduler stamps the sequence and sample time of
+ *       the packet as it is encoded, the publish time with maxAge, see
+ *       LORA_SCHEMA_HEAD
+ */
+typedef struct {
+    uint8_t* data; // Packet contents, first byte is the packet ID
+    uint8_t length; // Packet size including the ID byte
+    uint16_t rate; // Requested packets per second
+    uint16_t latency; // Ticks a due packet may wait to share a frame, under the period
+    const LoRa_Field* fields; // Codec schema, NULL to send the packet as is
+    uint8_t fieldCount; // Entries in fields
+    uint16_t maxAge; // Ticks a published sample may wait to be sent, 0 if it is never published
+} LoRa_Sched_Packet;
+
+typedef struct {
+    uint16_t rate; // Packets sent in the last second
+    uint32_t sent; // Packets on air since boot
+    uint32_t missed; // Deadlines missed, sent late or skipped
+    uint32_t errors; // Transmits that never reached TxDone
+    uint32_t airtime; // Time on air of the last frame carrying this packet in us
+    uint32_t overwritten; // Published samples replaced before they were sent
+    uint32_t dropped; // Published samples older than maxAge, never sent
+} LoRa_Sched_Stats;
+
+typedef struct {
+    uint32_t frames; // Radio frames sent since boot
+    uint32_t subPackets; // Packets carried by those frames
+    uint32_t bytes; // Frame payload bytes sent
+    uint16_t load; // Channel time on air in the last second, tenths of a percent
+    uint8_t limit; // Largest frame the current modem settings allow in bytes
+    uint32_t parity; // FEC parity frames sent since boot
+} LoRa_Sched_Frame_Stats;
+
+/* Function Prototypes ------------------------------------------------------*/
+
+/**
+ * @brief Load the rate table
+ * @note Each period is its deadline, a packet is due again one period after release
+ * 
+ * @param packets [const LoRa_Sched_Packet*] Rate table, must outlive the scheduler
+ * @param count [uint8_t] Entries in packets, up to LORA_SCHED_MAX_PACKETS
+ * @return LoRa_Sched_Status
+ */
+LoRa_Sched_Status LoRa_Sched_Init(const LoRa_Sched_Packet* packets, uint8_t count);
+
+/**
+ * @brief Publish a new sample of a packet with a maxAge
+ * @note Call from the producer once every field of the sample is written,
+ *       the packet is copied to its TX slot
+ * 
+ * @param id [uint8_t] Packet ID, the first byte of its data
+ * @return LoRa_Sched_Status LORA_SCHED_ERROR if no packet with a maxAge has the ID
+ */
+LoRa_Sched_Status LoRa_Sched_Publish(uint8_t id);
+
+/**
+ * @brief Send one frame once a due packet reaches its latency bound
+ * @note Packs every due packet in deadline order until the frame is full
+ * @note Carries the ADR link request when due, the frame limit follows
+ *       every data rate change
+ * @note With FEC on a parity frame follows every group of frames
+ * @note Sleeps until the next release or bound if nothing must go, call in a loop from one task
+ */
+void LoRa_Sched_Run();
+
+/**
+ * @brief Set the FEC code rate
+ * @note Call from the task running LoRa_Sched_Run, starts a new group
+ * 
+ * @param size [uint8_t] Frames per parity frame, up to LORA_FEC_MAX_GROUP, 0 turns FEC off
+ */
+void LoRa_Sched_Set_FEC(uint8_t size);
+
+/**
+ * @brief Get a copy of the statistics for one packet type
+ * 
+ * @param index [uint8_t] Entry in the rate table
+ * @param stats [LoRa_Sched_Stats*] Destination
+ * @return LoRa_Sched_Status LORA_SCHED_ERROR if index is out of range
+ */
+LoRa_Sched_Status LoRa_Sched_Get_Stats(uint8_t index, LoRa_Sched_Stats* stats);
+
+/**
+ * @brief Get a copy of the radio frame statistics
+ * 
+ * @param stats [LoRa_Sched_Frame_Stats*] Destination
+ */
+void LoRa_Sched_Get_Frame_Stats(LoRa_Sched_Frame_Stats* stats);
+
+/**
+ * @brief Give the TDMA superframe a GPS time sample
+ * @note Call from the GPS task, does nothing without LORA_TDMA
+ * 
+ * @param iTOW [uint32_t] NAV-PVT time of week in ms, only with validTime set
+ * @param timer [uint32_t] Get_Timer_Count when the solution was polled
+ */
+void LoRa_Sched_Set_Time(uint32_t iTOW, uint32_t timer);
+
+/**
+ * @brief Get a copy of the TDMA statistics, zero without LORA_TDMA
+ * 
+ * @param stats [LoRa_TDMA_Stats*] Destination
+ */
+void LoRa_Sched_Get_TDMA_Stats(LoRa_TDMA_Stats* stats);
+
+#endif /* LORA_SCHED_H */
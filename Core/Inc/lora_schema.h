@@ -0,0 +1,166 @@
+/************************************************
+* @file    lora_schema.h 
+* @author  APBashara
+* @date    10/2026
+* 
+* @brief   LoRa Telemetry Wire Schema
+* @note    The one definition of every LoRa packet. The firmware structs, the
+*          codec field tables, the static checks and the ground decoder
+*          (Tools/lora_ground.c) all expand from the lists below, and
+*          Tools/lora_codec.py parses this file
+* @note    Keyframes pack every field LSB first at its bit width, struct
+*          padding and byte order never reach the air
+* @note    Bump LORA_SCHEMA_VERSION on any change, the ground refuses frames
+*          tagged with another version
+***********************************************/
+
+#ifndef LORA_SCHEMA_H
+#define LORA_SCHEMA_H
+
+#include <stdint.h>
+
+#include "lora_codec.h"
+
+/* Macros -------------------------------------------------------------------*/
+#define LORA_SCHEMA_VERSION         (3)
+#define LORA_SCHEMA_TYPE            (0x7D) // Sub-packet type of the version tag
+#define LORA_SCHEMA_TAG_LEN         (3) // Version tag [type][1][version]
+
+// LoRa Packet IDs
+#define LORA_SUSPENSION_ID          (0x01) // 50 Hz
+#define LORA_GPS_ID                 (0x02) // 25 Hz
+#define LORA_ENGINE_ID              (0x03) // 20 Hz
+#define LORA_BRAKES_ACCEL_ID        (0x04) // 10 Hz
+#define LORA_TEMPERATURE_ID         (0x05) // 1 Hz
+
+/* Schema -------------------------------------------------------------------*/
+// FIELD(packet, name, type, bits), type is U8 I8 U16 I16 U32 I32 T32, bits the keyframe width
+// T32 is a Get_Timer_Count time, sent as us since the session epoch
+
+// Every packet starts with these, stamped by the scheduler as the packet is encoded
+#define LORA_SCHEMA_HEAD(FIELD, P) \
+    FIELD(P, Sequence, U8, 8)               /* Rolling count of this packet type */
+
+// and ends with these
+#define LORA_SCHEMA_TAIL(FIELD, P) \
+    FIELD(P, SampleTime, T32, 32)           /* Publish or snapshot time */
+
+// Front and Rear Suspension Potentiometer values
+#define LORA_SCHEMA_SUSPENSION(FIELD, P) \
+    FIELD(P, FrontPot, U16, 12)             /* Front Right Suspension Damper */ \
+    FIELD(P, RearPot, U16, 12)              /* Rear Right Suspension Damper */
+
+// GPS Latitude, Longitude, and Speed
+#define LORA_SCHEMA_GPS(FIELD, P) \
+    FIELD(P, latGPS, I32, 32)               /* Latitude GPS */ \
+    FIELD(P, longGPS, I32, 32)              /* Longitude GPS */ \
+    FIELD(P, Speed, I8, 8)                  /* Vehicle GPS Speed */
+
+// Engine RPM, Throttle Position, Steering Angle, and Brake Pressure
+#define LORA_SCHEMA_ENGINE(FIELD, P) \
+    FIELD(P, BrakePressure, U16, 12)        /* Brake Pressure */ \
+    FIELD(P, ThrottleADC, U16, 12)          /* Analog Throttle Position */ \
+    FIELD(P, Steering, U16, 12)             /* Steering Angle */ \
+    FIELD(P, RPM, U16, 16)                  /* Engine RPM */ \
+    FIELD(P, ThrottlePosSensor, U16, 16)    /* Throttle Position from ECU */ \
+    FIELD(P, Lambda, U16, 16)               /* Lambda */ \
+    FIELD(P, EcuTime, T32, 32)              /* Receive time of RPM and TPS */
+
+// Oil Pressure, Front and Rear Brake Temp, and Accelerometer values
+#define LORA_SCHEMA_BRAKES_ACCEL(FIELD, P) \
+    FIELD(P, OilPressure, U16, 16)          /* Oil Pressure */ \
+    FIELD(P, FrontBrakeTemp, U16, 16)       /* Front Right Brake Temp (F) */ \
+    FIELD(P, RearBrakeTemp, U16, 16)        /* Rear Right Brake Temp (F) */ \
+    FIELD(P, AccelX, U16, 16)               /* Accelerometer X Axis */ \
+    FIELD(P, AccelZ, U16, 16)               /* Accelerometer Z Axis */ \
+    FIELD(P, AccelY, U16, 16)               /* Accelerometer Y Axis */
+
+// Air and Coolant Temp
+#define LORA_SCHEMA_TEMPERATURE(FIELD, P) \
+    FIELD(P, AirTemp, U16, 16)              /* Air Temp (F) */ \
+    FIELD(P, CoolTemp, U16, 16)             /* Coolant Temp (F) */
+
+// PACKET(id, name, fields), makes LoRa_<name>_Packet and LoRa_<name>_Fields
+#define LORA_SCHEMA(PACKET) \
+    PACKET(LORA_SUSPENSION_ID, Suspension, LORA_SCHEMA_SUSPENSION) \
+    PACKET(LORA_GPS_ID, GPS, LORA_SCHEMA_GPS) \
+    PACKET(LORA_ENGINE_ID, Engine_Data, LORA_SCHEMA_ENGINE) \
+    PACKET(LORA_BRAKES_ACCEL_ID, Brakes_Accel, LORA_SCHEMA_BRAKES_ACCEL) \
+    PACKET(LORA_TEMPERATURE_ID, Temperature, LORA_SCHEMA_TEMPERATURE)
+
+/* Generated ----------------------------------------------------------------*/
+#define LORA_SCHEMA_ALL(fields, FIELD, P) \
+    LORA_SCHEMA_HEAD(FIELD, P) fields(FIELD, P) LORA_SCHEMA_TAIL(FIELD, P)
+
+// Field table entries of the stamps, the sample time is the last field
+#define LORA_SCHEMA_SEQUENCE_FIELD  (0)
+#define LORA_SCHEMA_TIME_FIELD(count) ((count) - 1)
+
+#define LORA_SCHEMA_CTYPE_U8        uint8_t
+#define LORA_SCHEMA_CTYPE_I8        int8_t
+#define LORA_SCHEMA_CTYPE_U16       uint16_t
+#define LORA_SCHEMA_CTYPE_I16       int16_t
+#define LORA_SCHEMA_CTYPE_U32       uint32_t
+#define LORA_SCHEMA_CTYPE_I32       int32_t
+#define LORA_SCHEMA_CTYPE_T32       uint32_t
+
+#define LORA_SCHEMA_MEMBER(P, name, type, bits)     LORA_SCHEMA_CTYPE_##type name;
+#define LORA_SCHEMA_ONE(P, name, type, bits)        + 1
+#define LORA_SCHEMA_BITS(P, name, type, bits)       + (bits)
+#define LORA_SCHEMA_ONE_PACKET(id, name, fields)    + 1
+
+// Packet structs, the ID byte first so the scheduler can read the type
+#define LORA_SCHEMA_STRUCT(id, name, fields) \
+    typedef struct { \
+        const uint8_t PacketID; \
+        LORA_SCHEMA_ALL(fields, LORA_SCHEMA_MEMBER, ) \
+    } LoRa_##name##_Packet;
+LORA_SCHEMA(LORA_SCHEMA_STRUCT)
+
+// LoRa_<name>_Field_Count and LoRa_<name>_Key_Len, the keyframe size with its header
+#define LORA_SCHEMA_SIZES(id, name, fields) \
+    LoRa_##name##_Field_Count = 0 LORA_SCHEMA_ALL(fields, LORA_SCHEMA_ONE, ), \
+    LoRa_##name##_Key_Len = 1 + ((0 LORA_SCHEMA_ALL(fields, LORA_SCHEMA_BITS, )) + 7) / 8,
+enum { LORA_SCHEMA(LORA_SCHEMA_SIZES) };
+
+#define LORA_SCHEMA_PACKETS         (0 LORA_SCHEMA(LORA_SCHEMA_ONE_PACKET))
+
+#define LORA_SCHEMA_EXTERN(id, name, fields) \
+    extern const LoRa_Field LoRa_##name##_Fields[LoRa_##name##_Field_Count];
+LORA_SCHEMA(LORA_SCHEMA_EXTERN)
+
+// Schema and field count of a packet, for a LoRa_Sched_Packet
+#define LORA_SCHEMA_FIELDS(name)    LoRa_##name##_Fields, LoRa_##name##_Field_Count
+
+// Any packet, for decoding before the type is known
+#define LORA_SCHEMA_UNION(id, name, fields) LoRa_##name##_Packet name;
+typedef union {
+    LORA_SCHEMA(LORA_SCHEMA_UNION)
+} LoRa_Schema_Any;
+
+/* Structs and Enums --------------------------------------------------------*/
+/**
+ * @brief One packet type of the schema
+ */
+typedef struct {
+    uint8_t id; // Packet ID, the sub-packet type on air
+    const char* name;
+    const LoRa_Field* fields;
+    const char* const* fieldNames;
+    uint8_t fieldCount;
+    uint8_t size; // Size of the packet struct on this build
+} LoRa_Schema_Packet;
+
+extern const LoRa_Schema_Packet loraSchema[LORA_SCHEMA_PACKETS];
+
+/* Function Prototypes ------------------------------------------------------*/
+
+/**
+ * @brief Look up a packet type
+ * 
+ * @param id [uint8_t] Packet ID
+ * @return [const LoRa_Schema_Packet*] NULL if the schema has no such packet
+ */
+const LoRa_Schema_Packet* LoRa_Schema_Find(uint8_t id);
+
+#endif /* LORA_SCHEMA_H */
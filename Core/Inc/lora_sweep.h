@@ -0,0 +1,83 @@
+/************************************************
+* @file    lora_sweep.h 
+* @author  APBashara
+* @date    10/2026
+* 
+* @brief   LoRa Airtime and Packet Error Rate Sweep
+* @note    Build the car with LORA_SWEEP and pair it with a receiver role
+*          board. For every SF, bandwidth, coding rate and payload length
+*          in the sweep the car announces [type][8][start][point] at the
+*          base settings, both ends switch, the car sends
+*          LORA_SWEEP_PACKETS packets and times each with TIM2, then both
+*          switch back and the receiver answers with what it got
+* @note    Sweep frames are [type][length][op][index u16] then
+*            start   sf, bw, cr, packets, length
+*            data    sequence, filler
+*            result  good, corrupt, snr avg, -rssi avg
+*          little endian. CRC is off, so the receiver checks the filler
+*          pattern itself and counts a packet that fails it as corrupt.
+* @note    The car writes one CSV row per point with the measured and
+*          the datasheet airtime, points whose packets take longer than
+*          LORA_SWEEP_MAX_AIRTIME are skipped
+***********************************************/
+
+#ifndef LORA_SWEEP_H
+#define LORA_SWEEP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+#include "lora.h"
+
+/* Macros -------------------------------------------------------------------*/
+#define LORA_SWEEP_TYPE             (0x7B) // Sub-packet type of all sweep frames
+#define LORA_SWEEP_START            (0x01) // Point settings, car to receiver at the base settings
+#define LORA_SWEEP_DATA             (0x02) // Test packet at the point settings
+#define LORA_SWEEP_RESULT           (0x03) // Receiver to car at the base settings
+#define LORA_SWEEP_START_LEN        (10) // Start sub-packet with its tag
+#define LORA_SWEEP_DATA_MIN_LEN     (6) // Data sub-packet up to the sequence
+#define LORA_SWEEP_RESULT_LEN       (9) // Result sub-packet with its tag
+#define LORA_SWEEP_PACKETS          (20) // Packets sent per point
+#define LORA_SWEEP_GAP              (5) // Ticks between packets, the receiver reads the last one meanwhile
+#define LORA_SWEEP_TURNAROUND       (20) // Ticks for the other end to switch settings
+#define LORA_SWEEP_TX_MARGIN        (10) // Ticks past the airtime to wait for TxDone
+#define LORA_SWEEP_MAX_AIRTIME      (1000000) // us, slower points are skipped
+#define LORA_SWEEP_LINE_LEN         (160) // Longest CSV line
+
+/* Structs and Enums --------------------------------------------------------*/
+
+/**
+ * @brief Called with each CSV line of the sweep
+ * 
+ * @param line [const char*] Line with its line ending, null terminated
+ * @param ctx [void*] Context given to LoRa_Sweep_Run
+ */
+typedef void (*LoRa_Sweep_Output)(const char* line, void* ctx);
+
+/* Function Prototypes ------------------------------------------------------*/
+
+/**
+ * @brief Run the whole sweep and write the CSV table
+ * @note Car side, from the LoRa task while nothing else uses the radio.
+ *       Takes the channel for as long as the sweep runs, minutes at the
+ *       slow points, and returns with the base settings back.
+ * 
+ * @param output [LoRa_Sweep_Output] Called with the header and each row
+ * @param ctx [void*] Passed to output
+ */
+void LoRa_Sweep_Run(LoRa_Sweep_Output output, void* ctx);
+
+/**
+ * @brief Serve a sweep point announced in a received frame
+ * @note Receiver side, blocks until the last packet of the point or its
+ *       window passes, the module is back at the base settings in Standby
+ *       afterwards
+ * 
+ * @param frame [const uint8_t*] Received LoRa frame
+ * @param length [uint8_t] Frame length
+ * @return [bool] True if the frame held an announcement
+ */
+bool LoRa_Sweep_Serve(const uint8_t* frame, uint8_t length);
+
+#endif /* LORA_SWEEP_H */
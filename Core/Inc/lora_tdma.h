@@ -0,0 +1,119 @@
+/************************************************
+* @file    lora_tdma.h 
+* @author  APBashara
+* @date    10/2026
+* 
+* @brief   TDMA Slots for Several Cars on One LoRa Channel
+* @note    A superframe of LORA_TDMA_SUPERFRAME ms starts on every multiple
+*          of it in GPS time of week, node n of N owns its n-th of it and
+*          only starts a frame that ends inside its slot
+* @note    GPS time comes from NAV-PVT iTOW polls, the poll answered
+*          soonest after its solution is the one the superframe follows.
+*          Polls slip 1 ms per solution so one in LORA_TDMA_SYNC_WINDOW
+*          lands right after a solution. Boards with the same receiver
+*          share its remaining latency.
+* @note    Times are in us of the free running Get_Timer_Count, passed in
+*          so the host simulation can run a fleet, see Tools/lora_tdma_sim.c
+***********************************************/
+
+#ifndef LORA_TDMA_H
+#define LORA_TDMA_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Macros -------------------------------------------------------------------*/
+#ifndef LORA_TDMA_NODES
+#define LORA_TDMA_NODES             (3) // Slots per superframe, set by the Makefile
+#endif
+#ifndef LORA_TDMA_NODE
+#define LORA_TDMA_NODE              (0) // Slot of this board, set by the Makefile
+#endif
+#define LORA_TDMA_SUPERFRAME        (60) // ms, divides the GPS week so slots line up across its rollover
+#define LORA_TDMA_SYNC_ERROR        (1500) // us two nodes' superframes may disagree, guarded on both slot edges
+#define LORA_TDMA_START_SLACK       (1000) // us a full frame may start late, the scheduler wakes on the tick
+#define LORA_TDMA_SYNC_WINDOW       (50) // Time samples before a later clock estimate replaces the held one
+#define LORA_TDMA_HOLDOVER          (30000000) // us the superframe free runs after the last time sample
+#define LORA_TDMA_WEEK              (604800000000LL) // us in a GPS week
+
+_Static_assert((LORA_TDMA_WEEK / 1000) % LORA_TDMA_SUPERFRAME == 0, "Superframe must divide the GPS week");
+_Static_assert(LORA_TDMA_NODE < LORA_TDMA_NODES, "Node must own one of the slots");
+
+/* Structs and Enums --------------------------------------------------------*/
+typedef struct {
+    bool locked; // Superframe follows GPS time, else the local timer or held while acquiring
+    uint32_t syncs; // Time samples given
+    int32_t correction; // us the superframe moved at the last adopted sample
+    uint32_t guard; // us kept free at the slot edges, sync error and the measured TX overrun
+    uint32_t held; // Frames held back for the slot
+    uint32_t overlong; // Frames longer than the slot, started at its opening
+} LoRa_TDMA_Stats;
+
+/**
+ * @brief Slot and GPS clock of one node
+ */
+typedef struct {
+    uint8_t node;
+    uint8_t nodes;
+    bool synced; // Has a GPS time sample
+    uint8_t acquired; // Samples since the first, frames are held until a window has passed
+    uint32_t syncTOW; // iTOW of the adopted sample in ms
+    uint32_t syncTimer; // Timer at that sample
+    uint32_t windowTOW; // Best sample of the current window
+    uint32_t windowTimer;
+    int32_t windowAhead; // us that sample is ahead of the adopted clock
+    uint8_t windowCount;
+    uint32_t overrun; // us TxDone came after the computed airtime, decaying maximum
+    LoRa_TDMA_Stats stats;
+} LoRa_TDMA_State;
+
+/* Function Prototypes ------------------------------------------------------*/
+
+/**
+ * @brief Take a slot, follows the local timer until the first time sample
+ * and holds frames for LORA_TDMA_SYNC_WINDOW samples after it
+ * 
+ * @param state [LoRa_TDMA_State*] Node state
+ * @param node [uint8_t] Slot of this node
+ * @param nodes [uint8_t] Slots per superframe
+ */
+void LoRa_TDMA_Init(LoRa_TDMA_State* state, uint8_t node, uint8_t nodes);
+
+/**
+ * @brief Give a GPS time sample
+ * @note Only samples with NAV-PVT validTime set
+ * 
+ * @param state [LoRa_TDMA_State*] Node state
+ * @param iTOW [uint32_t] GPS time of week of the solution in ms
+ * @param timer [uint32_t] Timer when the solution was polled
+ */
+void LoRa_TDMA_Sync(LoRa_TDMA_State* state, uint32_t iTOW, uint32_t timer);
+
+/**
+ * @brief Time until a frame may start
+ * 
+ * @param state [LoRa_TDMA_State*] Node state
+ * @param airtime [uint32_t] Time on air of the frame in us
+ * @param timer [uint32_t] Current timer
+ * @return [uint32_t] us to wait, 0 to send now
+ */
+uint32_t LoRa_TDMA_Wait(LoRa_TDMA_State* state, uint32_t airtime, uint32_t timer);
+
+/**
+ * @brief Account a sent frame, TxDone later than its airtime widens the guard
+ * 
+ * @param state [LoRa_TDMA_State*] Node state
+ * @param airtime [uint32_t] Computed time on air in us
+ * @param elapsed [uint32_t] Measured start to TxDone in us
+ */
+void LoRa_TDMA_Sent(LoRa_TDMA_State* state, uint32_t airtime, uint32_t elapsed);
+
+/**
+ * @brief Longest frame a slot holds
+ * 
+ * @param state [const LoRa_TDMA_State*] Node state
+ * @return [uint32_t] Airtime in us
+ */
+uint32_t LoRa_TDMA_Budget(const LoRa_TDMA_State* state);
+
+#endif /* LORA_TDMA_H */
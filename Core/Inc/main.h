@@ -42,11 +42,20 @@ extern "C" {
     #include "gpio.h"
 #endif
 #include "can.h"
+#include "can_decode.h"
+#include "can_capture.h"
+#include "isotp.h"
+#include "log_service.h"
 #include "adc.h"
 #include "timer.h"
 #include "uart.h"
 #include "gps.h"
 #include "lora.h"
+#include "lora_sched.h"
+#include "lora_link.h"
+#include "lora_offload.h"
+#include "lora_sweep.h"
+#include "lora_schema.h"
 
 /* Macros  ------------------------------------------------------------------*/
 // Constant Definitions
@@ -59,23 +68,12 @@ extern "C" {
 
 // Priotity Definitions -- Higher number = Higher Priority
 #define ADC_PRIORITY                (configMAX_PRIORITIES - 1)
+#define LORA_PRIORITY               (configMAX_PRIORITIES - 2)
 #define GPS_PRIORITY                (configMAX_PRIORITIES - 3)
 #define CAN_PRIORITY                (configMAX_PRIORITIES - 5)
 #define LED_PRIORITY                (configMAX_PRIORITIES - 7)
 #define STATS_PRIORITY              (configMAX_PRIORITIES - 8)
-
-#define LORA_SUSPENSION_PRIORITY    (configMAX_PRIORITIES - 2)
-#define LORA_GPS_PRIORITY           (configMAX_PRIORITIES - 4)
-#define LORA_ENGINE_PRIORITY        (configMAX_PRIORITIES - 6)
-#define LORA_BRAKES_ACCEL_PRIORITY  (configMAX_PRIORITIES - 6)
-#define LORA_TEMPERATURE_PRIORITY   (configMAX_PRIORITIES - 7)
-
-// LoRa Packet IDs
-#define LORA_SUSPENSION_ID          (0x01) // 50 Hz
-#define LORA_GPS_ID                 (0x02) // 25 Hz
-#define LORA_ENGINE_ID              (0x03) // 20 Hz
-#define LORA_BRAKES_ACCEL_ID        (0x04) // 10 Hz
-#define LORA_TEMPERATURE_ID         (0x05) // 1 Hz
+#define OFFLOAD_PRIORITY            (configMAX_PRIORITIES - 9)
 
 // ADC Channel Assignments
 #define Thermocouple_1_ADC          (0u)
@@ -96,74 +94,7 @@ extern "C" {
 // #define NA_ADC                      (3u)
 
 /* Data Structures  ---------------------------------------------------------*/
-/**
- * @brief 50 Hz packet with ID 0x01
- * @note  Contains Front and Rear Suspension Potentiometer values
- */
-typedef struct {
-  const uint8_t PacketID;           // ID = 0x01
-
-  uint16_t FrontPot;                // Front Right Suspension Damper
-  uint16_t RearPot;                 // Rear Right Suspension Damper
-
-} LoRa_Suspension_Packet;
-
-/**
- * @brief 25 Hz packet with ID 0x02
- * @note  Contains GPS Latitude, Longitude, and Speed
- */
-typedef struct {
-  const uint8_t PacketID;           // ID = 0x02
-
-  int32_t latGPS;                   // Latitude GPS
-  int32_t longGPS;                  // Longitude GPS
-  int8_t Speed;                    // Vehicle GPS Speed
-
-} LoRa_GPS_Packet;
-
-/**
- * @brief 20 Hz packet with ID 0x03
- * @note  Contains Engine RPM, Throttle Position, Steering Angle, and Brake Pressure
- */
-typedef struct {
-  const uint8_t PacketID;           // ID = 0x03
-
-  uint16_t BrakePressure;           // Brake Pressure
-  uint16_t ThrottleADC;             // Analog Throttle Position
-  uint16_t Steering;                // Steering Angle
-  uint16_t RPM;                     // Engine RPM
-  uint16_t ThrottlePosSensor;       // Throttle Position from ECU
-  uint16_t Lambda;                  // Lambda
-
-} LoRa_Engine_Data_Packet;
-
-/**
- * @brief 10 Hz packet with ID 0x04
- * @note  Contains Oil Pressure, Front and Rear Brake Temp, and Accelerometer values
- */
-typedef struct {
-  const uint8_t PacketID;           // ID = 0x04
-
-  uint16_t OilPressure;             // Oil Pressure
-  uint16_t FrontBrakeTemp;          // Front Right Brake Temp (F)
-  uint16_t RearBrakeTemp;           // Rear Right Brake Temp (F)
-  uint16_t AccelX;                  // Accelerometer X Axis
-  uint16_t AccelZ;                  // Accelerometer Z Axis
-  uint16_t AccelY;                  // Accelerometer Y Axis
-
-} LoRa_Brakes_Accel_Packet;
-
-/**
- * @brief 1 Hz packet with ID 0x05
- * @note  Contains Air and Coolant Temp
- */
-typedef struct {
-  const uint8_t PacketID;           // ID = 0x05
-
-  uint16_t AirTemp;                 // Air Temp (F)
-  uint16_t CoolTemp;                // Coolant Temp (F)
-
-} LoRa_Temperature_Packet;
+// LoRa packet structs are generated from the wire schema in lora_schema.h
 
 /**
  * @brief Telemetry Struct to hold all Telemetry Data
@@ -195,10 +126,18 @@ void Status_LED();
 
 /**
  * @brief Thread for handling CAN communication
- * @note Handles CAN RX with interrupts and FreeRTOS Queues
+ * @note Drains the CAN RX ring after a task notification from the RX ISRs
+ * @note With CAN_CAPTURE every frame is also logged to the SD card
+ * @note Frames on ISOTP_RX_ID are passed to Offload_Task
  */
 void CAN_Task();
 
+/**
+ * @brief Thread serving SD card log downloads over ISO-TP
+ * @note Lowest priority, only busy while a tester is connected
+ */
+void Offload_Task();
+
 /**
  * @brief Thread for handling GPS communication
  * @note TODO: Implement GPS Task
@@ -207,6 +146,8 @@ void GPS_Task();
 
 /**
  * @brief Thread for send the Telemetry Struct over LoRa
+ * @note Packet rates come from the loraPackets table in main.c
+ * @note With LORA_RECEIVER it forwards received frames instead, see lora_link.h
  */
 void Lora_Task();
  
@@ -222,36 +163,6 @@ void ADC_Task();
  */
 void Thermocouple_Task();
 
-/**
- * @brief Send Suspension Data over LoRa
- * @note Packet ID 0x01 @ 50 Hz
- */
-void LoRa_Suspension_Task();
-
-/**
- * @brief Send GPS Data over LoRa
- * @note Packet ID 0x02 @ 25 Hz
- */
-void LoRa_GPS_Task();
-
-/**
- * @brief Send Engine Data over LoRa
- * @note Packet ID 0x03 @ 20 Hz
- */
-void LoRa_Engine_Data_Task();
-
-/**
- * @brief Send Brake and Acceleration Data over LoRa
- * @note Packet ID 0x04 @ 10 Hz
- */
-void LoRa_Brakes_Accel_Task();
-
-/**
- * @brief Send Temperature Data over LoRa
- * @note Packet ID 0x05 @ 1 Hz
- */
-void LoRa_Temperature_Task();
-
 /**
  * @brief Thread for collecting system statistics
  * @note Build with make STATS=1 to enable
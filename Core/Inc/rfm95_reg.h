@@ -4,7 +4,8 @@
 * @date    6/2024
 * 
 * @brief   RFM95 Register Address Definitions
-* @note    Addresses are for LoRa Mode
+* @note    Addresses are for LoRa Mode, FSK Mode registers of the same
+*          page (0x02-0x05, 0x0D-0x3F) follow at the end
 ***********************************************/
 
 
@@ -80,6 +81,9 @@
 #define RegOpMode_LowFrequencyModeOn_Pos                (3u)
 #define RegOpMode_LowFrequencyModeOn_Msk                (0x1 << RegOpMode_LowFrequencyModeOn_Pos)
 #define RegOpMode_LowFrequencyModeOn                    RegOpMode_LowFrequencyModeOn_Msk
+#define RegOpMode_ModulationType_Pos                    (5u)
+#define RegOpMode_ModulationType_Msk                    (0x3u << RegOpMode_ModulationType_Pos)
+#define RegOpMode_ModulationType                        RegOpMode_ModulationType_Msk
 #define RegOpMode_AccessSharedReg_Pos                   (6u)
 #define RegOpMode_AccessSharedReg_Msk                   (0x1 << RegOpMode_AccessSharedReg_Pos)
 #define RegOpMode_AccessSharedReg                       RegOpMode_AccessSharedReg_Msk
@@ -349,9 +353,139 @@
 #define RegModemConfig3_LowDataRateOpt_Msk              (0x1u << RegModemConfig3_LowDataRateOpt_Pos)
 #define RegModemConfig3_LowDataRateOpt                  RegModemConfig3_LowDataRateOpt_Msk
 
+/*********************  RegDioMapping1  **********************/
+#define RegDioMapping1_Dio0Mapping_Pos                  (6u)
+#define RegDioMapping1_Dio0Mapping_Msk                  (0x3u << RegDioMapping1_Dio0Mapping_Pos)
+#define RegDioMapping1_Dio0Mapping                      RegDioMapping1_Dio0Mapping_Msk
+
+#define RegDioMapping1_Dio0_RxDone                      (0x0u << RegDioMapping1_Dio0Mapping_Pos)
+#define RegDioMapping1_Dio0_TxDone                      (0x1u << RegDioMapping1_Dio0Mapping_Pos)
+#define RegDioMapping1_Dio0_CadDone                     (0x2u << RegDioMapping1_Dio0Mapping_Pos)
+
 /*********************  RegPaDac  **********************/
 #define RegPaDac_PaDac_Pos                              (0u)
 #define RegPaDac_PaDac_Msk                              (0x7u << RegPaDac_PaDac_Pos)
 #define RegPaDac_PaDac                                  RegPaDac_PaDac_Msk
 
 #define RegPaDac_20dBm                                  0x87
+
+/******************  FSK Mode Register Memory Address Macros  *******************/
+#define RegBitrateMsb                                   (0x02u)
+#define RegBitrateLsb                                   (0x03u)
+#define RegFdevMsb                                      (0x04u)
+#define RegFdevLsb                                      (0x05u)
+#define RegRxConfig                                     (0x0Du)
+#define RegRxBw                                         (0x12u)
+#define RegAfcBw                                        (0x13u)
+#define RegPreambleDetect                               (0x1Fu)
+#define RegPreambleMsbFsk                               (0x25u)
+#define RegPreambleLsbFsk                               (0x26u)
+#define RegSyncConfig                                   (0x27u)
+#define RegSyncValue1                                   (0x28u)
+#define RegPacketConfig1                                (0x30u)
+#define RegPacketConfig2                                (0x31u)
+#define RegPayloadLengthFsk                             (0x32u)
+#define RegFifoThresh                                   (0x35u)
+#define RegIrqFlags1                                    (0x3Eu)
+#define RegIrqFlags2                                    (0x3Fu)
+
+/*********************  RegPaRamp FSK  **********************/
+#define RegPaRamp_ModulationShaping_Pos                 (5u)
+#define RegPaRamp_ModulationShaping_Msk                 (0x3u << RegPaRamp_ModulationShaping_Pos)
+#define RegPaRamp_ModulationShaping                     RegPaRamp_ModulationShaping_Msk
+
+#define RegPaRamp_Gaussian_1_0                          (0x1u << RegPaRamp_ModulationShaping_Pos)
+#define RegPaRamp_40us                                  (0x9u << RegPaRamp_PaRamp_Pos)
+
+/*********************  RegRxConfig  **********************/
+#define RegRxConfig_RxTrigger_Pos                       (0u)
+#define RegRxConfig_RxTrigger_Msk                       (0x7u << RegRxConfig_RxTrigger_Pos)
+#define RegRxConfig_RxTrigger                           RegRxConfig_RxTrigger_Msk
+#define RegRxConfig_AgcAutoOn_Pos                       (3u)
+#define RegRxConfig_AgcAutoOn_Msk                       (0x1u << RegRxConfig_AgcAutoOn_Pos)
+#define RegRxConfig_AgcAutoOn                           RegRxConfig_AgcAutoOn_Msk
+#define RegRxConfig_AfcAutoOn_Pos                       (4u)
+#define RegRxConfig_AfcAutoOn_Msk                       (0x1u << RegRxConfig_AfcAutoOn_Pos)
+#define RegRxConfig_AfcAutoOn                           RegRxConfig_AfcAutoOn_Msk
+
+#define RegRxConfig_RxTrigger_Preamble                  (0x6u << RegRxConfig_RxTrigger_Pos)
+
+/*********************  RegRxBw  **********************/
+#define RegRxBw_RxBwExp_Pos                             (0u)
+#define RegRxBw_RxBwExp_Msk                             (0x7u << RegRxBw_RxBwExp_Pos)
+#define RegRxBw_RxBwExp                                 RegRxBw_RxBwExp_Msk
+#define RegRxBw_RxBwMant_Pos                            (3u)
+#define RegRxBw_RxBwMant_Msk                            (0x3u << RegRxBw_RxBwMant_Pos)
+#define RegRxBw_RxBwMant                                RegRxBw_RxBwMant_Msk
+
+#define RegRxBw_250kHz                                  (0x1u << RegRxBw_RxBwExp_Pos) // Mant 16, Exp 1
+
+/*********************  RegPreambleDetect  **********************/
+#define RegPreambleDetect_Tol_Pos                       (0u)
+#define RegPreambleDetect_Tol_Msk                       (0x1Fu << RegPreambleDetect_Tol_Pos)
+#define RegPreambleDetect_Tol                           RegPreambleDetect_Tol_Msk
+#define RegPreambleDetect_Size_Pos                      (5u)
+#define RegPreambleDetect_Size_Msk                      (0x3u << RegPreambleDetect_Size_Pos)
+#define RegPreambleDetect_Size                          RegPreambleDetect_Size_Msk
+#define RegPreambleDetect_On_Pos                        (7u)
+#define RegPreambleDetect_On_Msk                        (0x1u << RegPreambleDetect_On_Pos)
+#define RegPreambleDetect_On                            RegPreambleDetect_On_Msk
+
+/*********************  RegSyncConfig  **********************/
+#define RegSyncConfig_SyncSize_Pos                      (0u)
+#define RegSyncConfig_SyncSize_Msk                      (0x7u << RegSyncConfig_SyncSize_Pos)
+#define RegSyncConfig_SyncSize                          RegSyncConfig_SyncSize_Msk
+#define RegSyncConfig_SyncOn_Pos                        (4u)
+#define RegSyncConfig_SyncOn_Msk                        (0x1u << RegSyncConfig_SyncOn_Pos)
+#define RegSyncConfig_SyncOn                            RegSyncConfig_SyncOn_Msk
+#define RegSyncConfig_AutoRestartRxMode_Pos             (6u)
+#define RegSyncConfig_AutoRestartRxMode_Msk             (0x3u << RegSyncConfig_AutoRestartRxMode_Pos)
+#define RegSyncConfig_AutoRestartRxMode                 RegSyncConfig_AutoRestartRxMode_Msk
+
+#define RegSyncConfig_AutoRestartRx_NoPll               (0x1u << RegSyncConfig_AutoRestartRxMode_Pos)
+
+/*********************  RegPacketConfig1  **********************/
+#define RegPacketConfig1_CrcAutoClearOff_Pos            (3u)
+#define RegPacketConfig1_CrcAutoClearOff_Msk            (0x1u << RegPacketConfig1_CrcAutoClearOff_Pos)
+#define RegPacketConfig1_CrcAutoClearOff                RegPacketConfig1_CrcAutoClearOff_Msk
+#define RegPacketConfig1_CrcOn_Pos                      (4u)
+#define RegPacketConfig1_CrcOn_Msk                      (0x1u << RegPacketConfig1_CrcOn_Pos)
+#define RegPacketConfig1_CrcOn                          RegPacketConfig1_CrcOn_Msk
+#define RegPacketConfig1_DcFree_Pos                     (5u)
+#define RegPacketConfig1_DcFree_Msk                     (0x3u << RegPacketConfig1_DcFree_Pos)
+#define RegPacketConfig1_DcFree                         RegPacketConfig1_DcFree_Msk
+#define RegPacketConfig1_PacketFormat_Pos               (7u)
+#define RegPacketConfig1_PacketFormat_Msk               (0x1u << RegPacketConfig1_PacketFormat_Pos)
+#define RegPacketConfig1_PacketFormat                   RegPacketConfig1_PacketFormat_Msk
+
+#define RegPacketConfig1_DcFree_Whitening               (0x2u << RegPacketConfig1_DcFree_Pos)
+
+/*********************  RegPacketConfig2  **********************/
+#define RegPacketConfig2_DataMode_Pos                   (6u)
+#define RegPacketConfig2_DataMode_Msk                   (0x1u << RegPacketConfig2_DataMode_Pos)
+#define RegPacketConfig2_DataMode                       RegPacketConfig2_DataMode_Msk
+
+/*********************  RegFifoThresh  **********************/
+#define RegFifoThresh_FifoThreshold_Pos                 (0u)
+#define RegFifoThresh_FifoThreshold_Msk                 (0x3Fu << RegFifoThresh_FifoThreshold_Pos)
+#define RegFifoThresh_FifoThreshold                     RegFifoThresh_FifoThreshold_Msk
+#define RegFifoThresh_TxStartCondition_Pos              (7u)
+#define RegFifoThresh_TxStartCondition_Msk              (0x1u << RegFifoThresh_TxStartCondition_Pos)
+#define RegFifoThresh_TxStartCondition                  RegFifoThresh_TxStartCondition_Msk
+
+/*********************  RegIrqFlags2  **********************/
+#define RegIrqFlags2_CrcOk_Pos                          (1u)
+#define RegIrqFlags2_CrcOk_Msk                          (0x1u << RegIrqFlags2_CrcOk_Pos)
+#define RegIrqFlags2_CrcOk                              RegIrqFlags2_CrcOk_Msk
+#define RegIrqFlags2_PayloadReady_Pos                   (2u)
+#define RegIrqFlags2_PayloadReady_Msk                   (0x1u << RegIrqFlags2_PayloadReady_Pos)
+#define RegIrqFlags2_PayloadReady                       RegIrqFlags2_PayloadReady_Msk
+#define RegIrqFlags2_PacketSent_Pos                     (3u)
+#define RegIrqFlags2_PacketSent_Msk                     (0x1u << RegIrqFlags2_PacketSent_Pos)
+#define RegIrqFlags2_PacketSent                         RegIrqFlags2_PacketSent_Msk
+#define RegIrqFlags2_FifoOverrun_Pos                    (4u)
+#define RegIrqFlags2_FifoOverrun_Msk                    (0x1u << RegIrqFlags2_FifoOverrun_Pos)
+#define RegIrqFlags2_FifoOverrun                        RegIrqFlags2_FifoOverrun_Msk
+
+/*********************  RegDioMapping1 FSK  **********************/
+#define RegDioMapping1_Dio0_PacketSent                  (0x0u << RegDioMapping1_Dio0Mapping_Pos) // PayloadReady in RX
@@ -6,44 +6,73 @@
 * @brief   Prototype Functions for SPI Driver
 ***********************************************/
 
+#ifndef SPI_H
+#define SPI_H
+
 #include "stm32f415xx.h"
 #include <stdint.h>
 #include <stddef.h>
 
 /* Macros -------------------------------------------------------------------*/
+#define SPI2_CS_PIN                 12 // PB12, chip select driven by the transfer engine
+#define SPI_DMA_MIN_LEN             8 // Shorter transfers are polled, DMA setup costs more
+#define SPI_DMA_TIMEOUT             10 // Ticks to wait for a DMA transfer
+#define SPI_DMA_IRQ_PRIORITY        13 // Must not be above configMAX_SYSCALL_INTERRUPT_PRIORITY
+
+// Transfer flags
+#define SPI_CS_HOLD                 (0x1u) // Leave CS low after the transfer, for a header then payload
+
 /* Structs and Enums --------------------------------------------------------*/
 typedef enum {
     SPI_ERROR,
     SPI_OK,
+    SPI_BUSY,
 } SPI_Status;
 
+/**
+ * @brief Called from the DMA interrupt when a transfer ends
+ * 
+ * @param status [SPI_Status] SPI_OK, or SPI_ERROR on a DMA transfer error
+ * @param context [void*] Pointer given to SPI2_Transfer_Start
+ */
+typedef void (*SPI_Callback)(SPI_Status status, void* context);
+
 /* Function Prototypes ------------------------------------------------------*/
 
 /**
  * @brief Initialize SPI2
  * @note CPOL = 0, CPHA = 0, MSB First, 8-bit Data Frame
  * @note Written to be used with RFM95W
+ * @note SPI2 stays enabled, DMA1 Stream 3 (RX) and Stream 4 (TX) on channel 0
  */
 void SPI2_Init();
 
 /**
- * @brief Transmit data over SPI
- * @note Blocking/Polling Call
+ * @brief Start a full duplex DMA transfer on SPI2
+ * @note CS is driven low here and released in the interrupt unless SPI_CS_HOLD is set
  * 
- * @param SPI [SPI_TypeDef*] SPI Peripheral to use
- * @param data [uint8_t*] Data buffer to send
- * @param len [size_t] Length of data buffer
- * @return SPI_Status 
+ * @param tx [const uint8_t*] Bytes to send, NULL to clock out zeros
+ * @param rx [uint8_t*] Buffer for received bytes, NULL to discard them
+ * @param len [size_t] Bytes to transfer, up to 65535
+ * @param flags [uint8_t] SPI_CS_HOLD or 0
+ * @param callback [SPI_Callback] Run from the interrupt on completion, may be NULL
+ * @param context [void*] Passed to callback
+ * @return SPI_Status SPI_BUSY if a transfer is already running
  */
-SPI_Status SPI_Transmit(SPI_TypeDef* SPI, uint8_t* data, size_t len);
+SPI_Status SPI2_Transfer_Start(const uint8_t* tx, uint8_t* rx, size_t len, uint8_t flags,
+    SPI_Callback callback, void* context);
 
 /**
- * @brief Receive data over SPI
- * @note Blocking/Polling Call
+ * @brief Full duplex transfer on SPI2, blocking the calling task
+ * @note Uses DMA and sleeps on a semaphore for SPI_DMA_MIN_LEN bytes and up,
+ *       polls shorter transfers and anything before the scheduler starts
  * 
- * @param SPI [SPI_TypeDef*] SPI Peripheral to use
- * @param buf [uint8_t*] Buffer to read into
- * @param len [size_t] Length of buffer
+ * @param tx [const uint8_t*] Bytes to send, NULL to clock out zeros
+ * @param rx [uint8_t*] Buffer for received bytes, NULL to discard them
+ * @param len [size_t] Bytes to transfer
+ * @param flags [uint8_t] SPI_CS_HOLD or 0
  * @return SPI_Status 
  */
-SPI_Status SPI_Receive(SPI_TypeDef* SPI, uint8_t* buf, size_t len);
\ No newline at end of file
+SPI_Status SPI2_Transfer(const uint8_t* tx, uint8_t* rx, size_t len, uint8_t flags);
+
+#endif /* SPI_H */
@@ -17,7 +17,7 @@ void TIM2_Init();
 
 /**
  * @brief Configure Timer for Run Time Stats
- * 
+ * @note Free running 1MHz counter, also used as the system microsecond timebase
  */
 void Timer_Stat_Init();
 
@@ -6,7 +6,21 @@
 * @brief   UART Function Prototypes
 ***********************************************/
 
+#ifndef UART_H
+#define UART_H
+
 #include "stm32f415xx.h"
+#include <stdint.h>
+
+#define USART2_DMA_BAUD             460800 // Baud of USART2 once DMA transmit is set up
+#define USART_DMA_IRQ_PRIORITY      12 // Must not be above configMAX_SYSCALL_INTERRUPT_PRIORITY
+
+/**
+ * @brief Called from the DMA interrupt when a transmit ends
+ * 
+ * @param context [void*] Pointer given to USART2_DMA_Send
+ */
+typedef void (*USART_Callback)(void* context);
 
 /**
  * @brief Initialize USART2
@@ -35,4 +49,24 @@ void send_Byte(USART_TypeDef* USART, uint8_t byte);
  * @param USART [USART_TypeDef*] USART to use to send message
  * @param string [uint8_t*] String to send
  */
-void send_String(USART_TypeDef* USART, uint8_t *string);
\ No newline at end of file
+void send_String(USART_TypeDef* USART, uint8_t *string);
+
+/**
+ * @brief Switch USART2 to USART2_DMA_BAUD and transmit through DMA
+ * @note Call after USART2_Init, DMA1 Stream 6 on channel 4
+ */
+void USART2_DMA_Init();
+
+/**
+ * @brief Start sending a buffer on USART2 by DMA
+ * @note The buffer must stay untouched until the callback runs
+ * 
+ * @param data [const uint8_t*] Bytes to send
+ * @param len [uint16_t] Bytes in data
+ * @param callback [USART_Callback] Run from the interrupt once the last byte is queued, may be NULL
+ * @param context [void*] Passed to callback
+ * @return uint8_t 1 if started, 0 while the last transmit is still running
+ */
+uint8_t USART2_DMA_Send(const uint8_t* data, uint16_t len, USART_Callback callback, void* context);
+
+#endif /* UART_H */
@@ -7,14 +7,124 @@
 ***********************************************/
 
 #include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
 
 #include "stm32f415xx.h"
 #include "can.h"
+#include "timer.h"
 
 CAN_State CAN1_State;
 
+// TX queue sorted by descending priority key, next frame to send is last
+static CAN_Frame canTXQueue[CAN_TX_QUEUE_SIZE];
+static uint8_t canTXCount;
+static CAN_TX_Stats canTXStats;
+static uint32_t canTXLoadTime[CAN_TX_MAILBOXES]; // TIM2 us when each mailbox was loaded
+
+static CAN_Bus_Stats canBusStats;
+static uint32_t canBusESR; // ESR error state flags last seen
+static volatile uint32_t canBusBits; // Bits seen on the bus, free running
+static volatile uint32_t canBusFrames; // Frames seen on the bus, free running
+
+/* Static Functions ---------------------------------------------------------*/
+
+/**
+ * @brief Copy a frame out of a receive FIFO mailbox and release it
+ * @note Leaves the timestamp to the caller, the ISR reads TIM2 once per drain
+ * 
+ * @param CAN [CAN_TypeDef*] CAN Peripheral to read from
+ * @param fifo [uint8_t] FIFO (0 or 1) to read from
+ * @param frame [CAN_Frame*] Frame to fill
+ */
+static void CAN_Read_FIFO(CAN_TypeDef* CAN, uint8_t fifo, CAN_Frame* frame) {
+    uint32_t rir = CAN->sFIFOMailBox[fifo].RIR;
+    uint32_t rdlr = CAN->sFIFOMailBox[fifo].RDLR;
+    uint32_t rdhr = CAN->sFIFOMailBox[fifo].RDHR;
+
+    frame->id = (rir & CAN_RI0R_STID_Msk) >> CAN_RI0R_STID_Pos;
+    frame->rtr = (rir & CAN_RI0R_RTR) ? CAN_RTR_Remote : CAN_RTR_Data;
+    frame->dlc = (CAN->sFIFOMailBox[fifo].RDTR & CAN_RDT0R_DLC_Msk) >> CAN_RDT0R_DLC_Pos;
+    for (int i = 0; i < 4; i++) {
+        frame->data[i] = (rdlr >> (i * 8)) & 0xFF;
+        frame->data[i + 4] = (rdhr >> (i * 8)) & 0xFF;
+    }
+
+    // Release the FIFO output mailbox
+    if (fifo == 0) {
+        CAN->RF0R = CAN_RF0R_RFOM0;
+    }
+    else {
+        CAN->RF1R = CAN_RF1R_RFOM1;
+    }
+}
+
+/**
+ * @brief Move every pending frame of a FIFO into the RX ring
+ * @note Both RX ISRs run at the same priority so they never preempt
+ *       each other, which keeps the ring single producer
+ * 
+ * @param fifo [uint8_t] FIFO (0 or 1) to drain
+ * @param pending [volatile uint32_t*] RFxR register of the FIFO
+ * @note RF0R and RF1R share the same bit layout
+ */
+static void CAN_RX_Drain_FIFO(uint8_t fifo, volatile uint32_t* pending) {
+    // Latch once on entry, the first frame raised the interrupt
+    uint32_t timestamp = Get_Timer_Count();
+
+    // Hardware FIFO overflowed before we got here
+    if (*pending & CAN_RF0R_FOVR0) {
+        *pending = CAN_RF0R_FOVR0;
+        canBusStats.fifoOverruns[fifo]++;
+    }
+
+    while (*pending & CAN_RF0R_FMP0) {
+        canBusBits += CAN_FRAME_BITS((CAN1->sFIFOMailBox[fifo].RDTR & CAN_RDT0R_DLC_Msk) >> CAN_RDT0R_DLC_Pos);
+        canBusFrames++;
+
+        CAN_Frame* frame = CAN_RX_Reserve();
+        if (frame == NULL) {
+            // Ring full, drop the frame but keep the FIFO moving
+            *pending = CAN_RF0R_RFOM0;
+            continue;
+        }
+        CAN_Read_FIFO(CAN1, fifo, frame);
+        frame->timestamp = timestamp;
+        CAN_RX_Commit();
+    }
+
+    CAN_RX_Publish();
+}
+
+/**
+ * @brief Count entries into each error state and returns from bus-off
+ * @note Caller must hold a critical section or be the SCE ISR. Leaving
+ *       bus-off raises no interrupt, so the stats task checks too.
+ * 
+ * @param esr [uint32_t] Current ESR value
+ */
+static void CAN_Track_Error_State(uint32_t esr) {
+    uint32_t rising = esr & ~canBusESR;
+
+    // Count entries into each error state, not every interrupt while in it
+    if (rising & CAN_ESR_EWGF) {
+        canBusStats.errorWarning++;
+    }
+    if (rising & CAN_ESR_EPVF) {
+        canBusStats.errorPassive++;
+    }
+    if (rising & CAN_ESR_BOFF) {
+        canBusStats.busOff++;
+    }
+    if ((canBusESR & CAN_ESR_BOFF) && !(esr & CAN_ESR_BOFF)) {
+        canBusStats.busOffRecoveries++;
+    }
+    canBusESR = esr & (CAN_ESR_EWGF | CAN_ESR_EPVF | CAN_ESR_BOFF);
+}
+
 /**
  * @brief Find an empty CAN Transmit mailbox
+ * @note Only valid while at least one TMEx bit is set
  * 
  * @return [uint8_t] Index of Empty Mailbox 
  */
@@ -22,6 +132,74 @@ static uint8_t Get_Empty_Mailbox() {
     return (CAN1->TSR & CAN_TSR_CODE_Msk) >> CAN_TSR_CODE_Pos;
 }
 
+/**
+ * @brief Check if any CAN1 transmit mailbox is empty
+ * 
+ * @return [bool] True if a mailbox can be loaded
+ */
+static bool Mailbox_Available() {
+    return (CAN1->TSR & (CAN_TSR_TME0 | CAN_TSR_TME1 | CAN_TSR_TME2)) != 0;
+}
+
+/**
+ * @brief Load a frame into a transmit mailbox and request transmission
+ * 
+ * @param CAN [CAN_TypeDef*] CAN Peripheral to use
+ * @param mailbox [uint8_t] Empty mailbox index
+ * @param frame [const CAN_Frame*] Frame to transmit
+ */
+static void CAN_Load_Mailbox(CAN_TypeDef* CAN, uint8_t mailbox, const CAN_Frame* frame) {
+    // Set ID, DLC, Frame Type, and Data
+    CAN->sTxMailBox[mailbox].TIR = (frame->id << CAN_TI0R_STID_Pos)
+                                    | (frame->rtr << CAN_TI0R_RTR_Pos);
+    CAN->sTxMailBox[mailbox].TDTR = (frame->dlc << CAN_TDT0R_DLC_Pos);
+    CAN->sTxMailBox[mailbox].TDLR = (frame->data[0] << CAN_TDL0R_DATA0_Pos) 
+                                    | (frame->data[1] << CAN_TDL0R_DATA1_Pos)
+                                    | (frame->data[2] << CAN_TDL0R_DATA2_Pos) 
+                                    | (frame->data[3] << CAN_TDL0R_DATA3_Pos);
+    CAN->sTxMailBox[mailbox].TDHR = (frame->data[4] << CAN_TDH0R_DATA4_Pos) 
+                                    | (frame->data[5] << CAN_TDH0R_DATA5_Pos) 
+                                    | (frame->data[6] << CAN_TDH0R_DATA6_Pos) 
+                                    | (frame->data[7] << CAN_TDH0R_DATA7_Pos);
+    // Request Transmission
+    canTXLoadTime[mailbox] = Get_Timer_Count();
+    CAN->sTxMailBox[mailbox].TIR |= CAN_TI0R_TXRQ;
+}
+
+/**
+ * @brief Check if a frame with the given ID is already waiting in a mailbox
+ * @note Equal IDs in two mailboxes leave in mailbox order, not queue order
+ * 
+ * @param id [uint16_t] 11-bit ID
+ * @return [bool] True if a pending mailbox holds this ID
+ */
+static bool Mailbox_Pending_ID(uint16_t id) {
+    static const uint32_t tme[CAN_TX_MAILBOXES] = { CAN_TSR_TME0, CAN_TSR_TME1, CAN_TSR_TME2 };
+    uint32_t tsr = CAN1->TSR;
+
+    for (uint8_t i = 0; i < CAN_TX_MAILBOXES; i++) {
+        if (!(tsr & tme[i]) &&
+            ((CAN1->sTxMailBox[i].TIR & CAN_TI0R_STID_Msk) >> CAN_TI0R_STID_Pos) == id) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Move queued frames into every empty mailbox
+ * @note Caller must hold a critical section or be the TX ISR
+ * @note Holds back a frame while one with the same ID is pending so
+ *       segmented transfers such as ISO-TP stay in order
+ */
+static void CAN_TX_Fill_Mailboxes() {
+    while (canTXCount > 0 && Mailbox_Available() &&
+           !Mailbox_Pending_ID(canTXQueue[canTXCount - 1].id)) {
+        canTXCount--;
+        CAN_Load_Mailbox(CAN1, Get_Empty_Mailbox(), &canTXQueue[canTXCount]);
+    }
+}
+
 CAN_Status CAN1_Init() {
 
     // Setup CAN Clocks
@@ -47,12 +225,24 @@ CAN_Status CAN1_Init() {
     CAN1_State = CAN_State_Initialization;
 
     // Configure CAN1 Settings
-    CAN1->MCR &= ~CAN_MCR_TXFP & ~CAN_MCR_RFLM & ~CAN_MCR_TTCM 
-                & ~CAN_MCR_ABOM & ~CAN_MCR_TXFP;
-    CAN1->MCR |= CAN_MCR_AWUM | CAN_MCR_NART | CAN_MCR_DBF;
-
-    // Enable RX Interrupts
-    CAN1->IER |= CAN_IER_FMPIE0 | CAN_IER_FMPIE1;
+    CAN1->MCR &= ~CAN_MCR_TXFP & ~CAN_MCR_RFLM & ~CAN_MCR_TTCM;
+    // Leave bus-off by itself after 128 x 11 recessive bits, otherwise CAN stays off until reset
+    CAN1->MCR |= CAN_MCR_ABOM;
+    CAN1->MCR &= ~CAN_MCR_NART; // Retransmit until success, a lost frame breaks ISO-TP
+    // Unacknowledged frames are aborted after CAN_TX_TIMEOUT, see CAN_TX_Abort_Stale
+    CAN1->MCR |= CAN_MCR_AWUM | CAN_MCR_DBF;
+
+    // Enable RX, FIFO Overrun and TX Mailbox Empty Interrupts
+    CAN1->IER |= CAN_IER_FMPIE0 | CAN_IER_FMPIE1 | CAN_IER_TMEIE
+                | CAN_IER_FOVIE0 | CAN_IER_FOVIE1;
+
+    // Enable Error Interrupts
+    CAN1->IER |= CAN_IER_ERRIE | CAN_IER_EWGIE | CAN_IER_EPVIE
+                | CAN_IER_BOFIE | CAN_IER_LECIE;
+    NVIC_EnableIRQ(CAN1_SCE_IRQn); // Enable Status Change Error Interrupt
+    NVIC_SetPriority(CAN1_SCE_IRQn, 15); // Set SCE Interrupt Priority
+    NVIC_EnableIRQ(CAN1_TX_IRQn); // Enable TX Interrupt
+    NVIC_SetPriority(CAN1_TX_IRQn, 15); // Set TX Interrupt Priority
     NVIC_EnableIRQ(CAN1_RX0_IRQn); // Enable RX0 Interrupt
     NVIC_EnableIRQ(CAN1_RX1_IRQn); // Enable RX1 Interrupt
     NVIC_SetPriority(CAN1_RX0_IRQn, 15); // Set RX0 Interrupt Priority
@@ -69,33 +259,27 @@ CAN_Status CAN1_Init() {
     return CAN_OK;
 }
 
-CAN_Status CAN_Filters_Init() {
-    if (CAN1_State != CAN_State_Initialization) {
+CAN_Status CAN_Filters_Init(const CAN_Filter_Config* config) {
+    if (CAN1_State != CAN_State_Initialization || config == NULL) {
         return CAN_Error;
     }
 
     CAN1->FMR |= CAN_FMR_FINIT; // Enter Filter Initialization Mode
     CAN1->FMR &= ~CAN_FMR_CAN2SB_Msk; 
-    CAN1->FMR |= (28UL << CAN_FMR_CAN2SB_Pos); // Set Filter Start Bank to 0
-
-    CAN1->FM1R |= CAN_FM1R_FBM_Msk; // Set Filters to ID mode
-    CAN1->FS1R &= ~CAN_FS1R_FSC_Msk ; // Set Filters to Dual 16-bit mode
-
-    // Create Filters for IDs and set masks to match IDs
-    CAN1->sFilterRegister[0].FR1 = 0x048 << CAN_F0R1_FB5_Pos;
-    CAN1->FFA1R &= ~CAN_FFA1R_FFA0; // Set Filter 0 to FIFO 0
+    CAN1->FMR |= (28UL << CAN_FMR_CAN2SB_Pos); // Give all 28 Filter Banks to CAN1
 
-    CAN1->sFilterRegister[0].FR1 |= 0x148 << CAN_F0R1_FB21_Pos;
-    CAN1->FFA1R |= CAN_FFA1R_FFA1; // Set Filter 1 to FIFO 1
+    CAN1->FA1R &= ~CAN_FA1R_FACT_Msk; // Disable all Filters while writing
+    CAN1->FM1R = config->fm1r; // Set List or Mask mode per Bank
+    CAN1->FS1R = config->fs1r; // Set Dual 16-bit mode
+    CAN1->FFA1R = config->ffa1r; // Set FIFO per Bank
 
-    CAN1->sFilterRegister[1].FR1 = 0x248 << CAN_F0R1_FB9_Pos;
-    CAN1->FFA1R |= CAN_FFA1R_FFA2; // Set Filter 2 to FIFO 1
-
-    CAN1->sFilterRegister[1].FR1 |= 0x548 << CAN_F0R1_FB21_Pos;
-    CAN1->FFA1R |= CAN_FFA1R_FFA2; // Set Filter 2 to FIFO 1
+    for (uint8_t bank = 0; bank < config->banks; bank++) {
+        CAN1->sFilterRegister[bank].FR1 = config->fr1[bank];
+        CAN1->sFilterRegister[bank].FR2 = config->fr2[bank];
+    }
 
     // Enable Filters
-    CAN1->FA1R |= CAN_FA1R_FACT0 | CAN_FA1R_FACT1;
+    CAN1->FA1R = config->fa1r;
     CAN1->FMR &= ~CAN_FMR_FINIT; // Exit Filter Initialization Mode
     return CAN_OK;
 }
@@ -121,35 +305,89 @@ CAN_Status CAN_Stop() {
     return CAN_OK;
 }
 
-CAN_Status CAN_Transmit(CAN_TypeDef* CAN, CAN_Frame* frame) {
-    // Basic Type Checking
-    if (CAN == NULL || frame == NULL ||
-        CAN1_State != CAN_State_Normal) {
+CAN_Status CAN_Transmit_Async(const CAN_Frame* frame) {
+    if (frame == NULL || CAN1_State != CAN_State_Normal) {
         return CAN_Error;
     }
 
-    volatile uint8_t mailbox = Get_Empty_Mailbox();
+    taskENTER_CRITICAL();
+    if (canTXCount >= CAN_TX_QUEUE_SIZE) {
+        canTXStats.rejected++;
+        taskEXIT_CRITICAL();
+        return CAN_Mailbox_Error;
+    }
 
-    // Clear the mailbox register
-    CAN->sTxMailBox[mailbox].TIR = 0x0UL; 
+    // Insert behind every frame of equal or higher priority so equal IDs stay FIFO
+    uint8_t pos = canTXCount;
+    while (pos > 0 && canTXQueue[pos - 1].id < frame->id) {
+        pos--;
+    }
+    while (pos > 0 && canTXQueue[pos - 1].id == frame->id) {
+        pos--;
+    }
+    memmove(&canTXQueue[pos + 1], &canTXQueue[pos], (canTXCount - pos) * sizeof(CAN_Frame));
+    canTXQueue[pos] = *frame;
+    canTXCount++;
 
-    // Set ID, DLC, Frame Type, and Data
-    CAN->sTxMailBox[mailbox].TIR |= (frame->id << CAN_TI0R_STID_Pos)
-                                    | (frame->rtr << CAN_TI0R_RTR_Pos);
-    CAN->sTxMailBox[mailbox].TDTR |= (frame->dlc << CAN_TDT0R_DLC_Pos);
-    CAN->sTxMailBox[mailbox].TDLR = (frame->data[0] << CAN_TDL0R_DATA0_Pos) 
-                                    | (frame->data[1] << CAN_TDL0R_DATA1_Pos)
-                                    | (frame->data[2] << CAN_TDL0R_DATA2_Pos) 
-                                    | (frame->data[3] << CAN_TDL0R_DATA3_Pos);
-    CAN->sTxMailBox[mailbox].TDHR = (frame->data[4] << CAN_TDH0R_DATA4_Pos) 
-                                    | (frame->data[5] << CAN_TDH0R_DATA5_Pos) 
-                                    | (frame->data[6] << CAN_TDH0R_DATA6_Pos) 
-                                    | (frame->data[7] << CAN_TDH0R_DATA7_Pos);
-    // Request Transmission
-    CAN->sTxMailBox[mailbox].TIR |= CAN_TI0R_TXRQ;
+    canTXStats.queued++;
+    if (canTXCount > canTXStats.highWater) {
+        canTXStats.highWater = canTXCount;
+    }
+
+    // Mailbox empty interrupt only fires on completion, so kick idle mailboxes here
+    CAN_TX_Fill_Mailboxes();
+    taskEXIT_CRITICAL();
     return CAN_TX_Req;
 }
 
+void CAN_TX_Abort_Stale() {
+    static const uint32_t tme[CAN_TX_MAILBOXES] = { CAN_TSR_TME0, CAN_TSR_TME1, CAN_TSR_TME2 };
+    static const uint32_t abrq[CAN_TX_MAILBOXES] = { CAN_TSR_ABRQ0, CAN_TSR_ABRQ1, CAN_TSR_ABRQ2 };
+
+    taskENTER_CRITICAL();
+    uint32_t tsr = CAN1->TSR;
+    uint32_t now = Get_Timer_Count();
+    for (uint8_t i = 0; i < CAN_TX_MAILBOXES; i++) {
+        if (!(tsr & tme[i]) && !(tsr & abrq[i]) && (now - canTXLoadTime[i]) > CAN_TX_TIMEOUT) {
+            CAN1->TSR = abrq[i]; // Completes with RQCP set and TXOK clear
+            canTXStats.timeouts++;
+        }
+    }
+    taskEXIT_CRITICAL();
+}
+
+void CAN_Get_TX_Stats(CAN_TX_Stats* stats) {
+    taskENTER_CRITICAL();
+    *stats = canTXStats;
+    taskEXIT_CRITICAL();
+}
+
+void CAN_Stats_Update() {
+    static uint32_t lastBits;
+    static uint32_t lastFrames;
+    uint32_t bits = canBusBits;
+    uint32_t frames = canBusFrames;
+
+    // Read ESR inside the critical section so the SCE ISR cannot see a newer state first
+    taskENTER_CRITICAL();
+    uint32_t esr = CAN1->ESR;
+    CAN_Track_Error_State(esr);
+    canBusStats.busLoad = ((uint64_t)(bits - lastBits) * 1000) / CAN_BITRATE;
+    canBusStats.framesPerSecond = frames - lastFrames;
+    canBusStats.tec = (esr & CAN_ESR_TEC_Msk) >> CAN_ESR_TEC_Pos;
+    canBusStats.rec = (esr & CAN_ESR_REC_Msk) >> CAN_ESR_REC_Pos;
+    taskEXIT_CRITICAL();
+
+    lastBits = bits;
+    lastFrames = frames;
+}
+
+void CAN_Get_Bus_Stats(CAN_Bus_Stats* stats) {
+    taskENTER_CRITICAL();
+    *stats = canBusStats;
+    taskEXIT_CRITICAL();
+}
+
 CAN_Status CAN_Receive(CAN_TypeDef* CAN, CAN_Frame* frame) {
     if (CAN == NULL || frame == NULL ||
         CAN1_State != CAN_State_Normal) {
@@ -157,27 +395,13 @@ CAN_Status CAN_Receive(CAN_TypeDef* CAN, CAN_Frame* frame) {
     }
 
     if ((CAN->RF0R & CAN_RF0R_FMP0)) {
-        frame->id = (CAN->sFIFOMailBox[0].RIR & CAN_RI0R_STID_Msk) >> CAN_RI0R_STID_Pos;
-        
-        for (int i = 0; i < 4; i++) {
-            frame->data[i] = (CAN->sFIFOMailBox[0].RDLR >> (i * 8)) & 0xFF;
-        }
-        for (int i = 0; i < 4; i++) {
-            frame->data[i + 4] = (CAN->sFIFOMailBox[0].RDHR >> (i * 8)) & 0xFF;
-        }
-        CAN->RF0R |= CAN_RF0R_RFOM0; // Release FIFO 0
+        CAN_Read_FIFO(CAN, 0, frame);
+        frame->timestamp = Get_Timer_Count();
         return CAN_OK;
     }
     else if ((CAN->RF1R & CAN_RF1R_FMP1)) {
-        frame->id = (CAN->sFIFOMailBox[1].RIR & CAN_RI1R_STID_Msk) >> CAN_RI1R_STID_Pos;
-
-        for (int i = 0; i < 4; i++) {
-            frame->data[i] = (CAN->sFIFOMailBox[1].RDLR >> (i * 8)) & 0xFF;
-        }
-        for (int i = 0; i < 4; i++) {
-            frame->data[i + 4] = (CAN->sFIFOMailBox[1].RDHR >> (i * 8)) & 0xFF;
-        }
-        CAN->RF1R |= CAN_RF1R_RFOM1; // Release FIFO 1
+        CAN_Read_FIFO(CAN, 1, frame);
+        frame->timestamp = Get_Timer_Count();
         return CAN_OK;
     }
     else {
@@ -187,36 +411,49 @@ CAN_Status CAN_Receive(CAN_TypeDef* CAN, CAN_Frame* frame) {
 
 /* Interrupt Handlers -------------------------------------------------------*/
 void CAN1_RX0_IRQHandler() {
-    CAN_Frame rxFrame;
+    CAN_RX_Drain_FIFO(0, &CAN1->RF0R);
+}
 
-    rxFrame.id = (CAN1->sFIFOMailBox[0].RIR & CAN_RI0R_STID_Msk) >> CAN_RI0R_STID_Pos;
-    for (int i = 0; i < 4; i++) {
-        rxFrame.data[i] = (CAN1->sFIFOMailBox[0].RDLR >> (i * 8)) & 0xFF;
-    }
-    for (int i = 0; i < 4; i++) {
-        rxFrame.data[i + 4] = (CAN1->sFIFOMailBox[0].RDHR >> (i * 8)) & 0xFF;
+void CAN1_RX1_IRQHandler() {
+    CAN_RX_Drain_FIFO(1, &CAN1->RF1R);
+}
+
+void CAN1_TX_IRQHandler() {
+    static const uint32_t rqcp[CAN_TX_MAILBOXES] = { CAN_TSR_RQCP0, CAN_TSR_RQCP1, CAN_TSR_RQCP2 };
+    static const uint32_t txok[CAN_TX_MAILBOXES] = { CAN_TSR_TXOK0, CAN_TSR_TXOK1, CAN_TSR_TXOK2 };
+    uint32_t tsr = CAN1->TSR;
+
+    for (uint8_t i = 0; i < CAN_TX_MAILBOXES; i++) {
+        if (tsr & rqcp[i]) {
+            if (tsr & txok[i]) {
+                canTXStats.completed++;
+                canBusBits += CAN_FRAME_BITS(CAN1->sTxMailBox[i].TDTR & CAN_TDT0R_DLC_Msk);
+                canBusFrames++;
+            }
+            else {
+                canTXStats.aborted++;
+            }
+            CAN1->TSR = rqcp[i]; // Clears RQCP, TXOK, ALST and TERR
+        }
     }
-    CAN1->RF0R |= CAN_RF0R_RFOM0; // Release FIFO 0
 
-    BaseType_t xHPW = pdFALSE;
-    xQueueSendFromISR(canRXQueue, &rxFrame, &xHPW);
-    portYIELD_FROM_ISR(xHPW);
+    CAN_TX_Fill_Mailboxes();
 }
 
-void CAN1_RX1_IRQHandler() {
-    CAN_Frame rxFrame;
+void CAN1_SCE_IRQHandler() {
+    uint32_t esr = CAN1->ESR;
 
-    rxFrame.id = (CAN1->sFIFOMailBox[1].RIR & CAN_RI1R_STID_Msk) >> CAN_RI1R_STID_Pos;
+    CAN_Track_Error_State(esr);
 
-    for (int i = 0; i < 4; i++) {
-        rxFrame.data[i] = (CAN1->sFIFOMailBox[1].RDLR >> (i * 8)) & 0xFF;
+    uint8_t lec = (esr & CAN_ESR_LEC_Msk) >> CAN_ESR_LEC_Pos;
+    if (lec != CAN_LEC_None && lec != CAN_LEC_Software) {
+        canBusStats.lastErrorCode[lec]++;
+        // Park LEC at the software value so only new errors are counted
+        CAN1->ESR = (CAN_LEC_Software << CAN_ESR_LEC_Pos);
     }
-    for (int i = 0; i < 4; i++) {
-        rxFrame.data[i + 4] = (CAN1->sFIFOMailBox[1].RDHR >> (i * 8)) & 0xFF;
-    }
-    CAN1->RF1R |= CAN_RF1R_RFOM1; // Release FIFO 1
 
-    BaseType_t xHPW;
-    xQueueSendFromISR(canRXQueue, &rxFrame, &xHPW);
-    portYIELD_FROM_ISR(xHPW)
+    canBusStats.tec = (esr & CAN_ESR_TEC_Msk) >> CAN_ESR_TEC_Pos;
+    canBusStats.rec = (esr & CAN_ESR_REC_Msk) >> CAN_ESR_REC_Pos;
+
+    CAN1->MSR = CAN_MSR_ERRI; // Clear Error Interrupt flag
 }
\ No newline at end of file
@@ -0,0 +1,219 @@
+/************************************************
+* @file    can_capture.c 
+* @author  APBashara
+* @date    10/2026
+* 
+* @brief   Raw CAN Bus Capture to the SD Card Implementation
+***********************************************/
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+#include "can_capture.h"
+#include "fatfs.h"
+#include "timer.h"
+
+_Static_assert(sizeof(CAN_Capture_Header) == 16, "Capture header must stay 16 bytes");
+
+// Blocks are gathered here so the card sees multi-sector writes
+static uint8_t blockBuffer[CAN_CAPTURE_BLOCKS][CAN_CAPTURE_BLOCK_SIZE] __attribute__((aligned(4)));
+static uint8_t blockIndex; // Block being filled
+static bool blockOpen; // Current block has a header
+static uint32_t blockSequence;
+static uint32_t lastTimestamp; // Timestamp of the previous record
+static uint32_t lastOverruns; // RX ring and FIFO overruns already reported
+static uint16_t unsyncedBlocks;
+static bool fileOpen;
+static char fileName[13]; // 8.3 name of the open capture
+static CAN_Capture_Stats captureStats;
+
+/* Static Functions ---------------------------------------------------------*/
+
+/**
+ * @brief Frames lost so far to RX ring and hardware FIFO overruns
+ * 
+ * @return [uint32_t] Free running count
+ */
+static uint32_t Get_Overruns() {
+    CAN_RX_Stats rxStats;
+    CAN_Bus_Stats busStats;
+
+    CAN_Get_RX_Stats(&rxStats);
+    CAN_Get_Bus_Stats(&busStats);
+    return rxStats.overruns + busStats.fifoOverruns[0] + busStats.fifoOverruns[1];
+}
+
+/**
+ * @brief Start a new block at the current buffer index
+ * 
+ * @param timestamp [uint32_t] Time of the first record
+ */
+static void Block_Start(uint32_t timestamp) {
+    CAN_Capture_Header* header = (CAN_Capture_Header*)blockBuffer[blockIndex];
+    uint32_t overruns = Get_Overruns();
+    uint32_t dropped = overruns - lastOverruns;
+    lastOverruns = overruns;
+    captureStats.dropped += dropped;
+
+    header->magic = CAN_CAPTURE_MAGIC;
+    header->count = 0;
+    header->sequence = blockSequence++;
+    header->timestamp = timestamp;
+    header->length = 0;
+    header->dropped = (dropped > 0xFFFF) ? 0xFFFF : dropped;
+    blockOpen = true;
+}
+
+/**
+ * @brief Pad the current block and move to the next buffer slot
+ */
+static void Block_Close() {
+    CAN_Capture_Header* header = (CAN_Capture_Header*)blockBuffer[blockIndex];
+    uint16_t used = sizeof(CAN_Capture_Header) + header->length;
+
+    memset(&blockBuffer[blockIndex][used], 0, CAN_CAPTURE_BLOCK_SIZE - used);
+    blockIndex++;
+    blockOpen = false;
+}
+
+/**
+ * @brief Write every closed block to the file in one call
+ * 
+ * @return CAN_Capture_Status
+ */
+static CAN_Capture_Status Write_Blocks() {
+    UINT written;
+    UINT length = blockIndex * CAN_CAPTURE_BLOCK_SIZE;
+
+    if (blockIndex == 0) {
+        return CAN_CAPTURE_OK;
+    }
+
+    uint32_t start = Get_Timer_Count();
+    FRESULT result = f_write(&USERFile, blockBuffer, length, &written);
+    uint32_t elapsed = Get_Timer_Count() - start;
+
+    if (elapsed > captureStats.maxWriteTime) {
+        captureStats.maxWriteTime = elapsed;
+    }
+    captureStats.blocks += blockIndex;
+    unsyncedBlocks += blockIndex;
+    blockIndex = 0;
+
+    if (result != FR_OK || written != length) {
+        captureStats.writeErrors++;
+        return CAN_CAPTURE_ERROR;
+    }
+
+    // Bound what a power cut can lose without syncing on every write
+    if (unsyncedBlocks >= CAN_CAPTURE_SYNC_BLOCKS) {
+        unsyncedBlocks = 0;
+        if (f_sync(&USERFile) != FR_OK) {
+            captureStats.writeErrors++;
+            return CAN_CAPTURE_ERROR;
+        }
+    }
+    return CAN_CAPTURE_OK;
+}
+
+/* Function Implementation --------------------------------------------------*/
+
+CAN_Capture_Status CAN_Capture_Init() {
+    char path[16];
+
+    // Never overwrite an earlier session
+    for (uint16_t n = 0; n < CAN_CAPTURE_MAX_FILES; n++) {
+        snprintf(path, sizeof(path), "%sCAN%03u.BIN", USERPath, n);
+        FRESULT result = f_open(&USERFile, path, FA_CREATE_NEW | FA_WRITE);
+        if (result == FR_EXIST) {
+            continue;
+        }
+        if (result != FR_OK) {
+            return CAN_CAPTURE_ERROR;
+        }
+
+        lastOverruns = Get_Overruns();
+        snprintf(fileName, sizeof(fileName), "CAN%03u.BIN", n);
+        fileOpen = true;
+        return CAN_CAPTURE_OK;
+    }
+    return CAN_CAPTURE_ERROR;
+}
+
+CAN_Capture_Status CAN_Capture_Frame(const CAN_Frame* frame) {
+    CAN_Capture_Status status = CAN_CAPTURE_OK;
+
+    if (!fileOpen || frame == NULL) {
+        return CAN_CAPTURE_ERROR;
+    }
+
+    uint8_t dlc = (frame->dlc > 8) ? 8 : frame->dlc;
+    uint8_t dataBytes = (frame->rtr == CAN_RTR_Remote) ? 0 : dlc;
+    uint32_t delta = frame->timestamp - lastTimestamp;
+
+    if (blockOpen) {
+        CAN_Capture_Header* header = (CAN_Capture_Header*)blockBuffer[blockIndex];
+        // Close early if the record does not fit or the delta would overflow
+        if (delta > 0xFFFF ||
+            sizeof(CAN_Capture_Header) + header->length + 4 + dataBytes > CAN_CAPTURE_BLOCK_SIZE) {
+            Block_Close();
+        }
+    }
+    if (!blockOpen) {
+        if (blockIndex == CAN_CAPTURE_BLOCKS) {
+            status = Write_Blocks();
+        }
+        Block_Start(frame->timestamp);
+        delta = 0;
+    }
+
+    CAN_Capture_Header* header = (CAN_Capture_Header*)blockBuffer[blockIndex];
+    uint8_t* record = &blockBuffer[blockIndex][sizeof(CAN_Capture_Header) + header->length];
+    uint16_t info = (frame->id & 0x7FF) | ((uint16_t)dlc << 11) | ((uint16_t)(frame->rtr == CAN_RTR_Remote) << 15);
+
+    // Records are little endian regardless of host
+    record[0] = delta & 0xFF;
+    record[1] = delta >> 8;
+    record[2] = info & 0xFF;
+    record[3] = info >> 8;
+    memcpy(&record[4], frame->data, dataBytes);
+
+    header->count++;
+    header->length += 4 + dataBytes;
+    lastTimestamp = frame->timestamp;
+    captureStats.frames++;
+
+    return status;
+}
+
+CAN_Capture_Status CAN_Capture_Flush() {
+    if (!fileOpen) {
+        return CAN_CAPTURE_ERROR;
+    }
+    if (blockOpen) {
+        Block_Close();
+    }
+    if (Write_Blocks() != CAN_CAPTURE_OK) {
+        return CAN_CAPTURE_ERROR;
+    }
+
+    unsyncedBlocks = 0;
+    if (f_sync(&USERFile) != FR_OK) {
+        captureStats.writeErrors++;
+        return CAN_CAPTURE_ERROR;
+    }
+    return CAN_CAPTURE_OK;
+}
+
+bool CAN_Capture_Is_Active(const char* name) {
+    return fileOpen && name != NULL && strcasecmp(name, fileName) == 0;
+}
+
+void CAN_Capture_Get_Stats(CAN_Capture_Stats* stats) {
+    if (stats != NULL) {
+        *stats = captureStats;
+    }
+}
@@ -0,0 +1,44 @@
+/************************************************
+* @file    can_db.c 
+* @author  APBashara
+* @date    10/2026
+* 
+* @brief   ECU CAN Signal Database
+* @note    Can be regenerated from a DBC file with Tools/dbc2c.py
+***********************************************/
+
+#include "main.h"
+
+extern Telemetry telemetry;
+
+/* Signal Tables ------------------------------------------------------------*/
+// startBit, length, byteOrder, isSigned, destType, scale, offset, dest
+static const CAN_Signal sig_0x048[] = {
+    { 0, 16, CAN_INTEL, 0, CAN_DEST_U16, 1.0f, 0.0f, &telemetry.Engine_Data_Packet.RPM },
+    { 16, 16, CAN_INTEL, 0, CAN_DEST_U16, 1.0f, 0.0f, &telemetry.Engine_Data_Packet.ThrottlePosSensor },
+};
+
+static const CAN_Signal sig_0x148[] = {
+    { 32, 16, CAN_INTEL, 0, CAN_DEST_U16, 1.0f, 0.0f, &telemetry.Engine_Data_Packet.Lambda },
+};
+
+static const CAN_Signal sig_0x248[] = {
+    { 48, 16, CAN_INTEL, 0, CAN_DEST_U16, 1.0f, 0.0f, &telemetry.Brakes_Accel_Packet.OilPressure },
+};
+
+static const CAN_Signal sig_0x548[] = {
+    { 16, 16, CAN_INTEL, 0, CAN_DEST_U16, 1.0f, 0.0f, &telemetry.Temperature_Packet.AirTemp },
+    { 32, 16, CAN_INTEL, 0, CAN_DEST_U16, 1.0f, 0.0f, &telemetry.Temperature_Packet.CoolTemp },
+};
+
+/* Message Table ------------------------------------------------------------*/
+// Must stay sorted by ID for the binary search in CAN_Decode_Lookup
+// id, rate (frames/s), signalCount, signals, timestamp
+const CAN_Message canMessages[] = {
+    { 0x048, 50, sizeof(sig_0x048) / sizeof(CAN_Signal), sig_0x048, &telemetry.Engine_Data_Packet.EcuTime },
+    { 0x148, 20, sizeof(sig_0x148) / sizeof(CAN_Signal), sig_0x148, NULL },
+    { 0x248, 10, sizeof(sig_0x248) / sizeof(CAN_Signal), sig_0x248, NULL },
+    { 0x548, 2, sizeof(sig_0x548) / sizeof(CAN_Signal), sig_0x548, NULL },
+};
+
+const uint16_t canMessageCount = sizeof(canMessages) / sizeof(CAN_Message);
@@ -0,0 +1,199 @@
+/************************************************
+* @file    can_decode.c 
+* @author  APBashara
+* @date    10/2026
+* 
+* @brief   Table Driven CAN Signal Decoder Implementation
+***********************************************/
+
+#include <stddef.h>
+
+#include "can_decode.h"
+
+// Frames decoded and last reception time per message table entry
+static uint32_t frameCounts[CAN_FILTER_MAX_IDS];
+static uint32_t frameTimes[CAN_FILTER_MAX_IDS];
+
+/* Static Functions ---------------------------------------------------------*/
+
+/**
+ * @brief Payload bits a signal needs, counted from the start of data[0]
+ * @note Above 64 the signal does not fit in any CAN frame
+ * 
+ * @param sig [const CAN_Signal*] Signal description
+ * @return [uint16_t] Bits from the first payload bit through the signal's last
+ */
+static uint16_t Signal_End(const CAN_Signal* sig) {
+    if (sig->byteOrder == CAN_INTEL) {
+        return sig->startBit + sig->length;
+    }
+    // Motorola: MSB position in the big endian payload, LSB follows length - 1 bits later
+    uint8_t msb = (sig->startBit & ~0x7) + (7 - (sig->startBit & 0x7));
+    return msb + sig->length;
+}
+
+/**
+ * @brief Pull the raw bits of a signal out of the frame payload
+ * 
+ * @param sig [const CAN_Signal*] Signal description
+ * @param le [uint64_t] Payload with data[0] as the least significant byte
+ * @param be [uint64_t] Payload with data[0] as the most significant byte
+ * @return [uint64_t] Raw value, sign extended if the signal is signed
+ */
+static uint64_t Extract_Raw(const CAN_Signal* sig, uint64_t le, uint64_t be) {
+    uint64_t raw;
+    uint64_t mask = (sig->length >= 64) ? ~0ULL : ((1ULL << sig->length) - 1);
+
+    if (sig->byteOrder == CAN_INTEL) {
+        raw = (le >> sig->startBit) & mask;
+    }
+    else {
+        // DBC Motorola start bit is the MSB, numbered LSB first within each byte
+        uint8_t msb = (sig->startBit & ~0x7) + (7 - (sig->startBit & 0x7));
+        raw = (be >> (64 - msb - sig->length)) & mask;
+    }
+
+    if (sig->isSigned && sig->length < 64 && (raw & (1ULL << (sig->length - 1)))) {
+        raw |= ~mask;
+    }
+    return raw;
+}
+
+/**
+ * @brief Write a decoded value into the destination field
+ * 
+ * @param sig [const CAN_Signal*] Signal description
+ * @param raw [uint64_t] Raw value from Extract_Raw
+ */
+static void Store_Value(const CAN_Signal* sig, uint64_t raw) {
+    // Integer path keeps full precision when no scaling is applied
+    if (sig->scale == 1.0f && sig->offset == 0.0f && sig->destType != CAN_DEST_F32) {
+        switch (sig->destType) {
+        case CAN_DEST_U8:  *(uint8_t*)sig->dest = (uint8_t)raw; break;
+        case CAN_DEST_I8:  *(int8_t*)sig->dest = (int8_t)raw; break;
+        case CAN_DEST_U16: *(uint16_t*)sig->dest = (uint16_t)raw; break;
+        case CAN_DEST_I16: *(int16_t*)sig->dest = (int16_t)raw; break;
+        case CAN_DEST_U32: *(uint32_t*)sig->dest = (uint32_t)raw; break;
+        case CAN_DEST_I32: *(int32_t*)sig->dest = (int32_t)raw; break;
+        default: break;
+        }
+        return;
+    }
+
+    float value = (sig->isSigned ? (float)(int64_t)raw : (float)raw) * sig->scale + sig->offset;
+    switch (sig->destType) {
+    case CAN_DEST_U8:  *(uint8_t*)sig->dest = (uint8_t)value; break;
+    case CAN_DEST_I8:  *(int8_t*)sig->dest = (int8_t)value; break;
+    case CAN_DEST_U16: *(uint16_t*)sig->dest = (uint16_t)value; break;
+    case CAN_DEST_I16: *(int16_t*)sig->dest = (int16_t)value; break;
+    case CAN_DEST_U32: *(uint32_t*)sig->dest = (uint32_t)value; break;
+    case CAN_DEST_I32: *(int32_t*)sig->dest = (int32_t)value; break;
+    case CAN_DEST_F32: *(float*)sig->dest = value; break;
+    default: break;
+    }
+}
+
+/* Function Implementation --------------------------------------------------*/
+
+CAN_Decode_Status CAN_Decode_Init() {
+    // Anything past this could never make it through the hardware filters
+    if (canMessageCount > CAN_FILTER_MAX_IDS) {
+        return CAN_DECODE_ERROR;
+    }
+
+    for (uint16_t i = 0; i < canMessageCount; i++) {
+        if (i > 0 && canMessages[i].id <= canMessages[i - 1].id) {
+            return CAN_DECODE_ERROR;
+        }
+        for (uint8_t j = 0; j < canMessages[i].signalCount; j++) {
+            const CAN_Signal* sig = &canMessages[i].signals[j];
+            if (sig->length == 0 || Signal_End(sig) > 64 || sig->dest == NULL) {
+                return CAN_DECODE_ERROR;
+            }
+        }
+    }
+    return CAN_DECODE_OK;
+}
+
+const CAN_Message* CAN_Decode_Lookup(uint16_t id) {
+    uint16_t low = 0;
+    uint16_t high = canMessageCount;
+
+    while (low < high) {
+        uint16_t mid = (low + high) / 2;
+        if (canMessages[mid].id < id) {
+            low = mid + 1;
+        }
+        else {
+            high = mid;
+        }
+    }
+
+    if (low < canMessageCount && canMessages[low].id == id) {
+        return &canMessages[low];
+    }
+    return NULL;
+}
+
+uint8_t CAN_Decode_Get_IDs(CAN_Filter_ID* ids, uint8_t max) {
+    uint8_t count = 0;
+
+    for (uint16_t i = 0; i < canMessageCount && count < max; i++) {
+        ids[count].id = canMessages[i].id;
+        ids[count].rate = canMessages[i].rate;
+        count++;
+    }
+    return count;
+}
+
+uint32_t CAN_Decode_Get_Count(uint16_t id) {
+    const CAN_Message* msg = CAN_Decode_Lookup(id);
+    if (msg == NULL) {
+        return 0;
+    }
+    return frameCounts[msg - canMessages];
+}
+
+uint32_t CAN_Decode_Get_Timestamp(uint16_t id) {
+    const CAN_Message* msg = CAN_Decode_Lookup(id);
+    if (msg == NULL) {
+        return 0;
+    }
+    return frameTimes[msg - canMessages];
+}
+
+CAN_Decode_Status CAN_Decode_Frame(const CAN_Frame* frame) {
+    if (frame == NULL || frame->rtr != CAN_RTR_Data) {
+        return CAN_DECODE_ERROR;
+    }
+
+    const CAN_Message* msg = CAN_Decode_Lookup(frame->id);
+    if (msg == NULL) {
+        return CAN_DECODE_UNKNOWN_ID;
+    }
+    frameCounts[msg - canMessages]++;
+    frameTimes[msg - canMessages] = frame->timestamp;
+
+    // Assemble the payload once in both byte orders for all signals
+    uint64_t le = 0;
+    uint64_t be = 0;
+    for (int i = 0; i < 8; i++) {
+        le |= (uint64_t)frame->data[i] << (i * 8);
+        be = (be << 8) | frame->data[i];
+    }
+
+    CAN_Decode_Status status = CAN_DECODE_OK;
+    uint8_t dlc = (frame->dlc > 8) ? 8 : frame->dlc;
+    for (uint8_t i = 0; i < msg->signalCount; i++) {
+        const CAN_Signal* sig = &msg->signals[i];
+        if (Signal_End(sig) > dlc * 8) {
+            status = CAN_DECODE_SHORT;
+            continue;
+        }
+        Store_Value(sig, Extract_Raw(sig, le, be));
+    }
+    if (msg->timestamp != NULL) {
+        *msg->timestamp = frame->timestamp;
+    }
+    return status;
+}
@@ -0,0 +1,168 @@
+/************************************************
+* @file    can_filter.c 
+* @author  APBashara
+* @date    10/2026
+* 
+* @brief   CAN Filter Bank Allocation
+* @note    Computes register images only, CAN_Filters_Init in can.c
+*          writes them, so the allocator also builds with CAN_HOST
+***********************************************/
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "can.h"
+
+/* Function Implementation --------------------------------------------------*/
+
+CAN_Status CAN_Filter_Alloc(CAN_Filter_ID* ids, uint8_t count, CAN_Filter_Config* config) {
+    // One entry is a single list ID or an aligned mask range
+    static struct {
+        uint16_t id;
+        uint16_t mask; // 0 for list entries
+        uint32_t rate;
+        uint8_t fifo;
+    } entries[CAN_FILTER_MAX_IDS];
+    uint8_t entryCount = 0;
+
+    if (ids == NULL || config == NULL || count == 0 || count > CAN_FILTER_MAX_IDS) {
+        return CAN_Error;
+    }
+    memset(config, 0, sizeof(CAN_Filter_Config));
+
+    // Only 11 bits reach the filters, compare IDs as the filters will
+    for (uint8_t i = 0; i < count; i++) {
+        ids[i].id &= 0x7FF;
+    }
+
+    // Sort by ID, lists are short and this only runs once at startup
+    for (uint8_t i = 1; i < count; i++) {
+        CAN_Filter_ID key = ids[i];
+        int16_t j = i - 1;
+        while (j >= 0 && ids[j].id > key.id) {
+            ids[j + 1] = ids[j];
+            j--;
+        }
+        ids[j + 1] = key;
+    }
+
+    // Merge duplicate IDs so ranges below are strictly consecutive
+    uint8_t unique = 1;
+    for (uint8_t i = 1; i < count; i++) {
+        if (ids[i].id == ids[unique - 1].id) {
+            ids[unique - 1].rate += ids[i].rate;
+        }
+        else {
+            ids[unique++] = ids[i];
+        }
+    }
+    count = unique;
+
+    // Build entries, covering fully subscribed aligned ranges with one mask
+    for (uint8_t i = 0; i < count; ) {
+        uint16_t id = ids[i].id;
+        uint16_t block = 1;
+
+        for (uint16_t size = 128; size >= CAN_FILTER_MIN_BLOCK; size >>= 1) {
+            if ((id & (size - 1)) == 0 && (i + size) <= count &&
+                ids[i + size - 1].id == id + size - 1) {
+                block = size;
+                break;
+            }
+        }
+
+        entries[entryCount].id = id;
+        entries[entryCount].mask = (block > 1) ? (~(block - 1) & 0x7FF) : 0;
+        entries[entryCount].rate = 0;
+        for (uint16_t k = 0; k < block; k++) {
+            entries[entryCount].rate += ids[i + k].rate;
+        }
+        entryCount++;
+        i += block;
+    }
+
+    // Balance expected load, busiest entries first onto the quieter FIFO
+    bool assigned[CAN_FILTER_MAX_IDS] = { false };
+    for (uint8_t n = 0; n < entryCount; n++) {
+        uint8_t best = 0xFF;
+        for (uint8_t k = 0; k < entryCount; k++) {
+            if (!assigned[k] && (best == 0xFF || entries[k].rate > entries[best].rate)) {
+                best = k;
+            }
+        }
+        assigned[best] = true;
+        entries[best].fifo = (config->fifoRate[1] < config->fifoRate[0]) ? 1 : 0;
+        config->fifoRate[entries[best].fifo] += entries[best].rate;
+    }
+
+    // Pack entries into banks, banks only hold one FIFO and one mode
+    for (uint8_t fifo = 0; fifo < 2; fifo++) {
+        for (uint8_t listMode = 0; listMode < 2; listMode++) {
+            uint16_t slots[4];
+            uint8_t used = 0;
+
+            for (uint8_t k = 0; k <= entryCount; k++) {
+                bool flush = (k == entryCount);
+                if (!flush) {
+                    if (entries[k].fifo != fifo || (entries[k].mask == 0) != listMode) {
+                        continue;
+                    }
+                    if (listMode) {
+                        slots[used++] = entries[k].id << CAN_F0R1_FB5_Pos;
+                    }
+                    else {
+                        // Mask also checks RTR and IDE so only standard data frames pass
+                        slots[used++] = entries[k].id << CAN_F0R1_FB5_Pos;
+                        slots[used++] = (entries[k].mask << CAN_F0R1_FB5_Pos)
+                                        | CAN_F0R1_FB4 | CAN_F0R1_FB3;
+                    }
+                    flush = (used == 4);
+                }
+                if (!flush || used == 0) {
+                    continue;
+                }
+
+                uint8_t bank = config->banks;
+                if (bank >= CAN_FILTER_BANKS) {
+                    return CAN_Error;
+                }
+                // Unused slots repeat the first entry so they match nothing new
+                for (uint8_t u = used; u < 4; u++) {
+                    slots[u] = listMode ? slots[0] : slots[u - 2];
+                }
+                config->fr1[bank] = slots[0] | ((uint32_t)slots[1] << 16);
+                config->fr2[bank] = slots[2] | ((uint32_t)slots[3] << 16);
+                config->fm1r |= ((uint32_t)listMode << bank);
+                config->ffa1r |= ((uint32_t)fifo << bank);
+                config->fa1r |= (1UL << bank);
+                config->banks++;
+                used = 0;
+            }
+        }
+    }
+
+    return CAN_OK;
+}
+
+CAN_Status CAN_Filter_Accept_All(CAN_Filter_Config* config) {
+    if (config == NULL) {
+        return CAN_Error;
+    }
+    memset(config, 0, sizeof(CAN_Filter_Config));
+
+    // One 16-bit mask bank per FIFO, only ID bit 0 and IDE are compared
+    for (uint8_t fifo = 0; fifo < 2; fifo++) {
+        uint16_t id = fifo << CAN_F0R1_FB5_Pos;
+        uint16_t mask = (1U << CAN_F0R1_FB5_Pos) | CAN_F0R1_FB3;
+
+        config->fr1[fifo] = id | ((uint32_t)mask << 16);
+        config->fr2[fifo] = config->fr1[fifo];
+        config->ffa1r |= ((uint32_t)fifo << fifo);
+        config->fa1r |= (1UL << fifo);
+        config->fifoRate[fifo] = CAN_BITRATE / CAN_FRAME_BITS(8) / 2;
+    }
+    config->banks = 2;
+
+    return CAN_OK;
+}
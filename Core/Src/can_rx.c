@@ -0,0 +1,78 @@
+/************************************************
+* @file    can_rx.c 
+* @author  APBashara
+* @date    10/2026
+* 
+* @brief   CAN RX Ring Implementation
+* @note    No register access, the RX ISRs in can.c fill the ring
+***********************************************/
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "can.h"
+#include "can_port.h"
+
+// RX ring, written only by the RX ISRs and read only by CAN_Task
+static CAN_Frame canRXRing[CAN_RX_RING_SIZE];
+static volatile uint32_t canRXHead; // Published write index, owned by the ISRs
+static volatile uint32_t canRXTail; // Next slot to read, owned by CAN_Task
+static uint32_t canRXWrite; // Write index not yet published by CAN_RX_Publish
+static CAN_RX_Stats canRXStats;
+
+/* Function Implementation --------------------------------------------------*/
+
+CAN_Frame* CAN_RX_Reserve() {
+    // Consumer may free slots at any time, re-read the tail every call
+    if ((canRXWrite - canRXTail) >= CAN_RX_RING_SIZE) {
+        canRXStats.overruns++;
+        return NULL;
+    }
+    return &canRXRing[canRXWrite & CAN_RX_RING_MASK];
+}
+
+void CAN_RX_Commit() {
+    canRXWrite++;
+    canRXStats.received++;
+    if ((canRXWrite - canRXTail) > canRXStats.highWater) {
+        canRXStats.highWater = canRXWrite - canRXTail;
+    }
+}
+
+void CAN_RX_Publish() {
+    uint32_t head = canRXHead;
+    if (canRXWrite == head) {
+        return;
+    }
+    bool wasEmpty = (head == canRXTail);
+
+    CAN_PORT_BARRIER(); // Frame data must land before the head index is published
+    canRXHead = canRXWrite;
+
+    // One notification per burst, CAN_Task drains until the ring is empty
+    if (wasEmpty) {
+        CAN_PORT_NOTIFY_RX();
+    }
+}
+
+uint16_t CAN_RX_Pop_Batch(CAN_Frame* frames, uint16_t max) {
+    uint32_t tail = canRXTail;
+    uint32_t head = canRXHead;
+    uint16_t count = 0;
+
+    CAN_PORT_BARRIER(); // Read the head index before the frame data it covers
+    while (tail != head && count < max) {
+        frames[count++] = canRXRing[tail & CAN_RX_RING_MASK];
+        tail++;
+    }
+    CAN_PORT_BARRIER(); // Finish copying before handing the slots back
+    canRXTail = tail;
+
+    return count;
+}
+
+void CAN_Get_RX_Stats(CAN_RX_Stats* stats) {
+    CAN_PORT_ENTER_CRITICAL();
+    *stats = canRXStats;
+    CAN_PORT_EXIT_CRITICAL();
+}
@@ -54,6 +54,13 @@
 
 /* Private application code --------------------------------------------------*/
 /* USER CODE BEGIN Application */
+/**
+ * @brief Sleep the core until the next interrupt when no task is ready
+ * @note Radio airtime and CAN waits are interrupt driven, so most idle time is spent here
+ */
+void vApplicationIdleHook(void) {
+  __WFI();
+}
 
 /* USER CODE END Application */
 
@@ -131,6 +131,12 @@ GPS_Status Get_Position(GPS_Data* data) {
 
     I2C_Read(I2C1, M9N_ADDR, M9N_DATA_REG, buffer, len);
 
+    data->iTOW = buffer[UBX_PVT_ITOW_Pos + 3] << 24 |
+                 buffer[UBX_PVT_ITOW_Pos + 2] << 16 |
+                 buffer[UBX_PVT_ITOW_Pos + 1] << 8 |
+                 buffer[UBX_PVT_ITOW_Pos];
+    data->timeValid = (buffer[UBX_PVT_VALID_Pos] & UBX_PVT_VALID_TIME) != 0;
+
     if (buffer[UBX_PVT_FIX_Pos] != 0x00) {
         // Data is sent in signed little-endian 32-bit integer, two's complement
         data->latitude = buffer[UBX_PVT_LAT_Pos + 3] << 24 |
@@ -0,0 +1,326 @@
+/************************************************
+* @file    isotp.c 
+* @author  APBashara
+* @date    10/2026
+* 
+* @brief   ISO 15765-2 (ISO-TP) Transport Implementation
+* @note    Single session, classic CAN with 12-bit message lengths
+***********************************************/
+
+#include <stddef.h>
+#include <string.h>
+
+#include "isotp.h"
+#include "queue.h"
+#include "task.h"
+#include "timer.h"
+
+// Protocol control information, upper nibble of the first byte
+#define PCI_SINGLE                  (0x0)
+#define PCI_FIRST                   (0x1)
+#define PCI_CONSECUTIVE             (0x2)
+#define PCI_FLOW                    (0x3)
+
+#define FLOW_CTS                    (0x0)
+#define FLOW_WAIT                   (0x1)
+#define FLOW_OVERFLOW               (0x2)
+
+typedef enum {
+    TX_IDLE,
+    TX_WAIT_FC, // Waiting for flow control from the tester
+    TX_SENDING, // Sending consecutive frames
+} TX_State;
+
+static QueueHandle_t isotpQueue;
+static ISOTP_Stats isotpStats;
+
+// Reassembly of the current request
+static uint8_t rxBuffer[ISOTP_MAX_RX];
+static uint16_t rxLength; // Total length from the first frame, 0 when idle
+static uint16_t rxReceived;
+static uint8_t rxSequence; // Next expected sequence number
+static TickType_t rxDeadline;
+
+// Segmentation of the current response
+static uint8_t txBuffer[ISOTP_MAX_TX];
+static TX_State txState;
+static uint16_t txLength;
+static uint16_t txSent;
+static uint8_t txSequence;
+static uint8_t txBlockLeft; // Frames left in this block, 0 = unlimited
+static uint8_t txBlockSize;
+static uint32_t txSTMin; // Minimum gap between consecutive frames in us
+static uint32_t txLastFrame; // TIM2 time the last consecutive frame was queued
+static uint8_t txStalled; // CAN TX queue was full on the last attempt
+static TickType_t txDeadline;
+
+/* Static Functions ---------------------------------------------------------*/
+
+/**
+ * @brief Queue a padded frame on ISOTP_TX_ID
+ * 
+ * @param data [const uint8_t*] Frame data
+ * @param length [uint8_t] Bytes of data, padded up to 8
+ * @return [CAN_Status] CAN_Mailbox_Error if the TX queue is full
+ */
+static CAN_Status Send_Frame(const uint8_t* data, uint8_t length) {
+    CAN_Frame frame = { .id = ISOTP_TX_ID, .dlc = 8, .rtr = CAN_RTR_Data };
+
+    memset(frame.data, ISOTP_PADDING, sizeof(frame.data));
+    memcpy(frame.data, data, length);
+    return CAN_Transmit_Async(&frame);
+}
+
+/**
+ * @brief Send our flow control for a multi-frame request
+ * 
+ * @param status [uint8_t] FLOW_CTS, FLOW_WAIT or FLOW_OVERFLOW
+ */
+static void Send_Flow_Control(uint8_t status) {
+    uint8_t fc[3] = { (PCI_FLOW << 4) | status, ISOTP_BLOCK_SIZE, ISOTP_ST_MIN };
+    Send_Frame(fc, sizeof(fc));
+}
+
+/**
+ * @brief Convert an STmin byte to microseconds
+ * 
+ * @param stMin [uint8_t] STmin from a flow control frame
+ * @return [uint32_t] Gap in microseconds
+ */
+static uint32_t STMin_To_Us(uint8_t stMin) {
+    if (stMin <= 0x7F) {
+        return stMin * 1000UL;
+    }
+    if (stMin >= 0xF1 && stMin <= 0xF9) {
+        return (stMin - 0xF0) * 100UL;
+    }
+    return 127000UL; // Reserved values mean the longest gap
+}
+
+/**
+ * @brief Handle one frame from the tester
+ * 
+ * @param frame [const CAN_Frame*] Frame on ISOTP_RX_ID
+ * @return [uint8_t] 1 if a request is now complete in rxBuffer
+ */
+static uint8_t Handle_Frame(const CAN_Frame* frame) {
+    uint8_t pci = frame->data[0] >> 4;
+
+    if (frame->dlc == 0 || frame->rtr != CAN_RTR_Data) {
+        return 0;
+    }
+
+    switch (pci) {
+    case PCI_SINGLE: {
+        uint8_t length = frame->data[0] & 0x0F;
+        if (length == 0 || length > 7 || length > frame->dlc - 1) {
+            return 0;
+        }
+        // A new request always replaces one still being reassembled
+        memcpy(rxBuffer, &frame->data[1], length);
+        rxLength = length;
+        rxReceived = length;
+        return 1;
+    }
+
+    case PCI_FIRST: {
+        uint16_t length = ((frame->data[0] & 0x0F) << 8) | frame->data[1];
+        if (frame->dlc < 8 || length < 8) {
+            return 0;
+        }
+        if (length > ISOTP_MAX_RX) {
+            rxLength = 0;
+            isotpStats.rxErrors++;
+            Send_Flow_Control(FLOW_OVERFLOW);
+            return 0;
+        }
+        memcpy(rxBuffer, &frame->data[2], 6);
+        rxLength = length;
+        rxReceived = 6;
+        rxSequence = 1;
+        rxDeadline = xTaskGetTickCount() + ISOTP_TIMEOUT;
+        Send_Flow_Control(FLOW_CTS);
+        return 0;
+    }
+
+    case PCI_CONSECUTIVE: {
+        if (rxLength == 0) {
+            return 0; // Not expecting one
+        }
+        if ((frame->data[0] & 0x0F) != rxSequence) {
+            rxLength = 0;
+            isotpStats.rxErrors++;
+            return 0;
+        }
+        uint16_t chunk = rxLength - rxReceived;
+        if (chunk > 7) {
+            chunk = 7;
+        }
+        if (frame->dlc < chunk + 1) {
+            rxLength = 0; // Too short for the bytes still due
+            isotpStats.rxErrors++;
+            return 0;
+        }
+        memcpy(&rxBuffer[rxReceived], &frame->data[1], chunk);
+        rxReceived += chunk;
+        rxSequence = (rxSequence + 1) & 0x0F;
+        rxDeadline = xTaskGetTickCount() + ISOTP_TIMEOUT;
+        return rxReceived == rxLength;
+    }
+
+    case PCI_FLOW:
+        if (txState != TX_WAIT_FC || frame->dlc < 3) {
+            return 0;
+        }
+        switch (frame->data[0] & 0x0F) {
+        case FLOW_CTS:
+            txBlockSize = frame->data[1];
+            txBlockLeft = txBlockSize;
+            txSTMin = STMin_To_Us(frame->data[2]);
+            txLastFrame = Get_Timer_Count() - txSTMin; // First frame may go at once
+            txState = TX_SENDING;
+            break;
+        case FLOW_WAIT:
+            txDeadline = xTaskGetTickCount() + ISOTP_TIMEOUT;
+            break;
+        default:
+            txState = TX_IDLE;
+            isotpStats.txErrors++;
+            break;
+        }
+        return 0;
+
+    default:
+        return 0;
+    }
+}
+
+/**
+ * @brief Queue as many consecutive frames as flow control and the TX queue allow
+ */
+static void Send_Consecutive() {
+    txStalled = 0;
+    while (txState == TX_SENDING) {
+        if ((Get_Timer_Count() - txLastFrame) < txSTMin) {
+            return;
+        }
+
+        uint8_t cf[8];
+        uint16_t chunk = txLength - txSent;
+        if (chunk > 7) {
+            chunk = 7;
+        }
+        cf[0] = (PCI_CONSECUTIVE << 4) | txSequence;
+        memcpy(&cf[1], &txBuffer[txSent], chunk);
+        if (Send_Frame(cf, chunk + 1) != CAN_TX_Req) {
+            txStalled = 1; // TX queue full, retry next tick
+            return;
+        }
+
+        txSent += chunk;
+        txSequence = (txSequence + 1) & 0x0F;
+        txLastFrame = Get_Timer_Count();
+
+        if (txSent >= txLength) {
+            txState = TX_IDLE;
+            isotpStats.txMessages++;
+        }
+        else if (txBlockSize != 0 && --txBlockLeft == 0) {
+            txState = TX_WAIT_FC;
+            txDeadline = xTaskGetTickCount() + ISOTP_TIMEOUT;
+        }
+        else if (txSTMin != 0) {
+            return;
+        }
+    }
+}
+
+/* Function Implementation --------------------------------------------------*/
+
+ISOTP_Status ISOTP_Init() {
+    isotpQueue = xQueueCreate(ISOTP_QUEUE_SIZE, sizeof(CAN_Frame));
+    return (isotpQueue == NULL) ? ISOTP_ERROR : ISOTP_OK;
+}
+
+void ISOTP_Receive_Frame(const CAN_Frame* frame) {
+    if (isotpQueue == NULL || xQueueSend(isotpQueue, frame, 0) != pdPASS) {
+        isotpStats.dropped++;
+    }
+}
+
+ISOTP_Status ISOTP_Send(const uint8_t* data, uint16_t length) {
+    if (data == NULL || length == 0 || length > ISOTP_MAX_TX) {
+        return ISOTP_ERROR;
+    }
+    if (txState != TX_IDLE) {
+        return ISOTP_BUSY;
+    }
+
+    if (length <= 7) {
+        uint8_t sf[8];
+        sf[0] = (PCI_SINGLE << 4) | length;
+        memcpy(&sf[1], data, length);
+        if (Send_Frame(sf, length + 1) != CAN_TX_Req) {
+            return ISOTP_BUSY;
+        }
+        isotpStats.txMessages++;
+        return ISOTP_OK;
+    }
+
+    uint8_t ff[8];
+    ff[0] = (PCI_FIRST << 4) | (length >> 8);
+    ff[1] = length & 0xFF;
+    memcpy(&ff[2], data, 6);
+    if (Send_Frame(ff, sizeof(ff)) != CAN_TX_Req) {
+        return ISOTP_BUSY;
+    }
+
+    memcpy(txBuffer, data, length);
+    txLength = length;
+    txSent = 6;
+    txSequence = 1;
+    txState = TX_WAIT_FC;
+    txDeadline = xTaskGetTickCount() + ISOTP_TIMEOUT;
+    return ISOTP_OK;
+}
+
+uint16_t ISOTP_Process(uint8_t* message) {
+    CAN_Frame frame;
+    uint16_t complete = 0;
+
+    // Only sleep when there is nothing to send right now
+    TickType_t wait = (txState == TX_SENDING && txSTMin == 0 && !txStalled) ? 0 : 1;
+
+    while (complete == 0 && xQueueReceive(isotpQueue, &frame, wait) == pdPASS) {
+        wait = 0;
+        if (Handle_Frame(&frame)) {
+            memcpy(message, rxBuffer, rxLength);
+            complete = rxLength;
+            rxLength = 0;
+            isotpStats.rxMessages++;
+        }
+    }
+
+    Send_Consecutive();
+
+    TickType_t now = xTaskGetTickCount();
+    if (rxLength != 0 && (int32_t)(now - rxDeadline) > 0) {
+        rxLength = 0; // N_Cr, tester stopped sending
+        isotpStats.rxErrors++;
+    }
+    if (txState == TX_WAIT_FC && (int32_t)(now - txDeadline) > 0) {
+        txState = TX_IDLE; // N_Bs, no flow control from the tester
+        isotpStats.txErrors++;
+    }
+    return complete;
+}
+
+uint8_t ISOTP_TX_Busy() {
+    return txState != TX_IDLE;
+}
+
+void ISOTP_Get_Stats(ISOTP_Stats* stats) {
+    if (stats != NULL) {
+        *stats = isotpStats;
+    }
+}
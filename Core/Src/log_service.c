@@ -0,0 +1,184 @@
+/************************************************
+* @file    log_service.c 
+* @author  APBashara
+* @date    10/2026
+* 
+* @brief   SD Card Log Download Service Implementation
+***********************************************/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "log_service.h"
+#include "lora_offload.h"
+#include "can_capture.h"
+#include "fatfs.h"
+
+static uint8_t serviceResponse[ISOTP_MAX_TX];
+static FIL serviceFile;
+static bool serviceFileOpen;
+
+/* Static Functions ---------------------------------------------------------*/
+
+/**
+ * @brief Build a negative response
+ * 
+ * @param code [uint8_t] Request code that failed
+ * @param error [uint8_t] FRESULT or LOG_SERVICE_BAD_REQUEST
+ * @return [uint16_t] Response length
+ */
+static uint16_t Negative(uint8_t code, uint8_t error) {
+    serviceResponse[0] = LOG_SERVICE_NEGATIVE;
+    serviceResponse[1] = code;
+    serviceResponse[2] = error;
+    return 3;
+}
+
+/**
+ * @brief Write a little endian uint32_t
+ * 
+ * @param dest [uint8_t*] Destination bytes
+ * @param value [uint32_t] Value to write
+ */
+static void Put_U32(uint8_t* dest, uint32_t value) {
+    for (uint8_t i = 0; i < 4; i++) {
+        dest[i] = (value >> (i * 8)) & 0xFF;
+    }
+}
+
+/**
+ * @brief Read a little endian uint32_t
+ * 
+ * @param src [const uint8_t*] Source bytes
+ * @return [uint32_t] Value
+ */
+static uint32_t Get_U32(const uint8_t* src) {
+    return src[0] | (src[1] << 8) | (src[2] << 16) | ((uint32_t)src[3] << 24);
+}
+
+/**
+ * @brief Return the index-th file in the root directory
+ * 
+ * @param index [uint16_t] File number, directories are skipped
+ * @return [uint16_t] Response length
+ */
+static uint16_t List_File(uint16_t index) {
+    DIR dir;
+    FILINFO info;
+    FRESULT result = f_opendir(&dir, USERPath);
+
+    while (result == FR_OK) {
+        result = f_readdir(&dir, &info);
+        if (result != FR_OK || info.fname[0] == '\0') {
+            break;
+        }
+        if ((info.fattrib & AM_DIR) || index-- > 0) {
+            continue;
+        }
+        f_closedir(&dir);
+
+        uint8_t nameLength = strlen(info.fname);
+        serviceResponse[0] = LOG_SERVICE_LIST + LOG_SERVICE_POSITIVE;
+        Put_U32(&serviceResponse[1], info.fsize);
+        memcpy(&serviceResponse[5], info.fname, nameLength);
+        return 5 + nameLength;
+    }
+    f_closedir(&dir);
+    return Negative(LOG_SERVICE_LIST, (result == FR_OK) ? FR_NO_FILE : result);
+}
+
+/* Function Implementation --------------------------------------------------*/
+
+uint16_t Log_Service_Handle(const uint8_t* request, uint16_t length, const uint8_t** response) {
+    FRESULT result;
+
+    *response = serviceResponse;
+    if (length == 0) {
+        return Negative(0, LOG_SERVICE_BAD_REQUEST);
+    }
+
+    switch (request[0]) {
+    case LOG_SERVICE_LIST:
+        if (length != 3) {
+            return Negative(request[0], LOG_SERVICE_BAD_REQUEST);
+        }
+        return List_File(request[1] | (request[2] << 8));
+
+    case LOG_SERVICE_OPEN: {
+        char path[20];
+        char name[13];
+        if (length < 2 || length > 13) {
+            return Negative(request[0], LOG_SERVICE_BAD_REQUEST);
+        }
+        if (serviceFileOpen) {
+            f_close(&serviceFile);
+            serviceFileOpen = false;
+        }
+        // FatFs would only say FR_LOCKED, tell the tester the file is still growing
+        snprintf(name, sizeof(name), "%.*s", length - 1, &request[1]);
+        if (CAN_Capture_Is_Active(name)) {
+            return Negative(request[0], LOG_SERVICE_CAPTURING);
+        }
+        snprintf(path, sizeof(path), "%s%s", USERPath, name);
+        result = f_open(&serviceFile, path, FA_READ | FA_OPEN_EXISTING);
+        if (result != FR_OK) {
+            return Negative(request[0], result);
+        }
+        serviceFileOpen = true;
+        serviceResponse[0] = LOG_SERVICE_OPEN + LOG_SERVICE_POSITIVE;
+        Put_U32(&serviceResponse[1], f_size(&serviceFile));
+        return 5;
+    }
+
+    case LOG_SERVICE_READ: {
+        UINT read;
+        if (length != 7 || !serviceFileOpen) {
+            return Negative(request[0], LOG_SERVICE_BAD_REQUEST);
+        }
+        uint32_t offset = Get_U32(&request[1]);
+        uint16_t count = request[5] | (request[6] << 8);
+        if (count > LOG_SERVICE_MAX_READ) {
+            count = LOG_SERVICE_MAX_READ;
+        }
+
+        // Sequential reads skip the seek
+        if (f_tell(&serviceFile) != offset) {
+            result = f_lseek(&serviceFile, offset);
+            if (result != FR_OK) {
+                return Negative(request[0], result);
+            }
+        }
+        result = f_read(&serviceFile, &serviceResponse[5], count, &read);
+        if (result != FR_OK) {
+            return Negative(request[0], result);
+        }
+        serviceResponse[0] = LOG_SERVICE_READ + LOG_SERVICE_POSITIVE;
+        Put_U32(&serviceResponse[1], offset);
+        return 5 + read;
+    }
+
+    case LOG_SERVICE_CLOSE:
+        if (serviceFileOpen) {
+            f_close(&serviceFile);
+            serviceFileOpen = false;
+        }
+        serviceResponse[0] = LOG_SERVICE_CLOSE + LOG_SERVICE_POSITIVE;
+        return 1;
+
+    case LOG_SERVICE_OFFLOAD: {
+        char name[13];
+        if (length > 13) {
+            return Negative(request[0], LOG_SERVICE_BAD_REQUEST);
+        }
+        // Without a name the newest capture goes, the LoRa task sends it when the radio is free
+        snprintf(name, sizeof(name), "%.*s", length - 1, &request[1]);
+        LoRa_Offload_Request(name);
+        serviceResponse[0] = LOG_SERVICE_OFFLOAD + LOG_SERVICE_POSITIVE;
+        return 1;
+    }
+
+    default:
+        return Negative(request[0], LOG_SERVICE_BAD_REQUEST);
+    }
+}
@@ -4,12 +4,46 @@
 * @date    10/2024
 * 
 * @brief   Implementation of RFM95W LoRa Module Driver
+* @note    Build with LORA_HOST to run against the simulated module in
+*          Tools/lora_sim.c, which raises DIO0 itself
 ***********************************************/                                                                                                                                               
 
+#include <string.h>
+
 #include "lora.h"
 
 LoRa_Mode loraMode = LORA_STANDBY; // Module inits to Standby Mode
 uint8_t loraRecvFlag = 0;
+static TaskHandle_t loraWaitingTask; // Task woken by DIO0
+
+// Modem settings mirrored from the setters, used for airtime
+static LoRa_Config loraConfig = {
+    .sf = LORA_SF_7,
+    .bw = LORA_BW_500,
+    .cr = LORA_CR_4_5,
+    .preamble = 8,
+    .crc = false,
+    .lowDataRate = false,
+};
+
+// Bandwidth in Hz indexed by LoRa_BW
+static const uint32_t loraBandwidthHz[] = {
+    7812, 10417, 15625, 20833, 31250, 41667, 62500, 125000, 250000, 500000,
+};
+
+// Shadow of the configuration registers, one bit per register in the masks
+static uint8_t loraShadow[LORA_SHADOW_SIZE];
+static uint8_t loraShadowValid[LORA_SHADOW_SIZE / 8]; // Shadow holds the module's value
+static uint8_t loraShadowDirty[LORA_SHADOW_SIZE / 8]; // Shadow changed, not yet written
+static bool loraShadowPending; // Any dirty bit set
+static bool loraIrqPending = true; // RegIrqFlags may hold a stale TxDone
+static bool loraFsk; // FSK modem selected, the page registers are not LoRa ones
+
+// SPI transaction counts
+static uint32_t loraSpiCount;
+static uint32_t loraSpiStart; // loraSpiCount at Lora_Transmit_Start
+static uint16_t loraSpiPacket;
+static uint16_t loraRxPackets; // RegRxPacketCntValue at the last Lora_RX_Read
 
 /* Static Functions ---------------------------------------------------------*/
 
@@ -50,117 +84,295 @@ static uint8_t Lora_Read_Reg(uint8_t reg);
  */
 static LoRa_Status Lora_Read(uint8_t reg, uint8_t* data, size_t len);
 
+/**
+ * @brief Check if a register is kept in the shadow
+ * @note Only registers the module never changes by itself, flags, RSSI
+ *       and FIFO pointers are always read from the module
+ * 
+ * @param reg [uint8_t] Register Address
+ * @return bool
+ */
+static bool Lora_Is_Shadowed(uint8_t reg);
+
+/**
+ * @brief Read a register, from the shadow if it is shadowed and valid
+ * 
+ * @param reg [uint8_t] Register Address
+ * @return uint8_t Register value
+ */
+static uint8_t Lora_Get_Reg(uint8_t reg);
+
+/**
+ * @brief Change bits of a shadowed register and mark it dirty
+ * @note Nothing is sent until Lora_Flush, an unchanged value is never sent.
+ *       A full mask of an uncached register skips the read, registers
+ *       outside the shadow are written straight through.
+ * 
+ * @param reg [uint8_t] Register Address
+ * @param mask [uint8_t] Bits to change
+ * @param value [uint8_t] New value of the masked bits
+ */
+static void Lora_Set_Reg(uint8_t reg, uint8_t mask, uint8_t value);
+
+/**
+ * @brief Write every dirty register to the module
+ * @note Runs of adjacent dirty registers go in one burst
+ * 
+ * @return LoRa_Status
+ */
+static LoRa_Status Lora_Flush();
+
+/**
+ * @brief RSSI of a received packet from its registers
+ * 
+ * @param raw [uint8_t] RegPktRssiValue
+ * @param snr [int8_t] RegPktSnrValue
+ * @return [int16_t] dBm
+ */
+static int16_t Lora_Packet_RSSI(uint8_t raw, int8_t snr);
+
 /** 
  * @brief Set the Mode of the LoRa Module
  * @note Also updates the global loraMode variable
+ * @note Flushes pending configuration first, the mode is not read back
  * 
  * @param mode [LoRa_Mode] Mode to set the module to
  * @return LoRa_Status
  */
 static LoRa_Status Lora_Set_Mode(LoRa_Mode mode);
 
+/**
+ * @brief Drop the shadow of the registers the LoRa and FSK modems do not share
+ * @note Addresses 0x0D-0x3F mean different registers in each modem
+ */
+static void Lora_Forget_Page();
+
+/**
+ * @brief Set LowDataRateOptimize for the current SF and bandwidth
+ * @note Required by the datasheet once a symbol is longer than 16 ms
+ */
+static void Lora_Update_Low_Data_Rate();
+
 /* Function Implementation --------------------------------------------------*/
 
 static LoRa_Status Lora_Write_Reg(uint8_t reg, uint8_t data) {
-    reg |= LORA_WRITE;
-    Clear_Pin(LORA_GPIO, LORA_CS);
-    SPI_Transmit(LORA_SPI, &reg, 1);
-    SPI_Transmit(LORA_SPI, &data, 1);
-    Set_Pin(LORA_GPIO, LORA_CS);
-    return LORA_OK;
+    uint8_t frame[2] = { reg | LORA_WRITE, data };
+    loraSpiCount++;
+    return (SPI2_Transfer(frame, NULL, sizeof(frame), 0) == SPI_OK) ? LORA_OK : LORA_ERROR;
 }
 
 static LoRa_Status Lora_Write(uint8_t reg, uint8_t* data, size_t len) {
     reg = reg | LORA_WRITE;
-    Clear_Pin(LORA_GPIO, LORA_CS);
-    SPI_Transmit(LORA_SPI, &reg, 1);
-    SPI_Transmit(LORA_SPI, data, len);
-    Set_Pin(LORA_GPIO, LORA_CS);
+    loraSpiCount++;
+    // Address byte keeps CS low, the payload goes by DMA while the task sleeps
+    if (SPI2_Transfer(&reg, NULL, 1, SPI_CS_HOLD) != SPI_OK ||
+        SPI2_Transfer(data, NULL, len, 0) != SPI_OK) {
+        return LORA_ERROR;
+    }
     return LORA_OK;
 }
 
 static uint8_t Lora_Read_Reg(uint8_t reg) {
-    uint8_t data;
-    reg &= ~LORA_WRITE;
-    Clear_Pin(LORA_GPIO, LORA_CS);
-    SPI_Transmit(LORA_SPI, &reg, 1);
-    SPI_Receive(LORA_SPI, &data, 1);
-    Set_Pin(LORA_GPIO, LORA_CS);
-    return data;
+    uint8_t tx[2] = { reg & ~LORA_WRITE, 0x00 };
+    uint8_t rx[2] = { 0 };
+    loraSpiCount++;
+    SPI2_Transfer(tx, rx, sizeof(tx), 0);
+    return rx[1];
 }
 
 static LoRa_Status Lora_Read(uint8_t reg, uint8_t* data, size_t len) {
-    Clear_Pin(LORA_GPIO, LORA_CS);
-    SPI_Transmit(LORA_SPI, &reg, 1);
-    SPI_Receive(LORA_SPI, data, len);
-    Set_Pin(LORA_GPIO, LORA_CS);
+    reg &= ~LORA_WRITE;
+    loraSpiCount++;
+    if (SPI2_Transfer(&reg, NULL, 1, SPI_CS_HOLD) != SPI_OK ||
+        SPI2_Transfer(NULL, data, len, 0) != SPI_OK) {
+        return LORA_ERROR;
+    }
     return LORA_OK;
 }
 
+static bool Lora_Is_Shadowed(uint8_t reg) {
+    switch (reg) {
+    case RegOpMode:
+    case RegFrfMsb:
+    case RegFrfMid:
+    case RegFrfLsb:
+    case RegPaConfig:
+    case RegFifoTxBaseAddr:
+    case RegFifoRxBaseAddr:
+    case RegModemConfig1:
+    case RegModemConfig2:
+    case RegPreambleMsb:
+    case RegPreambleLsb:
+    case RegPayloadLength:
+    case RegModemConfig3:
+    case RegDioMapping1:
+    case RegPaDac:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static uint8_t Lora_Get_Reg(uint8_t reg) {
+    if (!Lora_Is_Shadowed(reg)) {
+        return Lora_Read_Reg(reg);
+    }
+    if (!(loraShadowValid[reg / 8] & (1 << (reg % 8)))) {
+        loraShadow[reg] = Lora_Read_Reg(reg);
+        loraShadowValid[reg / 8] |= (1 << (reg % 8));
+    }
+    return loraShadow[reg];
+}
+
+static void Lora_Set_Reg(uint8_t reg, uint8_t mask, uint8_t value) {
+    uint8_t bit = (1 << (reg % 8));
+    uint8_t regData;
+
+    if (!Lora_Is_Shadowed(reg)) {
+        Lora_Write_Reg(reg, (Lora_Read_Reg(reg) & ~mask) | (value & mask));
+        return;
+    }
+    if (mask == 0xFF && !(loraShadowValid[reg / 8] & bit)) {
+        regData = value;
+    }
+    else {
+        regData = (Lora_Get_Reg(reg) & ~mask) | (value & mask);
+        if (regData == loraShadow[reg]) {
+            return;
+        }
+    }
+    loraShadow[reg] = regData;
+    loraShadowValid[reg / 8] |= bit;
+    loraShadowDirty[reg / 8] |= bit;
+    loraShadowPending = true;
+}
+
+static LoRa_Status Lora_Flush() {
+    LoRa_Status status = LORA_OK;
+    uint8_t reg = 0;
+
+    if (!loraShadowPending) {
+        return LORA_OK;
+    }
+    loraShadowPending = false;
+
+    while (reg < LORA_SHADOW_SIZE) {
+        if (!(loraShadowDirty[reg / 8] & (1 << (reg % 8)))) {
+            reg++;
+            continue;
+        }
+
+        // The address auto-increments, so a run of dirty registers is one transaction
+        uint8_t first = reg;
+        while (reg < LORA_SHADOW_SIZE && (loraShadowDirty[reg / 8] & (1 << (reg % 8)))) {
+            loraShadowDirty[reg / 8] &= ~(1 << (reg % 8));
+            reg++;
+        }
+        if (reg - first == 1) {
+            if (Lora_Write_Reg(first, loraShadow[first]) != LORA_OK) {
+                status = LORA_ERROR;
+            }
+        }
+        else if (Lora_Write(first, &loraShadow[first], reg - first) != LORA_OK) {
+            status = LORA_ERROR;
+        }
+    }
+    return status;
+}
+
+static int16_t Lora_Packet_RSSI(uint8_t raw, int8_t snr) {
+    // SX1276 datasheet 5.5.5, high frequency port, below the noise floor SNR adds on
+    int16_t rssi = -157 + raw;
+    if (snr < 0) {
+        rssi += snr / 4;
+    }
+    return rssi;
+}
+
 static LoRa_Status Lora_Set_Mode(LoRa_Mode mode) {
-    uint8_t regData = Lora_Read_Reg(RegOpMode);
-    regData &= ~RegOpMode_Mode;
-    regData |= (mode << RegOpMode_Mode_Pos);
-    Lora_Write_Reg(RegOpMode, regData);
-    loraMode = Lora_Read_Reg(RegOpMode) & RegOpMode_Mode;
-    if (loraMode != mode) {
+    // Configuration goes out before the mode that uses it
+    if (Lora_Flush() != LORA_OK) {
         return LORA_ERROR;
     }
-    return LORA_OK;
+    Lora_Set_Reg(RegOpMode, RegOpMode_Mode, (mode << RegOpMode_Mode_Pos));
+    loraMode = mode;
+    return Lora_Flush();
+}
+
+static void Lora_Forget_Page() {
+    for (uint8_t reg = RegFifoAddrPtr; reg < RegDioMapping1; reg++) {
+        loraShadowValid[reg / 8] &= ~(1 << (reg % 8));
+        loraShadowDirty[reg / 8] &= ~(1 << (reg % 8));
+    }
+}
+
+static void Lora_Update_Low_Data_Rate() {
+    // Symbol time 2^SF / BW above 16 ms
+    bool lowDataRate = ((uint32_t)1000 << loraConfig.sf) > 16 * loraBandwidthHz[loraConfig.bw];
+
+    Lora_Set_Reg(RegModemConfig3, RegModemConfig3_LowDataRateOpt,
+        lowDataRate ? RegModemConfig3_LowDataRateOpt : 0);
+    loraConfig.lowDataRate = lowDataRate;
 }
 
 LoRa_Status Lora_Init() {
     volatile uint8_t regData = 0;
-    // Rising Edge Interrupt on PA9
+    // Forget the shadow, the module may have been reset
+    memset(loraShadowValid, 0, sizeof(loraShadowValid));
+    memset(loraShadowDirty, 0, sizeof(loraShadowDirty));
+    loraShadowPending = false;
+    loraIrqPending = true;
+    loraFsk = false;
+
+#ifndef LORA_HOST
+    // Rising Edge Interrupt on PA9 (DIO0)
     // Calls EXTI9_5_IRQHandler when PA9 gets set high
-    GPIO_EXTI_Init(LORA_GPIO, LORA_INT);
-    NVIC_SetPriority(EXTI9_5_IRQn, 2);
+    GPIO_EXTI_Init(LORA_IO_PORT, LORA_INT);
+    NVIC_SetPriority(EXTI9_5_IRQn, LORA_IRQ_PRIORITY);
     NVIC_EnableIRQ(EXTI9_5_IRQn);
+#endif
 
     // Enter Sleep Mode
     Lora_Set_Mode(LORA_SLEEP);
 
     // Set Long Range Mode (LoRa) and High Frequency Mode
-    regData = Lora_Read_Reg(RegOpMode);
-    regData |= RegOpMode_LongRangeMode;
-    regData &= ~RegOpMode_LowFrequencyModeOn;
-    Lora_Write_Reg(RegOpMode, regData);
+    // Read back from the module, not the shadow, to check it is there
+    Lora_Set_Reg(RegOpMode, RegOpMode_LongRangeMode | RegOpMode_LowFrequencyModeOn,
+        RegOpMode_LongRangeMode);
+    Lora_Flush();
     if (!(Lora_Read_Reg(RegOpMode) & RegOpMode_LongRangeMode) ||
         (Lora_Read_Reg(RegOpMode) & RegOpMode_LowFrequencyModeOn)) {
         return LORA_ERROR;
     }
 
     // Configure FIFO Pointers
-    Lora_Write_Reg(RegFifoTxBaseAddr, RegFifo);
-    Lora_Write_Reg(RegFifoRxBaseAddr, RegFifo);
+    Lora_Set_Reg(RegFifoTxBaseAddr, 0xFF, RegFifo);
+    Lora_Set_Reg(RegFifoRxBaseAddr, 0xFF, RegFifo);
+    Lora_Flush();
     if (Lora_Read_Reg(RegFifoTxBaseAddr) != RegFifo ||
         Lora_Read_Reg(RegFifoRxBaseAddr) != RegFifo) {
         return LORA_ERROR;
     }
 
     // Set the Module to Standby Mode and wait for it to enter
-    while (Lora_Set_Mode(LORA_STANDBY) != LORA_OK);
+    Lora_Set_Mode(LORA_STANDBY);
+    while ((Lora_Read_Reg(RegOpMode) & RegOpMode_Mode) != (LORA_STANDBY << RegOpMode_Mode_Pos));
 
     // Set Bandwidth and Coding Rate
     Lora_Set_CodingRate(LORA_CR_4_5);
     Lora_Set_BW(LORA_BW_500);
 
     // Explicit Header Mode
-    regData = Lora_Read_Reg(RegModemConfig1);
-    regData &= ~RegModemConfig1_ImplicitHeaderModeOn;
-    Lora_Write_Reg(RegModemConfig1, regData);
+    Lora_Set_Reg(RegModemConfig1, RegModemConfig1_ImplicitHeaderModeOn, 0);
 
     // Set Spreading Factor, CRC
     Lora_Set_SF(LORA_SF_7);
     Lora_Set_CRC(false);
 
-    regData = Lora_Read_Reg(RegModemConfig2);
-
     // Disable Low data rate and set AGC On
-    regData = Lora_Read_Reg(RegModemConfig3);
-    regData &= ~RegModemConfig3_LowDataRateOpt;
-    regData |= RegModemConfig3_AgcAutoOn;
-    Lora_Write_Reg(RegModemConfig3, regData);
+    Lora_Set_Reg(RegModemConfig3, RegModemConfig3_LowDataRateOpt | RegModemConfig3_AgcAutoOn,
+        RegModemConfig3_AgcAutoOn);
+    loraConfig.lowDataRate = false;
 
     // Set Preamble Length
     Lora_Set_Preamble(8);
@@ -168,17 +380,18 @@ LoRa_Status Lora_Init() {
     // Calculate and set Carrier Frequency
     // To use a different frequency, change the LORA_FREQ macro
     regData = (((uint32_t)RFM95_Frf >> 16) & 0xFF); // MSB
-    Lora_Write_Reg(RegFrfMsb, regData);
+    Lora_Set_Reg(RegFrfMsb, 0xFF, regData);
     regData = (((uint32_t)RFM95_Frf >> 8) & 0xFF); // MID
-    Lora_Write_Reg(RegFrfMid, regData);
+    Lora_Set_Reg(RegFrfMid, 0xFF, regData);
     regData = (((uint32_t)RFM95_Frf >> 0) & 0xFF); // LSB
-    Lora_Write_Reg(RegFrfLsb, regData);
+    Lora_Set_Reg(RegFrfLsb, 0xFF, regData);
 
     // Set Power to 20 dBm
-    Lora_Write_Reg(RegPaDac, RegPaDac_20dBm);
-    Lora_Write_Reg(RegPaConfig, RegPaConfig_20dBm);
+    Lora_Set_Reg(RegPaDac, 0xFF, RegPaDac_20dBm);
+    Lora_Set_Reg(RegPaConfig, 0xFF, RegPaConfig_20dBm);
 
-    return LORA_OK;
+    // Frequency and power in one burst, modem settings in another
+    return Lora_Flush();
 }
 
 LoRa_Status Lora_Set_SF(LoRa_SF sf) {
@@ -190,11 +403,10 @@ LoRa_Status Lora_Set_SF(LoRa_SF sf) {
         sf = LORA_SF_12;
     }
 
-    // Read and Rewrite Register
-    uint8_t regData = Lora_Read_Reg(RegModemConfig2);
-    regData &= ~RegModemConfig2_SpreadingFactor;
-    regData |= (sf << RegModemConfig2_SpreadingFactor_Pos);
-    Lora_Write_Reg(RegModemConfig2, regData);
+    Lora_Set_Reg(RegModemConfig2, RegModemConfig2_SpreadingFactor,
+        (sf << RegModemConfig2_SpreadingFactor_Pos));
+    loraConfig.sf = sf;
+    Lora_Update_Low_Data_Rate();
 
     return LORA_OK;
 }
@@ -208,11 +420,9 @@ LoRa_Status Lora_Set_BW(LoRa_BW bw) {
         bw = LORA_BW_500;
     }
 
-    // Read and Rewrite Register
-    uint8_t regData = Lora_Read_Reg(RegModemConfig1);
-    regData &= ~RegModemConfig1_Bw;
-    regData |= (bw << RegModemConfig1_Bw_Pos);
-    Lora_Write_Reg(RegModemConfig1, regData);
+    Lora_Set_Reg(RegModemConfig1, RegModemConfig1_Bw, (bw << RegModemConfig1_Bw_Pos));
+    loraConfig.bw = bw;
+    Lora_Update_Low_Data_Rate();
     return LORA_OK;
 }
 
@@ -225,42 +435,71 @@ LoRa_Status Lora_Set_CodingRate(LoRa_CR cr) {
         cr = LORA_CR_4_8;
     }
 
-    // Read and Rewrite Register
-    uint8_t regData = Lora_Read_Reg(RegModemConfig1);
-    regData &= ~RegModemConfig1_CodingRate;
-    regData |= (cr << RegModemConfig1_CodingRate_Pos);
-    Lora_Write_Reg(RegModemConfig1, regData);
+    Lora_Set_Reg(RegModemConfig1, RegModemConfig1_CodingRate,
+        (cr << RegModemConfig1_CodingRate_Pos));
+    loraConfig.cr = cr;
     return LORA_OK;
 }
 
 LoRa_Status Lora_Set_CRC(bool crc) {
-    uint8_t regData = Lora_Read_Reg(RegModemConfig2);
-    if (crc) {
-        regData |= RegModemConfig2_RxPayloadCrcOn;
-    }
-    else {
-        regData &= ~RegModemConfig2_RxPayloadCrcOn;
-    }
-    Lora_Write_Reg(RegModemConfig2, regData);
+    Lora_Set_Reg(RegModemConfig2, RegModemConfig2_RxPayloadCrcOn,
+        crc ? RegModemConfig2_RxPayloadCrcOn : 0);
+    loraConfig.crc = crc;
     
     return LORA_OK;
 }
 
 LoRa_Status Lora_Set_Preamble(uint16_t preamble) {
-    Lora_Write_Reg(RegPreambleMsb, ((preamble >> 8) & 0xFF));
-    Lora_Write_Reg(RegPreambleLsb, (preamble & 0xFF));
+    Lora_Set_Reg(RegPreambleMsb, 0xFF, ((preamble >> 8) & 0xFF));
+    Lora_Set_Reg(RegPreambleLsb, 0xFF, (preamble & 0xFF));
+    loraConfig.preamble = preamble;
     return LORA_OK;
 }
 
+void Lora_Get_Config(LoRa_Config* config) {
+    if (config != NULL) {
+        *config = loraConfig;
+    }
+}
+
+void Lora_Get_SPI_Stats(LoRa_SPI_Stats* stats) {
+    if (stats != NULL) {
+        stats->total = loraSpiCount;
+        stats->lastPacket = loraSpiPacket;
+    }
+}
+
+uint32_t Lora_Get_Airtime(size_t len) {
+    // Semtech SX1276 datasheet 4.1.1.7, explicit header, counted in quarter symbols
+    int32_t sf = loraConfig.sf;
+    int32_t de = loraConfig.lowDataRate ? 1 : 0;
+    int32_t bits = 8 * (int32_t)len - 4 * sf + 28 + (loraConfig.crc ? 16 : 0);
+    int32_t bitsPerSymbol = 4 * (sf - 2 * de);
+    int32_t payloadSymbols = 8;
+
+    if (bits > 0) {
+        payloadSymbols += ((bits + bitsPerSymbol - 1) / bitsPerSymbol) * (loraConfig.cr + 4);
+    }
+
+    uint32_t quarterSymbols = 4 * (uint32_t)loraConfig.preamble + 17 + 4 * payloadSymbols;
+    return (uint32_t)((((uint64_t)quarterSymbols << sf) * 1000000) /
+        (4 * loraBandwidthHz[loraConfig.bw]));
+}
+
 LoRa_Status Lora_Transmit(uint8_t* data, size_t len) {
-    if (len == 0 || len == NULL || 
-        len > LORA_MAX_PAYLOAD_LEN || data == NULL) {
+    if (Lora_Transmit_Start(data, len) != LORA_OK) {
         return LORA_ERROR;
     }
+    return Lora_Transmit_Complete(LORA_TX_TIMEOUT);
+}
 
-    uint8_t regData = 0;
+LoRa_Status Lora_Transmit_Start(uint8_t* data, size_t len) {
+    if (len == 0 || len > LORA_MAX_PAYLOAD_LEN || data == NULL) {
+        return LORA_ERROR;
+    }
 
-    Lora_Set_Mode(LORA_STANDBY);
+    loraSpiStart = loraSpiCount;
+    Lora_Set_Mode(LORA_STANDBY); // Already there unless the last packet failed
 
     // Set Address Pointer to FIFO
     Lora_Write_Reg(RegFifoAddrPtr, RegFifo);
@@ -268,48 +507,81 @@ LoRa_Status Lora_Transmit(uint8_t* data, size_t len) {
     // Write data to FIFO
     Lora_Write(RegFifo, data, len);
 
-    // Set Payload Length
-    Lora_Write_Reg(RegPayloadLength, len);
+    // Set Payload Length, only sent when it changes
+    Lora_Set_Reg(RegPayloadLength, 0xFF, len);
 
-    // Clear TXDone and Set to TX Mode
-    Lora_Write_Reg(RegIrqFlags, RegIrqFlags_TxDone);
+    // Raise DIO0 on TxDone and drop any wake-up left from an earlier packet
+    Lora_Set_Reg(RegDioMapping1, RegDioMapping1_Dio0Mapping, RegDioMapping1_Dio0_TxDone);
+    loraWaitingTask = xTaskGetCurrentTaskHandle();
+    ulTaskNotifyTake(pdTRUE, 0);
+
+    // Clear TXDone if a failed packet may have left it and Set to TX Mode
+    if (loraIrqPending) {
+        Lora_Write_Reg(RegIrqFlags, RegIrqFlags_TxDone);
+        loraIrqPending = false;
+    }
     Lora_Set_Mode(LORA_TX);
 
-    // Check for TX Done
-    while (1) {
-        regData = Lora_Read_Reg(RegIrqFlags);
-        if (regData & RegIrqFlags_TxDone) {
-            Lora_Write_Reg(RegIrqFlags, RegIrqFlags_TxDone); // Clear Flag
-            break;
-        }
+    return LORA_OK;
+}
+
+LoRa_Status Lora_Transmit_Complete(TickType_t timeout) {
+    // Sleep through the airtime, DIO0 wakes us on TxDone
+    ulTaskNotifyTake(pdTRUE, timeout);
+    loraWaitingTask = NULL;
+
+    // Check the flag as well in case the edge was missed
+    if (!(Lora_Read_Reg(RegIrqFlags) & RegIrqFlags_TxDone)) {
+        Lora_Set_Mode(LORA_STANDBY);
+        loraIrqPending = true;
+        loraSpiPacket = loraSpiCount - loraSpiStart;
+        return LORA_TX_ERROR;
     }
+    Lora_Write_Reg(RegIrqFlags, RegIrqFlags_TxDone); // Clear Flag
 
+    // The module drops back to Standby by itself after TxDone
+    loraShadow[RegOpMode] = (loraShadow[RegOpMode] & ~RegOpMode_Mode) | (LORA_STANDBY << RegOpMode_Mode_Pos);
+    loraMode = LORA_STANDBY;
+    loraSpiPacket = loraSpiCount - loraSpiStart;
     return LORA_OK;
 }
 
+void Lora_DIO0_IRQHandler() {
+    if (loraWaitingTask != NULL) {
+        BaseType_t xHPW = pdFALSE;
+        vTaskNotifyGiveFromISR(loraWaitingTask, &xHPW);
+#ifndef LORA_HOST
+        portYIELD_FROM_ISR(xHPW);
+#endif
+    }
+}
+
 LoRa_Status Lora_Receive(uint8_t* data, uint8_t* len) {
-    volatile uint8_t regData = 0;
-    volatile uint8_t opMode = 0;
+    return Lora_Receive_Timeout(data, LORA_MAX_PAYLOAD_LEN, len, portMAX_DELAY);
+}
 
-    // Set to RX Continuous Mode
-    Lora_Set_Mode(LORA_STANDBY);
-    Lora_Set_Mode(LORA_RX_CONTINUOUS);
-    opMode = Lora_Read_Reg(RegOpMode);
-    
-    // if (Lora_Set_Mode(LORA_RX_CONTINUOUS) != LORA_OK) {
-    //     return LORA_ERROR;
-    // }
+LoRa_Status Lora_Receive_Timeout(uint8_t* data, uint8_t size, uint8_t* len, TickType_t timeout) {
+    TickType_t start = xTaskGetTickCount();
 
-    // Wait for RX Done
-    while (1) {
-        regData = Lora_Read_Reg(RegIrqFlags);
-        if (regData & RegIrqFlags_RxDone) {
-            break;
+    Lora_RX_Start();
+
+    // Sleep until RX Done
+    while (!(Lora_Read_Reg(RegIrqFlags) & RegIrqFlags_RxDone)) {
+        TickType_t waited = xTaskGetTickCount() - start;
+        if (timeout != portMAX_DELAY && waited >= timeout) {
+            loraWaitingTask = NULL;
+            Lora_Set_Mode(LORA_STANDBY);
+            return LORA_RX_TIMEOUT;
         }
+        ulTaskNotifyTake(pdTRUE, (timeout == portMAX_DELAY) ? portMAX_DELAY : timeout - waited);
     }
+    loraWaitingTask = NULL;
 
     // Read the length of the received packet
     *len = Lora_Read_Reg(RegRxNbBytes);
+    if (*len > size) {
+        *len = size;
+    }
 
     // Set FIFO address to current RX address
     // uint8_t rxAddr = Lora_Read_Reg(RegFifoRxCurrentAddr);
@@ -325,4 +597,199 @@ LoRa_Status Lora_Receive(uint8_t* data, uint8_t* len) {
     Lora_Set_Mode(LORA_STANDBY);
 
     return LORA_OK;
-}
\ No newline at end of file
+}
+
+LoRa_Status Lora_RX_Start() {
+    // Raise DIO0 on RxDone and set to RX Continuous Mode
+    Lora_Set_Mode(LORA_STANDBY);
+    Lora_Set_Reg(RegDioMapping1, RegDioMapping1_Dio0Mapping, RegDioMapping1_Dio0_RxDone);
+    Lora_Write_Reg(RegIrqFlags, RegIrqFlags_RxDone | RegIrqFlags_PayloadCrcError |
+        RegIrqFlags_ValidHeader); // Drop a late packet
+    loraWaitingTask = xTaskGetCurrentTaskHandle();
+    ulTaskNotifyTake(pdTRUE, 0);
+    loraRxPackets = 0; // The module counts from entering RX
+    return Lora_Set_Mode(LORA_RX_CONTINUOUS);
+}
+
+LoRa_Status Lora_RX_Read(LoRa_RX_Frame* frame, TickType_t timeout) {
+    // RegFifoRxCurrentAddr through RegPktRssiValue
+    uint8_t regs[RegPktRssiValue - RegFifoRxCurrentAddr + 1];
+    uint8_t* flags = &regs[RegIrqFlags - RegFifoRxCurrentAddr];
+    TickType_t start = xTaskGetTickCount();
+
+    while (1) {
+        if (Lora_Read(RegFifoRxCurrentAddr, regs, sizeof(regs)) != LORA_OK) {
+            return LORA_ERROR;
+        }
+        if (*flags & RegIrqFlags_RxDone) {
+            break;
+        }
+        // DIO0 notifications that arrive after the read are kept for the wait
+        TickType_t waited = xTaskGetTickCount() - start;
+        if (waited >= timeout) {
+            return LORA_RX_TIMEOUT;
+        }
+        ulTaskNotifyTake(pdTRUE, timeout - waited);
+    }
+
+    // Clear at once, a frame landing after this raises its own RxDone
+    Lora_Write_Reg(RegIrqFlags, *flags & (RegIrqFlags_RxDone | RegIrqFlags_PayloadCrcError |
+        RegIrqFlags_ValidHeader));
+
+    uint16_t packets = (regs[RegRxPacketCntValueMsb - RegFifoRxCurrentAddr] << 8) |
+        regs[RegRxPacketCntValueLsb - RegFifoRxCurrentAddr];
+    frame->missed = (uint16_t)(packets - loraRxPackets - 1);
+    loraRxPackets = packets;
+    frame->length = regs[RegRxNbBytes - RegFifoRxCurrentAddr];
+    frame->crcError = (*flags & RegIrqFlags_PayloadCrcError) != 0;
+    frame->snr = (int8_t)regs[RegPktSnrValue - RegFifoRxCurrentAddr];
+    frame->rssi = Lora_Packet_RSSI(regs[RegPktRssiValue - RegFifoRxCurrentAddr], frame->snr);
+
+    if (frame->length == 0) {
+        return LORA_OK;
+    }
+
+    // The frame stays where it landed, later frames go after it
+    Lora_Write_Reg(RegFifoAddrPtr, regs[0]);
+    return Lora_Read(RegFifo, frame->data, frame->length);
+}
+
+LoRa_Status Lora_FSK_Start() {
+    // The modem can only change in Sleep, which also empties the FIFO
+    Lora_Set_Mode(LORA_SLEEP);
+    Lora_Set_Reg(RegOpMode, RegOpMode_LongRangeMode | RegOpMode_ModulationType, 0);
+    if (Lora_Flush() != LORA_OK) {
+        return LORA_ERROR;
+    }
+    Lora_Forget_Page();
+    loraFsk = true;
+
+    // Bit rate and deviation in one burst
+    uint16_t bitrate = (uint16_t)(RFM95_XOSC_FREQ / LORA_FSK_BITRATE + 0.5);
+    uint16_t fdev = (uint16_t)(LORA_FSK_FDEV / RFM95_FSTEP + 0.5);
+    uint8_t rates[] = { bitrate >> 8, bitrate & 0xFF, fdev >> 8, fdev & 0xFF };
+    Lora_Write(RegBitrateMsb, rates, sizeof(rates));
+    Lora_Write_Reg(RegPaRamp, RegPaRamp_Gaussian_1_0 | RegPaRamp_40us);
+
+    // Receiver starts on a preamble, no AFC so the turnaround stays short
+    uint8_t bandwidths[] = { RegRxBw_250kHz, RegRxBw_250kHz };
+    Lora_Write(RegRxBw, bandwidths, sizeof(bandwidths));
+    Lora_Write_Reg(RegRxConfig, RegRxConfig_AgcAutoOn | RegRxConfig_RxTrigger_Preamble);
+    Lora_Write_Reg(RegPreambleDetect, RegPreambleDetect_On | (1 << RegPreambleDetect_Size_Pos) |
+        (10 << RegPreambleDetect_Tol_Pos));
+
+    // Preamble, 4 byte sync word and RX restarting by itself after each packet
+    uint8_t sync[] = {
+        0, LORA_FSK_PREAMBLE,
+        RegSyncConfig_AutoRestartRx_NoPll | RegSyncConfig_SyncOn | (3 << RegSyncConfig_SyncSize_Pos),
+        0x2D, 0xD4, 0x4C, 0x4F,
+    };
+    Lora_Write(RegPreambleMsbFsk, sync, sizeof(sync));
+
+    // Variable length with whitening and CRC, a failed CRC empties the FIFO
+    uint8_t packet[] = {
+        RegPacketConfig1_PacketFormat | RegPacketConfig1_DcFree_Whitening | RegPacketConfig1_CrcOn,
+        RegPacketConfig2_DataMode,
+        LORA_FSK_MAX_PAYLOAD,
+    };
+    Lora_Write(RegPacketConfig1, packet, sizeof(packet));
+    Lora_Write_Reg(RegFifoThresh, RegFifoThresh_TxStartCondition | (15 << RegFifoThresh_FifoThreshold_Pos));
+
+    Lora_Set_Reg(RegDioMapping1, RegDioMapping1_Dio0Mapping, RegDioMapping1_Dio0_PacketSent);
+    return Lora_Set_Mode(LORA_STANDBY);
+}
+
+LoRa_Status Lora_FSK_Stop() {
+    Lora_Set_Mode(LORA_SLEEP);
+    Lora_Set_Reg(RegOpMode, RegOpMode_LongRangeMode | RegOpMode_ModulationType, RegOpMode_LongRangeMode);
+    if (Lora_Flush() != LORA_OK) {
+        return LORA_ERROR;
+    }
+    Lora_Forget_Page();
+    loraFsk = false;
+    Lora_Write_Reg(RegPaRamp, RegPaRamp_40us);
+
+    // Write the whole LoRa page again from the settings, nothing is read back
+    Lora_Set_Reg(RegFifoTxBaseAddr, 0xFF, RegFifo);
+    Lora_Set_Reg(RegFifoRxBaseAddr, 0xFF, RegFifo);
+    Lora_Set_Reg(RegModemConfig1, 0xFF, (loraConfig.bw << RegModemConfig1_Bw_Pos) |
+        (loraConfig.cr << RegModemConfig1_CodingRate_Pos));
+    Lora_Set_Reg(RegModemConfig2, 0xFF, (loraConfig.sf << RegModemConfig2_SpreadingFactor_Pos) |
+        (loraConfig.crc ? RegModemConfig2_RxPayloadCrcOn : 0));
+    Lora_Set_Reg(RegModemConfig3, 0xFF, RegModemConfig3_AgcAutoOn |
+        (loraConfig.lowDataRate ? RegModemConfig3_LowDataRateOpt : 0));
+    Lora_Set_Preamble(loraConfig.preamble);
+    loraIrqPending = true;
+    return Lora_Set_Mode(LORA_STANDBY);
+}
+
+LoRa_Status Lora_FSK_Transmit(const uint8_t* data, uint8_t len) {
+    uint8_t packet[LORA_FSK_MAX_PAYLOAD + 1];
+
+    if (!loraFsk || len == 0 || len > LORA_FSK_MAX_PAYLOAD || data == NULL) {
+        return LORA_ERROR;
+    }
+
+    // Out of RX, and drop what a packet cut short left in the FIFO
+    Lora_Set_Mode(LORA_STANDBY);
+    Lora_Write_Reg(RegIrqFlags2, RegIrqFlags2_FifoOverrun);
+
+    // Length byte and payload in one burst, TX starts once the FIFO is not empty
+    packet[0] = len;
+    memcpy(&packet[1], data, len);
+    Lora_Write(RegFifo, packet, len + 1);
+
+    loraWaitingTask = xTaskGetCurrentTaskHandle();
+    ulTaskNotifyTake(pdTRUE, 0);
+    Lora_Set_Mode(LORA_TX);
+    ulTaskNotifyTake(pdTRUE, LORA_FSK_TX_TIMEOUT);
+    loraWaitingTask = NULL;
+
+    // The FSK transmitter stays on after the packet, Standby also clears PacketSent
+    bool sent = (Lora_Read_Reg(RegIrqFlags2) & RegIrqFlags2_PacketSent) != 0;
+    Lora_Set_Mode(LORA_STANDBY);
+    return sent ? LORA_OK : LORA_TX_ERROR;
+}
+
+LoRa_Status Lora_FSK_Receive(uint8_t* data, uint8_t* len, TickType_t timeout) {
+    TickType_t start = xTaskGetTickCount();
+    uint8_t length;
+
+    if (!loraFsk || data == NULL || len == NULL) {
+        return LORA_ERROR;
+    }
+
+    loraWaitingTask = xTaskGetCurrentTaskHandle();
+    if (loraMode != LORA_RX_CONTINUOUS) {
+        ulTaskNotifyTake(pdTRUE, 0);
+        Lora_Set_Mode(LORA_RX_CONTINUOUS);
+    }
+
+    while (!(Lora_Read_Reg(RegIrqFlags2) & RegIrqFlags2_PayloadReady)) {
+        TickType_t waited = xTaskGetTickCount() - start;
+        if (waited >= timeout) {
+            return LORA_RX_TIMEOUT;
+        }
+        ulTaskNotifyTake(pdTRUE, timeout - waited);
+    }
+
+    // Reading the FIFO empty clears PayloadReady and restarts RX
+    if (Lora_Read(RegFifo, &length, 1) != LORA_OK) {
+        return LORA_ERROR;
+    }
+    if (length == 0 || length > LORA_FSK_MAX_PAYLOAD) {
+        Lora_Write_Reg(RegIrqFlags2, RegIrqFlags2_FifoOverrun);
+        return LORA_ERROR;
+    }
+    *len = length;
+    return Lora_Read(RegFifo, data, length);
+}
+
+int8_t Lora_Get_Packet_SNR() {
+    return (int8_t)Lora_Read_Reg(RegPktSnrValue);
+}
+
+int16_t Lora_Get_Packet_RSSI() {
+    int8_t snr = Lora_Get_Packet_SNR();
+    return Lora_Packet_RSSI(Lora_Read_Reg(RegPktRssiValue), snr);
+}
@@ -0,0 +1,212 @@
+/************************************************
+* @file    lora_adr.c 
+* @author  APBashara
+* @date    10/2026
+* 
+* @brief   Adaptive LoRa Data Rate Implementation
+* @note    Link margin is the reported SNR over the demodulator limit of a
+*          step, corrected for the noise bandwidth, in quarter dB
+***********************************************/
+
+#include <stddef.h>
+
+#include "lora_adr.h"
+#include "task.h"
+
+#define ADR_NOISE_FLOOR             (-552) // -174 dBm/Hz thermal, 6 dB noise figure, Hz to kHz, quarter dB
+
+typedef struct {
+    LoRa_SF sf;
+    LoRa_BW bw;
+    LoRa_CR cr;
+    int16_t noise; // 10 log10 of the bandwidth in kHz, quarter dB
+    int16_t floor; // Lowest SNR the step demodulates, quarter dB
+} ADR_Step;
+
+// Fastest first, every step stays under 16 ms symbols so LowDataRateOptimize stays off
+static const ADR_Step adrSteps[] = {
+    { LORA_SF_7, LORA_BW_500, LORA_CR_4_5, 108, -30 },
+    { LORA_SF_7, LORA_BW_250, LORA_CR_4_5, 96, -30 },
+    { LORA_SF_8, LORA_BW_250, LORA_CR_4_5, 96, -40 },
+    { LORA_SF_8, LORA_BW_125, LORA_CR_4_5, 84, -40 },
+    { LORA_SF_9, LORA_BW_125, LORA_CR_4_5, 84, -50 },
+    { LORA_SF_10, LORA_BW_125, LORA_CR_4_5, 84, -60 },
+    { LORA_SF_10, LORA_BW_125, LORA_CR_4_8, 84, -64 }, // Stronger code rides out interference bursts
+};
+#define ADR_STEPS                   (sizeof(adrSteps) / sizeof(ADR_Step))
+
+static uint8_t adrStep; // Step in use
+static uint8_t adrNext; // Step announced in the next request
+static uint8_t adrMeasured; // Step the last request was sent at, the report measures it
+static uint8_t adrGood; // Reports in a row with room to step up
+static uint8_t adrLost; // Reports in a row that never came
+static TickType_t adrLastRequest;
+static LoRa_ADR_Stats adrStats;
+
+/* Static Functions ---------------------------------------------------------*/
+
+/**
+ * @brief Write the settings of a step to the radio
+ * @note The registers go out at the next mode change
+ * 
+ * @param step [uint8_t] Index in adrSteps
+ */
+static void Apply_Step(uint8_t step) {
+    Lora_Set_SF(adrSteps[step].sf);
+    Lora_Set_BW(adrSteps[step].bw);
+    Lora_Set_CodingRate(adrSteps[step].cr);
+    adrStep = step;
+    adrStats.step = step;
+}
+
+/**
+ * @brief Link margin a step would have, from a report measured at adrMeasured
+ * @note Once SNR saturates RSSI against the step sensitivity is the better guide
+ * 
+ * @param step [uint8_t] Index in adrSteps
+ * @param snr [int8_t] Reported SNR in quarter dB
+ * @param rssi [int16_t] Reported RSSI in dBm
+ * @return [int16_t] Margin in quarter dB
+ */
+static int16_t Margin(uint8_t step, int8_t snr, int16_t rssi) {
+    int16_t margin = snr + adrSteps[adrMeasured].noise - adrSteps[step].noise - adrSteps[step].floor;
+    if (snr >= LORA_ADR_SNR_SATURATED) {
+        int16_t rssiMargin = 4 * rssi - (ADR_NOISE_FLOOR + adrSteps[step].noise + adrSteps[step].floor);
+        if (rssiMargin > margin) {
+            margin = rssiMargin;
+        }
+    }
+    return margin;
+}
+
+/**
+ * @brief Pick the step for the next request
+ * @note Steps down at once on a thin margin, steps up only after
+ *       LORA_ADR_UP_REPORTS reports say the faster step keeps a wide one
+ * 
+ * @param snr [int8_t] Reported SNR in quarter dB
+ * @param rssi [int16_t] Reported RSSI in dBm
+ */
+static void Update_Policy(int8_t snr, int16_t rssi) {
+    adrNext = adrStep;
+
+    if (Margin(adrStep, snr, rssi) < 4 * LORA_ADR_MARGIN_DOWN) {
+        adrGood = 0;
+        if (adrStep + 1 < ADR_STEPS) {
+            adrNext = adrStep + 1;
+        }
+        return;
+    }
+
+    if (adrStep == 0 || Margin(adrStep - 1, snr, rssi) < 4 * LORA_ADR_MARGIN_UP) {
+        adrGood = 0;
+        return;
+    }
+    if (++adrGood >= LORA_ADR_UP_REPORTS) {
+        adrGood = 0;
+        adrNext = adrStep - 1;
+    }
+}
+
+/* Function Implementation --------------------------------------------------*/
+
+void LoRa_ADR_Init(TickType_t now) {
+    adrStep = 0;
+    adrNext = 0;
+    adrMeasured = 0;
+    adrGood = 0;
+    adrLost = 0;
+    adrLastRequest = now;
+    adrStats = (LoRa_ADR_Stats){ 0 };
+}
+
+uint8_t LoRa_ADR_Request(TickType_t now, uint8_t* out) {
+    if (now - adrLastRequest < LORA_ADR_REPORT_PERIOD) {
+        return 0;
+    }
+    out[0] = LORA_ADR_TYPE;
+    out[1] = 1;
+    out[2] = adrNext;
+    return LORA_ADR_REQUEST_LEN;
+}
+
+bool LoRa_ADR_Listen() {
+    uint8_t report[LORA_ADR_REPORT_LEN];
+    uint8_t length = 0;
+    bool changed = (adrNext != adrStep);
+
+    adrLastRequest = xTaskGetTickCount();
+    adrMeasured = adrStep;
+    if (changed) {
+        Apply_Step(adrNext);
+        adrStats.changes++;
+    }
+
+    // Report airtime follows the new settings
+    TickType_t window = pdMS_TO_TICKS(Lora_Get_Airtime(LORA_ADR_REPORT_LEN) / 1000 + 1) + LORA_ADR_TURNAROUND;
+    if (Lora_Receive_Timeout(report, sizeof(report), &length, window) == LORA_OK &&
+        length == LORA_ADR_REPORT_LEN && report[0] == LORA_ADR_TYPE &&
+        report[1] == LORA_ADR_REPORT_LEN - 2 && report[2] == adrStep) {
+        adrLost = 0;
+        adrStats.reports++;
+        adrStats.snr = (int8_t)report[3];
+        adrStats.rssi = -(int16_t)report[4];
+        Update_Policy(adrStats.snr, adrStats.rssi);
+        return changed;
+    }
+
+    // The receiver may not have heard the switch, meet it at the most robust step
+    adrStats.lost++;
+    adrGood = 0;
+    if (++adrLost >= LORA_ADR_MAX_LOST) {
+        adrLost = 0;
+        adrNext = ADR_STEPS - 1;
+    }
+    return changed;
+}
+
+bool LoRa_ADR_Reply(const uint8_t* frame, uint8_t length) {
+    uint16_t pos = 0;
+    int16_t step = -1;
+
+    while (pos + 2 <= length) {
+        if (frame[pos] == LORA_ADR_TYPE && frame[pos + 1] == 1 && pos + 3 <= length) {
+            step = frame[pos + 2];
+        }
+        pos += 2 + frame[pos + 1];
+    }
+    if (step < 0 || step >= (int16_t)ADR_STEPS) {
+        return false;
+    }
+
+    // Measure the frame before the radio moves on
+    int8_t snr = Lora_Get_Packet_SNR();
+    int16_t rssi = Lora_Get_Packet_RSSI();
+    uint8_t report[LORA_ADR_REPORT_LEN] = {
+        LORA_ADR_TYPE, LORA_ADR_REPORT_LEN - 2, step, (uint8_t)snr, (rssi < -255) ? 255 : -rssi,
+    };
+
+    if (step != adrStep) {
+        Apply_Step(step);
+        adrStats.changes++;
+    }
+    adrNext = step;
+    adrStats.snr = snr;
+    adrStats.rssi = rssi;
+    adrStats.reports++;
+    return Lora_Transmit(report, sizeof(report)) == LORA_OK;
+}
+
+void LoRa_ADR_Fallback() {
+    if (adrStep != ADR_STEPS - 1) {
+        Apply_Step(ADR_STEPS - 1);
+        adrStats.changes++;
+    }
+    adrNext = adrStep;
+}
+
+void LoRa_ADR_Get_Stats(LoRa_ADR_Stats* stats) {
+    if (stats != NULL) {
+        *stats = adrStats;
+    }
+}
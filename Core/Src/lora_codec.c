@@ -0,0 +1,291 @@
+/************************************************
+* @file    lora_codec.c 
+* @author  APBashara
+* @date    10/2026
+* 
+* @brief   Keyframe and Delta Encoding Implementation
+* @note    Mirrored by Tools/lora_codec.py, keep the two in step
+***********************************************/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "lora_codec.h"
+
+/* Static Functions ---------------------------------------------------------*/
+
+/**
+ * @brief Read a field as a 32-bit value, signed types sign extended
+ * 
+ * @param field [const LoRa_Field*] Field to read
+ * @param packet [const uint8_t*] Packet struct
+ * @return [uint32_t] Field value
+ */
+static uint32_t Read_Field(const LoRa_Field* field, const uint8_t* packet) {
+    const uint8_t* src = &packet[field->offset];
+    uint16_t u16;
+    uint32_t u32;
+
+    switch (field->type) {
+    case LORA_FIELD_U8:
+        return src[0];
+    case LORA_FIELD_I8:
+        return (uint32_t)(int32_t)(int8_t)src[0];
+    case LORA_FIELD_U16:
+        memcpy(&u16, src, sizeof(u16));
+        return u16;
+    case LORA_FIELD_I16:
+        memcpy(&u16, src, sizeof(u16));
+        return (uint32_t)(int32_t)(int16_t)u16;
+    default:
+        memcpy(&u32, src, sizeof(u32));
+        return u32;
+    }
+}
+
+/**
+ * @brief Write a 32-bit value to a field, cut to the field type
+ * 
+ * @param field [const LoRa_Field*] Field to write
+ * @param packet [uint8_t*] Packet struct
+ * @param value [uint32_t] Field value
+ */
+static void Write_Field(const LoRa_Field* field, uint8_t* packet, uint32_t value) {
+    uint8_t* dst = &packet[field->offset];
+    uint16_t u16 = value;
+
+    switch (field->type) {
+    case LORA_FIELD_U8:
+    case LORA_FIELD_I8:
+        dst[0] = value;
+        break;
+    case LORA_FIELD_U16:
+    case LORA_FIELD_I16:
+        memcpy(dst, &u16, sizeof(u16));
+        break;
+    default:
+        memcpy(dst, &value, sizeof(value));
+        break;
+    }
+}
+
+/**
+ * @brief Saturate a field value to the range its schema width holds
+ * @note Done once before encoding, so keyframes and deltas carry the same
+ *       value and the decoder's key never drifts from the encoder's
+ * 
+ * @param field [const LoRa_Field*] Field schema
+ * @param value [uint32_t] Field value from Read_Field
+ * @return [uint32_t] Value that fits in field->bits
+ */
+static uint32_t Clamp_Value(const LoRa_Field* field, uint32_t value) {
+    if (field->bits >= 32) {
+        return value;
+    }
+    if (field->type == LORA_FIELD_I8 || field->type == LORA_FIELD_I16 || field->type == LORA_FIELD_I32) {
+        int32_t max = (1L << (field->bits - 1)) - 1;
+        int32_t signedValue = (int32_t)value;
+        if (signedValue > max) {
+            return (uint32_t)max;
+        }
+        if (signedValue < -max - 1) {
+            return (uint32_t)(-max - 1);
+        }
+        return value;
+    }
+    uint32_t max = (1UL << field->bits) - 1;
+    return (value > max) ? max : value;
+}
+
+/**
+ * @brief Value a keyframe decodes to, the field cut to its width
+ * 
+ * @param field [const LoRa_Field*] Field schema
+ * @param value [uint32_t] Full field value
+ * @return [uint32_t] Value the receiver sees
+ */
+static uint32_t Key_Value(const LoRa_Field* field, uint32_t value) {
+    if (field->bits >= 32) {
+        return value;
+    }
+    value &= (1UL << field->bits) - 1;
+    if ((field->type == LORA_FIELD_I8 || field->type == LORA_FIELD_I16 ||
+        field->type == LORA_FIELD_I32) && (value >> (field->bits - 1))) {
+        value |= ~((1UL << field->bits) - 1); // Sign extend
+    }
+    return value;
+}
+
+/**
+ * @brief Write a zigzag varint
+ * 
+ * @param delta [int32_t] Signed difference
+ * @param out [uint8_t*] Destination, up to 5 bytes
+ * @return [uint8_t] Bytes written
+ */
+static uint8_t Write_Varint(int32_t delta, uint8_t* out) {
+    uint32_t zigzag = ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+    uint8_t length = 0;
+
+    while (zigzag >= 0x80) {
+        out[length++] = (zigzag & 0x7F) | 0x80;
+        zigzag >>= 7;
+    }
+    out[length++] = zigzag;
+    return length;
+}
+
+/**
+ * @brief Read a zigzag varint
+ * 
+ * @param in [const uint8_t*] Payload
+ * @param length [uint8_t] Payload length
+ * @param pos [uint8_t*] Read position, advanced past the varint
+ * @param delta [int32_t*] Signed difference
+ * @return [bool] False if the payload ends inside the varint
+ */
+static bool Read_Varint(const uint8_t* in, uint8_t length, uint8_t* pos, int32_t* delta) {
+    uint32_t zigzag = 0;
+
+    for (uint8_t shift = 0; shift < 35; shift += 7) {
+        if (*pos >= length) {
+            return false;
+        }
+        uint8_t byte = in[(*pos)++];
+        zigzag |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *delta = (int32_t)((zigzag >> 1) ^ -(zigzag & 1));
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Function Implementation --------------------------------------------------*/
+
+uint8_t LoRa_Codec_Max_Length(const LoRa_Field* fields, uint8_t count) {
+    uint16_t bits = 0;
+
+    for (uint8_t i = 0; i < count; i++) {
+        bits += fields[i].bits;
+    }
+    return 1 + (bits + 7) / 8;
+}
+
+uint8_t LoRa_Codec_Encode(const LoRa_Field* fields, uint8_t count, LoRa_Codec_State* state,
+    const uint8_t* packet, uint8_t* out) {
+    uint32_t values[LORA_CODEC_MAX_FIELDS];
+    uint8_t keyLength = LoRa_Codec_Max_Length(fields, count);
+
+    for (uint8_t i = 0; i < count; i++) {
+        values[i] = Clamp_Value(&fields[i], Read_Field(&fields[i], packet));
+    }
+
+    // Deltas against the keyframe, so a lost delta never affects the next one
+    if (state->keyed && state->sinceKey < LORA_CODEC_KEY_INTERVAL) {
+        uint8_t delta[1 + 5 * LORA_CODEC_MAX_FIELDS];
+        uint8_t length = 1;
+        delta[0] = state->sequence;
+        for (uint8_t i = 0; i < count; i++) {
+            length += Write_Varint((int32_t)(values[i] - state->key[i]), &delta[length]);
+        }
+        if (length < keyLength) {
+            memcpy(out, delta, length);
+            state->sinceKey++;
+            return length;
+        }
+    }
+
+    // Keyframe, fields packed LSB first
+    uint32_t acc = 0;
+    uint8_t accBits = 0;
+    uint8_t length = 1;
+
+    state->sequence = (state->sequence + 1) & LORA_CODEC_SEQUENCE_MSK;
+    out[0] = LORA_CODEC_KEYFRAME | state->sequence;
+    for (uint8_t i = 0; i < count; i++) {
+        uint32_t value = values[i];
+        uint8_t bits = fields[i].bits;
+        state->key[i] = value; // Clamped, so exactly what the keyframe decodes to
+
+        // Feed at most 16 bits at a time so the accumulator never overflows
+        while (bits > 0) {
+            uint8_t chunk = (bits > 16) ? 16 : bits;
+            acc |= (value & ((1UL << chunk) - 1)) << accBits;
+            accBits += chunk;
+            value >>= chunk;
+            bits -= chunk;
+            while (accBits >= 8) {
+                out[length++] = acc & 0xFF;
+                acc >>= 8;
+                accBits -= 8;
+            }
+        }
+    }
+    if (accBits > 0) {
+        out[length++] = acc & 0xFF;
+    }
+    state->sinceKey = 0;
+    state->keyed = 1;
+    return length;
+}
+
+void LoRa_Codec_Resync(LoRa_Codec_State* state) {
+    state->keyed = 0;
+}
+
+LoRa_Codec_Status LoRa_Codec_Decode(const LoRa_Field* fields, uint8_t count, LoRa_Codec_State* state,
+    const uint8_t* in, uint8_t length, uint8_t* packet) {
+    if (length == 0 || count > LORA_CODEC_MAX_FIELDS) {
+        return LORA_CODEC_ERROR;
+    }
+
+    if (in[0] & LORA_CODEC_KEYFRAME) {
+        if (length != LoRa_Codec_Max_Length(fields, count)) {
+            return LORA_CODEC_ERROR;
+        }
+
+        // Unpack LSB first, at most 16 bits at a time like the encoder
+        uint32_t acc = 0;
+        uint8_t accBits = 0;
+        uint8_t pos = 1;
+        for (uint8_t i = 0; i < count; i++) {
+            uint32_t value = 0;
+            uint8_t done = 0;
+            while (done < fields[i].bits) {
+                uint8_t chunk = (fields[i].bits - done > 16) ? 16 : fields[i].bits - done;
+                while (accBits < chunk) {
+                    acc |= (uint32_t)in[pos++] << accBits;
+                    accBits += 8;
+                }
+                value |= (acc & ((1UL << chunk) - 1)) << done;
+                acc >>= chunk;
+                accBits -= chunk;
+                done += chunk;
+            }
+            state->key[i] = Key_Value(&fields[i], value);
+            Write_Field(&fields[i], packet, state->key[i]);
+        }
+        state->sequence = in[0] & LORA_CODEC_SEQUENCE_MSK;
+        state->keyed = 1;
+        return LORA_CODEC_OK;
+    }
+
+    if (!state->keyed || state->sequence != in[0]) {
+        return LORA_CODEC_NO_KEY;
+    }
+
+    // Check the whole delta before touching the packet
+    int32_t deltas[LORA_CODEC_MAX_FIELDS];
+    uint8_t pos = 1;
+    for (uint8_t i = 0; i < count; i++) {
+        if (!Read_Varint(in, length, &pos, &deltas[i])) {
+            return LORA_CODEC_ERROR;
+        }
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        Write_Field(&fields[i], packet, state->key[i] + (uint32_t)deltas[i]);
+    }
+    return LORA_CODEC_OK;
+}
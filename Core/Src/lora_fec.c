@@ -0,0 +1,74 @@
+/************************************************
+* @file    lora_fec.c 
+* @author  APBashara
+* @date    10/2026
+* 
+* @brief   XOR Parity Across Groups of LoRa Frames Implementation
+* @note    Mirrored by Tools/lora_fec.py, keep the two in step
+***********************************************/
+
+#include <string.h>
+
+#include "lora_fec.h"
+
+/* Function Implementation --------------------------------------------------*/
+
+void LoRa_FEC_Init(LoRa_FEC_State* state, uint8_t size) {
+    memset(state, 0, sizeof(LoRa_FEC_State));
+    state->size = (size > LORA_FEC_MAX_GROUP) ? LORA_FEC_MAX_GROUP : size;
+}
+
+uint8_t LoRa_FEC_Header(const LoRa_FEC_State* state, uint8_t* out) {
+    if (state->size == 0) {
+        return 0;
+    }
+    out[0] = LORA_FEC_TYPE;
+    out[1] = LORA_FEC_HEADER_LEN - 2;
+    out[2] = state->group;
+    out[3] = state->index;
+    return LORA_FEC_HEADER_LEN;
+}
+
+void LoRa_FEC_Add(LoRa_FEC_State* state, const uint8_t* frame, uint8_t length) {
+    if (state->size == 0 || length < LORA_FEC_HEADER_LEN) {
+        return;
+    }
+
+    const uint8_t* data = &frame[LORA_FEC_HEADER_LEN];
+    uint8_t dataLength = length - LORA_FEC_HEADER_LEN;
+    if (dataLength > sizeof(state->parity)) {
+        dataLength = sizeof(state->parity);
+    }
+
+    // Shorter frames count as zero padded
+    for (uint8_t i = 0; i < dataLength; i++) {
+        state->parity[i] ^= data[i];
+    }
+    if (dataLength > state->parityLength) {
+        state->parityLength = dataLength;
+    }
+    state->lengthXor ^= dataLength;
+    state->index++;
+}
+
+uint8_t LoRa_FEC_Parity(LoRa_FEC_State* state, uint8_t* out) {
+    if (state->size == 0 || state->index < state->size) {
+        return 0;
+    }
+
+    uint8_t length = LORA_FEC_PARITY_LEN + state->parityLength;
+    out[0] = LORA_FEC_TYPE;
+    out[1] = length - 2;
+    out[2] = state->group;
+    out[3] = state->size; // One past the last data index marks parity
+    out[4] = state->lengthXor;
+    memcpy(&out[LORA_FEC_PARITY_LEN], state->parity, state->parityLength);
+
+    // Next group
+    memset(state->parity, 0, state->parityLength);
+    state->parityLength = 0;
+    state->lengthXor = 0;
+    state->index = 0;
+    state->group++;
+    return length;
+}
@@ -0,0 +1,244 @@
+/************************************************
+* @file    lora_link.c 
+* @author  APBashara
+* @date    10/2026
+* 
+* @brief   LoRa Receiver Role Implementation
+* @note    The task is the only writer of linkHead, the DMA interrupt the
+*          only writer of linkTail, each span is sent straight from the ring
+***********************************************/
+
+#include <stddef.h>
+#include <string.h>
+
+#include "lora_link.h"
+#include "lora_offload.h"
+#include "lora_sweep.h"
+#include "task.h"
+#include "timer.h"
+#include "uart.h"
+
+#define LINK_RING_MASK              (LORA_LINK_RING_SIZE - 1)
+#define LINK_MAX_LINE               (32 + 2 * LORA_MAX_PAYLOAD_LEN) // Prefix and hex of the largest frame
+
+_Static_assert((LORA_LINK_RING_SIZE & LINK_RING_MASK) == 0, "Ring size must be a power of two");
+_Static_assert(LORA_LINK_RING_SIZE <= 0x8000, "Ring indices are 16 bit");
+
+static uint8_t linkRing[LORA_LINK_RING_SIZE];
+static volatile uint16_t linkHead; // Next byte the task writes
+static volatile uint16_t linkTail; // First byte not sent yet
+static volatile uint16_t linkSending; // Bytes of the running DMA transmit, 0 when idle
+static char linkLine[LINK_MAX_LINE];
+static LoRa_RX_Frame linkFrame;
+static uint32_t linkTimeLast; // Get_Timer_Count of the last frame
+static uint64_t linkTime; // Microseconds since boot
+static LoRa_Link_Stats linkStats;
+
+static const char linkHex[] = "0123456789ABCDEF";
+
+/* Static Functions ---------------------------------------------------------*/
+
+static void Send_Next();
+
+/**
+ * @brief DMA done, release the span and send the next one
+ * 
+ * @param context [void*] Unused
+ */
+static void Sent(void* context) {
+    (void)context;
+    linkTail = (linkTail + linkSending) & LINK_RING_MASK;
+    linkSending = 0;
+    Send_Next();
+}
+
+/**
+ * @brief Start a DMA transmit of the waiting bytes up to the end of the ring
+ * @note Runs in the DMA interrupt or with it masked
+ */
+static void Send_Next() {
+    uint16_t head = linkHead;
+    uint16_t tail = linkTail;
+    if (linkSending != 0 || head == tail) {
+        return;
+    }
+    linkSending = (head > tail) ? head - tail : LORA_LINK_RING_SIZE - tail;
+    if (!USART2_DMA_Send(&linkRing[tail], linkSending, Sent, NULL)) {
+        linkSending = 0;
+    }
+}
+
+/**
+ * @brief Write a decimal number
+ * 
+ * @param out [char*] Destination
+ * @param value [int32_t] Number
+ * @param digits [uint8_t] Least digits, zero padded
+ * @return [char*] End of the written text
+ */
+static char* Put_Decimal(char* out, int32_t value, uint8_t digits) {
+    char text[11];
+    uint8_t count = 0;
+    uint32_t magnitude = (value < 0) ? -(uint32_t)value : (uint32_t)value;
+
+    if (value < 0) {
+        *out++ = '-';
+    }
+    do {
+        text[count++] = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while (magnitude != 0 || count < digits);
+    while (count > 0) {
+        *out++ = text[--count];
+    }
+    return out;
+}
+
+/**
+ * @brief Format a frame as one line in linkLine
+ * 
+ * @param frame [const LoRa_RX_Frame*] Received frame
+ * @param now [uint64_t] Receive time in us
+ * @return [uint16_t] Line length
+ */
+static uint16_t Format_Line(const LoRa_RX_Frame* frame, uint64_t now) {
+    char* out = linkLine;
+
+    out = Put_Decimal(out, (int32_t)(now / 1000000), 1);
+    *out++ = '.';
+    out = Put_Decimal(out, (int32_t)(now % 1000000), 6);
+    *out++ = ' ';
+    out = Put_Decimal(out, frame->rssi, 1);
+    *out++ = ' ';
+    out = Put_Decimal(out, frame->snr, 1);
+    *out++ = ':';
+    *out++ = ' ';
+    for (uint8_t i = 0; i < frame->length; i++) {
+        *out++ = linkHex[frame->data[i] >> 4];
+        *out++ = linkHex[frame->data[i] & 0xF];
+    }
+    *out++ = '\n';
+    return out - linkLine;
+}
+
+/**
+ * @brief Copy a line into the ring and start the DMA if it is idle
+ * 
+ * @param line [const char*] Line
+ * @param length [uint16_t] Line length
+ * @return [bool] False if the line did not fit
+ */
+static bool Queue_Line(const char* line, uint16_t length) {
+    uint16_t head = linkHead;
+    uint16_t used = (head - linkTail) & LINK_RING_MASK;
+    if (length > LINK_RING_MASK - used) {
+        return false;
+    }
+
+    uint16_t first = LORA_LINK_RING_SIZE - head;
+    if (first > length) {
+        first = length;
+    }
+    memcpy(&linkRing[head], line, first);
+    memcpy(linkRing, line + first, length - first);
+    if (used + length > linkStats.ringPeak) {
+        linkStats.ringPeak = used + length;
+    }
+
+    taskENTER_CRITICAL();
+    linkHead = (head + length) & LINK_RING_MASK;
+    Send_Next();
+    taskEXIT_CRITICAL();
+    return true;
+}
+
+/**
+ * @brief Write an offload frame as a line, timed by its arrival
+ * @note LoRa_Offload_Output, the link quality of FSK frames is not read
+ */
+static bool Offload_Line(const uint8_t* data, uint8_t length, void* ctx) {
+    LoRa_RX_Frame* frame = &linkFrame;
+    (void)ctx;
+
+    uint32_t count = Get_Timer_Count();
+    linkTime += (uint32_t)(count - linkTimeLast);
+    linkTimeLast = count;
+
+    memcpy(frame->data, data, length);
+    frame->length = length;
+    frame->rssi = 0;
+    frame->snr = 0;
+    if (!Queue_Line(linkLine, Format_Line(frame, linkTime))) {
+        linkStats.dropped++;
+        return false;
+    }
+    linkStats.frames++;
+    return true;
+}
+
+/* Function Implementation --------------------------------------------------*/
+
+void LoRa_Link_Init() {
+    linkHead = 0;
+    linkTail = 0;
+    linkSending = 0;
+    linkTime = 0;
+    linkTimeLast = Get_Timer_Count();
+    memset(&linkStats, 0, sizeof(linkStats));
+
+    LoRa_ADR_Init(xTaskGetTickCount());
+    Lora_RX_Start();
+}
+
+void LoRa_Link_Run() {
+    if (Lora_RX_Read(&linkFrame, LORA_LINK_SILENCE) != LORA_OK) {
+#ifndef LORA_TDMA
+        // Nothing heard, meet the car at the most robust step
+        LoRa_ADR_Fallback();
+#endif
+        Lora_RX_Start();
+        return;
+    }
+
+    // The microsecond timer wraps every 71 minutes, frames or fallbacks come far more often
+    uint32_t count = Get_Timer_Count();
+    linkTime += (uint32_t)(count - linkTimeLast);
+    linkTimeLast = count;
+
+    linkStats.missed += linkFrame.missed;
+    if (linkFrame.crcError) {
+        linkStats.crcErrors++;
+        return;
+    }
+    if (linkFrame.length == 0) {
+        return;
+    }
+
+    if (Queue_Line(linkLine, Format_Line(&linkFrame, linkTime))) {
+        linkStats.frames++;
+    } else {
+        linkStats.dropped++;
+    }
+
+    // The report goes out at once, the car only listens for a few ticks
+    if (LoRa_ADR_Reply(linkFrame.data, linkFrame.length)) {
+        linkStats.reports++;
+        Lora_RX_Start();
+    }
+
+    // The frames of an offload replace the telemetry until it ends
+    if (LoRa_Offload_Serve(linkFrame.data, linkFrame.length, Offload_Line, NULL)) {
+        Lora_RX_Start();
+    }
+
+    // A sweep point runs at its own settings, the car waits for the result at these
+    if (LoRa_Sweep_Serve(linkFrame.data, linkFrame.length)) {
+        Lora_RX_Start();
+    }
+}
+
+void LoRa_Link_Get_Stats(LoRa_Link_Stats* stats) {
+    if (stats != NULL) {
+        *stats = linkStats;
+    }
+}
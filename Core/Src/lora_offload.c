@@ -0,0 +1,426 @@
+/************************************************
+* @file    lora_offload.c 
+* @author  APBashara
+* @date    10/2026
+* 
+* @brief   SD Log Offload over an FSK Burst Implementation
+* @note    The car keeps one window of file bytes, the ack always lands on
+*          a frame boundary so a slot is only reused once its frame is acked
+***********************************************/
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "lora_offload.h"
+#include "can_capture.h"
+#include "fatfs.h"
+#include "task.h"
+
+#define OFFLOAD_NAME_LEN            (13) // 8.3 name and terminator
+#define OFFLOAD_END_TRIES           (3) // End frames sent, the receiver also leaves on silence
+#define OFFLOAD_M_PER_UNIT          (0.011132f) // m per 1e-7 degree of latitude
+
+static FIL offloadFile;
+static uint8_t offloadWindow[LORA_OFFLOAD_WINDOW][LORA_OFFLOAD_CHUNK];
+static uint8_t offloadFrame[LORA_FSK_MAX_PAYLOAD];
+static uint8_t offloadFound[(CAN_CAPTURE_MAX_FILES + 7) / 8]; // Capture file numbers on the card
+static char offloadName[OFFLOAD_NAME_LEN]; // Requested file, empty for the newest capture
+static volatile bool offloadPending;
+static volatile uint8_t offloadRequest; // Counts requests, one made during a transfer is kept
+static uint8_t offloadAttempts;
+static TickType_t offloadRetry; // Tick of the next attempt
+static bool fenceArmed = true; // Left the pit lane since the last offload
+static bool fenceParked;
+static TickType_t fenceSince; // Tick the car stopped in the pit lane
+static LoRa_Offload_Stats offloadStats;
+
+/* Static Functions ---------------------------------------------------------*/
+
+/**
+ * @brief Write a little endian uint32_t
+ * 
+ * @param dest [uint8_t*] Destination bytes
+ * @param value [uint32_t] Value to write
+ */
+static void Put_U32(uint8_t* dest, uint32_t value) {
+    for (uint8_t i = 0; i < 4; i++) {
+        dest[i] = (value >> (i * 8)) & 0xFF;
+    }
+}
+
+/**
+ * @brief Read a little endian uint32_t
+ * 
+ * @param src [const uint8_t*] Source bytes
+ * @return [uint32_t] Value
+ */
+static uint32_t Get_U32(const uint8_t* src) {
+    return src[0] | (src[1] << 8) | (src[2] << 16) | ((uint32_t)src[3] << 24);
+}
+
+/**
+ * @brief Open the requested file, or the newest capture that is not being written
+ * @note The capture holds its file open for writing, FatFs would refuse it with FR_LOCKED
+ * 
+ * @param name [char*] Requested name, the opened name is written back
+ * @return [FRESULT] FR_LOCKED if the requested file is being captured
+ */
+static FRESULT Open_File(char* name) {
+    char path[20];
+    DIR dir;
+    FILINFO info;
+
+    if (name[0] != '\0') {
+        if (CAN_Capture_Is_Active(name)) {
+            offloadStats.capturing++;
+            return FR_LOCKED;
+        }
+        snprintf(path, sizeof(path), "%s%s", USERPath, name);
+        return f_open(&offloadFile, path, FA_READ | FA_OPEN_EXISTING);
+    }
+
+    memset(offloadFound, 0, sizeof(offloadFound));
+    FRESULT result = f_opendir(&dir, USERPath);
+    while (result == FR_OK) {
+        result = f_readdir(&dir, &info);
+        if (result != FR_OK || info.fname[0] == '\0') {
+            break;
+        }
+        const char* n = info.fname;
+        if ((info.fattrib & AM_DIR) || strncmp(n, "CAN", 3) != 0 || strcmp(&n[6], ".BIN") != 0 ||
+            n[3] < '0' || n[3] > '9' || n[4] < '0' || n[4] > '9' || n[5] < '0' || n[5] > '9') {
+            continue;
+        }
+        uint16_t number = (n[3] - '0') * 100 + (n[4] - '0') * 10 + (n[5] - '0');
+        offloadFound[number / 8] |= 1 << (number % 8);
+    }
+    f_closedir(&dir);
+    if (result != FR_OK) {
+        return result;
+    }
+
+    for (int16_t number = CAN_CAPTURE_MAX_FILES - 1; number >= 0; number--) {
+        if (!(offloadFound[number / 8] & (1 << (number % 8)))) {
+            continue;
+        }
+        snprintf(name, OFFLOAD_NAME_LEN, "CAN%03u.BIN", number);
+        if (CAN_Capture_Is_Active(name)) {
+            continue;
+        }
+        snprintf(path, sizeof(path), "%s%s", USERPath, name);
+        return f_open(&offloadFile, path, FA_READ | FA_OPEN_EXISTING);
+    }
+    return FR_NO_FILE;
+}
+
+/**
+ * @brief Send offloadFrame
+ * 
+ * @param length [uint8_t] Frame length
+ */
+static void Send(uint8_t length) {
+    if (Lora_FSK_Transmit(offloadFrame, length) == LORA_OK) {
+        offloadStats.frames++;
+    }
+}
+
+/**
+ * @brief Wait for an ack after a frame with the poll bit
+ * 
+ * @param next [uint32_t*] Offset the receiver wants next
+ * @return [bool] False if none came in LORA_OFFLOAD_ACK_TIMEOUT
+ */
+static bool Wait_Ack(uint32_t* next) {
+    uint8_t ack[LORA_FSK_MAX_PAYLOAD];
+    uint8_t length;
+    TickType_t start = xTaskGetTickCount();
+    TickType_t waited;
+
+    while ((waited = xTaskGetTickCount() - start) < LORA_OFFLOAD_ACK_TIMEOUT) {
+        if (Lora_FSK_Receive(ack, &length, LORA_OFFLOAD_ACK_TIMEOUT - waited) == LORA_OK &&
+            length == LORA_OFFLOAD_HEADER_LEN && ack[0] == LORA_OFFLOAD_ACK) {
+            *next = Get_U32(&ack[1]);
+            return true;
+        }
+    }
+    offloadStats.timeouts++;
+    return false;
+}
+
+/**
+ * @brief Send offloadFrame with the poll bit and wait for the ack
+ * 
+ * @param length [uint8_t] Frame length
+ * @param next [uint32_t*] Offset the receiver wants next
+ * @return [bool] False if no ack came
+ */
+static bool Poll(uint8_t length, uint32_t* next) {
+    offloadFrame[0] |= LORA_OFFLOAD_POLL;
+    Send(length);
+    return Wait_Ack(next);
+}
+
+/**
+ * @brief Go-back-N transfer of the open file
+ * 
+ * @param name [const char*] File name for the start frame
+ * @param size [uint32_t] File size
+ * @return LoRa_Offload_Status
+ */
+static LoRa_Offload_Status Transfer(const char* name, uint32_t size) {
+    uint8_t nameLength = strlen(name);
+    uint32_t base = 0; // First byte not acked
+    uint32_t read = 0; // Bytes read from the card into the window
+    uint32_t sent = 0; // Bytes sent at least once
+    uint32_t ack;
+    uint8_t timeouts = 0;
+
+    // The receiver may still be switching to FSK, keep asking until it answers
+    offloadFrame[0] = LORA_OFFLOAD_START;
+    Put_U32(&offloadFrame[1], size);
+    memcpy(&offloadFrame[LORA_OFFLOAD_HEADER_LEN], name, nameLength);
+    while (!Poll(LORA_OFFLOAD_HEADER_LEN + nameLength, &ack) || ack != 0) {
+        if (++timeouts >= LORA_OFFLOAD_MAX_TIMEOUTS) {
+            return LORA_OFFLOAD_NO_ANSWER;
+        }
+    }
+
+    timeouts = 0;
+    while (base < size) {
+        uint32_t limit = base + LORA_OFFLOAD_WINDOW * LORA_OFFLOAD_CHUNK;
+        if (limit > size) {
+            limit = size;
+        }
+
+        // Slots behind the ack are free for the next bytes of the card
+        while (read < limit) {
+            UINT count;
+            UINT wanted = (size - read < LORA_OFFLOAD_CHUNK) ? size - read : LORA_OFFLOAD_CHUNK;
+            if (f_read(&offloadFile, offloadWindow[(read / LORA_OFFLOAD_CHUNK) % LORA_OFFLOAD_WINDOW], wanted,
+                &count) != FR_OK || count != wanted) {
+                return LORA_OFFLOAD_ERROR;
+            }
+            read += count;
+        }
+
+        // The whole window back to back, the last frame polls
+        for (uint32_t next = base; next < limit; next += LORA_OFFLOAD_CHUNK) {
+            uint8_t count = (limit - next < LORA_OFFLOAD_CHUNK) ? limit - next : LORA_OFFLOAD_CHUNK;
+            offloadFrame[0] = LORA_OFFLOAD_DATA | ((next + count >= limit) ? LORA_OFFLOAD_POLL : 0);
+            Put_U32(&offloadFrame[1], next);
+            memcpy(&offloadFrame[LORA_OFFLOAD_HEADER_LEN],
+                offloadWindow[(next / LORA_OFFLOAD_CHUNK) % LORA_OFFLOAD_WINDOW], count);
+            if (next < sent) {
+                offloadStats.resent++;
+            }
+            Send(LORA_OFFLOAD_HEADER_LEN + count);
+        }
+        if (limit > sent) {
+            sent = limit;
+        }
+
+        // A window that gets nothing through counts as lost too, the receiver may not be taking data
+        if (!Wait_Ack(&ack) || ack <= base || ack > limit) {
+            if (++timeouts >= LORA_OFFLOAD_MAX_TIMEOUTS) {
+                return LORA_OFFLOAD_LOST;
+            }
+            continue;
+        }
+        timeouts = 0;
+        offloadStats.bytes += ack - base;
+        base = ack; // Everything after a lost frame goes again
+    }
+
+    // The data is complete either way, the receiver also leaves on silence
+    offloadFrame[0] = LORA_OFFLOAD_END;
+    Put_U32(&offloadFrame[1], size);
+    for (uint8_t i = 0; i < OFFLOAD_END_TRIES && !Poll(LORA_OFFLOAD_HEADER_LEN, &ack); i++) {
+    }
+    return LORA_OFFLOAD_OK;
+}
+
+/* Function Implementation --------------------------------------------------*/
+
+void LoRa_Offload_Request(const char* name) {
+    taskENTER_CRITICAL();
+    memset(offloadName, 0, sizeof(offloadName));
+    if (name != NULL) {
+        strncpy(offloadName, name, sizeof(offloadName) - 1);
+    }
+    offloadRequest++;
+    offloadAttempts = 0;
+    offloadRetry = xTaskGetTickCount();
+    offloadPending = true;
+    taskEXIT_CRITICAL();
+}
+
+void LoRa_Offload_Geofence(int32_t latitude, int32_t longitude, int32_t speed, TickType_t now) {
+#if LORA_OFFLOAD_PIT_LAT != 0
+    // Flat earth is plenty over a pit lane
+    float north = (float)((int64_t)latitude - LORA_OFFLOAD_PIT_LAT) * OFFLOAD_M_PER_UNIT;
+    float east = (float)((int64_t)longitude - LORA_OFFLOAD_PIT_LON) * OFFLOAD_M_PER_UNIT *
+        cosf(LORA_OFFLOAD_PIT_LAT * 1.745329e-9f);
+
+    if (north * north + east * east > (float)LORA_OFFLOAD_PIT_RADIUS * LORA_OFFLOAD_PIT_RADIUS) {
+        fenceArmed = true;
+        fenceParked = false;
+        return;
+    }
+    if (!fenceArmed || speed > LORA_OFFLOAD_PIT_SPEED) {
+        fenceParked = false;
+        return;
+    }
+    if (!fenceParked) {
+        fenceParked = true;
+        fenceSince = now;
+        return;
+    }
+    if (now - fenceSince >= LORA_OFFLOAD_PIT_DWELL) {
+        fenceArmed = false;
+        LoRa_Offload_Request(NULL);
+    }
+#else
+    (void)latitude;
+    (void)longitude;
+    (void)speed;
+    (void)now;
+    (void)fenceArmed;
+    (void)fenceParked;
+    (void)fenceSince;
+#endif
+}
+
+bool LoRa_Offload_Due(TickType_t now) {
+    return offloadPending && (int32_t)(now - offloadRetry) >= 0;
+}
+
+LoRa_Offload_Status LoRa_Offload_Run() {
+    LoRa_Offload_Status status = LORA_OFFLOAD_ERROR;
+    char name[OFFLOAD_NAME_LEN];
+
+    taskENTER_CRITICAL();
+    uint8_t request = offloadRequest;
+    memcpy(name, offloadName, sizeof(name));
+    taskEXIT_CRITICAL();
+
+    if (Open_File(name) == FR_OK) {
+        uint8_t announce[] = { LORA_OFFLOAD_TYPE, 1, LORA_OFFLOAD_START };
+        uint32_t size = f_size(&offloadFile);
+        TickType_t start = xTaskGetTickCount();
+
+        // Announced at the LoRa rate in use, the receiver switches as it hears it
+        if (Lora_Transmit(announce, sizeof(announce)) == LORA_OK && Lora_FSK_Start() == LORA_OK) {
+            vTaskDelay(LORA_OFFLOAD_TURNAROUND);
+            status = Transfer(name, size);
+        }
+        Lora_FSK_Stop();
+        f_close(&offloadFile);
+
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (status == LORA_OFFLOAD_OK) {
+            offloadStats.files++;
+            offloadStats.rate = (uint64_t)size * configTICK_RATE_HZ / (elapsed ? elapsed : 1);
+        }
+    }
+    if (status != LORA_OFFLOAD_OK) {
+        offloadStats.failed++;
+    }
+
+    // A missing file will not appear by retrying, a silent receiver may
+    taskENTER_CRITICAL();
+    if (request == offloadRequest) {
+        if (status == LORA_OFFLOAD_OK || status == LORA_OFFLOAD_ERROR ||
+            ++offloadAttempts >= LORA_OFFLOAD_ATTEMPTS) {
+            offloadPending = false;
+        }
+        offloadRetry = xTaskGetTickCount() + LORA_OFFLOAD_RETRY;
+    }
+    taskEXIT_CRITICAL();
+    return status;
+}
+
+bool LoRa_Offload_Serve(const uint8_t* frame, uint8_t length, LoRa_Offload_Output output, void* ctx) {
+    uint8_t line[2 + LORA_FSK_MAX_PAYLOAD]; // Frame as a sub-packet for output
+    uint8_t* rx = &line[2];
+    uint8_t rxLength;
+    uint32_t expected = 0; // Next file byte wanted
+    bool started = false;
+    bool announced = false;
+
+    for (uint16_t pos = 0; pos + 2 <= length; pos += 2 + frame[pos + 1]) {
+        if (frame[pos] == LORA_OFFLOAD_TYPE && frame[pos + 1] == 1 && pos + 3 <= length &&
+            frame[pos + 2] == LORA_OFFLOAD_START) {
+            announced = true;
+        }
+    }
+    if (!announced) {
+        return false;
+    }
+
+    Lora_FSK_Start();
+    TickType_t heard = xTaskGetTickCount();
+    TickType_t waited;
+    while ((waited = xTaskGetTickCount() - heard) < LORA_OFFLOAD_SILENCE) {
+        if (Lora_FSK_Receive(rx, &rxLength, LORA_OFFLOAD_SILENCE - waited) != LORA_OK ||
+            rxLength < LORA_OFFLOAD_HEADER_LEN) {
+            continue;
+        }
+        heard = xTaskGetTickCount();
+
+        uint8_t op = rx[0] & ~LORA_OFFLOAD_POLL;
+        uint8_t poll = rx[0] & LORA_OFFLOAD_POLL;
+        uint32_t value = Get_U32(&rx[1]);
+        bool accepted = false;
+        bool done = false;
+        switch (op) {
+        case LORA_OFFLOAD_START:
+            // Again if the ack was lost, the car has sent no data yet
+            accepted = true;
+            break;
+        case LORA_OFFLOAD_DATA:
+            accepted = started && value == expected;
+            break;
+        case LORA_OFFLOAD_END:
+            done = started && value == expected;
+            accepted = done;
+            break;
+        default:
+            break;
+        }
+
+        // A frame the output cannot take is left for the car to resend, that paces it to the UART
+        if (accepted && output != NULL) {
+            rx[0] = op;
+            line[0] = LORA_OFFLOAD_TYPE;
+            line[1] = rxLength;
+            accepted = output(line, rxLength + 2, ctx);
+            done = done && accepted;
+        }
+        if (accepted && op == LORA_OFFLOAD_START) {
+            expected = 0;
+            started = true;
+        }
+        else if (accepted && op == LORA_OFFLOAD_DATA) {
+            expected += rxLength - LORA_OFFLOAD_HEADER_LEN;
+        }
+
+        // Silent until a start is taken, the car asks again
+        if (poll && started) {
+            uint8_t ack[LORA_OFFLOAD_HEADER_LEN] = { LORA_OFFLOAD_ACK };
+            Put_U32(&ack[1], expected);
+            Lora_FSK_Transmit(ack, sizeof(ack));
+        }
+        if (done) {
+            break;
+        }
+    }
+    Lora_FSK_Stop();
+    return true;
+}
+
+void LoRa_Offload_Get_Stats(LoRa_Offload_Stats* stats) {
+    if (stats != NULL) {
+        *stats = offloadStats;
+    }
+}
@@ -0,0 +1,522 @@
+/************************************************
+* @file    lora_sched.c 
+* @author  APBashara
+* @date    10/2026
+* 
+* @brief   Airtime Budgeted LoRa Packet Scheduler Implementation
+* @note    Non-preemptive EDF, every packet type is released once per period
+*          and must be on air before the next release
+* @note    Due packets wait up to their latency bound so several share the
+*          preamble and header of one frame
+* @note    With LORA_TDMA frames only start in the node's slot and fill it
+*          at most, see lora_tdma.h
+* @note    Producers write a packet's TX slot under a critical section, the
+*          scheduler takes a packet out of it or its data the same way
+***********************************************/
+
+#include <stddef.h>
+#include <string.h>
+
+#include "lora_offload.h"
+#include "lora_sched.h"
+#include "lora_schema.h"
+#include "lora_tdma.h"
+#include "task.h"
+#include "timer.h"
+
+// Link request and schema version tag, sent together
+#define SCHED_CONTROL_LEN           (LORA_ADR_REQUEST_LEN + LORA_SCHEMA_TAG_LEN)
+
+typedef struct {
+    const LoRa_Sched_Packet* packet;
+    TickType_t period; // Ticks between releases, also the relative deadline
+    TickType_t release; // Tick the pending packet was released
+    uint16_t windowCount; // Packets sent in the current rate window
+    uint8_t maxLength; // Largest sub-packet payload
+    uint8_t sequence; // Next packet sequence
+    bool fresh; // The slot holds a sample not sent yet
+    uint32_t sampleTime; // Get_Timer_Count when the slot was published
+    TickType_t published; // Tick the slot was published
+    uint8_t slot[LORA_SCHED_MAX_PACKET_LEN]; // Last published sample
+    LoRa_Codec_State codec;
+    LoRa_Sched_Stats stats;
+} Sched_Entry;
+
+static Sched_Entry schedEntries[LORA_SCHED_MAX_PACKETS];
+static uint8_t schedCount;
+static TickType_t schedWindowStart; // Start of the one second rate window
+static uint32_t schedWindowAirtime; // Time on air in the current window in us
+static LoRa_Sched_Frame_Stats frameStats;
+static LoRa_FEC_State schedFec;
+static uint32_t schedEpoch; // Microsecond timebase at init, sample times count from here
+#ifdef LORA_TDMA
+static LoRa_TDMA_State schedTdma;
+static uint32_t schedLimitAirtime; // us on air of a full frame
+static TickType_t schedTagDue; // Next schema version tag, there are no link requests to carry it
+#endif
+static uint8_t loraFrame[LORA_MAX_PAYLOAD_LEN];
+static uint8_t schedSample[LORA_SCHED_MAX_PACKET_LEN]; // Packet being encoded
+
+/* Static Functions ---------------------------------------------------------*/
+
+/**
+ * @brief Publish the achieved rates once per second
+ * 
+ * @param now [TickType_t] Current tick
+ */
+static void Update_Rates(TickType_t now) {
+    TickType_t elapsed = now - schedWindowStart;
+    if (elapsed < configTICK_RATE_HZ) {
+        return;
+    }
+    for (uint8_t i = 0; i < schedCount; i++) {
+        schedEntries[i].stats.rate = schedEntries[i].windowCount;
+        schedEntries[i].windowCount = 0;
+    }
+    // us on air * ticks per second / (elapsed ticks * 1000) = tenths of a percent
+    frameStats.load = (uint64_t)schedWindowAirtime * configTICK_RATE_HZ / ((uint64_t)elapsed * 1000);
+    schedWindowAirtime = 0;
+    schedWindowStart = now;
+}
+
+/**
+ * @brief Size frames for the current modem settings
+ * @note A frame may hold the channel for one period of the fastest packet.
+ *       It always fits the largest sub-packet, the link and version tags
+ *       and the FEC tags. When even the smallest useful frame is longer the rates cannot be
+ *       met anyway, and LORA_SCHED_OVERLOAD of those frames share one
+ *       preamble instead.
+ */
+static void Update_Budget() {
+    TickType_t period = portMAX_DELAY;
+    uint16_t largest = 0;
+
+    for (uint8_t i = 0; i < schedCount; i++) {
+        if (schedEntries[i].period < period) {
+            period = schedEntries[i].period;
+        }
+        if (schedEntries[i].maxLength + LORA_SCHED_TAG_LEN > largest) {
+            largest = schedEntries[i].maxLength + LORA_SCHED_TAG_LEN;
+        }
+    }
+
+    uint16_t minimum = largest + SCHED_CONTROL_LEN + LORA_FEC_PARITY_LEN;
+
+    uint32_t budget = (uint64_t)period * 1000000 / configTICK_RATE_HZ; // us
+#ifdef LORA_TDMA
+    // One frame per slot, the superframe sets the rates
+    budget = LoRa_TDMA_Budget(&schedTdma);
+#else
+    if (Lora_Get_Airtime(minimum) > budget) {
+        budget = LORA_SCHED_OVERLOAD * Lora_Get_Airtime(minimum);
+    }
+#endif
+    uint16_t limit = LORA_MAX_PAYLOAD_LEN;
+    while (limit > minimum && Lora_Get_Airtime(limit) > budget) {
+        limit--;
+    }
+    frameStats.limit = limit;
+#ifdef LORA_TDMA
+    schedLimitAirtime = Lora_Get_Airtime(limit);
+#endif
+}
+
+/**
+ * @brief Pick the due packet with the earliest deadline that still fits
+ * 
+ * @param packed [uint8_t] Bitmask of entries already in the frame
+ * @param space [uint16_t] Bytes left in the frame
+ * @param now [TickType_t] Current tick
+ * @return [int8_t] Entry index, -1 if none
+ */
+static int8_t Next_Due(uint8_t packed, uint16_t space, TickType_t now) {
+    int8_t next = -1;
+
+    for (uint8_t i = 0; i < schedCount; i++) {
+        Sched_Entry* entry = &schedEntries[i];
+        if ((packed & (1u << i)) || (int32_t)(entry->release - now) > 0 ||
+            (entry->packet->maxAge != 0 && !entry->fresh) || entry->maxLength + LORA_SCHED_TAG_LEN > space) {
+            continue;
+        }
+        if (next < 0 || (int32_t)((entry->release + entry->period) -
+            (schedEntries[next].release + schedEntries[next].period)) < 0) {
+            next = i;
+        }
+    }
+    return next;
+}
+
+/**
+ * @brief Copy a packet into schedSample
+ * @note A published sample leaves its slot, data is copied as it is now
+ * 
+ * @param entry [Sched_Entry*] Packet
+ * @return [uint32_t] Get_Timer_Count the sample was taken
+ */
+static uint32_t Take_Sample(Sched_Entry* entry) {
+    const LoRa_Sched_Packet* packet = entry->packet;
+    uint32_t sampleTime;
+
+    taskENTER_CRITICAL();
+    if (packet->maxAge != 0) {
+        memcpy(schedSample, entry->slot, packet->length);
+        sampleTime = entry->sampleTime;
+        entry->fresh = false;
+    }
+    else {
+        memcpy(schedSample, packet->data, packet->length);
+        sampleTime = Get_Timer_Count();
+    }
+    taskEXIT_CRITICAL();
+    return sampleTime;
+}
+
+/**
+ * @brief Stamp schedSample with its sequence and sample time before encoding
+ * @note Every T32 field, the sample time too, goes on the session epoch
+ * 
+ * @param entry [Sched_Entry*] Packet with a codec schema
+ * @param sampleTime [uint32_t] Get_Timer_Count the sample was taken
+ */
+static void Stamp(Sched_Entry* entry, uint32_t sampleTime) {
+    const LoRa_Sched_Packet* packet = entry->packet;
+    uint32_t time;
+
+    schedSample[packet->fields[LORA_SCHEMA_SEQUENCE_FIELD].offset] = entry->sequence++;
+    memcpy(&schedSample[packet->fields[LORA_SCHEMA_TIME_FIELD(packet->fieldCount)].offset], &sampleTime,
+        sizeof(sampleTime));
+    for (uint8_t i = 0; i < packet->fieldCount; i++) {
+        if (packet->fields[i].type == LORA_FIELD_T32) {
+            uint8_t* field = &schedSample[packet->fields[i].offset];
+            memcpy(&time, field, sizeof(time));
+            time -= schedEpoch;
+            memcpy(field, &time, sizeof(time));
+        }
+    }
+}
+
+/**
+ * @brief Send the parity frame once its group is complete
+ * @note Under TDMA it waits for a slot with room for it
+ * 
+ * @return [bool] True if a parity frame went on air
+ */
+static bool Send_Parity() {
+    if (schedFec.size == 0 || schedFec.index < schedFec.size) {
+        return false;
+    }
+    uint32_t parityAirtime = Lora_Get_Airtime(LORA_FEC_PARITY_LEN + schedFec.parityLength);
+#ifdef LORA_TDMA
+    taskENTER_CRITICAL();
+    uint32_t hold = LoRa_TDMA_Wait(&schedTdma, parityAirtime, Get_Timer_Count());
+    taskEXIT_CRITICAL();
+    if (hold > 0) {
+        return false;
+    }
+#endif
+
+    uint8_t parityLength = LoRa_FEC_Parity(&schedFec, loraFrame);
+    if (Lora_Transmit_Start(loraFrame, parityLength) != LORA_OK ||
+        Lora_Transmit_Complete(pdMS_TO_TICKS(parityAirtime / 1000 + 1) + LORA_SCHED_TX_MARGIN) != LORA_OK) {
+        return false;
+    }
+    frameStats.parity++;
+    schedWindowAirtime += parityAirtime;
+    return true;
+}
+
+/* Function Implementation --------------------------------------------------*/
+
+LoRa_Sched_Status LoRa_Sched_Init(const LoRa_Sched_Packet* packets, uint8_t count) {
+    if (packets == NULL || count == 0 || count > LORA_SCHED_MAX_PACKETS) {
+        return LORA_SCHED_ERROR;
+    }
+
+    TickType_t now = xTaskGetTickCount();
+    for (uint8_t i = 0; i < count; i++) {
+        uint8_t maxLength = (packets[i].fields != NULL) ?
+            LoRa_Codec_Max_Length(packets[i].fields, packets[i].fieldCount) : packets[i].length - 1;
+        if (packets[i].data == NULL || packets[i].length == 0 || packets[i].length > LORA_SCHED_MAX_PACKET_LEN ||
+            packets[i].fieldCount > LORA_CODEC_MAX_FIELDS ||
+            maxLength + LORA_SCHED_TAG_LEN + SCHED_CONTROL_LEN + LORA_FEC_PARITY_LEN > LORA_MAX_PAYLOAD_LEN ||
+            packets[i].rate == 0 || packets[i].rate > configTICK_RATE_HZ ||
+            packets[i].latency >= configTICK_RATE_HZ / packets[i].rate) {
+            return LORA_SCHED_ERROR;
+        }
+        schedEntries[i] = (Sched_Entry){
+            .packet = &packets[i],
+            .period = configTICK_RATE_HZ / packets[i].rate,
+            .release = now,
+            .maxLength = maxLength,
+        };
+    }
+    schedCount = count;
+    schedWindowStart = now;
+    schedEpoch = Get_Timer_Count();
+    LoRa_ADR_Init(now);
+    LoRa_FEC_Init(&schedFec, LORA_FEC_DEFAULT_GROUP);
+#ifdef LORA_TDMA
+    LoRa_TDMA_Init(&schedTdma, LORA_TDMA_NODE, LORA_TDMA_NODES);
+    schedTagDue = now;
+#endif
+    Update_Budget();
+    return LORA_SCHED_OK;
+}
+
+void LoRa_Sched_Run() {
+    TickType_t now = xTaskGetTickCount();
+    TickType_t sleep = portMAX_DELAY;
+    uint8_t flush = 0;
+    TickType_t window = schedWindowStart;
+
+    // The offload holds the radio, packets released meanwhile start over instead of counting as missed
+    if (LoRa_Offload_Due(now)) {
+        LoRa_Offload_Run();
+        now = xTaskGetTickCount();
+        for (uint8_t i = 0; i < schedCount; i++) {
+            schedEntries[i].release = now;
+        }
+        return;
+    }
+
+    Update_Rates(now);
+#ifdef LORA_TDMA
+    if (schedWindowStart != window) {
+        Update_Budget(); // The guard follows the measured TX overrun
+    }
+#else
+    (void)window;
+#endif
+
+    for (uint8_t i = 0; i < schedCount; i++) {
+        Sched_Entry* entry = &schedEntries[i];
+        int32_t early = (int32_t)(entry->release - now);
+        if (early > 0) {
+            if ((TickType_t)early < sleep) {
+                sleep = early;
+            }
+            continue;
+        }
+
+        // A release whose whole period has passed is stale, skip to the current one
+        TickType_t late = (now - entry->release) / entry->period;
+        if (late > 0) {
+            entry->stats.missed += late;
+            entry->release += late * entry->period;
+        }
+
+        // A published packet goes with a new sample only, and never once it is too old
+        if (entry->packet->maxAge != 0) {
+            taskENTER_CRITICAL();
+            bool fresh = entry->fresh;
+            if (fresh && now - entry->published > entry->packet->maxAge) {
+                entry->fresh = fresh = false;
+                entry->stats.dropped++;
+            }
+            taskEXIT_CRITICAL();
+
+            if (!fresh) {
+                // A sample may still come up to the latency bound, after it nothing goes this period
+                TickType_t wait = entry->release + entry->packet->latency - now;
+                if ((int32_t)wait <= 0) {
+                    entry->release += entry->period;
+                    wait = entry->release - now;
+                }
+                if (wait < sleep) {
+                    sleep = wait;
+                }
+                continue;
+            }
+        }
+
+        // Send once any due packet has waited as long as it may
+        int32_t wait = (int32_t)(entry->release + entry->packet->latency - now);
+        if (wait <= 0) {
+            flush = 1;
+        }
+        else if ((TickType_t)wait < sleep) {
+            sleep = wait;
+        }
+    }
+
+    if (!flush) {
+        vTaskDelay(sleep);
+        return;
+    }
+
+#ifdef LORA_TDMA
+    // Frames only start in this node's slot, a full one always fits
+    taskENTER_CRITICAL();
+    uint32_t hold = LoRa_TDMA_Wait(&schedTdma, schedLimitAirtime, Get_Timer_Count());
+    taskEXIT_CRITICAL();
+    if (hold > 0) {
+        vTaskDelay(pdMS_TO_TICKS((hold + 999) / 1000));
+        return;
+    }
+    // Parity that found no room in the last slot takes this one
+    if (Send_Parity()) {
+        return;
+    }
+#endif
+
+    // FEC tag and link request first, then due packets in deadline order, the rest wait for the next frame
+    uint8_t packed = 0;
+    uint16_t length = LoRa_FEC_Header(&schedFec, loraFrame);
+#ifdef LORA_TDMA
+    // One receiver hears the whole fleet at one data rate, no node may ask for another
+    uint8_t request = 0;
+    uint8_t tag = (int32_t)(now - schedTagDue) >= 0;
+#else
+    uint8_t request = LoRa_ADR_Request(now, &loraFrame[length]);
+    uint8_t tag = request;
+#endif
+    uint16_t limit = frameStats.limit - (length ? LORA_FEC_PARITY_LEN - LORA_FEC_HEADER_LEN : 0); // Parity fits too
+    int8_t next;
+
+    length += request;
+    if (tag) {
+        // The ground checks the schema version as often as the link
+        loraFrame[length++] = LORA_SCHEMA_TYPE;
+        loraFrame[length++] = LORA_SCHEMA_TAG_LEN - 2;
+        loraFrame[length++] = LORA_SCHEMA_VERSION;
+    }
+    while ((next = Next_Due(packed, limit - length, now)) >= 0) {
+        Sched_Entry* entry = &schedEntries[next];
+        const LoRa_Sched_Packet* packet = entry->packet;
+        uint8_t* payload = &loraFrame[length + LORA_SCHED_TAG_LEN];
+        uint8_t payloadLength = packet->length - 1;
+        uint32_t sampleTime = Take_Sample(entry);
+
+        if (packet->fields != NULL) {
+            Stamp(entry, sampleTime);
+            payloadLength = LoRa_Codec_Encode(packet->fields, packet->fieldCount, &entry->codec,
+                schedSample, payload);
+        }
+        else {
+            memcpy(payload, &schedSample[1], payloadLength);
+        }
+        loraFrame[length++] = schedSample[0]; // Packet ID is the type
+        loraFrame[length++] = payloadLength;
+        length += payloadLength;
+        packed |= (1u << next);
+    }
+
+    // Airtime follows the modem settings, which may change at runtime
+    uint32_t airtime = Lora_Get_Airtime(length);
+    uint8_t sent = (Lora_Transmit_Start(loraFrame, length) == LORA_OK);
+    uint32_t started = Get_Timer_Count();
+    sent = sent && Lora_Transmit_Complete(pdMS_TO_TICKS(airtime / 1000 + 1) + LORA_SCHED_TX_MARGIN) == LORA_OK;
+    TickType_t done = xTaskGetTickCount();
+
+    if (sent) {
+        frameStats.frames++;
+        frameStats.bytes += length;
+        schedWindowAirtime += airtime;
+#ifdef LORA_TDMA
+        LoRa_TDMA_Sent(&schedTdma, airtime, Get_Timer_Count() - started);
+        if (tag) {
+            schedTagDue = now + LORA_ADR_REPORT_PERIOD;
+        }
+#else
+        (void)started;
+#endif
+
+        LoRa_FEC_Add(&schedFec, loraFrame, length);
+
+        // Listen for the link report, the frame size follows any rate change
+        if (request && LoRa_ADR_Listen()) {
+            Update_Budget();
+        }
+
+        // Parity after the report so it never talks over the receiver
+        Send_Parity();
+    }
+
+    for (uint8_t i = 0; i < schedCount; i++) {
+        Sched_Entry* entry = &schedEntries[i];
+        if (!(packed & (1u << i))) {
+            continue;
+        }
+        entry->stats.airtime = airtime;
+        if (!sent) {
+            entry->stats.errors++;
+            LoRa_Codec_Resync(&entry->codec); // Receiver may have lost a keyframe
+        }
+        else {
+            entry->stats.sent++;
+            entry->windowCount++;
+            frameStats.subPackets++;
+            if ((int32_t)(done - (entry->release + entry->period)) > 0) {
+                entry->stats.missed++;
+            }
+        }
+        entry->release += entry->period;
+    }
+}
+
+LoRa_Sched_Status LoRa_Sched_Publish(uint8_t id) {
+    for (uint8_t i = 0; i < schedCount; i++) {
+        Sched_Entry* entry = &schedEntries[i];
+        const LoRa_Sched_Packet* packet = entry->packet;
+        if (packet->maxAge == 0 || packet->data[0] != id) {
+            continue;
+        }
+
+        // The newest sample replaces one still waiting
+        taskENTER_CRITICAL();
+        if (entry->fresh) {
+            entry->stats.overwritten++;
+        }
+        memcpy(entry->slot, packet->data, packet->length);
+        entry->sampleTime = Get_Timer_Count();
+        entry->published = xTaskGetTickCount();
+        entry->fresh = true;
+        taskEXIT_CRITICAL();
+        return LORA_SCHED_OK;
+    }
+    return LORA_SCHED_ERROR;
+}
+
+void LoRa_Sched_Set_FEC(uint8_t size) {
+    uint8_t group = schedFec.group + 1; // The ground must not mix the old group with the new
+    LoRa_FEC_Init(&schedFec, size);
+    schedFec.group = group;
+}
+
+LoRa_Sched_Status LoRa_Sched_Get_Stats(uint8_t index, LoRa_Sched_Stats* stats) {
+    if (index >= schedCount || stats == NULL) {
+        return LORA_SCHED_ERROR;
+    }
+    *stats = schedEntries[index].stats;
+    return LORA_SCHED_OK;
+}
+
+void LoRa_Sched_Get_Frame_Stats(LoRa_Sched_Frame_Stats* stats) {
+    if (stats != NULL) {
+        *stats = frameStats;
+    }
+}
+
+void LoRa_Sched_Set_Time(uint32_t iTOW, uint32_t timer) {
+#ifdef LORA_TDMA
+    taskENTER_CRITICAL();
+    LoRa_TDMA_Sync(&schedTdma, iTOW, timer);
+    taskEXIT_CRITICAL();
+#else
+    (void)iTOW;
+    (void)timer;
+#endif
+}
+
+void LoRa_Sched_Get_TDMA_Stats(LoRa_TDMA_Stats* stats) {
+    if (stats == NULL) {
+        return;
+    }
+#ifdef LORA_TDMA
+    taskENTER_CRITICAL();
+    *stats = schedTdma.stats;
+    taskEXIT_CRITICAL();
+#else
+    memset(stats, 0, sizeof(LoRa_TDMA_Stats));
+#endif
+}
@@ -0,0 +1,61 @@
+/************************************************
+* @file    lora_schema.c 
+* @author  APBashara
+* @date    10/2026
+* 
+* @brief   LoRa Telemetry Wire Schema Tables
+* @note    Builds for the firmware and for the ground decoder on Linux,
+*          keep it free of STM32 headers
+***********************************************/
+
+#include <stddef.h>
+
+#include "lora_schema.h"
+
+/* Static Checks ------------------------------------------------------------*/
+#define SCHEMA_MAX_KEY_LEN          (200) // Keyframe bytes, leaves room for the tags in a 255 byte frame
+
+#define CHECK_FIELD(P, name, type, bits) \
+    _Static_assert((bits) >= 1 && (bits) <= 8 * sizeof(LORA_SCHEMA_CTYPE_##type), \
+        #P "." #name " bits do not fit its type");
+#define CHECK_PACKET(id, name, fields) \
+    LORA_SCHEMA_ALL(fields, CHECK_FIELD, name) \
+    _Static_assert(offsetof(LoRa_##name##_Packet, PacketID) == 0, #name " must start with its ID"); \
+    _Static_assert(sizeof(LoRa_##name##_Packet) <= UINT8_MAX, #name " is too long for the scheduler"); \
+    _Static_assert(LoRa_##name##_Field_Count <= LORA_CODEC_MAX_FIELDS, #name " has too many fields"); \
+    _Static_assert(LoRa_##name##_Key_Len <= SCHEMA_MAX_KEY_LEN, #name " keyframe does not fit a frame"); \
+    _Static_assert((id) < LORA_SCHEMA_TYPE, #name " ID is taken by the link tags");
+LORA_SCHEMA(CHECK_PACKET)
+
+/* Tables -------------------------------------------------------------------*/
+#define FIELD_ENTRY(P, name, type, bits) { offsetof(LoRa_##P##_Packet, name), LORA_FIELD_##type, bits },
+#define FIELD_NAME(P, name, type, bits) #name,
+#define FIELD_TABLES(id, name, fields) \
+    const LoRa_Field LoRa_##name##_Fields[LoRa_##name##_Field_Count] = { LORA_SCHEMA_ALL(fields, FIELD_ENTRY, name) }; \
+    static const char* const name##FieldNames[] = { LORA_SCHEMA_ALL(fields, FIELD_NAME, name) };
+LORA_SCHEMA(FIELD_TABLES)
+
+#define PACKET_ENTRY(id, name, fields) \
+    { id, #name, LoRa_##name##_Fields, name##FieldNames, LoRa_##name##_Field_Count, sizeof(LoRa_##name##_Packet) },
+const LoRa_Schema_Packet loraSchema[LORA_SCHEMA_PACKETS] = { LORA_SCHEMA(PACKET_ENTRY) };
+
+/* Function Implementation --------------------------------------------------*/
+
+const LoRa_Schema_Packet* LoRa_Schema_Find(uint8_t id) {
+    // One case per packet, so a duplicate ID does not compile
+#define PACKET_CASE(packetId, name, fields) case packetId:
+    switch (id) {
+    LORA_SCHEMA(PACKET_CASE)
+        break;
+    default:
+        return NULL;
+    }
+#undef PACKET_CASE
+
+    for (uint8_t i = 0; i < LORA_SCHEMA_PACKETS; i++) {
+        if (loraSchema[i].id == id) {
+            return &loraSchema[i];
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,352 @@
+/************************************************
+* @file    lora_sweep.c 
+* @author  APBashara
+* @date    10/2026
+* 
+* @brief   LoRa Airtime and Packet Error Rate Sweep Implementation
+* @note    Points are numbered in sweep order, skipped ones included, so
+*          the same index means the same settings on both ends
+***********************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "lora_sweep.h"
+#include "lora_link.h"
+#include "task.h"
+#include "timer.h"
+
+#define SWEEP_SF_COUNT              (sizeof(sweepSF) / sizeof(sweepSF[0]))
+#define SWEEP_BW_COUNT              (sizeof(sweepBW) / sizeof(sweepBW[0]))
+#define SWEEP_CR_COUNT              (sizeof(sweepCR) / sizeof(sweepCR[0]))
+#define SWEEP_LENGTH_COUNT          (sizeof(sweepLength) / sizeof(sweepLength[0]))
+
+typedef struct {
+    LoRa_SF sf;
+    LoRa_BW bw;
+    LoRa_CR cr;
+    uint8_t packets;
+    uint8_t length; // Frame length, tag included
+} Sweep_Point;
+
+typedef struct {
+    uint32_t airtime; // Datasheet airtime in us
+    uint32_t min; // Measured TX time in us
+    uint32_t max;
+    uint32_t total;
+    uint8_t sent; // Packets that reached TxDone
+    uint8_t errors; // Packets that did not
+    bool answered; // The receiver's result arrived
+    uint8_t good;
+    uint8_t corrupt;
+    int8_t snr; // Quarter dB, mean of the good packets
+    uint8_t rssi; // -dBm, mean of the good packets
+} Sweep_Result;
+
+// SF6 needs implicit headers and the narrow bandwidths are too slow for telemetry
+static const LoRa_SF sweepSF[] = { LORA_SF_7, LORA_SF_8, LORA_SF_9, LORA_SF_10, LORA_SF_11, LORA_SF_12 };
+static const LoRa_BW sweepBW[] = { LORA_BW_125, LORA_BW_250, LORA_BW_500 };
+static const uint32_t sweepBandwidthHz[] = { 125000, 250000, 500000 };
+static const LoRa_CR sweepCR[] = { LORA_CR_4_5, LORA_CR_4_6, LORA_CR_4_7, LORA_CR_4_8 };
+static const uint8_t sweepLength[] = { 16, 64, 128, 255 };
+
+static uint8_t sweepFrame[LORA_MAX_PAYLOAD_LEN];
+static LoRa_RX_Frame sweepRx;
+static char sweepLine[LORA_SWEEP_LINE_LEN];
+
+/* Static Functions ---------------------------------------------------------*/
+
+/**
+ * @brief Write a little endian uint16_t
+ * 
+ * @param dest [uint8_t*] Destination bytes
+ * @param value [uint16_t] Value to write
+ */
+static void Put_U16(uint8_t* dest, uint16_t value) {
+    dest[0] = value & 0xFF;
+    dest[1] = value >> 8;
+}
+
+/**
+ * @brief Read a little endian uint16_t
+ * 
+ * @param src [const uint8_t*] Source bytes
+ * @return [uint16_t] Value
+ */
+static uint16_t Get_U16(const uint8_t* src) {
+    return src[0] | (src[1] << 8);
+}
+
+/**
+ * @brief Set the modem settings, written at the next mode change
+ */
+static void Apply(LoRa_SF sf, LoRa_BW bw, LoRa_CR cr) {
+    Lora_Set_SF(sf);
+    Lora_Set_BW(bw);
+    Lora_Set_CodingRate(cr);
+}
+
+/**
+ * @brief Build a data packet in sweepFrame
+ * @note The filler is the sequence plus the byte position
+ * 
+ * @param index [uint16_t] Point index
+ * @param sequence [uint8_t] Packet of the point
+ * @param length [uint8_t] Frame length
+ */
+static void Fill(uint16_t index, uint8_t sequence, uint8_t length) {
+    sweepFrame[0] = LORA_SWEEP_TYPE;
+    sweepFrame[1] = length - 2;
+    sweepFrame[2] = LORA_SWEEP_DATA;
+    Put_U16(&sweepFrame[3], index);
+    sweepFrame[5] = sequence;
+    for (uint16_t i = LORA_SWEEP_DATA_MIN_LEN; i < length; i++) {
+        sweepFrame[i] = sequence + i;
+    }
+}
+
+/**
+ * @brief Check a received data packet byte for byte
+ * 
+ * @param rx [const LoRa_RX_Frame*] Received frame
+ * @param index [uint16_t] Point index
+ * @param point [const Sweep_Point*] Point settings
+ * @return [bool] True if it is an intact packet of the point
+ */
+static bool Check(const LoRa_RX_Frame* rx, uint16_t index, const Sweep_Point* point) {
+    const uint8_t* data = rx->data;
+    if (rx->length != point->length || data[0] != LORA_SWEEP_TYPE || data[1] != point->length - 2 ||
+        data[2] != LORA_SWEEP_DATA || Get_U16(&data[3]) != index || data[5] >= point->packets) {
+        return false;
+    }
+    for (uint16_t i = LORA_SWEEP_DATA_MIN_LEN; i < point->length; i++) {
+        if (data[i] != (uint8_t)(data[5] + i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Run one point and collect its timings and the receiver's result
+ * @note Starts and ends at the base settings
+ * 
+ * @param index [uint16_t] Point index
+ * @param point [const Sweep_Point*] Point settings
+ * @param base [const LoRa_Config*] Settings the receiver listens at
+ * @param result [Sweep_Result*] Destination, airtime is filled in already
+ */
+static void Measure(uint16_t index, const Sweep_Point* point, const LoRa_Config* base, Sweep_Result* result) {
+    TickType_t timeout = pdMS_TO_TICKS(result->airtime / 1000 + 1) + LORA_SWEEP_TX_MARGIN;
+
+    // Announced at the base settings, the receiver switches as it hears it
+    sweepFrame[0] = LORA_SWEEP_TYPE;
+    sweepFrame[1] = LORA_SWEEP_START_LEN - 2;
+    sweepFrame[2] = LORA_SWEEP_START;
+    Put_U16(&sweepFrame[3], index);
+    sweepFrame[5] = point->sf;
+    sweepFrame[6] = point->bw;
+    sweepFrame[7] = point->cr;
+    sweepFrame[8] = point->packets;
+    sweepFrame[9] = point->length;
+    if (Lora_Transmit(sweepFrame, LORA_SWEEP_START_LEN) != LORA_OK) {
+        result->errors = point->packets;
+        return;
+    }
+    Apply(point->sf, point->bw, point->cr);
+    vTaskDelay(LORA_SWEEP_TURNAROUND);
+
+    for (uint8_t sequence = 0; sequence < point->packets; sequence++) {
+        Fill(index, sequence, point->length);
+        if (Lora_Transmit_Start(sweepFrame, point->length) != LORA_OK) {
+            result->errors++;
+            continue;
+        }
+
+        // TX mode set to TxDone seen by the task, what the scheduler budgets per packet
+        uint32_t start = Get_Timer_Count();
+        LoRa_Status status = Lora_Transmit_Complete(timeout);
+        uint32_t elapsed = Get_Timer_Count() - start;
+        if (status != LORA_OK) {
+            result->errors++;
+        }
+        else {
+            result->sent++;
+            result->total += elapsed;
+            if (elapsed < result->min) {
+                result->min = elapsed;
+            }
+            if (elapsed > result->max) {
+                result->max = elapsed;
+            }
+        }
+        vTaskDelay(LORA_SWEEP_GAP);
+    }
+    Apply(base->sf, base->bw, base->cr);
+
+    // The receiver waits out its window when the last packet is lost, then turns around
+    uint8_t answer[LORA_SWEEP_RESULT_LEN];
+    uint8_t length;
+    TickType_t window = pdMS_TO_TICKS(Lora_Get_Airtime(LORA_SWEEP_RESULT_LEN) / 1000 + 1) +
+        3 * LORA_SWEEP_TURNAROUND;
+    TickType_t listen = xTaskGetTickCount();
+    TickType_t waited;
+    while ((waited = xTaskGetTickCount() - listen) < window) {
+        if (Lora_Receive_Timeout(answer, sizeof(answer), &length, window - waited) == LORA_OK &&
+            length == LORA_SWEEP_RESULT_LEN && answer[0] == LORA_SWEEP_TYPE &&
+            answer[1] == LORA_SWEEP_RESULT_LEN - 2 && answer[2] == LORA_SWEEP_RESULT &&
+            Get_U16(&answer[3]) == index) {
+            result->answered = true;
+            result->good = answer[5];
+            result->corrupt = answer[6];
+            result->snr = (int8_t)answer[7];
+            result->rssi = answer[8];
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Write the CSV row of a point to sweepLine
+ * @note Timing columns are empty without a TxDone, receiver columns
+ *       without a result
+ * 
+ * @param index [uint16_t] Point index
+ * @param point [const Sweep_Point*] Point settings
+ * @param bandwidth [uint32_t] Hz
+ * @param result [const Sweep_Result*] Measurements
+ */
+static void Format_Row(uint16_t index, const Sweep_Point* point, uint32_t bandwidth, const Sweep_Result* result) {
+    size_t used = snprintf(sweepLine, sizeof(sweepLine), "%u,%u,%lu,4/%u,%u,%u,%lu,", index, point->sf,
+        (unsigned long)bandwidth, point->cr + 4, point->length, point->packets, (unsigned long)result->airtime);
+
+    uint32_t mean = result->sent ? result->total / result->sent : 0;
+    if (result->sent) {
+        used += snprintf(&sweepLine[used], sizeof(sweepLine) - used, "%lu,%lu,%lu,%ld,%u,%lu,",
+            (unsigned long)result->min, (unsigned long)mean, (unsigned long)result->max,
+            (long)mean - (long)result->airtime, result->errors,
+            (unsigned long)(mean ? (uint64_t)point->length * 8 * 1000000 / mean : 0));
+    }
+    else {
+        used += snprintf(&sweepLine[used], sizeof(sweepLine) - used, ",,,,%u,,", result->errors);
+    }
+
+    if (result->answered && used < sizeof(sweepLine)) {
+        uint32_t goodput = mean ? (uint64_t)point->length * 8 * 1000000 * result->good / point->packets / mean : 0;
+        used += snprintf(&sweepLine[used], sizeof(sweepLine) - used, "%u,%u,%u,%lu,%d,%d\r\n", result->good,
+            result->corrupt, 1000 - 1000 * result->good / point->packets, (unsigned long)goodput, result->snr,
+            -(int16_t)result->rssi);
+    }
+    else if (used < sizeof(sweepLine)) {
+        snprintf(&sweepLine[used], sizeof(sweepLine) - used, ",,,,,\r\n");
+    }
+}
+
+/* Function Implementation --------------------------------------------------*/
+
+void LoRa_Sweep_Run(LoRa_Sweep_Output output, void* ctx) {
+    LoRa_Config base;
+    uint16_t index = 0;
+
+#ifndef LORA_TDMA
+    // A receiver that hears nothing falls back to the most robust step, meet it there
+    LoRa_ADR_Fallback();
+    vTaskDelay(2 * LORA_LINK_SILENCE);
+#endif
+    Lora_Get_Config(&base);
+
+    output("point,sf,bw_hz,cr,length,packets,airtime_us,tx_min_us,tx_mean_us,tx_max_us,tx_over_us,tx_errors,"
+        "bps,received,corrupt,per_permille,goodput_bps,snr_qdb,rssi_dbm\r\n", ctx);
+
+    for (uint8_t s = 0; s < SWEEP_SF_COUNT; s++) {
+        for (uint8_t b = 0; b < SWEEP_BW_COUNT; b++) {
+            for (uint8_t c = 0; c < SWEEP_CR_COUNT; c++) {
+                for (uint8_t l = 0; l < SWEEP_LENGTH_COUNT; l++, index++) {
+                    Sweep_Point point = { sweepSF[s], sweepBW[b], sweepCR[c], LORA_SWEEP_PACKETS, sweepLength[l] };
+                    Sweep_Result result = { 0 };
+
+                    Apply(point.sf, point.bw, point.cr);
+                    result.airtime = Lora_Get_Airtime(point.length);
+                    result.min = UINT32_MAX;
+                    Apply(base.sf, base.bw, base.cr);
+                    if (result.airtime > LORA_SWEEP_MAX_AIRTIME) {
+                        continue;
+                    }
+
+                    Measure(index, &point, &base, &result);
+                    Format_Row(index, &point, sweepBandwidthHz[b], &result);
+                    output(sweepLine, ctx);
+                }
+            }
+        }
+    }
+}
+
+bool LoRa_Sweep_Serve(const uint8_t* frame, uint8_t length) {
+    Sweep_Point point = { 0 };
+    uint16_t index = 0;
+    bool announced = false;
+
+    for (uint16_t pos = 0; pos + 2 <= length; pos += 2 + frame[pos + 1]) {
+        if (frame[pos] == LORA_SWEEP_TYPE && frame[pos + 1] == LORA_SWEEP_START_LEN - 2 &&
+            pos + LORA_SWEEP_START_LEN <= length && frame[pos + 2] == LORA_SWEEP_START) {
+            index = Get_U16(&frame[pos + 3]);
+            point = (Sweep_Point){ frame[pos + 5], frame[pos + 6], frame[pos + 7], frame[pos + 8], frame[pos + 9] };
+            announced = true;
+        }
+    }
+    if (!announced) {
+        return false;
+    }
+    if (point.length < LORA_SWEEP_DATA_MIN_LEN || point.packets == 0) {
+        return true;
+    }
+
+    LoRa_Config base;
+    Lora_Get_Config(&base);
+    Apply(point.sf, point.bw, point.cr);
+
+    // Covers the car's turnaround, every packet and its gap, with a turnaround to spare
+    TickType_t window = 2 * LORA_SWEEP_TURNAROUND +
+        point.packets * (pdMS_TO_TICKS(Lora_Get_Airtime(point.length) / 1000 + 1) + LORA_SWEEP_GAP);
+    uint8_t good = 0;
+    uint8_t corrupt = 0;
+    int32_t snr = 0;
+    int32_t rssi = 0;
+
+    Lora_RX_Start();
+    TickType_t start = xTaskGetTickCount();
+    TickType_t waited;
+    while ((waited = xTaskGetTickCount() - start) < window) {
+        if (Lora_RX_Read(&sweepRx, window - waited) != LORA_OK) {
+            continue;
+        }
+        if (sweepRx.crcError || !Check(&sweepRx, index, &point)) {
+            if (corrupt < UINT8_MAX) {
+                corrupt++;
+            }
+            continue;
+        }
+        good++;
+        snr += sweepRx.snr;
+        rssi += sweepRx.rssi;
+        if (sweepRx.data[5] == point.packets - 1) {
+            break;
+        }
+    }
+    Apply(base.sf, base.bw, base.cr);
+
+    // Give the car time to switch back and listen
+    vTaskDelay(LORA_SWEEP_TURNAROUND);
+    uint8_t answer[LORA_SWEEP_RESULT_LEN] = { LORA_SWEEP_TYPE, LORA_SWEEP_RESULT_LEN - 2, LORA_SWEEP_RESULT };
+    Put_U16(&answer[3], index);
+    answer[5] = good;
+    answer[6] = corrupt;
+    if (good != 0) {
+        rssi /= good;
+        answer[7] = (uint8_t)(int8_t)(snr / good);
+        answer[8] = (rssi < -255) ? 255 : (uint8_t)-rssi;
+    }
+    Lora_Transmit(answer, sizeof(answer));
+    return true;
+}
@@ -0,0 +1,139 @@
+/************************************************
+* @file    lora_tdma.c 
+* @author  APBashara
+* @date    10/2026
+* 
+* @brief   TDMA Slots for Several Cars on One LoRa Channel Implementation
+* @note    A sample read late says it is earlier than it is, so of the
+*          samples the one putting the clock furthest ahead is the freshest.
+*          It is adopted at once, a window of only later ones replaces it
+*          with their best so a fast local crystal is followed too.
+***********************************************/
+
+#include <string.h>
+
+#include "lora_tdma.h"
+
+#define TDMA_FRAME_US               ((uint32_t)LORA_TDMA_SUPERFRAME * 1000)
+#define TDMA_MAX_STEP               (1000000) // us behind the clock a sample is taken as a time jump
+
+/* Static Functions ---------------------------------------------------------*/
+
+/**
+ * @brief GPS time now by the adopted sample, or the local timer unlocked
+ * 
+ * @param state [const LoRa_TDMA_State*] Node state
+ * @param timer [uint32_t] Current timer
+ * @return [uint64_t] us
+ */
+static uint64_t Now(const LoRa_TDMA_State* state, uint32_t timer) {
+    if (!state->synced) {
+        return timer;
+    }
+    return (uint64_t)state->syncTOW * 1000 + (uint32_t)(timer - state->syncTimer);
+}
+
+/**
+ * @brief How far a sample puts the clock ahead of the adopted one
+ * 
+ * @return [int32_t] us, the week rollover taken out
+ */
+static int32_t Ahead(const LoRa_TDMA_State* state, uint32_t iTOW, uint32_t timer) {
+    int64_t ahead = (int64_t)iTOW * 1000 - (int64_t)Now(state, timer);
+    ahead %= LORA_TDMA_WEEK;
+    if (ahead > LORA_TDMA_WEEK / 2) {
+        ahead -= LORA_TDMA_WEEK;
+    }
+    else if (ahead < -LORA_TDMA_WEEK / 2) {
+        ahead += LORA_TDMA_WEEK;
+    }
+    if (ahead > INT32_MAX || ahead < INT32_MIN) {
+        return (ahead > 0) ? INT32_MAX : INT32_MIN;
+    }
+    return ahead;
+}
+
+static void Adopt(LoRa_TDMA_State* state, uint32_t iTOW, uint32_t timer, int32_t ahead) {
+    state->syncTOW = iTOW;
+    state->syncTimer = timer;
+    state->windowCount = 0;
+    state->stats.correction = ahead;
+    state->synced = true;
+}
+
+/* Function Implementation --------------------------------------------------*/
+
+void LoRa_TDMA_Init(LoRa_TDMA_State* state, uint8_t node, uint8_t nodes) {
+    memset(state, 0, sizeof(LoRa_TDMA_State));
+    state->nodes = (nodes > 0) ? nodes : 1;
+    state->node = (node < state->nodes) ? node : 0;
+    state->stats.guard = 2 * LORA_TDMA_SYNC_ERROR;
+}
+
+void LoRa_TDMA_Sync(LoRa_TDMA_State* state, uint32_t iTOW, uint32_t timer) {
+    state->stats.syncs++;
+    if (!state->synced) {
+        state->acquired = 0;
+        Adopt(state, iTOW, timer, 0);
+        return;
+    }
+    if (state->acquired < LORA_TDMA_SYNC_WINDOW && ++state->acquired == LORA_TDMA_SYNC_WINDOW) {
+        state->stats.locked = true; // The poll phase has swept a whole solution period
+    }
+
+    int32_t ahead = Ahead(state, iTOW, timer);
+    if (ahead > 0 || ahead < -TDMA_MAX_STEP) {
+        Adopt(state, iTOW, timer, ahead);
+        return;
+    }
+    if (state->windowCount == 0 || ahead > state->windowAhead) {
+        state->windowTOW = iTOW;
+        state->windowTimer = timer;
+        state->windowAhead = ahead;
+    }
+    if (++state->windowCount >= LORA_TDMA_SYNC_WINDOW) {
+        Adopt(state, state->windowTOW, state->windowTimer, state->windowAhead);
+    }
+}
+
+uint32_t LoRa_TDMA_Wait(LoRa_TDMA_State* state, uint32_t airtime, uint32_t timer) {
+    if (state->synced && (uint32_t)(timer - state->syncTimer) > LORA_TDMA_HOLDOVER) {
+        state->synced = false; // The crystal has drifted past the guard
+        state->stats.locked = false;
+    }
+
+    uint32_t slot = TDMA_FRAME_US / state->nodes;
+    uint32_t position = Now(state, timer) % TDMA_FRAME_US;
+    uint32_t open = state->node * slot + LORA_TDMA_SYNC_ERROR;
+    bool overlong = airtime > LoRa_TDMA_Budget(state);
+    // An overlong frame goes at the opening and spills over, better than never
+    uint32_t latest = overlong ? open + LORA_TDMA_SYNC_ERROR :
+        (state->node + 1) * slot - LORA_TDMA_SYNC_ERROR - state->overrun - airtime;
+
+    // While acquiring the clock may be a whole solution period off, nothing goes
+    bool acquiring = state->synced && !state->stats.locked;
+    if (position >= open && position <= latest && !acquiring) {
+        if (overlong) {
+            state->stats.overlong++;
+        }
+        return 0;
+    }
+    state->stats.held++;
+    uint32_t wait = (open + TDMA_FRAME_US - position) % TDMA_FRAME_US;
+    return (wait > 0) ? wait : TDMA_FRAME_US;
+}
+
+void LoRa_TDMA_Sent(LoRa_TDMA_State* state, uint32_t airtime, uint32_t elapsed) {
+    uint32_t excess = (elapsed > airtime) ? elapsed - airtime : 0;
+    state->overrun -= state->overrun / 16;
+    if (excess > state->overrun) {
+        state->overrun = excess;
+    }
+    state->stats.guard = 2 * LORA_TDMA_SYNC_ERROR + state->overrun;
+}
+
+uint32_t LoRa_TDMA_Budget(const LoRa_TDMA_State* state) {
+    uint32_t slot = TDMA_FRAME_US / state->nodes;
+    uint32_t guard = 2 * LORA_TDMA_SYNC_ERROR + state->overrun + LORA_TDMA_START_SLACK;
+    return (slot > guard) ? slot - guard : 0;
+}
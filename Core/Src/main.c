@@ -7,6 +7,9 @@
 ***********************************************/
 
 #include "main.h"
+#include "fatfs.h"
+
+#include <stdio.h>
 
 /* Global Variables ---------------------------------------------------------*/
 Telemetry telemetry = 
@@ -20,9 +23,16 @@ Telemetry telemetry =
 
 uint16_t ADC_Buffer[16];
 
-SemaphoreHandle_t LoRa_Mutex;
-
-QueueHandle_t canRXQueue;
+// LoRa rate table, Lora_Task sends these in deadline order
+// data, length, rate (packets/s), latency (ticks a due packet may wait to share a frame), schema,
+// max age (ticks a published sample may wait, 0 for packets filled by CAN signals as they arrive)
+static const LoRa_Sched_Packet loraPackets[] = {
+  { (uint8_t*)&telemetry.Suspension_Packet, sizeof(telemetry.Suspension_Packet), 50, 5, LORA_SCHEMA_FIELDS(Suspension), 20 },
+  { (uint8_t*)&telemetry.GPS_Packet, sizeof(telemetry.GPS_Packet), 25, 20, LORA_SCHEMA_FIELDS(GPS), 80 },
+  { (uint8_t*)&telemetry.Engine_Data_Packet, sizeof(telemetry.Engine_Data_Packet), 20, 25, LORA_SCHEMA_FIELDS(Engine_Data), 0 },
+  { (uint8_t*)&telemetry.Brakes_Accel_Packet, sizeof(telemetry.Brakes_Accel_Packet), 10, 50, LORA_SCHEMA_FIELDS(Brakes_Accel), 0 },
+  { (uint8_t*)&telemetry.Temperature_Packet, sizeof(telemetry.Temperature_Packet), 1, 500, LORA_SCHEMA_FIELDS(Temperature), 0 },
+};
 
 // Task Handlers
 TaskHandle_t xCAN_Task;
@@ -31,12 +41,51 @@ TaskHandle_t xCAN_Task;
 void main() {
   uint8_t Task_Status = 1;
 
+#ifdef LORA_RECEIVER
+  // Receiver role, only the radio and the link to the ground computer
+  Sysclk_168();
+  Timer_Stat_Init(); // Microsecond timebase for receive times
+  LED_Init();
+  SPI2_Init();
+  GPIO_Init();
+  USART2_Init();
+  USART2_DMA_Init();
+  USART3_Init();
+  Lora_Init();
+  Clear_Pin(GPIOA, LORA_RST_PIN); // Turn On LoRa Module
+
+  Task_Status &= xTaskCreate(Status_LED, "Status_Task", 128, NULL, LED_PRIORITY, NULL);
+#ifdef STATS_Task
+  Task_Status &= xTaskCreate(Collect_Stats, "Stats_Task", 512, NULL, STATS_PRIORITY, NULL);
+#endif
+  Task_Status &= xTaskCreate(Lora_Task, "LoRa_Task", 256, NULL, LORA_PRIORITY, NULL); // Serves log offloads too
+#else
+  CAN_Filter_ID canIDs[CAN_FILTER_MAX_IDS];
+  CAN_Filter_Config canFilters;
+
   // Initialize Hardware
   Sysclk_168();
+  Timer_Stat_Init(); // Microsecond timebase for CAN timestamps
   LED_Init();
   I2C1_Init();
   CAN1_Init();
-  CAN_Filters_Init();
+
+#ifdef CAN_CAPTURE
+  // Accept the whole bus for logging, the decoder ignores unknown IDs
+  (void)canIDs;
+  if (CAN_Decode_Init() != CAN_DECODE_OK || CAN_Filter_Accept_All(&canFilters) != CAN_OK) {
+    Error_Handler();
+  }
+#else
+  // Only accept the IDs the signal decoder subscribes to, plus log download requests
+  uint8_t canIDCount = CAN_Decode_Get_IDs(canIDs, CAN_FILTER_MAX_IDS - 1);
+  canIDs[canIDCount++] = (CAN_Filter_ID){ ISOTP_RX_ID, ISOTP_RX_RATE };
+  if (CAN_Decode_Init() != CAN_DECODE_OK ||
+      CAN_Filter_Alloc(canIDs, canIDCount, &canFilters) != CAN_OK) {
+    Error_Handler();
+  }
+#endif
+  CAN_Filters_Init(&canFilters);
   CAN_Start();
   SPI2_Init();
   GPIO_Init();
@@ -44,40 +93,39 @@ void main() {
   USART3_Init();
   Lora_Init();
   Clear_Pin(GPIOA, LORA_RST_PIN); // Turn On LoRa Module
+  if (LoRa_Sched_Init(loraPackets, sizeof(loraPackets) / sizeof(LoRa_Sched_Packet)) != LORA_SCHED_OK) {
+    Error_Handler();
+  }
+
+  // Register the SD card, the volume itself is mounted on first access
+  MX_FATFS_Init();
+  if (retUSER != 0 || f_mount(&USERFatFS, USERPath, 0) != FR_OK || ISOTP_Init() != ISOTP_OK) {
+    Error_Handler();
+  }
 
   // Create Tasks to collect Data
   Task_Status &= xTaskCreate(ADC_Task, "ADC_Task", 128, NULL, ADC_PRIORITY, NULL);
   Task_Status &= xTaskCreate(GPS_Task, "GPS_Task", 512, NULL, GPS_PRIORITY, NULL);
+#ifdef CAN_CAPTURE
+  Task_Status &= xTaskCreate(CAN_Task, "CAN_Task", 512, NULL, CAN_PRIORITY, &xCAN_Task);
+#else
   Task_Status &= xTaskCreate(CAN_Task, "CAN_Task", 256, NULL, CAN_PRIORITY, &xCAN_Task);
+#endif
   Task_Status &= xTaskCreate(Status_LED, "Status_Task", 128, NULL, LED_PRIORITY, NULL);
+  Task_Status &= xTaskCreate(Offload_Task, "Offload_Task", 384, NULL, OFFLOAD_PRIORITY, NULL);
 #ifdef STATS_Task
   Task_Status &= xTaskCreate(Collect_Stats, "Stats_Task", 512, NULL, STATS_PRIORITY, NULL);
 #endif
 
-  // Create Tasks to send LoRa Packets
-  Task_Status &= xTaskCreate(LoRa_Suspension_Task, "LoRa_Suspension_Task", 128, NULL, LORA_SUSPENSION_PRIORITY, NULL);
-  Task_Status &= xTaskCreate(LoRa_GPS_Task, "LoRa_GPS_Task", 128, NULL, LORA_GPS_PRIORITY, NULL);
-  Task_Status &= xTaskCreate(LoRa_Engine_Data_Task, "LoRa_Engine_Data_Task", 128, NULL, LORA_ENGINE_PRIORITY, NULL);
-  Task_Status &= xTaskCreate(LoRa_Brakes_Accel_Task, "LoRa_Brakes_Accel_Task", 128, NULL, LORA_BRAKES_ACCEL_PRIORITY, NULL);
-  Task_Status &= xTaskCreate(LoRa_Temperature_Task, "LoRa_Temperature_Task", 128, NULL, LORA_TEMPERATURE_PRIORITY, NULL);
+  // Create Task to send LoRa Packets, it reads the SD card for log offloads
+  Task_Status &= xTaskCreate(Lora_Task, "LoRa_Task", 384, NULL, LORA_PRIORITY, NULL);
+#endif
   
   // Check that tasks were created successfully
   if (Task_Status != pdPASS) {
     Error_Handler();
   }
 
-  // Create and check LoRa Mutex Creation
-  LoRa_Mutex = xSemaphoreCreateMutex();
-  if (LoRa_Mutex == NULL) {
-    Error_Handler();
-  }
-
-  // Create and check CAN RX Queue Creation
-  canRXQueue = xQueueCreate(10, sizeof(CAN_Frame));
-  if (canRXQueue == NULL) {
-    Error_Handler();
-  }
-
   NVIC_SetPriorityGrouping(0);
 
   vTaskStartScheduler(); // Start FreeRTOS Scheduler
@@ -97,37 +145,68 @@ void Status_LED() {
 }
 
 void CAN_Task() {
-  volatile CAN_Frame rxFrame;
+  const TickType_t StatsFrequency = 1000; // 1Hz bus load window
+  TickType_t xLastStats = xTaskGetTickCount();
+  CAN_Frame rxFrames[CAN_RX_BATCH];
+  uint16_t count;
+
+#ifdef CAN_CAPTURE
+  // Keep decoding for telemetry even if the card is missing
+  CAN_Capture_Init();
+#endif
 
   while(1) {
-    if (xQueueReceive(canRXQueue, &rxFrame, portMAX_DELAY) == pdTRUE) {
-      switch (rxFrame.id)
-      {
-      case 0x048:
-        telemetry.Engine_Data_Packet.RPM = rxFrame.data[0] + (rxFrame.data[1] << 8);
-        telemetry.Engine_Data_Packet.ThrottlePosSensor = rxFrame.data[2] + (rxFrame.data[3] << 8);
-        break;
-      case 0x148:
-        telemetry.Engine_Data_Packet.Lambda = rxFrame.data[4] + (rxFrame.data[5] << 8);
-        break;
-      case 0x248:
-        telemetry.Brakes_Accel_Packet.OilPressure = rxFrame.data[6] + (rxFrame.data[7] << 8);
-        break;
-      case 0x548:
-        telemetry.Temperature_Packet.AirTemp = rxFrame.data[2] + (rxFrame.data[3] << 8);
-        telemetry.Temperature_Packet.CoolTemp = rxFrame.data[4] + (rxFrame.data[5] << 8);
-        break;
-      default:
-        break;
+    // Woken once per burst by the RX ISRs, then drain the ring until empty
+    ulTaskNotifyTake(pdTRUE, StatsFrequency);
+    while ((count = CAN_RX_Pop_Batch(rxFrames, CAN_RX_BATCH)) > 0) {
+      for (uint16_t i = 0; i < count; i++) {
+#ifdef CAN_CAPTURE
+        CAN_Capture_Frame(&rxFrames[i]);
+#endif
+        if (rxFrames[i].id == ISOTP_RX_ID) {
+          ISOTP_Receive_Frame(&rxFrames[i]);
+        }
+        else {
+          CAN_Decode_Frame(&rxFrames[i]);
+        }
       }
     }
+
+    // Unacknowledged frames retransmit forever, free their mailboxes
+    CAN_TX_Abort_Stale();
+
+    if ((xTaskGetTickCount() - xLastStats) >= StatsFrequency) {
+#ifdef CAN_CAPTURE
+      CAN_Capture_Flush();
+#endif
+      CAN_Stats_Update();
+      xLastStats += StatsFrequency;
+    }
+  }
+}
+
+void Offload_Task() {
+  static uint8_t request[ISOTP_MAX_RX];
+  const uint8_t* response;
+
+  while(1) {
+    uint16_t length = ISOTP_Process(request);
+    // Testers wait for each response, a request during a send is a protocol error
+    if (length > 0 && !ISOTP_TX_Busy()) {
+      uint16_t responseLength = Log_Service_Handle(request, length, &response);
+      ISOTP_Send(response, responseLength);
+    }
   }
 }
 
 void GPS_Task() {
   GPS_Status status;
   volatile GPS_Data data;
+#ifdef LORA_TDMA
+  const TickType_t GPSFrequency = 41; // Slips against the 40 ms solutions, some poll lands right after one
+#else
   const TickType_t GPSFrequency = 40; // 25 Hz
+#endif
 
   // Reset GPS Module
   Clear_Pin(GPIOB, GPS_RST_PIN); // Turn off GPS Power
@@ -145,11 +224,18 @@ void GPS_Task() {
   TickType_t xLastWakeTime = xTaskGetTickCount();
 
   while(1) {
-    if (Get_Position(&data) == GPS_OK) {
+    uint32_t polled = Get_Timer_Count(); // Before the poll, a late reply only makes the sample look older
+    status = Get_Position(&data);
+    if (status == GPS_OK) {
       telemetry.GPS_Packet.latGPS = data.latitude;
       telemetry.GPS_Packet.longGPS = data.longitude;
       telemetry.GPS_Packet.Speed = 
         (int8_t)(data.speed / 447.04); // Convert speed from mm/s to mph
+      LoRa_Sched_Publish(LORA_GPS_ID); // Nothing goes out while the fix is lost
+      LoRa_Offload_Geofence(data.latitude, data.longitude, data.speed, xTaskGetTickCount());
+    }
+    if (status != GPS_ERROR && data.timeValid) {
+      LoRa_Sched_Set_Time(data.iTOW, polled); // TDMA superframe follows GPS time
     }
     vTaskDelayUntil(&xLastWakeTime, GPSFrequency); // 25Hz rate = 40ms period
   }
@@ -162,6 +248,7 @@ void ADC_Task() {
   while(1) {
     telemetry.Suspension_Packet.FrontPot = (ADC_Buffer[Sus_Pot_1_ADC] / ADC_RESOLUTION) * SUS_POT_TRAVEL;
     telemetry.Suspension_Packet.RearPot = (ADC_Buffer[Sus_Pot_2_ADC] / ADC_RESOLUTION) * SUS_POT_TRAVEL;
+    LoRa_Sched_Publish(LORA_SUSPENSION_ID);
     telemetry.Engine_Data_Packet.Steering = (ADC_Buffer[Steering_Angle_ADC] / ADC_RESOLUTION) * 360;
     telemetry.Engine_Data_Packet.BrakePressure = (ADC_Buffer[Brake_Position_ADC] / ADC_RESOLUTION) * 100;
     vTaskDelayUntil(&xLastWakeTime, ADCFrequency); 
@@ -173,82 +260,127 @@ void Collect_Stats() {
   const TickType_t StatsFrequency = 1000;
   TickType_t xLastWakeTime = xTaskGetTickCount();
   uint8_t StatsBuffer[64*5];
+#ifndef LORA_RECEIVER
+  CAN_Bus_Stats canStats;
+  CAN_RX_Stats canRXStats;
+#endif
 
   while(1) {
     vTaskGetRunTimeStats(&StatsBuffer);
     send_String(USART3, &StatsBuffer);
-    vTaskDelayUntil(&xLastWakeTime, StatsFrequency);
-  }
-}
-#endif
 
-/* LoRa Transmit Tasks ------------------------------------------------------*/
-void LoRa_Suspension_Task() {
-  const TickType_t LoRaFrequency = 20; // 50Hz
-  TickType_t xLastWakeTime = xTaskGetTickCount();
+#ifdef LORA_RECEIVER
+    // Link health, missed frames mean the task fell behind the radio
+    LoRa_Link_Stats linkStats;
+    LoRa_Link_Get_Stats(&linkStats);
+    LoRa_ADR_Stats loraLink;
+    LoRa_ADR_Get_Stats(&loraLink);
+    snprintf((char*)StatsBuffer, sizeof(StatsBuffer),
+      "LoRa RX %lu frames %lu crc %lu missed %lu dropped %u ring peak %lu reports step %u\r\n",
+      linkStats.frames, linkStats.crcErrors, linkStats.missed, linkStats.dropped, linkStats.ringPeak,
+      linkStats.reports, loraLink.step);
+    send_String(USART3, StatsBuffer);
+#else
+    // CAN health, lets us tell if frames are being lost on track
+    CAN_Get_Bus_Stats(&canStats);
+    CAN_Get_RX_Stats(&canRXStats);
+    snprintf((char*)StatsBuffer, sizeof(StatsBuffer),
+      "CAN load %u.%u%% %lu fps tec %u rec %u fovr %lu/%lu ring ovr %lu ewg %lu epv %lu boff %lu/%lu\r\n",
+      canStats.busLoad / 10, canStats.busLoad % 10, canStats.framesPerSecond,
+      canStats.tec, canStats.rec, canStats.fifoOverruns[0], canStats.fifoOverruns[1],
+      canRXStats.overruns, canStats.errorWarning, canStats.errorPassive, canStats.busOff,
+      canStats.busOffRecoveries);
+    send_String(USART3, StatsBuffer);
+
+#ifdef CAN_CAPTURE
+    CAN_Capture_Stats captureStats;
+    CAN_Capture_Get_Stats(&captureStats);
+    snprintf((char*)StatsBuffer, sizeof(StatsBuffer),
+      "Capture %lu frames %lu blocks %lu dropped %lu errors %lu us max write\r\n",
+      captureStats.frames, captureStats.blocks, captureStats.dropped,
+      captureStats.writeErrors, captureStats.maxWriteTime);
+    send_String(USART3, StatsBuffer);
+#endif
 
-  while(1) {
-    if (xSemaphoreTake(LoRa_Mutex, portMAX_DELAY) == pdTRUE) {
-      Lora_Transmit((uint8_t)&telemetry.Suspension_Packet, sizeof(telemetry.Suspension_Packet));
-      xSemaphoreGive(LoRa_Mutex);
+    // LoRa schedule, shows which packets lose out when the airtime runs short
+    LoRa_Sched_Stats loraStats;
+    LoRa_Sched_Frame_Stats loraFrames;
+    LoRa_Sched_Get_Frame_Stats(&loraFrames);
+    snprintf((char*)StatsBuffer, sizeof(StatsBuffer), "LoRa load %u.%u%% %lu frames %lu parity %lu packets %lu bytes\r\n",
+      loraFrames.load / 10, loraFrames.load % 10, loraFrames.frames, loraFrames.parity, loraFrames.subPackets,
+      loraFrames.bytes);
+    send_String(USART3, StatsBuffer);
+    LoRa_SPI_Stats loraSpi;
+    Lora_Get_SPI_Stats(&loraSpi);
+    snprintf((char*)StatsBuffer, sizeof(StatsBuffer), "LoRa SPI %u per packet %lu total\r\n",
+      loraSpi.lastPacket, loraSpi.total);
+    send_String(USART3, StatsBuffer);
+    LoRa_ADR_Stats loraLink;
+    LoRa_ADR_Get_Stats(&loraLink);
+    snprintf((char*)StatsBuffer, sizeof(StatsBuffer),
+      "LoRa ADR step %u snr %d dB rssi %d dBm %lu reports %lu lost %lu changes %u byte frames\r\n",
+      loraLink.step, loraLink.snr / 4, loraLink.rssi, loraLink.reports, loraLink.lost, loraLink.changes,
+      loraFrames.limit);
+    send_String(USART3, StatsBuffer);
+    LoRa_Offload_Stats loraOffload;
+    LoRa_Offload_Get_Stats(&loraOffload);
+    snprintf((char*)StatsBuffer, sizeof(StatsBuffer),
+      "LoRa offload %lu files %lu bytes %lu frames %lu resent %lu timeouts %lu failed %lu capturing %lu B/s\r\n",
+      loraOffload.files, loraOffload.bytes, loraOffload.frames, loraOffload.resent, loraOffload.timeouts,
+      loraOffload.failed, loraOffload.capturing, loraOffload.rate);
+    send_String(USART3, StatsBuffer);
+#ifdef LORA_TDMA
+    LoRa_TDMA_Stats loraTdma;
+    LoRa_Sched_Get_TDMA_Stats(&loraTdma);
+    snprintf((char*)StatsBuffer, sizeof(StatsBuffer),
+      "LoRa TDMA slot %u/%u locked %u %lu syncs %ld us step %lu us guard %lu held %lu overlong\r\n",
+      LORA_TDMA_NODE, LORA_TDMA_NODES, loraTdma.locked, loraTdma.syncs, loraTdma.correction, loraTdma.guard,
+      loraTdma.held, loraTdma.overlong);
+    send_String(USART3, StatsBuffer);
+#endif
+    for (uint8_t i = 0; LoRa_Sched_Get_Stats(i, &loraStats) == LORA_SCHED_OK; i++) {
+      snprintf((char*)StatsBuffer, sizeof(StatsBuffer),
+        "LoRa 0x%02X %u/%u Hz %lu sent %lu missed %lu errors %lu us %lu overwritten %lu dropped\r\n",
+        loraPackets[i].data[0], loraStats.rate, loraPackets[i].rate,
+        loraStats.sent, loraStats.missed, loraStats.errors, loraStats.airtime,
+        loraStats.overwritten, loraStats.dropped);
+      send_String(USART3, StatsBuffer);
     }
-    vTaskDelayUntil(&xLastWakeTime, LoRaFrequency); // 50Hz rate = 20ms period
-  }
-}
-
-void LoRa_GPS_Task() {
-  const TickType_t LoRaFrequency = 40; // 25Hz
-  TickType_t xLastWakeTime = xTaskGetTickCount();
+#endif
 
-  while(1) {
-    if (xSemaphoreTake(LoRa_Mutex, portMAX_DELAY) == pdTRUE) {
-      Lora_Transmit((uint8_t)&telemetry.GPS_Packet, sizeof(telemetry.GPS_Packet));
-      xSemaphoreGive(LoRa_Mutex);
-    }
-    vTaskDelayUntil(&xLastWakeTime, LoRaFrequency); // 25Hz rate = 40ms period
+    vTaskDelayUntil(&xLastWakeTime, StatsFrequency);
   }
 }
+#endif
 
-void LoRa_Engine_Data_Task() {
-  const TickType_t LoRaFrequency = 50; // 20Hz
-  TickType_t xLastWakeTime = xTaskGetTickCount();
-
-  while(1) {
-    if (xSemaphoreTake(LoRa_Mutex, portMAX_DELAY) == pdTRUE) {
-      Lora_Transmit((uint8_t)&telemetry.Engine_Data_Packet, sizeof(telemetry.Engine_Data_Packet));
-      xSemaphoreGive(LoRa_Mutex);
-    }
-    vTaskDelayUntil(&xLastWakeTime, LoRaFrequency); // 20Hz rate = 50ms period
-  }
+/* LoRa Transmit Task ------------------------------------------------------*/
+#ifdef LORA_SWEEP
+/**
+ * @brief Write a sweep CSV line to the debug UART
+ */
+static void Sweep_Line(const char* line, void* ctx) {
+  (void)ctx;
+  send_String(USART3, (uint8_t*)line);
 }
+#endif
 
-void LoRa_Brakes_Accel_Task() {
-  const TickType_t LoRaFrequency = 100; // 10Hz
-  TickType_t xLastWakeTime = xTaskGetTickCount();
-
+void Lora_Task() {
+#ifdef LORA_RECEIVER
+  LoRa_Link_Init();
   while(1) {
-    if (xSemaphoreTake(LoRa_Mutex, portMAX_DELAY) == pdTRUE) {
-      Lora_Transmit((uint8_t)&telemetry.Brakes_Accel_Packet, sizeof(telemetry.Brakes_Accel_Packet));
-      xSemaphoreGive(LoRa_Mutex);
-    }
-    vTaskDelayUntil(&xLastWakeTime, LoRaFrequency); // 10Hz rate = 100ms period
+    LoRa_Link_Run(); // Sleeps until the next frame arrives
   }
-}
-
-void LoRa_Temperature_Task() {
-  const TickType_t LoRaFrequency = 1000; // 1Hz
-  TickType_t xLastWakeTime = xTaskGetTickCount();
-
+#elif defined(LORA_SWEEP)
+  // Characterise the radio settings once instead of sending telemetry
+  LoRa_Sweep_Run(Sweep_Line, NULL);
+  vTaskSuspend(NULL);
+#else
   while(1) {
-    if (xSemaphoreTake(LoRa_Mutex, portMAX_DELAY) == pdTRUE) {
-      Lora_Transmit((uint8_t)&telemetry.Temperature_Packet, sizeof(telemetry.Temperature_Packet));
-      xSemaphoreGive(LoRa_Mutex);
-    }
-    vTaskDelayUntil(&xLastWakeTime, LoRaFrequency); // 1Hz rate = 1000ms period
+    LoRa_Sched_Run(); // Sleeps until the next packet is due
   }
+#endif
 }
 
-
 /* Error Handlers -----------------------------------------------------------*/
 void Error_Handler() {
   Set_Pin(GPIOC, STATUS_LED_PIN);
@@ -257,8 +389,8 @@ void Error_Handler() {
 
 /* Interrupt Handlers -------------------------------------------------------*/
 void EXTI9_5_IRQHandler() {
-  if (EXTI->PR & (0x1 << 9)) {
-    EXTI->PR |= (0x1 << 9); // Clear the status bit
-    // Set Flag for Lora Recv
+  if (EXTI->PR & (0x1 << LORA_INT)) {
+    EXTI->PR = (0x1 << LORA_INT); // Clear the status bit, write 1 to clear
+    Lora_DIO0_IRQHandler(); // TxDone or RxDone from the radio
   }
 }
\ No newline at end of file
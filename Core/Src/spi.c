@@ -7,6 +7,53 @@
 ***********************************************/
 
 #include "spi.h"
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "task.h"
+
+static SemaphoreHandle_t spiDone; // Given by the DMA interrupt for SPI2_Transfer
+static volatile SPI_Status spiResult;
+static volatile uint8_t spiBusy;
+static uint8_t spiFlags;
+static SPI_Callback spiCallback;
+static void* spiContext;
+static uint8_t spiDummyTx; // Zeros clocked out when there is nothing to send
+static uint8_t spiDummyRx; // Sink for bytes nobody wants
+
+/* Static Functions ---------------------------------------------------------*/
+
+/**
+ * @brief Full duplex transfer by polling TXE and RXNE
+ * @note Reads every byte back so RXNE never overruns
+ * 
+ * @param tx [const uint8_t*] Bytes to send, NULL for zeros
+ * @param rx [uint8_t*] Received bytes, NULL to discard
+ * @param len [size_t] Bytes to transfer
+ */
+static void SPI2_Transfer_Polled(const uint8_t* tx, uint8_t* rx, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    while (!(SPI2->SR & SPI_SR_TXE));
+    SPI2->DR = (tx != NULL) ? tx[i] : 0x00;
+    while (!(SPI2->SR & SPI_SR_RXNE));
+    uint8_t data = SPI2->DR;
+    if (rx != NULL) {
+      rx[i] = data;
+    }
+  }
+  while (SPI2->SR & SPI_SR_BSY);
+}
+
+/**
+ * @brief Wake the task blocked in SPI2_Transfer
+ */
+static void SPI2_Transfer_Done(SPI_Status status, void* context) {
+  BaseType_t xHPW = pdFALSE;
+  spiResult = status;
+  xSemaphoreGiveFromISR(spiDone, &xHPW);
+  portYIELD_FROM_ISR(xHPW);
+}
+
+/* Function Implementation --------------------------------------------------*/
 
 void SPI2_Init() {
   // Enable Clocks
@@ -37,61 +84,117 @@ void SPI2_Init() {
 
   // Set NSS High
   GPIOB->BSRR = GPIO_BSRR_BS12;
+
+  // DMA1 Stream 3 = SPI2_RX, Stream 4 = SPI2_TX, both channel 0, byte wide
+  RCC->AHB1ENR |= RCC_AHB1ENR_DMA1EN;
+  DMA1_Stream3->CR &= ~DMA_SxCR_EN;
+  DMA1_Stream4->CR &= ~DMA_SxCR_EN;
+  while ((DMA1_Stream3->CR & DMA_SxCR_EN) || (DMA1_Stream4->CR & DMA_SxCR_EN));
+  DMA1_Stream3->PAR = (uint32_t) &(SPI2->DR);
+  DMA1_Stream4->PAR = (uint32_t) &(SPI2->DR);
+  DMA1_Stream3->CR = (0x00 << DMA_SxCR_CHSEL_Pos) // Channel 0
+                   | (0x2 << DMA_SxCR_PL_Pos) // High Priority
+                   | (0x00 << DMA_SxCR_DIR_Pos) // Peripheral to Memory
+                   | DMA_SxCR_TCIE | DMA_SxCR_TEIE; // RX finishes last, so it signals completion
+  DMA1_Stream4->CR = (0x00 << DMA_SxCR_CHSEL_Pos) // Channel 0
+                   | (0x2 << DMA_SxCR_PL_Pos) // High Priority
+                   | (0x01 << DMA_SxCR_DIR_Pos); // Memory to Peripheral
+  NVIC_SetPriority(DMA1_Stream3_IRQn, SPI_DMA_IRQ_PRIORITY);
+  NVIC_EnableIRQ(DMA1_Stream3_IRQn);
+
+  spiDone = xSemaphoreCreateBinary();
+
+  // Left enabled, toggling SPE per call only adds bus turnaround
+  SPI2->CR1 |= SPI_CR1_SPE;
 }
 
-SPI_Status SPI_Transmit(SPI_TypeDef* SPI, uint8_t* data, size_t len) {
-  SPI->CR1 |= SPI_CR1_SPE; // Enable SPI
-  if (SPI->CR1 & SPI_CR1_DFF) { // 16-bit Data Frame
-    while (len > 0) {
-      while (!(SPI->SR & SPI_SR_TXE)); 
-      SPI->DR = *((uint16_t*)data);
-      // increment data pointer by 2 bytes
-      data += sizeof(uint16_t);
-      len--;
-    }
+SPI_Status SPI2_Transfer_Start(const uint8_t* tx, uint8_t* rx, size_t len, uint8_t flags,
+    SPI_Callback callback, void* context) {
+  if (len == 0 || len > 0xFFFF) {
+    return SPI_ERROR;
   }
-  else { // 8-bit Data Frame
-    while (len > 0) {
-      while (!(SPI->SR & SPI_SR_TXE));
-      SPI->DR = *data;
-      data++;
-      len--;
-    }
+  if (spiBusy) {
+    return SPI_BUSY;
   }
-  // Wait for last byte to be sent
-  while (SPI->SR & SPI_SR_BSY);
+  spiBusy = 1;
+  spiFlags = flags;
+  spiCallback = callback;
+  spiContext = context;
+
+  // Memory side only walks real buffers, dummies are a single byte
+  DMA1_Stream3->M0AR = (uint32_t) ((rx != NULL) ? rx : &spiDummyRx);
+  DMA1_Stream4->M0AR = (uint32_t) ((tx != NULL) ? tx : &spiDummyTx);
+  DMA1_Stream3->NDTR = len;
+  DMA1_Stream4->NDTR = len;
+  DMA1_Stream3->CR = (DMA1_Stream3->CR & ~DMA_SxCR_MINC) | ((rx != NULL) ? DMA_SxCR_MINC : 0);
+  DMA1_Stream4->CR = (DMA1_Stream4->CR & ~DMA_SxCR_MINC) | ((tx != NULL) ? DMA_SxCR_MINC : 0);
+  DMA1->LIFCR = DMA_LIFCR_CTCIF3 | DMA_LIFCR_CHTIF3 | DMA_LIFCR_CTEIF3 | DMA_LIFCR_CDMEIF3 | DMA_LIFCR_CFEIF3;
+  DMA1->HIFCR = DMA_HIFCR_CTCIF4 | DMA_HIFCR_CHTIF4 | DMA_HIFCR_CTEIF4 | DMA_HIFCR_CDMEIF4 | DMA_HIFCR_CFEIF4;
 
-  SPI->CR1 &= ~SPI_CR1_SPE; // Disable SPI
+  // Drop anything left in DR so the first received byte lines up
+  (void)SPI2->DR;
+
+  GPIOB->BSRR = GPIO_BSRR_BR12; // CS Low
+  DMA1_Stream3->CR |= DMA_SxCR_EN;
+  DMA1_Stream4->CR |= DMA_SxCR_EN;
+  SPI2->CR2 |= SPI_CR2_RXDMAEN | SPI_CR2_TXDMAEN; // TX request starts the clock
 
   return SPI_OK;
 }
 
-SPI_Status SPI_Receive(SPI_TypeDef* SPI, uint8_t* buf, size_t len) {
-  SPI->CR1 |= SPI_CR1_SPE; // Enable SPI
-  if (SPI->CR1 & SPI_CR1_DFF) { // 16-bit Data Frame
-    while (len > 0) {
-      while(!(SPI->SR & SPI_SR_TXE));
-      SPI->DR = 0x0000; // Dummy Data
-      while (!(SPI->SR & SPI_SR_RXNE));
-      *((uint16_t*)buf) = SPI->DR; // Cast to 16-bit
-      // increment data pointer by 2 bytes and len by 2
-      buf += sizeof(uint16_t);
-      len --;
-    }
+SPI_Status SPI2_Transfer(const uint8_t* tx, uint8_t* rx, size_t len, uint8_t flags) {
+  if (len == 0) {
+    return SPI_OK;
   }
-  else { // 8-bit Data Frame
-    for (size_t i = 0; i < len; i++) {
-      while(!(SPI->SR & SPI_SR_TXE));
-      SPI->DR = 0x00; // Dummy Data to generate clk
-      while (!(SPI->SR & SPI_SR_RXNE));
-      buf[i] = SPI->DR;
+
+  // Short transfers and startup code poll, nothing to sleep through
+  if (len < SPI_DMA_MIN_LEN || xTaskGetSchedulerState() != taskSCHEDULER_RUNNING) {
+    if (spiBusy) {
+      return SPI_BUSY;
+    }
+    GPIOB->BSRR = GPIO_BSRR_BR12; // CS Low
+    SPI2_Transfer_Polled(tx, rx, len);
+    if (!(flags & SPI_CS_HOLD)) {
+      GPIOB->BSRR = GPIO_BSRR_BS12; // CS High
     }
+    return SPI_OK;
   }
-  // Wait for last byte to be received
-  while (SPI->SR & SPI_SR_BSY);
 
-  SPI->CR1 &= ~SPI_CR1_SPE; // Disable SPI
-
-  return SPI_OK;
+  xSemaphoreTake(spiDone, 0); // Clear a give left by an aborted transfer
+  SPI_Status status = SPI2_Transfer_Start(tx, rx, len, flags, SPI2_Transfer_Done, NULL);
+  if (status != SPI_OK) {
+    return status;
+  }
+  if (xSemaphoreTake(spiDone, SPI_DMA_TIMEOUT) != pdTRUE) {
+    // Abort, the stream never finished
+    SPI2->CR2 &= ~(SPI_CR2_RXDMAEN | SPI_CR2_TXDMAEN);
+    DMA1_Stream3->CR &= ~DMA_SxCR_EN;
+    DMA1_Stream4->CR &= ~DMA_SxCR_EN;
+    GPIOB->BSRR = GPIO_BSRR_BS12; // CS High
+    spiBusy = 0;
+    return SPI_ERROR;
+  }
+  return spiResult;
 }
 
+void DMA1_Stream3_IRQHandler() {
+  if (!(DMA1->LISR & (DMA_LISR_TCIF3 | DMA_LISR_TEIF3))) {
+    return;
+  }
+  SPI_Status status = (DMA1->LISR & DMA_LISR_TEIF3) ? SPI_ERROR : SPI_OK;
+  DMA1->LIFCR = DMA_LIFCR_CTCIF3 | DMA_LIFCR_CHTIF3 | DMA_LIFCR_CTEIF3 | DMA_LIFCR_CDMEIF3 | DMA_LIFCR_CFEIF3;
+
+  // Last byte is in, the TX stream finished before it
+  SPI2->CR2 &= ~(SPI_CR2_RXDMAEN | SPI_CR2_TXDMAEN);
+  DMA1_Stream3->CR &= ~DMA_SxCR_EN;
+  DMA1_Stream4->CR &= ~DMA_SxCR_EN;
+  while (SPI2->SR & SPI_SR_BSY);
+  if (!(spiFlags & SPI_CS_HOLD)) {
+    GPIOB->BSRR = GPIO_BSRR_BS12; // CS High
+  }
+  spiBusy = 0;
+
+  if (spiCallback != NULL) {
+    spiCallback(status, spiContext);
+  }
+}
@@ -32,14 +32,19 @@ void TIM2_Init() {
 }
 
 void Timer_Stat_Init() {
+  // Already running as the microsecond timebase, keep counting
+  if ((RCC->APB1ENR & RCC_APB1ENR_TIM2EN) && (TIM2->CR1 & TIM_CR1_CEN)) return;
+
   RCC->APB1ENR |= RCC_APB1ENR_TIM2EN; // Enable TIM2 Clock
   
   TIM2->CR1 &= ~TIM_CR1_CEN; // Disable Timer
   // Count up and no clock division
   TIM2->CR1 &= ~TIM_CR1_DIR & ~TIM_CR1_CKD;
 
-  TIM2->PSC = ((SystemCoreClock / 1000000) - 1); // Set Prescaler to 83 (1MHz)
+  // TIM2 is clocked at 2 * APB1 = SystemCoreClock / 2
+  TIM2->PSC = ((SystemCoreClock / 2 / 1000000) - 1); // Set Prescaler to 83 (1MHz)
   TIM2->ARR = 0xFFFFFFFF; // Set Auto Reload Register to max
+  TIM2->EGR = TIM_EGR_UG; // Load the prescaler now rather than at the first overflow
 
   TIM2->CR1 |= TIM_CR1_CEN; // Enable Timer
 }
@@ -7,6 +7,12 @@
 ***********************************************/
 
 #include "stm32f415xx.h"
+#include "uart.h"
+#include <stddef.h>
+
+static volatile uint8_t usart2Busy; // DMA transmit running
+static USART_Callback usart2Callback;
+static void* usart2Context;
 
 /**
  * @brief Initialize USART2
@@ -95,4 +101,58 @@ void send_String(USART_TypeDef* USART, uint8_t *string) {
     send_Byte(USART, string[i]);
     i++;
   }
-}
\ No newline at end of file
+}
+
+void USART2_DMA_Init() {
+  RCC->AHB1ENR |= RCC_AHB1ENR_DMA1EN; // Enable DMA1 Clock
+
+  USART2->CR1 &= ~USART_CR1_UE; // Disable USART
+
+  // baud rate = fCK / (8 * (2 - OVER8) * USARTDIV)
+  // 460800 @ 42MHz = 5.6875
+  USART2->BRR = (0xB << USART_BRR_DIV_Fraction_Pos) | (0x5 << USART_BRR_DIV_Mantissa_Pos);
+  USART2->CR3 |= USART_CR3_DMAT; // Transmit requests go to the DMA
+
+  USART2->CR1 |= USART_CR1_UE; // Enable USART
+
+  // DMA1 Stream 6 = USART2_TX, channel 4, byte wide
+  DMA1_Stream6->CR &= ~DMA_SxCR_EN;
+  while (DMA1_Stream6->CR & DMA_SxCR_EN);
+  DMA1_Stream6->PAR = (uint32_t) &(USART2->DR);
+  DMA1_Stream6->CR = (0x04 << DMA_SxCR_CHSEL_Pos) // Channel 4
+                   | (0x1 << DMA_SxCR_PL_Pos) // Medium Priority, below the radio SPI
+                   | (0x01 << DMA_SxCR_DIR_Pos) // Memory to Peripheral
+                   | DMA_SxCR_MINC | DMA_SxCR_TCIE | DMA_SxCR_TEIE;
+  NVIC_SetPriority(DMA1_Stream6_IRQn, USART_DMA_IRQ_PRIORITY);
+  NVIC_EnableIRQ(DMA1_Stream6_IRQn);
+}
+
+uint8_t USART2_DMA_Send(const uint8_t* data, uint16_t len, USART_Callback callback, void* context) {
+  if (usart2Busy || len == 0) {
+    return 0;
+  }
+  usart2Busy = 1;
+  usart2Callback = callback;
+  usart2Context = context;
+
+  DMA1->HIFCR = DMA_HIFCR_CTCIF6 | DMA_HIFCR_CHTIF6 | DMA_HIFCR_CTEIF6 | DMA_HIFCR_CDMEIF6 | DMA_HIFCR_CFEIF6;
+  DMA1_Stream6->M0AR = (uint32_t) data;
+  DMA1_Stream6->NDTR = len;
+  USART2->SR &= ~USART_SR_TC; // Reference manual 30.3.13, clear TC before the stream starts
+  DMA1_Stream6->CR |= DMA_SxCR_EN;
+  return 1;
+}
+
+void DMA1_Stream6_IRQHandler() {
+  if (!(DMA1->HISR & (DMA_HISR_TCIF6 | DMA_HISR_TEIF6))) {
+    return;
+  }
+  DMA1->HIFCR = DMA_HIFCR_CTCIF6 | DMA_HIFCR_CHTIF6 | DMA_HIFCR_CTEIF6 | DMA_HIFCR_CDMEIF6 | DMA_HIFCR_CFEIF6;
+  DMA1_Stream6->CR &= ~DMA_SxCR_EN;
+  usart2Busy = 0;
+
+  // The last bytes are still shifting out, the next transmit queues behind them
+  if (usart2Callback != NULL) {
+    usart2Callback(usart2Context);
+  }
+}
@@ -0,0 +1,301 @@
+/************************************************
+* @file    can_filter_test.c 
+* @author  APBashara
+* @date    10/2026
+* 
+* @brief   Host Test of the CAN Filter Bank Allocator
+* @note    Runs Core/Src/can_filter.c on fixed ID sets and compares the
+*          FR1/FR2/FM1R/FS1R/FFA1R/FA1R images with ones worked out by
+*          hand from RM0090 32.7.4. Every image, fixed or from a random ID
+*          set, is also run through a model of the bxCAN filter match for
+*          all 2048 standard IDs, data and remote, so an accepted ID that
+*          was not asked for or a subscribed ID that is lost shows up.
+* 
+*          Build from the repository root:
+* 
+*          gcc -O2 -DCAN_HOST -DUSE_HAL_DRIVER -DSTM32F415xx -ICore/Inc \
+*              -IDrivers/STM32F4xx_HAL_Driver/Inc -IDrivers/CMSIS/Include \
+*              -IDrivers/CMSIS/Device/ST/STM32F4xx/Include \
+*              -IMiddlewares/Third_Party/FreeRTOS/Source/include \
+*              -IMiddlewares/Third_Party/FreeRTOS/Source/CMSIS_RTOS_V2 \
+*              -IMiddlewares/Third_Party/FreeRTOS/Source/portable/GCC/ARM_CM4F \
+*              Tools/can_filter_test.c Core/Src/can_filter.c -o can_filter_test
+* 
+*          Usage: can_filter_test
+*          Exits 1 on any check that fails.
+***********************************************/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "can.h"
+
+#define TEST_MAX_BANKS              (4) // Banks a fixed case compares
+#define TEST_RANDOM_SETS            (2000)
+
+typedef struct {
+    const char* name;
+    uint8_t count;
+    CAN_Filter_ID ids[8];
+    uint8_t banks;
+    uint32_t fm1r;
+    uint32_t fs1r;
+    uint32_t ffa1r;
+    uint32_t fa1r;
+    uint32_t fr1[TEST_MAX_BANKS];
+    uint32_t fr2[TEST_MAX_BANKS];
+    uint32_t fifoRate[2];
+} Test_Case;
+
+// 16-bit filter fields: STDID in 15:5, RTR bit 4, IDE bit 3
+static const Test_Case cases[] = {
+    {
+        // Nothing consecutive, list entries only, equal rates alternate the FIFOs
+        "sparse list", 5,
+        { { 0x300, 10 }, { 0x050, 10 }, { 0x7FF, 10 }, { 0x100, 10 }, { 0x200, 10 } },
+        2, 0x3, 0, 0x2, 0x3,
+        { 0x40000A00, 0x60002000 },
+        { 0x0A00FFE0, 0x20002000 },
+        { 30, 20 },
+    },
+    {
+        // 0x400-0x40F is one mask entry, 0x123 is not aligned and stays a list entry
+        "dense range", 0, { { 0 } },
+        2, 0x1, 0, 0x2, 0x3,
+        { 0x24602460, 0xFE188000 },
+        { 0x24602460, 0xFE188000 },
+        { 100, 16 },
+    },
+    {
+        // The duplicate merges, its rates add and the range still closes
+        "duplicates", 5,
+        { { 0x012, 1 }, { 0x010, 5 }, { 0x013, 1 }, { 0x010, 7 }, { 0x011, 1 } },
+        1, 0x0, 0, 0x0, 0x1,
+        { 0xFF980200 },
+        { 0xFF980200 },
+        { 15, 0 },
+    },
+    {
+        // Bits above the 11-bit ID are dropped before the range check
+        "wide id", 4,
+        { { 0x010, 1 }, { 0x011, 1 }, { 0x012, 1 }, { 0x813, 1 } },
+        1, 0x0, 0, 0x0, 0x1,
+        { 0xFF980200 },
+        { 0xFF980200 },
+        { 4, 0 },
+    },
+    {
+        // Busiest first onto the quieter FIFO: 500 0, 300 1, 250 1, 100 0, 50 1
+        "rate balance", 5,
+        { { 0x140, 50 }, { 0x100, 500 }, { 0x130, 100 }, { 0x110, 300 }, { 0x120, 250 } },
+        2, 0x3, 0, 0x2, 0x3,
+        { 0x26002000, 0x24002200 },
+        { 0x20002000, 0x22002800 },
+        { 600, 600 },
+    },
+};
+
+static uint32_t failures;
+
+/* Static Functions ---------------------------------------------------------*/
+
+static void Fail(const char* name, const char* what, uint32_t got, uint32_t expected) {
+    failures++;
+    printf("fail: %s %s 0x%08X, expected 0x%08X\n", name, what, got, expected);
+}
+
+/**
+ * @brief Filter match of one standard frame, RM0090 32.7.4
+ * @note 16-bit scale only, the allocator never uses 32-bit banks
+ * 
+ * @param config [const CAN_Filter_Config*] Register images
+ * @param id [uint16_t] 11-bit ID
+ * @param remote [bool] Remote frame
+ * @return [int] FIFO the frame is stored in, -1 if it is dropped
+ */
+static int Match(const CAN_Filter_Config* config, uint16_t id, bool remote) {
+    uint16_t field = (id << CAN_F0R1_FB5_Pos) | (remote ? CAN_F0R1_FB4 : 0);
+
+    for (uint8_t bank = 0; bank < CAN_FILTER_BANKS; bank++) {
+        if (!(config->fa1r & (1UL << bank)) || (config->fs1r & (1UL << bank))) {
+            continue;
+        }
+        uint16_t half[4] = {
+            config->fr1[bank] & 0xFFFF, config->fr1[bank] >> 16,
+            config->fr2[bank] & 0xFFFF, config->fr2[bank] >> 16,
+        };
+        int fifo = (config->ffa1r >> bank) & 1;
+        if (config->fm1r & (1UL << bank)) {
+            for (uint8_t i = 0; i < 4; i++) {
+                if (half[i] == field) {
+                    return fifo;
+                }
+            }
+        }
+        else {
+            for (uint8_t i = 0; i < 4; i += 2) {
+                if (((field ^ half[i]) & half[i + 1]) == 0) {
+                    return fifo;
+                }
+            }
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Check the images accept exactly the subscribed data frames
+ * 
+ * @param name [const char*] Case name
+ * @param ids [const CAN_Filter_ID*] IDs as given to the allocator
+ * @param count [uint8_t] Number of IDs
+ * @param config [const CAN_Filter_Config*] Images from the allocator
+ */
+static void Check_Match(const char* name, const CAN_Filter_ID* ids, uint8_t count, const CAN_Filter_Config* config) {
+    bool wanted[2048] = { false };
+    uint32_t rate[2] = { 0 };
+    uint32_t total = 0;
+
+    for (uint8_t i = 0; i < count; i++) {
+        wanted[ids[i].id & 0x7FF] = true;
+        total += ids[i].rate;
+    }
+    for (uint16_t id = 0; id < 2048; id++) {
+        int fifo = Match(config, id, false);
+        if ((fifo >= 0) != wanted[id]) {
+            Fail(name, wanted[id] ? "lost id" : "extra id", id, id);
+        }
+        if (Match(config, id, true) >= 0) {
+            Fail(name, "remote frame accepted", id, id);
+        }
+        for (uint8_t i = 0; i < count && fifo >= 0; i++) {
+            if ((ids[i].id & 0x7FF) == id) {
+                rate[fifo] += ids[i].rate;
+            }
+        }
+    }
+    if (rate[0] != config->fifoRate[0] || rate[1] != config->fifoRate[1] || rate[0] + rate[1] != total) {
+        Fail(name, "fifo rate", rate[0] << 16 | rate[1], config->fifoRate[0] << 16 | config->fifoRate[1]);
+    }
+}
+
+/**
+ * @brief Allocate a fixed case and compare every image
+ */
+static void Run_Case(const Test_Case* test) {
+    CAN_Filter_ID ids[CAN_FILTER_MAX_IDS];
+    CAN_Filter_ID given[CAN_FILTER_MAX_IDS];
+    CAN_Filter_Config config;
+    uint8_t count = test->count;
+
+    memcpy(ids, test->ids, count * sizeof(CAN_Filter_ID));
+    if (count == 0) {
+        // Dense range: 0x400-0x40F at 1 frame/s each and 0x123 at 100
+        ids[count++] = (CAN_Filter_ID){ 0x123, 100 };
+        for (uint16_t id = 0x40F; id >= 0x400; id--) {
+            ids[count++] = (CAN_Filter_ID){ id, 1 };
+        }
+    }
+    memcpy(given, ids, count * sizeof(CAN_Filter_ID));
+
+    if (CAN_Filter_Alloc(ids, count, &config) != CAN_OK) {
+        Fail(test->name, "status", 1, 0);
+        return;
+    }
+    if (config.banks != test->banks) {
+        Fail(test->name, "banks", config.banks, test->banks);
+    }
+    if (config.fm1r != test->fm1r) {
+        Fail(test->name, "FM1R", config.fm1r, test->fm1r);
+    }
+    if (config.fs1r != test->fs1r) {
+        Fail(test->name, "FS1R", config.fs1r, test->fs1r);
+    }
+    if (config.ffa1r != test->ffa1r) {
+        Fail(test->name, "FFA1R", config.ffa1r, test->ffa1r);
+    }
+    if (config.fa1r != test->fa1r) {
+        Fail(test->name, "FA1R", config.fa1r, test->fa1r);
+    }
+    for (uint8_t bank = 0; bank < test->banks; bank++) {
+        if (config.fr1[bank] != test->fr1[bank]) {
+            Fail(test->name, "FR1", config.fr1[bank], test->fr1[bank]);
+        }
+        if (config.fr2[bank] != test->fr2[bank]) {
+            Fail(test->name, "FR2", config.fr2[bank], test->fr2[bank]);
+        }
+    }
+    if (config.fifoRate[0] != test->fifoRate[0] || config.fifoRate[1] != test->fifoRate[1]) {
+        Fail(test->name, "fifo rate", config.fifoRate[0] << 16 | config.fifoRate[1],
+            test->fifoRate[0] << 16 | test->fifoRate[1]);
+    }
+    Check_Match(test->name, given, count, &config);
+    printf("%-14s %3u ids %2u banks\n", test->name, count, config.banks);
+}
+
+/**
+ * @brief Allocate random ID sets, clustered so ranges and duplicates occur
+ */
+static void Run_Random() {
+    CAN_Filter_ID ids[CAN_FILTER_MAX_IDS];
+    CAN_Filter_ID given[CAN_FILTER_MAX_IDS];
+    CAN_Filter_Config config;
+    uint32_t fitted = 0;
+
+    srand(1);
+    for (uint32_t set = 0; set < TEST_RANDOM_SETS; set++) {
+        uint8_t count = 1 + rand() % CAN_FILTER_MAX_IDS;
+        uint16_t base = rand() % 2048;
+        for (uint8_t i = 0; i < count; i++) {
+            uint16_t id = (rand() % 4) ? base + rand() % 96 : rand() % 2048;
+            ids[i] = (CAN_Filter_ID){ id & 0x7FF, rand() % 200 };
+        }
+        memcpy(given, ids, count * sizeof(CAN_Filter_ID));
+        if (CAN_Filter_Alloc(ids, count, &config) != CAN_OK) {
+            continue; // Too many list entries for 28 banks
+        }
+        fitted++;
+        Check_Match("random", given, count, &config);
+    }
+    printf("%-14s %u of %u sets fit\n", "random", fitted, TEST_RANDOM_SETS);
+}
+
+/* Function Implementation --------------------------------------------------*/
+
+int main() {
+    CAN_Filter_ID ids[CAN_FILTER_MAX_IDS + 1];
+    CAN_Filter_Config config;
+
+    for (uint8_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        Run_Case(&cases[i]);
+    }
+
+    // 112 IDs two apart fill every bank with list entries, one more does not fit
+    for (uint8_t i = 0; i <= CAN_FILTER_MAX_IDS; i++) {
+        ids[i] = (CAN_Filter_ID){ i * 2, 1 };
+    }
+    if (CAN_Filter_Alloc(ids, CAN_FILTER_MAX_IDS, &config) != CAN_OK || config.banks != CAN_FILTER_BANKS) {
+        Fail("full banks", "banks", config.banks, CAN_FILTER_BANKS);
+    }
+    if (CAN_Filter_Alloc(ids, CAN_FILTER_MAX_IDS + 1, &config) != CAN_Error) {
+        Fail("too many ids", "status", 0, 1);
+    }
+
+    if (CAN_Filter_Accept_All(&config) != CAN_OK || config.fr1[0] != 0x00280000 || config.fr1[1] != 0x00280020 ||
+        config.ffa1r != 0x2 || config.fa1r != 0x3 || config.fm1r != 0) {
+        Fail("accept all", "images", config.fr1[0], 0x00280000);
+    }
+    for (uint16_t id = 0; id < 2048; id++) {
+        if (Match(&config, id, false) != (id & 1)) {
+            Fail("accept all", "fifo", id, id & 1);
+        }
+    }
+
+    Run_Random();
+    if (failures) {
+        fprintf(stderr, "%u checks failed\n", failures);
+    }
+    return failures ? 1 : 0;
+}
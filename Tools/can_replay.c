@@ -0,0 +1,564 @@
+/************************************************
+* @file    can_replay.c 
+* @author  APBashara
+* @date    10/2026
+* 
+* @brief   Host Replay of CAN Logs Through the Firmware Decode Path
+* @note    Frames go through the same RX ring and CAN_Decode_Frame calls as
+*          CAN_Task, with the ISR side driven from the log instead of CAN1.
+*          Every decoded signal is checked against a bit by bit reference
+*          extraction of the same can_db.c entry, which catches decoder
+*          regressions but not a wrong can_db.c entry. Signals past a
+*          frame's DLC must leave their field untouched.
+* 
+*          With -e the fields are also checked against values decoded
+*          from the DBC by Tools/dbc2c.py --expect, independent of
+*          can_db.c, so a wrong start bit, scale, destination or a
+*          missing message shows up as a mismatch too:
+* 
+*          Tools/dbc2c.py ecu.dbc signals.map --expect log.log > expected.txt
+* 
+*          Build from the repository root:
+* 
+*          gcc -O2 -DCAN_HOST -DUSE_HAL_DRIVER -DSTM32F415xx -ICore/Inc \
+*              -IDrivers/STM32F4xx_HAL_Driver/Inc -IDrivers/CMSIS/Include \
+*              -IDrivers/CMSIS/Device/ST/STM32F4xx/Include \
+*              -IMiddlewares/Third_Party/FreeRTOS/Source/include \
+*              -IMiddlewares/Third_Party/FreeRTOS/Source/CMSIS_RTOS_V2 \
+*              -IMiddlewares/Third_Party/FreeRTOS/Source/portable/GCC/ARM_CM4F \
+*              Tools/can_replay.c Core/Src/can_rx.c Core/Src/can_decode.c \
+*              Core/Src/can_db.c Core/Src/lora_schema.c -o can_replay
+* 
+*          Usage: can_replay [-n repeats] [-e expected.txt] log.{log,asc}
+*          Reads candump (-L) and Vector ASC logs, exits 1 on any mismatch.
+***********************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// main.h declares the firmware entry point, keep it out of the way
+#define main firmware_main
+#include "main.h"
+#undef main
+
+#define REPLAY_MAX_FRAMES           (1 << 20)
+#define REPLAY_FIFO_DEPTH           (3) // Frames a hardware FIFO holds per interrupt
+#define REPLAY_MAX_REPORTS          (10) // Mismatches printed in full
+
+Telemetry telemetry;
+
+typedef enum {
+    REPLAY_EXPECT_VALUE, // Field holds value
+    REPLAY_EXPECT_SKIP, // Signal past the DLC, field unchanged
+    REPLAY_EXPECT_TIME, // Field holds the frame timestamp
+} Replay_Expect_Kind;
+
+typedef struct {
+    uint32_t frame; // Log frame index
+    uint16_t id;
+    uint8_t kind; // Replay_Expect_Kind
+    const LoRa_Field* field; // Destination field in its telemetry packet
+    uint8_t* base; // Telemetry packet holding the field
+    int64_t value;
+} Replay_Expect;
+
+// Telemetry packet of each schema packet type, Telemetry names them <name>_Packet
+#define REPLAY_PACKET(id, name, fields) { #name "_Packet", (uint8_t*)&telemetry.name##_Packet },
+static const struct {
+    const char* member;
+    uint8_t* base;
+} replayPackets[] = { LORA_SCHEMA(REPLAY_PACKET) };
+
+typedef struct {
+    uint32_t frames;
+    uint64_t totalNs; // Ring push to decode complete
+    uint64_t maxNs;
+} Replay_ID_Stats;
+
+static CAN_Frame logFrames[REPLAY_MAX_FRAMES];
+static uint32_t logCount;
+static Replay_ID_Stats idStats[2048];
+static uint32_t mismatches;
+static Replay_Expect* expects;
+static uint32_t expectCount;
+static uint32_t expectNext; // Next entry to check in the checked pass
+static Telemetry before; // Telemetry before the frame being checked was decoded
+
+/* Static Functions ---------------------------------------------------------*/
+
+/**
+ * @brief Monotonic host time
+ * 
+ * @return [uint64_t] Nanoseconds
+ */
+static uint64_t Now_Ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * @brief Parse one candump or ASC line
+ * 
+ * @param line [const char*] Text line from the log
+ * @param seconds [double*] Log time of the frame
+ * @param frame [CAN_Frame*] Frame to fill, timestamp is set by the caller
+ * @return [int] 1 for a standard frame, 0 for anything else
+ */
+static int Parse_Line(const char* line, double* seconds, CAN_Frame* frame) {
+    char iface[32];
+    char body[64];
+    unsigned id;
+    int used;
+
+    memset(frame, 0, sizeof(CAN_Frame));
+
+    // candump -L: (1700000000.123456) can0 123#0102 or 123#R
+    char idText[16];
+    if (sscanf(line, " (%lf) %31s %15[0-9A-Fa-f]#%63s", seconds, iface, idText, body) == 4) {
+        if (strlen(idText) != 3 || body[0] == '#') {
+            return 0; // Extended IDs have 8 digits, CAN FD uses ##
+        }
+        frame->id = strtoul(idText, NULL, 16) & 0x7FF;
+        if (body[0] == 'R') {
+            frame->rtr = CAN_RTR_Remote;
+            frame->dlc = (body[1] >= '0' && body[1] <= '8') ? body[1] - '0' : 0;
+            return 1;
+        }
+        size_t len = strlen(body) / 2;
+        frame->dlc = (len > 8) ? 8 : len;
+        for (uint8_t i = 0; i < frame->dlc; i++) {
+            unsigned byte;
+            sscanf(&body[i * 2], "%2x", &byte);
+            frame->data[i] = byte;
+        }
+        return 1;
+    }
+
+    // Vector ASC: 0.012345 1  123  Rx   d 8 01 02 03 04 05 06 07 08
+    char dir[8];
+    char kind;
+    unsigned dlc;
+    if (sscanf(line, " %lf %*d %15s %7s %c %u%n", seconds, idText, dir, &kind, &dlc, &used) == 5) {
+        char* end;
+        id = strtoul(idText, &end, 16);
+        if (*end != '\0' || id > 0x7FF || (kind != 'd' && kind != 'r')) {
+            return 0; // Extended IDs end in x
+        }
+        frame->id = id;
+        frame->dlc = (dlc > 8) ? 8 : dlc;
+        if (kind == 'r') {
+            frame->rtr = CAN_RTR_Remote;
+            return 1;
+        }
+        const char* p = line + used;
+        for (uint8_t i = 0; i < frame->dlc; i++) {
+            unsigned byte;
+            int n;
+            if (sscanf(p, " %2x%n", &byte, &n) != 1) {
+                return 0;
+            }
+            frame->data[i] = byte;
+            p += n;
+        }
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Report a mismatch, the first REPLAY_MAX_REPORTS in full
+ */
+static void Mismatch(uint32_t index, uint16_t id, const char* what) {
+    if (mismatches++ < REPLAY_MAX_REPORTS) {
+        printf("mismatch: frame %u id 0x%03X %s\n", index, id, what);
+    }
+}
+
+/**
+ * @brief Read a telemetry field as a signed 64-bit value
+ * 
+ * @param field [const LoRa_Field*] Field in its packet
+ * @param base [const uint8_t*] Packet
+ * @return [int64_t] Value
+ */
+static int64_t Read_Field(const LoRa_Field* field, const uint8_t* base) {
+    const uint8_t* src = &base[field->offset];
+    uint16_t u16;
+    uint32_t u32;
+
+    switch (field->type) {
+    case LORA_FIELD_U8:  return src[0];
+    case LORA_FIELD_I8:  return (int8_t)src[0];
+    case LORA_FIELD_U16: memcpy(&u16, src, 2); return u16;
+    case LORA_FIELD_I16: memcpy(&u16, src, 2); return (int16_t)u16;
+    case LORA_FIELD_U32:
+    case LORA_FIELD_T32: memcpy(&u32, src, 4); return u32;
+    default:             memcpy(&u32, src, 4); return (int32_t)u32;
+    }
+}
+
+/**
+ * @brief Find a telemetry field by its map file name, telemetry.<packet>.<field>
+ * 
+ * @param name [const char*] Destination as written in the map file
+ * @param expect [Replay_Expect*] Entry to fill with the field and its packet
+ * @return [int] 0 if the schema has no such field
+ */
+static int Resolve_Field(const char* name, Replay_Expect* expect) {
+    char member[64];
+    char fieldName[64];
+
+    if (sscanf(name, "telemetry.%63[^.].%63s", member, fieldName) != 2) {
+        return 0;
+    }
+    for (uint8_t p = 0; p < sizeof(replayPackets) / sizeof(replayPackets[0]); p++) {
+        if (strcmp(member, replayPackets[p].member) != 0) {
+            continue;
+        }
+        const LoRa_Schema_Packet* packet = &loraSchema[p];
+        for (uint8_t f = 0; f < packet->fieldCount; f++) {
+            if (strcmp(fieldName, packet->fieldNames[f]) == 0) {
+                expect->field = &packet->fields[f];
+                expect->base = replayPackets[p].base;
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Load the values dbc2c.py --expect decoded from the DBC
+ * 
+ * @param path [const char*] Expected values file
+ * @return [int] 0 on a malformed line or unknown field, reported on stderr
+ */
+static int Load_Expected(const char* path) {
+    char line[256];
+    char dest[128];
+    char value[32];
+    unsigned frame;
+    unsigned id;
+    uint32_t capacity = 0;
+    uint32_t lineNumber = 0;
+
+    FILE* f = fopen(path, "r");
+    if (f == NULL) {
+        perror(path);
+        return 0;
+    }
+    while (fgets(line, sizeof(line), f) != NULL) {
+        lineNumber++;
+        if (sscanf(line, "%u %x %127s %31s", &frame, &id, dest, value) != 4) {
+            continue;
+        }
+        if (expectCount == capacity) {
+            capacity = capacity ? capacity * 2 : 4096;
+            expects = realloc(expects, capacity * sizeof(Replay_Expect));
+        }
+        Replay_Expect* expect = &expects[expectCount];
+        char* end;
+        expect->frame = frame;
+        expect->id = id;
+        expect->value = 0;
+        if (strcmp(value, "skip") == 0) {
+            expect->kind = REPLAY_EXPECT_SKIP;
+        }
+        else if (strcmp(value, "time") == 0) {
+            expect->kind = REPLAY_EXPECT_TIME;
+        }
+        else {
+            expect->kind = REPLAY_EXPECT_VALUE;
+            expect->value = strtoll(value, &end, 10);
+            if (*end != '\0') {
+                fprintf(stderr, "%s:%u: value %s is not an integer\n", path, lineNumber, value);
+                fclose(f);
+                return 0;
+            }
+        }
+        if ((expectCount > 0 && frame < expects[expectCount - 1].frame) || !Resolve_Field(dest, expect)) {
+            fprintf(stderr, "%s:%u: unknown field %s or frames out of order\n", path, lineNumber, dest);
+            fclose(f);
+            return 0;
+        }
+        expectCount++;
+    }
+    fclose(f);
+    return 1;
+}
+
+/**
+ * @brief Check the fields the DBC says this frame sets
+ * 
+ * @param frame [const CAN_Frame*] Frame that was decoded
+ * @param index [uint32_t] Position in the log
+ */
+static void Check_Expected(const CAN_Frame* frame, uint32_t index) {
+    char what[96];
+
+    while (expectNext < expectCount && expects[expectNext].frame == index) {
+        const Replay_Expect* expect = &expects[expectNext++];
+        int64_t got = Read_Field(expect->field, expect->base);
+        int64_t want = expect->value;
+
+        if (expect->id != frame->id) {
+            Mismatch(index, frame->id, "is not the frame dbc2c.py read at this index");
+            continue;
+        }
+        if (expect->kind == REPLAY_EXPECT_SKIP) {
+            want = Read_Field(expect->field, expect->base - (uint8_t*)&telemetry + (uint8_t*)&before);
+        }
+        else if (expect->kind == REPLAY_EXPECT_TIME) {
+            want = frame->timestamp;
+        }
+        if (got != want) {
+            snprintf(what, sizeof(what), "field at offset %u holds %lld, DBC says %lld%s", expect->field->offset,
+                     (long long)got, (long long)want, (expect->kind == REPLAY_EXPECT_SKIP) ? " (past DLC)" : "");
+            Mismatch(index, frame->id, what);
+        }
+    }
+}
+
+/**
+ * @brief Extract a signal one bit at a time, independent of Extract_Raw
+ * 
+ * @param sig [const CAN_Signal*] Signal description
+ * @param data [const uint8_t*] 8 payload bytes
+ * @param bytes [uint8_t*] Payload bytes the signal touches
+ * @return [uint64_t] Raw value, sign extended if signed
+ */
+static uint64_t Reference_Raw(const CAN_Signal* sig, const uint8_t* data, uint8_t* bytes) {
+    uint64_t raw = 0;
+    int bit = sig->startBit;
+
+    *bytes = 0;
+    for (int i = 0; i < sig->length; i++) {
+        int b = (sig->byteOrder == CAN_INTEL) ? sig->startBit + i : bit;
+        uint64_t value = (b >= 0 && b < 64) ? (data[b / 8] >> (b % 8)) & 1 : 0;
+        if (b / 8 + 1 > *bytes) {
+            *bytes = b / 8 + 1;
+        }
+
+        if (sig->byteOrder == CAN_INTEL) {
+            raw |= value << i;
+        }
+        else {
+            // Walk from the MSB towards the LSB through the sawtooth numbering
+            raw = (raw << 1) | value;
+            bit = (bit % 8 == 0) ? bit + 15 : bit - 1;
+        }
+    }
+
+    if (sig->isSigned && sig->length < 64 && (raw >> (sig->length - 1)) & 1) {
+        raw |= ~0ULL << sig->length;
+    }
+    return raw;
+}
+
+/**
+ * @brief Compare a decoded destination against the reference value
+ * @note A signal past the DLC must have left its destination as it was
+ * 
+ * @param sig [const CAN_Signal*] Signal description
+ * @param frame [const CAN_Frame*] Frame that was decoded
+ * @return [int] 1 if the destination holds the expected value
+ */
+static int Check_Signal(const CAN_Signal* sig, const CAN_Frame* frame) {
+    union {
+        uint8_t u8; int8_t i8; uint16_t u16; int16_t i16;
+        uint32_t u32; int32_t i32; float f32;
+    } expect;
+    static const size_t sizes[] = { 1, 1, 2, 2, 4, 4, 4 };
+    uint8_t bytes;
+    uint64_t raw = Reference_Raw(sig, frame->data, &bytes);
+
+    if (bytes > frame->dlc) {
+        const uint8_t* old = (const uint8_t*)&before + ((uint8_t*)sig->dest - (uint8_t*)&telemetry);
+        return sig->destType <= CAN_DEST_F32 && memcmp(old, sig->dest, sizes[sig->destType]) == 0;
+    }
+    int integer = (sig->scale == 1.0f && sig->offset == 0.0f && sig->destType != CAN_DEST_F32);
+    float value = (sig->isSigned ? (float)(int64_t)raw : (float)raw) * sig->scale + sig->offset;
+
+    switch (sig->destType) {
+    case CAN_DEST_U8:  expect.u8 = integer ? (uint8_t)raw : (uint8_t)value; break;
+    case CAN_DEST_I8:  expect.i8 = integer ? (int8_t)raw : (int8_t)value; break;
+    case CAN_DEST_U16: expect.u16 = integer ? (uint16_t)raw : (uint16_t)value; break;
+    case CAN_DEST_I16: expect.i16 = integer ? (int16_t)raw : (int16_t)value; break;
+    case CAN_DEST_U32: expect.u32 = integer ? (uint32_t)raw : (uint32_t)value; break;
+    case CAN_DEST_I32: expect.i32 = integer ? (int32_t)raw : (int32_t)value; break;
+    case CAN_DEST_F32: expect.f32 = value; break;
+    default: return 0;
+    }
+    return memcmp(&expect, sig->dest, sizes[sig->destType]) == 0;
+}
+
+/**
+ * @brief Check every signal of a frame just decoded
+ * 
+ * @param frame [const CAN_Frame*] Frame that was decoded
+ * @param index [uint32_t] Position in the log, for reporting
+ */
+static void Check_Frame(const CAN_Frame* frame, uint32_t index) {
+    char what[64];
+
+    Check_Expected(frame, index);
+
+    const CAN_Message* msg = CAN_Decode_Lookup(frame->id);
+    if (msg == NULL || frame->rtr == CAN_RTR_Remote) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < msg->signalCount; i++) {
+        if (!Check_Signal(&msg->signals[i], frame)) {
+            snprintf(what, sizeof(what), "signal %u (start %u len %u, dlc %u)", i,
+                     msg->signals[i].startBit, msg->signals[i].length, frame->dlc);
+            Mismatch(index, frame->id, what);
+        }
+    }
+    if (msg->timestamp != NULL && *msg->timestamp != frame->timestamp) {
+        Mismatch(index, frame->id, "timestamp");
+    }
+}
+
+/**
+ * @brief Push the log through the RX ring and decoder like the RX ISRs and CAN_Task
+ * 
+ * @param check [int] Verify signals and collect per-ID latency
+ * @return [uint64_t] Elapsed nanoseconds
+ */
+static uint64_t Replay(int check) {
+    static uint64_t pushTime[CAN_RX_RING_SIZE];
+    CAN_Frame rxFrames[CAN_RX_BATCH];
+    uint32_t pushed = 0;
+    uint32_t popped = 0;
+    uint64_t start = Now_Ns();
+
+    while (popped < logCount) {
+        // ISR side, one burst of up to a full hardware FIFO
+        for (uint8_t n = 0; n < REPLAY_FIFO_DEPTH && pushed < logCount; n++) {
+            CAN_Frame* slot = CAN_RX_Reserve();
+            if (slot == NULL) {
+                break;
+            }
+            *slot = logFrames[pushed];
+            if (check) {
+                pushTime[pushed & CAN_RX_RING_MASK] = Now_Ns();
+            }
+            CAN_RX_Commit();
+            pushed++;
+        }
+        CAN_RX_Publish();
+
+        // Task side, same drain loop as CAN_Task
+        uint16_t count = CAN_RX_Pop_Batch(rxFrames, CAN_RX_BATCH);
+        for (uint16_t i = 0; i < count; i++, popped++) {
+            if (check) {
+                memcpy(&before, &telemetry, sizeof(before)); // PacketID members are const
+            }
+            CAN_Decode_Frame(&rxFrames[i]);
+            if (check) {
+                uint64_t latency = Now_Ns() - pushTime[popped & CAN_RX_RING_MASK];
+                Replay_ID_Stats* stats = &idStats[rxFrames[i].id & 0x7FF];
+                stats->frames++;
+                stats->totalNs += latency;
+                if (latency > stats->maxNs) {
+                    stats->maxNs = latency;
+                }
+                Check_Frame(&rxFrames[i], popped);
+            }
+        }
+    }
+    return Now_Ns() - start;
+}
+
+/* Function Implementation --------------------------------------------------*/
+
+int main(int argc, char** argv) {
+    char line[512];
+    const char* expected = NULL;
+    int repeats = 100;
+    int arg = 1;
+
+    while (arg + 1 < argc && argv[arg][0] == '-') {
+        if (strcmp(argv[arg], "-n") == 0) {
+            repeats = atoi(argv[arg + 1]);
+        }
+        else if (strcmp(argv[arg], "-e") == 0) {
+            expected = argv[arg + 1];
+        }
+        else {
+            break;
+        }
+        arg += 2;
+    }
+    if (arg + 1 != argc || repeats < 1) {
+        fprintf(stderr, "usage: %s [-n repeats] [-e expected.txt] log.{log,asc}\n", argv[0]);
+        return 2;
+    }
+    if (expected != NULL && !Load_Expected(expected)) {
+        return 2;
+    }
+
+    FILE* f = fopen(argv[arg], "r");
+    if (f == NULL) {
+        perror(argv[arg]);
+        return 2;
+    }
+
+    double first = -1;
+    double seconds;
+    while (fgets(line, sizeof(line), f) != NULL && logCount < REPLAY_MAX_FRAMES) {
+        CAN_Frame* frame = &logFrames[logCount];
+        if (Parse_Line(line, &seconds, frame)) {
+            if (first < 0) {
+                first = seconds;
+            }
+            // Same wrapping microsecond counter as TIM2
+            frame->timestamp = (uint32_t)(uint64_t)((seconds - first) * 1e6);
+            logCount++;
+        }
+    }
+    fclose(f);
+
+    if (logCount == 0 || CAN_Decode_Init() != CAN_DECODE_OK) {
+        fprintf(stderr, "no frames or bad message table\n");
+        return 2;
+    }
+
+    // Checked pass first, then timed passes without the checks
+    Replay(1);
+    if (expectNext != expectCount) {
+        Mismatch(expects[expectNext].frame, expects[expectNext].id, "and later frames in the expected file never came");
+    }
+    uint64_t elapsed = 0;
+    for (int r = 0; r < repeats; r++) {
+        elapsed += Replay(0);
+    }
+
+    CAN_RX_Stats rxStats;
+    CAN_Get_RX_Stats(&rxStats);
+    double fps = (double)logCount * repeats / (elapsed / 1e9);
+    printf("%u frames, %d timed passes, %.0f frames/s (%.1f ns/frame), ring high water %u, overruns %u\n",
+           logCount, repeats, fps, 1e9 / fps, rxStats.highWater, rxStats.overruns);
+
+    printf("  id   frames   subscribed  avg ns  max ns\n");
+    for (uint16_t id = 0; id < 2048; id++) {
+        Replay_ID_Stats* stats = &idStats[id];
+        if (stats->frames == 0) {
+            continue;
+        }
+        printf("  %03X  %7u  %-10s  %6llu  %6llu\n", id, stats->frames,
+               CAN_Decode_Lookup(id) ? "yes" : "no",
+               (unsigned long long)(stats->totalNs / stats->frames),
+               (unsigned long long)stats->maxNs);
+    }
+
+    if (expected != NULL) {
+        printf("%u expected field values from %s\n", expectCount, expected);
+    }
+    printf("%u mismatches\n", mismatches);
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,256 @@
+/************************************************
+* @file    can_rx_flood.c 
+* @author  APBashara
+* @date    10/2026
+* 
+* @brief   Host Flood Test of the CAN RX Ring at Full Bus Load
+* @note    Drives Core/Src/can_rx.c the way the RX ISRs and CAN_Task do,
+*          in simulated time. A 500 kbps bus at 100% load carries back to
+*          back standard frames without data, the most frames a second it
+*          can hold. The task only runs when CAN_PORT_NOTIFY_RX woke it
+*          and is stalled now and then for longer than the ring lasts, as
+*          an SD write would.
+* 
+*          Every reserve is checked against a shadow of the ring, so the
+*          test knows which frame must be dropped, the overrun count, the
+*          high-water mark and the order every frame comes out in. A lost
+*          wake-up leaves frames in the ring and fails the test too.
+* 
+*          Build from the repository root, add -DCAN_CAPTURE for the
+*          capture build's ring:
+* 
+*          gcc -O2 -DCAN_HOST -DCAN_HOST_NOTIFY -DUSE_HAL_DRIVER -DSTM32F415xx -ICore/Inc \
+*              -IDrivers/STM32F4xx_HAL_Driver/Inc -IDrivers/CMSIS/Include \
+*              -IDrivers/CMSIS/Device/ST/STM32F4xx/Include \
+*              -IMiddlewares/Third_Party/FreeRTOS/Source/include \
+*              -IMiddlewares/Third_Party/FreeRTOS/Source/CMSIS_RTOS_V2 \
+*              -IMiddlewares/Third_Party/FreeRTOS/Source/portable/GCC/ARM_CM4F \
+*              Tools/can_rx_flood.c Core/Src/can_rx.c -o can_rx_flood
+* 
+*          Usage: can_rx_flood [-t seconds]
+*          Exits 1 on any check that fails.
+***********************************************/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "can.h"
+
+#define FLOOD_BITRATE               (500000)
+#define FLOOD_FRAME_BITS            (47) // Standard data frame without data and the 3 bit intermission
+#define FLOOD_PERIOD_NS             (1000000000ULL * FLOOD_FRAME_BITS / FLOOD_BITRATE)
+#define FLOOD_WAKE_NS               (15000) // Notification to CAN_Task running
+#define FLOOD_POP_NS                (2000) // One CAN_RX_Pop_Batch call
+#define FLOOD_FRAME_NS              (40000) // Decode of one frame, well inside the frame period
+#define FLOOD_STALL_PERIOD_NS       (200000000ULL) // Between task stalls
+#define FLOOD_STALL_EXTRA           (16) // Frames a stall runs past a full ring
+#define FLOOD_MAX_REPORTS           (10) // Failures printed in full
+
+typedef enum {
+    FLOOD_IDLE, // Waiting for a notification
+    FLOOD_DRAINING, // Popping batches until the ring is empty
+} Flood_Task_State;
+
+typedef struct {
+    const char* name;
+    uint64_t stallNs; // Task stall every FLOOD_STALL_PERIOD_NS, 0 for none
+} Flood_Scenario;
+
+static uint32_t shadow[CAN_RX_RING_SIZE]; // Sequence numbers in the ring, oldest first
+static uint32_t shadowHead;
+static uint32_t shadowTail;
+static uint32_t shadowHigh;
+static bool notified;
+static uint32_t notifications;
+static uint32_t failures;
+
+/* Static Functions ---------------------------------------------------------*/
+
+void CAN_Host_Notify_RX() {
+    notified = true;
+    notifications++;
+}
+
+static void Fail(const char* what, uint32_t sequence) {
+    if (failures++ < FLOOD_MAX_REPORTS) {
+        printf("fail: %s at frame %u\n", what, sequence);
+    }
+}
+
+/**
+ * @brief One RX interrupt for one frame, like CAN_RX_Drain_FIFO
+ * 
+ * @param sequence [uint32_t] Frame number, carried in the timestamp
+ * @return [bool] True if the ring took the frame
+ */
+static bool Receive(uint32_t sequence) {
+    bool full = (shadowHead - shadowTail) == CAN_RX_RING_SIZE;
+    CAN_Frame* slot = CAN_RX_Reserve();
+
+    if ((slot == NULL) != full) {
+        Fail(full ? "reserve on a full ring" : "overrun on a ring with room", sequence);
+    }
+    if (slot != NULL) {
+        memset(slot, 0, sizeof(CAN_Frame));
+        slot->id = sequence & 0x7FF;
+        slot->timestamp = sequence;
+        CAN_RX_Commit();
+        shadow[shadowHead++ & CAN_RX_RING_MASK] = sequence;
+        if (shadowHead - shadowTail > shadowHigh) {
+            shadowHigh = shadowHead - shadowTail;
+        }
+    }
+    CAN_RX_Publish();
+    return slot != NULL;
+}
+
+/**
+ * @brief One CAN_RX_Pop_Batch of CAN_Task, checked against the shadow
+ * 
+ * @return [uint16_t] Frames popped
+ */
+static uint16_t Drain_Batch() {
+    CAN_Frame frames[CAN_RX_BATCH];
+    uint16_t count = CAN_RX_Pop_Batch(frames, CAN_RX_BATCH);
+
+    for (uint16_t i = 0; i < count; i++) {
+        if (shadowTail == shadowHead) {
+            Fail("frame popped from an empty ring", frames[i].timestamp);
+            continue;
+        }
+        uint32_t expected = shadow[shadowTail++ & CAN_RX_RING_MASK];
+        if (frames[i].timestamp != expected || frames[i].id != (expected & 0x7FF)) {
+            Fail("frame out of order", expected);
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief Earliest time the task can run, after any stall it falls in
+ */
+static uint64_t After_Stall(uint64_t time, uint64_t stallNs) {
+    if (stallNs != 0 && time % FLOOD_STALL_PERIOD_NS < stallNs) {
+        return time - time % FLOOD_STALL_PERIOD_NS + stallNs;
+    }
+    return time;
+}
+
+/**
+ * @brief Flood the ring for a while and check the statistics it kept
+ * 
+ * @param scenario [const Flood_Scenario*] Task stalls
+ * @param seconds [uint32_t] Simulated bus time
+ * @param sequence [uint32_t*] Next frame number, kept across scenarios
+ */
+static void Run(const Flood_Scenario* scenario, uint32_t seconds, uint32_t* sequence) {
+    Flood_Task_State state = FLOOD_IDLE;
+    uint64_t end = (uint64_t)seconds * 1000000000ULL;
+    uint64_t nextFrame = 0;
+    uint64_t taskReady = 0; // Time the task's next step happens
+    uint32_t produced = 0;
+    uint32_t dropped = 0;
+    uint32_t startNotifications = notifications;
+    CAN_RX_Stats before;
+    CAN_RX_Stats after;
+
+    CAN_Get_RX_Stats(&before);
+    shadowHigh = 0;
+
+    while (nextFrame < end || state != FLOOD_IDLE || notified) {
+        // Interrupts preempt the task, the bus stops at the end
+        bool waiting = (state == FLOOD_IDLE && !notified);
+        if (nextFrame < end && (waiting || nextFrame <= taskReady)) {
+            if (!Receive((*sequence)++)) {
+                dropped++;
+            }
+            if (waiting && notified) {
+                taskReady = After_Stall(nextFrame + FLOOD_WAKE_NS, scenario->stallNs);
+            }
+            produced++;
+            nextFrame += FLOOD_PERIOD_NS;
+            continue;
+        }
+
+        if (state == FLOOD_IDLE) {
+            // ulTaskNotifyTake clears the notification and returns
+            notified = false;
+            state = FLOOD_DRAINING;
+            continue;
+        }
+
+        uint16_t count = Drain_Batch();
+        taskReady = After_Stall(taskReady + FLOOD_POP_NS + count * FLOOD_FRAME_NS, scenario->stallNs);
+        if (count == 0) {
+            // Back to ulTaskNotifyTake, which returns at once if notified meanwhile
+            state = FLOOD_IDLE;
+        }
+    }
+
+    CAN_Get_RX_Stats(&after);
+    uint32_t received = after.received - before.received;
+    uint32_t overruns = after.overruns - before.overruns;
+    uint32_t expectHigh = (shadowHigh > before.highWater) ? shadowHigh : before.highWater;
+
+    if (overruns != dropped) {
+        Fail("overrun count", *sequence);
+    }
+    if (received != produced - dropped) {
+        Fail("received count", *sequence);
+    }
+    if (after.highWater != expectHigh) {
+        Fail("high-water mark", *sequence);
+    }
+    if (shadowHead != shadowTail) {
+        Fail("frames left in the ring, a wake-up was lost", *sequence);
+    }
+    if (scenario->stallNs == 0 && overruns != 0) {
+        Fail("overruns while the task keeps up", *sequence);
+    }
+    if (scenario->stallNs != 0 && (overruns == 0 || shadowHigh != CAN_RX_RING_SIZE)) {
+        Fail("stall did not fill the ring", *sequence);
+    }
+
+    printf("%-10s %9u %9u %9u %9u %6u/%u %9u\n", scenario->name, produced, received, overruns,
+        notifications - startNotifications, shadowHigh, CAN_RX_RING_SIZE, after.highWater);
+}
+
+/* Function Implementation --------------------------------------------------*/
+
+int main(int argc, char** argv) {
+    uint32_t seconds = 5;
+    uint32_t sequence = 0;
+
+    if (argc == 3 && strcmp(argv[1], "-t") == 0) {
+        seconds = strtoul(argv[2], NULL, 0);
+    }
+    else if (argc != 1) {
+        fprintf(stderr, "usage: %s [-t seconds]\n", argv[0]);
+        return 2;
+    }
+    if (seconds == 0) {
+        fprintf(stderr, "at least a second\n");
+        return 2;
+    }
+
+    // A stall just long enough to fill the ring from empty, plus some frames to drop
+    const Flood_Scenario scenarios[] = {
+        { "keeps up", 0 },
+        { "stalled", (CAN_RX_RING_SIZE + FLOOD_STALL_EXTRA) * FLOOD_PERIOD_NS },
+    };
+
+    printf("%u kbps, %llu us per frame, %u frame ring\n", FLOOD_BITRATE / 1000,
+        (unsigned long long)(FLOOD_PERIOD_NS / 1000), CAN_RX_RING_SIZE);
+    printf("%-10s %9s %9s %9s %9s %8s %9s\n", "task", "frames", "received", "overruns", "wakeups", "peak",
+        "high wat");
+    for (uint8_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+        Run(&scenarios[i], seconds, &sequence);
+    }
+
+    if (failures) {
+        fprintf(stderr, "%u checks failed\n", failures);
+    }
+    return failures ? 1 : 0;
+}
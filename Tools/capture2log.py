@@ -0,0 +1,75 @@
+#!/usr/bin/env python3
+"""
+Convert a CANxxx.BIN capture from the SD card into candump log format.
+
+The file is a sequence of 512 byte blocks, each a 16 byte header
+
+    uint16 magic (0xCA5E), uint16 count, uint32 sequence,
+    uint32 timestamp_us, uint16 length, uint16 dropped
+
+followed by records of uint16 delta_us, uint16 (id | dlc << 11 | rtr << 15)
+and dlc data bytes (none for remote frames). All fields are little endian.
+
+The output can be replayed with can-utils or loaded by SavvyCAN. Timestamps
+are seconds since the logger booted.
+
+Usage: capture2log.py CAN000.BIN [interface] > capture.log
+"""
+
+import struct
+import sys
+
+BLOCK_SIZE = 512
+HEADER = struct.Struct('<HHIIHH')
+MAGIC = 0xCA5E
+
+
+def main():
+    if len(sys.argv) < 2:
+        print(__doc__, file=sys.stderr)
+        sys.exit(1)
+    iface = sys.argv[2] if len(sys.argv) > 2 else 'can0'
+
+    with open(sys.argv[1], 'rb') as f:
+        data = f.read()
+
+    expected = None
+    wraps = 0
+    last_time = None
+    for offset in range(0, len(data) - BLOCK_SIZE + 1, BLOCK_SIZE):
+        magic, count, sequence, timestamp, length, dropped = HEADER.unpack_from(data, offset)
+        if magic != MAGIC:
+            print(f'warning: bad block at offset {offset}', file=sys.stderr)
+            continue
+        if expected is not None and sequence != expected:
+            print(f'warning: blocks {expected}..{sequence - 1} missing', file=sys.stderr)
+        expected = sequence + 1
+        if dropped:
+            print(f'warning: {dropped} frames dropped before block {sequence}', file=sys.stderr)
+
+        pos = offset + HEADER.size
+        end = pos + length
+        time = timestamp
+        for _ in range(count):
+            if pos + 4 > end:
+                break
+            delta, info = struct.unpack_from('<HH', data, pos)
+            can_id = info & 0x7FF
+            dlc = (info >> 11) & 0xF
+            rtr = info >> 15
+            payload = b'' if rtr else data[pos + 4:pos + 4 + dlc]
+            pos += 4 + len(payload)
+            time = (time + delta) & 0xFFFFFFFF
+
+            # TIM2 is a 32-bit microsecond counter and wraps every 71 minutes
+            if last_time is not None and time < last_time:
+                wraps += 1
+            last_time = time
+            seconds = (wraps << 32 | time) / 1e6
+
+            body = 'R' if rtr else payload.hex().upper()
+            print(f'({seconds:.6f}) {iface} {can_id:03X}#{body}')
+
+
+if __name__ == '__main__':
+    main()
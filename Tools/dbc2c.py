@@ -0,0 +1,283 @@
+#!/usr/bin/env python3
+"""
+Generate Core/Src/can_db.c from a DBC file.
+
+Only signals listed in the map file are emitted, so the ECU can broadcast
+far more channels than the firmware subscribes to. Each map line is
+
+    SIGNAL_NAME  destination.field  dest_type
+
+where dest_type is one of u8, i8, u16, i16, u32, i32, f32. A line
+
+    MESSAGE_NAME  destination.field  time
+
+instead stores the TIM2 receive time (us) of that DBC message in a u32
+field each time it is decoded. Blank lines and lines starting with # are
+ignored.
+
+Usage: dbc2c.py ecu.dbc signals.map > Core/Src/can_db.c
+
+With --expect the script instead decodes a candump (-L) or Vector ASC log
+straight from the DBC and prints what each mapped field must hold after
+every frame, for Tools/can_replay.c -e. One line per signal and frame:
+
+    frame_index  id  destination.field  value|skip|time
+
+skip marks a signal past the frame's DLC, which must stay untouched, and
+time a receive time field, which must hold the frame timestamp. Frames are
+numbered as can_replay.c numbers them, standard data and remote frames.
+
+Usage: dbc2c.py ecu.dbc signals.map --expect log.{log,asc} > expected.txt
+"""
+
+import re
+import struct
+import sys
+
+BO_RE = re.compile(r'^BO_\s+(\d+)\s+(\w+)\s*:')
+CYCLE_RE = re.compile(r'^BA_\s+"GenMsgCycleTime"\s+BO_\s+(\d+)\s+(\d+)\s*;')
+SG_RE = re.compile(r'^\s*SG_\s+(\w+)\s*(?:\w+\s*)?:\s*(\d+)\|(\d+)@([01])([+-])'
+                   r'\s*\(([^,]+),([^)]+)\)')
+
+DEST_TYPES = {
+    'u8': 'CAN_DEST_U8', 'i8': 'CAN_DEST_I8',
+    'u16': 'CAN_DEST_U16', 'i16': 'CAN_DEST_I16',
+    'u32': 'CAN_DEST_U32', 'i32': 'CAN_DEST_I32',
+    'f32': 'CAN_DEST_F32',
+}
+
+
+def standard_id(dbc_id, name):
+    """11-bit ID of a DBC message, None for an extended (29-bit) one"""
+    if dbc_id & 0x80000000 or dbc_id > 0x7FF:
+        print(f'warning: skipping {name}, extended ID 0x{dbc_id & 0x1FFFFFFF:08X} '
+              f'(filters are standard ID only)', file=sys.stderr)
+        return None
+    return dbc_id
+
+
+def parse_dbc(path):
+    messages = {}
+    names = {}
+    cycles = {}
+    current = None
+    with open(path, encoding='latin-1') as f:
+        for line in f:
+            m = CYCLE_RE.match(line)
+            if m:
+                if int(m.group(1)) <= 0x7FF:
+                    cycles[int(m.group(1))] = int(m.group(2))
+                continue
+            m = BO_RE.match(line)
+            if m:
+                current = standard_id(int(m.group(1)), m.group(2))
+                if current is not None:
+                    messages[current] = []
+                    names[m.group(2)] = current
+                continue
+            m = SG_RE.match(line)
+            if m and current is not None:
+                name, start, length, order, sign, scale, offset = m.groups()
+                messages[current].append({
+                    'name': name,
+                    'start': int(start),
+                    'length': int(length),
+                    'order': 'CAN_INTEL' if order == '1' else 'CAN_MOTOROLA',
+                    'signed': 1 if sign == '-' else 0,
+                    'scale': float(scale),
+                    'offset': float(offset),
+                })
+            elif not line.strip():
+                current = None
+    return messages, names, cycles
+
+
+def parse_map(path):
+    mapping = {}
+    times = {}
+    with open(path) as f:
+        for line in f:
+            line = line.split('#', 1)[0].strip()
+            if not line:
+                continue
+            name, dest, dtype = line.split()
+            if dtype == 'time':
+                times[name] = dest
+                continue
+            if dtype not in DEST_TYPES:
+                sys.exit(f'unknown dest_type {dtype} for {name}')
+            mapping[name] = (dest, dtype)
+    return mapping, times
+
+
+def signal_end(s):
+    """Payload bits a signal needs from the start of byte 0, as Signal_End in can_decode.c"""
+    if s['order'] == 'CAN_INTEL':
+        return s['start'] + s['length']
+    msb = (s['start'] & ~0x7) + (7 - (s['start'] & 0x7))
+    return msb + s['length']
+
+
+def parse_log(path):
+    """Yield (dlc, data, remote) per frame, accepted exactly as Parse_Line in can_replay.c."""
+    candump = re.compile(r'^\s*\(([-+0-9.eE]+)\)\s+\S+\s+([0-9A-Fa-f]+)#(\S+)')
+    with open(path, encoding='latin-1') as f:
+        for line in f:
+            m = candump.match(line)
+            if m:
+                id_text, body = m.group(2), m.group(3)
+                if len(id_text) != 3 or body[0] == '#':
+                    continue
+                can_id = int(id_text, 16) & 0x7FF
+                if body[0] == 'R':
+                    yield can_id, 0, bytes(8), True
+                    continue
+                dlc = min(len(body) // 2, 8)
+                yield can_id, dlc, bytes.fromhex(body[:dlc * 2]).ljust(8, b'\0'), False
+                continue
+
+            fields = line.split()
+            try:
+                float(fields[0])
+                int(fields[1])
+                can_id = int(fields[2], 16)
+                kind, dlc = fields[4][0], int(fields[5])
+            except (IndexError, ValueError):
+                continue
+            if can_id > 0x7FF or kind not in 'dr':
+                continue
+            dlc = min(dlc, 8)
+            if kind == 'r':
+                yield can_id, dlc, bytes(8), True
+                continue
+            try:
+                data = bytes(int(b, 16) for b in fields[6:6 + dlc])
+            except ValueError:
+                continue
+            if len(data) == dlc:
+                yield can_id, dlc, data.ljust(8, b'\0'), False
+
+
+def f32(value):
+    """Round to single precision, as the firmware's float arithmetic does."""
+    return struct.unpack('<f', struct.pack('<f', value))[0]
+
+
+def expected_value(s, dtype, data):
+    """Field value after decoding one signal, from the DBC definition alone."""
+    mask = (1 << s['length']) - 1
+    if s['order'] == 'CAN_INTEL':
+        raw = (int.from_bytes(data, 'little') >> s['start']) & mask
+    else:
+        msb = (s['start'] & ~0x7) + (7 - (s['start'] & 0x7))
+        raw = (int.from_bytes(data, 'big') >> (64 - msb - s['length'])) & mask
+    if s['signed'] and raw >> (s['length'] - 1):
+        raw -= 1 << s['length']
+
+    if dtype != 'f32' and s['scale'] == 1.0 and s['offset'] == 0.0:
+        value = raw
+    else:
+        value = f32(f32(f32(raw) * f32(s['scale'])) + f32(s['offset']))
+        if dtype == 'f32':
+            return repr(value)
+        value = int(value)  # C casts truncate towards zero
+    bits = int(dtype[1:])
+    value &= (1 << bits) - 1
+    if dtype[0] == 'i' and value >> (bits - 1):
+        value -= 1 << bits
+    return str(value)
+
+
+def expect(messages, names, mapping, times, path):
+    by_id = {can_id: [s for s in signals if s['name'] in mapping] for can_id, signals in messages.items()}
+    timestamps = {names[name]: dest for name, dest in times.items() if name in names}
+    out = []
+    for index, (can_id, dlc, data, remote) in enumerate(parse_log(path)):
+        signals = by_id.get(can_id)
+        if remote or not signals:
+            continue
+        for s in signals:
+            dest, dtype = mapping[s['name']]
+            value = 'skip' if signal_end(s) > dlc * 8 else expected_value(s, dtype, data)
+            out.append(f'{index} {can_id:03X} {dest} {value}')
+        if can_id in timestamps:
+            out.append(f'{index} {can_id:03X} {timestamps[can_id]} time')
+    print('\n'.join(out))
+
+
+def c_float(value):
+    return repr(float(value)) + 'f'
+
+
+def main():
+    if len(sys.argv) not in (3, 5) or (len(sys.argv) == 5 and sys.argv[3] != '--expect'):
+        sys.exit(__doc__)
+
+    messages, names, cycles = parse_dbc(sys.argv[1])
+    mapping, times = parse_map(sys.argv[2])
+    if len(sys.argv) == 5:
+        expect(messages, names, mapping, times, sys.argv[4])
+        return
+    timestamps = {names[name]: dest for name, dest in times.items() if name in names}
+
+    out = []
+    out.append('/************************************************')
+    out.append('* @file    can_db.c ')
+    out.append('* @author  Generated by Tools/dbc2c.py')
+    out.append('* ')
+    out.append('* @brief   ECU CAN Signal Database')
+    out.append('* @note    Do not edit, regenerate from the DBC file')
+    out.append('***********************************************/')
+    out.append('')
+    out.append('#include "main.h"')
+    out.append('')
+    out.append('extern Telemetry telemetry;')
+    out.append('')
+    out.append('/* Signal Tables ------------------------------------------------------------*/')
+    out.append('// startBit, length, byteOrder, isSigned, destType, scale, offset, dest')
+
+    used = []
+    for can_id in sorted(messages):
+        signals = [s for s in messages[can_id] if s['name'] in mapping]
+        if not signals:
+            continue
+        used.append(can_id)
+        out.append(f'static const CAN_Signal sig_0x{can_id:03X}[] = {{')
+        for s in signals:
+            if s['length'] == 0 or signal_end(s) > 64:
+                sys.exit(f"signal {s['name']} of 0x{can_id:03X} does not fit in 64 bits")
+            dest, dtype = mapping[s['name']]
+            dtype = DEST_TYPES[dtype]
+            out.append(f"    {{ {s['start']}, {s['length']}, {s['order']}, {s['signed']}, "
+                       f"{dtype}, {c_float(s['scale'])}, {c_float(s['offset'])}, &{dest} }}, "
+                       f"// {s['name']}")
+        out.append('};')
+        out.append('')
+
+    missing = set(mapping) - {s['name'] for m in messages.values() for s in m}
+    for name in sorted(missing):
+        print(f'warning: {name} not found in DBC', file=sys.stderr)
+    for name in sorted(set(times) - set(names)):
+        print(f'warning: message {name} not found in DBC', file=sys.stderr)
+    for can_id in sorted(set(timestamps) - set(used)):
+        print(f'warning: message 0x{can_id:03X} has a time but no mapped signals', file=sys.stderr)
+
+    out.append('/* Message Table ------------------------------------------------------------*/')
+    out.append('// Must stay sorted by ID for the binary search in CAN_Decode_Lookup')
+    out.append('// id, rate (frames/s), signalCount, signals, timestamp')
+    out.append('const CAN_Message canMessages[] = {')
+    for can_id in used:
+        # Messages without a cycle time are treated as 1 Hz
+        cycle = cycles.get(can_id, 0)
+        rate = 1000 // cycle if cycle > 0 else 1
+        timestamp = f'&{timestamps[can_id]}' if can_id in timestamps else 'NULL'
+        out.append(f'    {{ 0x{can_id:03X}, {rate}, sizeof(sig_0x{can_id:03X}) / sizeof(CAN_Signal), '
+                   f'sig_0x{can_id:03X}, {timestamp} }},')
+    out.append('};')
+    out.append('')
+    out.append('const uint16_t canMessageCount = sizeof(canMessages) / sizeof(CAN_Message);')
+    print('\n'.join(out))
+
+
+if __name__ == '__main__':
+    main()
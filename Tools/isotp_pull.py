@@ -0,0 +1,242 @@
+#!/usr/bin/env python3
+"""
+Download SD card logs from the car over CAN using ISO-TP (ISO 15765-2).
+
+Talks to the log service in Core/Src/log_service.c through a SocketCAN
+interface wired to the pit connector:
+
+    isotp_pull.py can0 --list
+    isotp_pull.py can0 CAN003.BIN [more files...]
+    isotp_pull.py can0 --radio [CAN003.BIN]
+
+--radio asks the car to send a file, by default the newest capture, to the
+LoRa receiver at its next chance, see Tools/lora_offload.py.
+
+With --serve DIR the script plays the car instead and serves files from DIR,
+so the transfer can be exercised on a virtual interface without hardware:
+
+    sudo ip link add dev vcan0 type vcan && sudo ip link set up vcan0
+    isotp_pull.py vcan0 --serve logs/ &
+    isotp_pull.py vcan0 --list
+
+Requests go out on 0x7E0 and responses come back on 0x7E8, both padded to
+8 bytes. The tester asks for BS=0 and STmin=0 so the car sends at bus speed.
+"""
+
+import argparse
+import os
+import socket
+import struct
+import sys
+import time
+
+REQUEST_ID = 0x7E0
+RESPONSE_ID = 0x7E8
+PADDING = 0xCC
+TIMEOUT = 1.0  # N_Bs / N_Cr in seconds
+
+LIST, OPEN, READ, CLOSE, OFFLOAD = 0x01, 0x02, 0x03, 0x04, 0x05
+POSITIVE = 0x40
+NEGATIVE = 0x7F
+CAPTURING = 0xFE  # Negative code for the file the CAN capture is writing
+MAX_READ = 4095 - 5
+
+CAN_FRAME = struct.Struct('=IB3x8s')
+
+
+class IsoTp:
+    """Single ISO-TP session over a raw SocketCAN socket."""
+
+    def __init__(self, iface, tx_id, rx_id, block_size=0, st_min=0):
+        self.sock = socket.socket(socket.AF_CAN, socket.SOCK_RAW, socket.CAN_RAW)
+        self.sock.setsockopt(socket.SOL_CAN_RAW, socket.CAN_RAW_FILTER,
+                             struct.pack('=II', rx_id, 0x7FF))
+        self.sock.bind((iface,))
+        self.tx_id = tx_id
+        self.block_size = block_size
+        self.st_min = st_min
+
+    def _send_frame(self, data):
+        data = bytes(data).ljust(8, bytes([PADDING]))
+        self.sock.send(CAN_FRAME.pack(self.tx_id, 8, data))
+
+    def _recv_frame(self, timeout):
+        self.sock.settimeout(timeout)
+        try:
+            frame = self.sock.recv(CAN_FRAME.size)
+        except socket.timeout:
+            return None
+        _, dlc, data = CAN_FRAME.unpack(frame)
+        return data[:dlc]
+
+    def send(self, payload):
+        if len(payload) <= 7:
+            self._send_frame(bytes([len(payload)]) + payload)
+            return
+        self._send_frame(bytes([0x10 | (len(payload) >> 8), len(payload) & 0xFF]) + payload[:6])
+        sent = 6
+        sequence = 1
+        while sent < len(payload):
+            fc = self._recv_frame(TIMEOUT)
+            if fc is None:
+                raise TimeoutError('no flow control')
+            if fc[0] >> 4 != 3:
+                continue
+            if fc[0] & 0x0F == 1:
+                continue  # Wait
+            if fc[0] & 0x0F != 0:
+                raise IOError('receiver overflow')
+            block, st_min = fc[1], fc[2]
+            gap = st_min / 1000 if st_min <= 0x7F else (st_min - 0xF0) / 10000
+            count = 0
+            while sent < len(payload) and (block == 0 or count < block):
+                self._send_frame(bytes([0x20 | sequence]) + payload[sent:sent + 7])
+                sent += 7
+                sequence = (sequence + 1) & 0x0F
+                count += 1
+                if gap:
+                    time.sleep(gap)
+
+    def recv(self, timeout=TIMEOUT):
+        while True:
+            frame = self._recv_frame(timeout)
+            if frame is None:
+                return None
+            pci = frame[0] >> 4
+            if pci == 0:
+                return frame[1:1 + (frame[0] & 0x0F)]
+            if pci != 1:
+                continue  # Stray consecutive or flow control
+
+            length = ((frame[0] & 0x0F) << 8) | frame[1]
+            payload = bytearray(frame[2:8])
+            self._send_frame([0x30, self.block_size, self.st_min])
+            sequence = 1
+            count = 0
+            while len(payload) < length:
+                frame = self._recv_frame(TIMEOUT)
+                if frame is None:
+                    raise TimeoutError('consecutive frame timeout')
+                if frame[0] >> 4 != 2:
+                    continue
+                if frame[0] & 0x0F != sequence:
+                    raise IOError('sequence error')
+                payload += frame[1:1 + min(7, length - len(payload))]
+                sequence = (sequence + 1) & 0x0F
+                count += 1
+                if self.block_size and count == self.block_size and len(payload) < length:
+                    self._send_frame([0x30, self.block_size, self.st_min])
+                    count = 0
+            return bytes(payload)
+
+
+def request(link, payload):
+    link.send(payload)
+    response = link.recv()
+    if response is None:
+        raise TimeoutError('no response to request 0x%02X' % payload[0])
+    if response[0] == NEGATIVE:
+        if response[2] == CAPTURING:
+            raise IOError('request 0x%02X refused, the file is still being captured' % response[1])
+        raise IOError('request 0x%02X failed with code %d' % (response[1], response[2]))
+    if response[0] != payload[0] + POSITIVE:
+        raise IOError('unexpected response 0x%02X' % response[0])
+    return response[1:]
+
+
+def list_files(link):
+    files = []
+    while True:
+        try:
+            body = request(link, struct.pack('<BH', LIST, len(files)))
+        except IOError:
+            return files
+        files.append((body[4:].decode(), struct.unpack_from('<I', body)[0]))
+
+
+def pull(link, name, dest):
+    size = struct.unpack('<I', request(link, bytes([OPEN]) + name.encode()))[0]
+    start = time.monotonic()
+    with open(os.path.join(dest, name), 'wb') as f:
+        offset = 0
+        while offset < size:
+            body = request(link, struct.pack('<BIH', READ, offset, MAX_READ))
+            if struct.unpack_from('<I', body)[0] != offset or len(body) == 4:
+                raise IOError('bad read at offset %d' % offset)
+            f.write(body[4:])
+            offset += len(body) - 4
+            print('\r%s %d/%d' % (name, offset, size), end='', file=sys.stderr)
+    request(link, bytes([CLOSE]))
+    elapsed = time.monotonic() - start
+    print('\r%s %d bytes in %.1f s (%.1f kB/s)' % (name, size, elapsed, size / elapsed / 1000 if elapsed else 0),
+          file=sys.stderr)
+
+
+def serve(link, root):
+    """Stand-in for the car side log service."""
+    handle = None
+    while True:
+        req = link.recv(timeout=None)
+        if not req:
+            continue
+        code = req[0]
+        try:
+            if code == LIST:
+                index = struct.unpack_from('<H', req, 1)[0]
+                names = sorted(n for n in os.listdir(root) if os.path.isfile(os.path.join(root, n)))
+                if index >= len(names):
+                    raise FileNotFoundError
+                name = names[index]
+                resp = struct.pack('<BI', code + POSITIVE, os.path.getsize(os.path.join(root, name))) + name.encode()
+            elif code == OPEN:
+                if handle:
+                    handle.close()
+                handle = open(os.path.join(root, os.path.basename(req[1:].decode())), 'rb')
+                resp = struct.pack('<BI', code + POSITIVE, os.fstat(handle.fileno()).st_size)
+            elif code == READ and handle:
+                offset, count = struct.unpack_from('<IH', req, 1)
+                handle.seek(offset)
+                resp = struct.pack('<BI', code + POSITIVE, offset) + handle.read(min(count, MAX_READ))
+            elif code == OFFLOAD and len(req) <= 13:
+                print('offload of %s requested' % (req[1:].decode() or 'the newest capture'), file=sys.stderr)
+                resp = bytes([code + POSITIVE])
+            elif code == CLOSE:
+                if handle:
+                    handle.close()
+                handle = None
+                resp = bytes([code + POSITIVE])
+            else:
+                raise ValueError
+        except (OSError, ValueError, struct.error):
+            resp = bytes([NEGATIVE, code, 0xFF])
+        link.send(resp)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Download car logs over ISO-TP')
+    parser.add_argument('iface', help='SocketCAN interface, e.g. can0 or vcan0')
+    parser.add_argument('files', nargs='*', help='files to download')
+    parser.add_argument('--list', action='store_true', help='list files on the SD card')
+    parser.add_argument('--dest', default='.', help='directory to write downloads to')
+    parser.add_argument('--serve', metavar='DIR', help='act as the car and serve DIR')
+    parser.add_argument('--radio', nargs='?', const='', metavar='FILE',
+                        help='have the car send FILE, or its newest capture, over the radio')
+    args = parser.parse_args()
+
+    if args.serve:
+        serve(IsoTp(args.iface, RESPONSE_ID, REQUEST_ID), args.serve)
+        return
+
+    link = IsoTp(args.iface, REQUEST_ID, RESPONSE_ID)
+    if args.list:
+        for name, size in list_files(link):
+            print('%-12s %10d' % (name, size))
+    for name in args.files:
+        pull(link, name, args.dest)
+    if args.radio is not None:
+        request(link, bytes([OFFLOAD]) + args.radio.encode())
+        print('offload of %s requested' % (args.radio or 'the newest capture'), file=sys.stderr)
+
+
+if __name__ == '__main__':
+    main()
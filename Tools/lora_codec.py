@@ -0,0 +1,264 @@
+#!/usr/bin/env python3
+"""
+Keyframe and delta codec for LoRa telemetry, mirror of Core/Src/lora_codec.c.
+
+Every sub-packet payload starts with a header byte: bit 7 set for a keyframe,
+bits 0-6 the keyframe sequence. A keyframe packs each field LSB first at its
+schema width. A delta holds one zigzag varint per field, the difference from
+the keyframe with the same sequence, so only a lost keyframe costs data and
+only until the next one.
+
+The schema is read from Core/Inc/lora_schema.h, the same lists the firmware
+structs and field tables expand from. A version tag of type 0x7D names the
+schema the car was built with, frames under another version are refused.
+
+Run as a script to benchmark the codec on a recorded session of uncompressed
+frames (one hex frame per line, sub-packets of type, length and the raw
+struct without its ID byte):
+
+    lora_codec.py session.txt
+"""
+
+import os
+import re
+import struct
+import sys
+
+KEYFRAME = 0x80
+SEQUENCE_MASK = 0x7F
+KEY_INTERVAL = 10
+LINK = 0x7F  # ADR link request [step] or report [step][snr][-rssi], Core/Inc/lora_adr.h
+OFFLOAD = 0x7C  # Log offload announcement or frame, Core/Inc/lora_offload.h
+SWEEP = 0x7B  # Radio settings sweep point or result, Core/Inc/lora_sweep.h
+HEADER = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'Core', 'Inc', 'lora_schema.h')
+
+# Width in bits and struct code of each C field type
+TYPES = {'u8': 8, 'i8': 8, 'u16': 16, 'i16': 16, 'u32': 32, 'i32': 32, 't32': 32}
+CODES = {'u8': 'B', 'i8': 'b', 'u16': 'H', 'i16': 'h', 'u32': 'I', 'i32': 'i', 't32': 'I'}
+
+
+def _layout(fields):
+    """Struct format of a packet struct without its ID byte, ARM EABI alignment."""
+    codes = []
+    offset = 1
+    largest = 1
+    for _, kind, _ in fields:
+        size = TYPES[kind] // 8
+        largest = max(largest, size)
+        pad = -offset % size
+        codes += ['x'] * pad + [CODES[kind]]
+        offset += pad + size
+    codes += ['x'] * (-offset % largest)
+
+    # Run length, '<x6H2xI' rather than '<xHHHHHHxxI'
+    layout = '<'
+    for code, run in re.findall(r'((.)\2*)', ''.join(codes)):
+        layout += (str(len(code)) if len(code) > 1 else '') + run
+    return layout
+
+
+def load_schema(path=HEADER):
+    """Parse lora_schema.h into (version, type, {id: (name, raw layout, [(field, type, bits)])})."""
+    with open(path) as f:
+        text = f.read()
+    constants = dict(re.findall(r'#define (LORA_\w+)\s+\((0x[0-9A-Fa-f]+|\d+)\)', text))
+    lists = {}
+    for macro, body in re.findall(r'#define (\w+)\(FIELD, P\)((?:.*\\\n)*.*)', text):
+        lists[macro] = [(name, kind.lower(), int(bits))
+                        for name, kind, bits in re.findall(r'FIELD\(P, (\w+), ([UIT]\d+), (\d+)\)', body)]
+    schema = {}
+    for packet_id, name, fields in re.findall(r'PACKET\((LORA_\w+), (\w+), (\w+)\)', text):
+        fields = lists['LORA_SCHEMA_HEAD'] + lists[fields] + lists['LORA_SCHEMA_TAIL']
+        schema[int(constants[packet_id], 0)] = (name, _layout(fields), fields)
+    return (int(constants['LORA_SCHEMA_VERSION'], 0), int(constants['LORA_SCHEMA_TYPE'], 0), schema)
+
+
+# type: (name, raw payload layout, [(field, type, bits)])
+VERSION, VERSION_TYPE, SCHEMA = load_schema()
+
+
+def _extend(value, bits, signed):
+    """Cut value to bits and sign extend, as the receiver sees it."""
+    value &= (1 << bits) - 1
+    if signed and value >> (bits - 1):
+        value -= 1 << bits
+    return value
+
+
+def clamp(value, bits, kind):
+    """Saturate value to what bits holds, as LoRa_Codec_Encode does before encoding."""
+    if bits >= 32:
+        return value
+    if kind.startswith('i'):
+        return max(-(1 << (bits - 1)), min(value, (1 << (bits - 1)) - 1))
+    return min(value, (1 << bits) - 1)
+
+
+def _to_type(value, kind):
+    """Wrap a 32-bit result to the C field type."""
+    return _extend(value, TYPES[kind], kind.startswith('i'))
+
+
+def _varint(delta):
+    zigzag = ((delta << 1) ^ (delta >> 31)) & 0xFFFFFFFF
+    out = bytearray()
+    while zigzag >= 0x80:
+        out.append((zigzag & 0x7F) | 0x80)
+        zigzag >>= 7
+    out.append(zigzag)
+    return out
+
+
+def key_length(fields):
+    return 1 + (sum(bits for _, _, bits in fields) + 7) // 8
+
+
+class Encoder:
+    """Encoder state for one packet type, same choices as LoRa_Codec_Encode."""
+
+    def __init__(self, fields):
+        self.fields = fields
+        self.key = None
+        self.sequence = 0
+        self.since_key = 0
+
+    def encode(self, values):
+        values = [clamp(value, bits, kind) for value, (_, kind, bits) in zip(values, self.fields)]
+        if self.key is not None and self.since_key < KEY_INTERVAL:
+            out = bytearray([self.sequence])
+            for value, key in zip(values, self.key):
+                out += _varint(_extend(value - key, 32, True))
+            if len(out) < key_length(self.fields):
+                self.since_key += 1
+                return bytes(out)
+
+        self.sequence = (self.sequence + 1) & SEQUENCE_MASK
+        acc = 0
+        acc_bits = 0
+        self.key = []
+        for value, (_, kind, bits) in zip(values, self.fields):
+            acc |= (value & ((1 << bits) - 1)) << acc_bits
+            acc_bits += bits
+            self.key.append(_extend(value, bits, kind.startswith('i')))
+        self.since_key = 0
+        return bytes([KEYFRAME | self.sequence]) + acc.to_bytes((acc_bits + 7) // 8, 'little')
+
+
+class Decoder:
+    """Decoder for every packet type, keeps the last keyframe of each."""
+
+    def __init__(self):
+        self.keys = {}
+        self.lost = 0  # Deltas dropped because their keyframe never arrived
+        self.version = None  # Last schema version tag seen
+        self.refused = 0  # Packets dropped under another schema version
+
+    def decode(self, kind, payload):
+        """Return (name, {field: value}), values are None if the packet cannot be decoded."""
+        if kind == VERSION_TYPE and len(payload) == 1:
+            self.version = payload[0]
+            return 'Schema', {'version': self.version}
+        if kind == LINK and len(payload) == 1:
+            return 'Link_Request', {'step': payload[0]}
+        if kind == LINK and len(payload) == 3:
+            snr = payload[1] - 256 if payload[1] > 127 else payload[1]
+            return 'Link_Report', {'step': payload[0], 'snr': snr / 4, 'rssi': -payload[2]}
+        if kind == OFFLOAD and payload:
+            return 'Offload', {'op': payload[0], 'length': len(payload)}
+        if kind == SWEEP and len(payload) >= 3:
+            return 'Sweep', {'op': payload[0], 'point': payload[1] | payload[2] << 8}
+        if kind not in SCHEMA or not payload:
+            return 'Unknown_0x%02X' % kind, None
+        name, _, fields = SCHEMA[kind]
+        if self.version is not None and self.version != VERSION:
+            self.refused += 1
+            return name, None
+        header = payload[0]
+
+        if header & KEYFRAME:
+            acc = int.from_bytes(payload[1:], 'little')
+            values = []
+            for _, field_kind, bits in fields:
+                values.append(_extend(acc, bits, field_kind.startswith('i')))
+                acc >>= bits
+            self.keys[kind] = (header & SEQUENCE_MASK, values)
+            return name, dict(zip((f[0] for f in fields), values))
+
+        sequence, key = self.keys.get(kind, (None, None))
+        if sequence != header:
+            self.lost += 1
+            return name, None
+        values = []
+        pos = 1
+        for (_, field_kind, _), base in zip(fields, key):
+            zigzag = shift = 0
+            while True:
+                if pos >= len(payload):
+                    raise ValueError('truncated delta for %s' % name)
+                byte = payload[pos]
+                pos += 1
+                zigzag |= (byte & 0x7F) << shift
+                shift += 7
+                if not byte & 0x80:
+                    break
+            delta = (zigzag >> 1) ^ -(zigzag & 1)
+            values.append(_to_type(base + delta, field_kind))
+        return name, dict(zip((f[0] for f in fields), values))
+
+
+def split(frame):
+    """Yield (type, payload) for each [type][length][payload] sub-packet."""
+    pos = 0
+    while pos < len(frame):
+        if pos + 2 > len(frame):
+            raise ValueError('truncated tag at byte %d' % pos)
+        kind, length = frame[pos], frame[pos + 1]
+        pos += 2
+        if pos + length > len(frame):
+            raise ValueError('sub-packet 0x%02X overruns the frame' % kind)
+        yield kind, frame[pos:pos + length]
+        pos += length
+
+
+def bench(lines):
+    """Re-encode a session of uncompressed frames and report the ratio per packet type."""
+    encoders = {kind: Encoder(fields) for kind, (_, _, fields) in SCHEMA.items()}
+    decoder = Decoder()
+    totals = {}
+    for line in lines:
+        text = line.strip().replace(' ', '')
+        if not text:
+            continue
+        for kind, payload in split(bytes.fromhex(text)):
+            if kind not in SCHEMA:
+                continue
+            name, layout, fields = SCHEMA[kind]
+            values = list(struct.unpack(layout, payload))
+            encoded = encoders[kind].encode(values)
+            _, decoded = decoder.decode(kind, encoded)
+            sent = [clamp(value, bits, field_kind) for value, (_, field_kind, bits) in zip(values, fields)]
+            if decoded is None or list(decoded.values()) != sent:
+                raise ValueError('%s does not round trip: %s' % (name, values))
+            count, raw, packed = totals.get(name, (0, 0, 0))
+            totals[name] = (count + 1, raw + len(payload), packed + len(encoded))
+
+    all_raw = all_packed = 0
+    print('%-14s %8s %10s %10s %6s' % ('packet', 'count', 'raw', 'encoded', 'ratio'))
+    for name, (count, raw, packed) in totals.items():
+        print('%-14s %8d %10d %10d %6.2f' % (name, count, raw, packed, raw / packed))
+        all_raw += raw
+        all_packed += packed
+    if all_packed:
+        print('%-14s %8s %10d %10d %6.2f' % ('total', '', all_raw, all_packed, all_raw / all_packed))
+
+
+def main():
+    if len(sys.argv) < 2:
+        print(__doc__, file=sys.stderr)
+        sys.exit(1)
+    with open(sys.argv[1]) as f:
+        bench(f)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,179 @@
+/************************************************
+* @file    lora_codec_test.c 
+* @author  APBashara
+* @date    10/2026
+* 
+* @brief   Host Round Trip Test of the LoRa Keyframe and Delta Codec
+* @note    Encodes packet streams with Core/Src/lora_codec.c, decodes every
+*          packet again and compares each field with what was sent. Some
+*          values do not fit their schema width, a U16 field declared 12
+*          bits or a signed field past its range. The encoder saturates
+*          them, so every packet must decode to the saturated value, the
+*          keyframe that carries one and all deltas against it alike.
+* 
+*          Build from the repository root:
+* 
+*          gcc -O2 -ICore/Inc Tools/lora_codec_test.c Core/Src/lora_codec.c \
+*              Core/Src/lora_schema.c -o lora_codec_test
+* 
+*          Usage: lora_codec_test
+*          Exits 1 on any check that fails.
+***********************************************/
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lora_codec.h"
+#include "lora_schema.h"
+
+#define TEST_PACKETS                (200) // Packets per stream, many keyframe intervals
+#define TEST_MAX_PACKET             (64) // Bytes of the largest packet struct
+
+// Signed fields narrower than their type, the schema has none yet
+typedef struct {
+    const uint8_t PacketID;
+    int16_t Yaw;
+    int8_t Trim;
+    uint32_t SampleTime;
+} Test_Signed_Packet;
+
+static const LoRa_Field signedFields[] = {
+    { offsetof(Test_Signed_Packet, Yaw), LORA_FIELD_I16, 10 },
+    { offsetof(Test_Signed_Packet, Trim), LORA_FIELD_I8, 4 },
+    { offsetof(Test_Signed_Packet, SampleTime), LORA_FIELD_U32, 32 },
+};
+
+static uint32_t failures;
+
+/* Static Functions ---------------------------------------------------------*/
+
+/**
+ * @brief Field value as a signed or unsigned long
+ */
+static long Field_Value(const LoRa_Field* field, const uint8_t* packet) {
+    const uint8_t* src = &packet[field->offset];
+    uint16_t u16;
+    uint32_t u32;
+
+    switch (field->type) {
+    case LORA_FIELD_U8:
+        return src[0];
+    case LORA_FIELD_I8:
+        return (int8_t)src[0];
+    case LORA_FIELD_U16:
+        memcpy(&u16, src, sizeof(u16));
+        return u16;
+    case LORA_FIELD_I16:
+        memcpy(&u16, src, sizeof(u16));
+        return (int16_t)u16;
+    case LORA_FIELD_U32:
+    case LORA_FIELD_T32:
+        memcpy(&u32, src, sizeof(u32));
+        return u32;
+    default:
+        memcpy(&u32, src, sizeof(u32));
+        return (int32_t)u32;
+    }
+}
+
+/**
+ * @brief Value the receiver must see, the field saturated to its width
+ */
+static long Expected(const LoRa_Field* field, long value) {
+    if (field->bits >= 32) {
+        return value;
+    }
+    if (field->type == LORA_FIELD_I8 || field->type == LORA_FIELD_I16 || field->type == LORA_FIELD_I32) {
+        long max = (1L << (field->bits - 1)) - 1;
+        return (value > max) ? max : (value < -max - 1) ? -max - 1 : value;
+    }
+    long max = (1L << field->bits) - 1;
+    return (value > max) ? max : value;
+}
+
+/**
+ * @brief Encode and decode a stream of packets, check every field
+ * 
+ * @param name [const char*] Stream name
+ * @param fields [const LoRa_Field*] Packet schema
+ * @param count [uint8_t] Fields in the schema
+ * @param packets [const uint8_t*] TEST_PACKETS packet structs of size bytes
+ * @param size [uint8_t] Packet struct size
+ */
+static void Round_Trip(const char* name, const LoRa_Field* fields, uint8_t count, const uint8_t* packets,
+    uint8_t size) {
+    LoRa_Codec_State encoder = { 0 };
+    LoRa_Codec_State decoder = { 0 };
+    uint8_t out[TEST_MAX_PACKET];
+    uint8_t decoded[TEST_MAX_PACKET];
+    uint32_t keyframes = 0;
+    uint32_t bytes = 0;
+
+    for (uint16_t n = 0; n < TEST_PACKETS; n++) {
+        const uint8_t* packet = &packets[n * size];
+        uint8_t length = LoRa_Codec_Encode(fields, count, &encoder, packet, out);
+        keyframes += (out[0] & LORA_CODEC_KEYFRAME) ? 1 : 0;
+        bytes += length;
+
+        memset(decoded, 0, sizeof(decoded));
+        if (LoRa_Codec_Decode(fields, count, &decoder, out, length, decoded) != LORA_CODEC_OK) {
+            failures++;
+            printf("fail: %s packet %u does not decode\n", name, n);
+            continue;
+        }
+        for (uint8_t i = 0; i < count; i++) {
+            long sent = Field_Value(&fields[i], packet);
+            long got = Field_Value(&fields[i], decoded);
+            if (got != Expected(&fields[i], sent)) {
+                failures++;
+                printf("fail: %s packet %u field %u sent %ld decoded %ld, expected %ld (%s)\n", name, n, i,
+                    sent, got, Expected(&fields[i], sent), (out[0] & LORA_CODEC_KEYFRAME) ? "keyframe" : "delta");
+            }
+        }
+    }
+    printf("%-12s %3u packets %3u keyframes %5u bytes\n", name, TEST_PACKETS, keyframes, bytes);
+}
+
+/* Function Implementation --------------------------------------------------*/
+
+int main() {
+    static LoRa_Engine_Data_Packet engine[TEST_PACKETS];
+    static Test_Signed_Packet signedPackets[TEST_PACKETS];
+
+    _Static_assert(sizeof(LoRa_Engine_Data_Packet) <= TEST_MAX_PACKET, "TEST_MAX_PACKET too small");
+
+    // 12-bit brake pressure ramps past 4095 and back, so keyframes land on both sides
+    srand(1);
+    for (uint16_t n = 0; n < TEST_PACKETS; n++) {
+        LoRa_Engine_Data_Packet* p = &engine[n];
+        memset(p, 0, sizeof(*p));
+        p->Sequence = n;
+        p->BrakePressure = 3800 + (n % 50) * 20;
+        p->ThrottleADC = (n % 7 == 0) ? 0xFFFF : rand() % 4096;
+        p->Steering = 2048 + rand() % 64;
+        p->RPM = 6000 + rand() % 200;
+        p->ThrottlePosSensor = rand() % 1000;
+        p->Lambda = 1000 + rand() % 10;
+        p->EcuTime = n * 50000;
+        p->SampleTime = n * 50000 + 7;
+    }
+    Round_Trip("engine", LORA_SCHEMA_FIELDS(Engine_Data), (const uint8_t*)engine, sizeof(engine[0]));
+
+    // Signed fields swing past both ends of 10 and 4 bits
+    for (uint16_t n = 0; n < TEST_PACKETS; n++) {
+        Test_Signed_Packet* p = &signedPackets[n];
+        memset(p, 0, sizeof(*p));
+        p->Yaw = (n % 40 - 20) * 40;
+        p->Trim = (n % 20) - 10;
+        p->SampleTime = n * 1000;
+    }
+    Round_Trip("signed", signedFields, sizeof(signedFields) / sizeof(signedFields[0]),
+        (const uint8_t*)signedPackets, sizeof(signedPackets[0]));
+
+    if (failures) {
+        fprintf(stderr, "%u checks failed\n", failures);
+    }
+    return failures ? 1 : 0;
+}
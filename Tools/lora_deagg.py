@@ -0,0 +1,73 @@
+#!/usr/bin/env python3
+"""
+Split aggregated LoRa telemetry frames back into packets.
+
+Core/Src/lora_sched.c packs every due packet into one radio frame as
+repeated sub-packets
+
+    uint8 type (packet ID), uint8 length, length bytes of payload
+
+where the payload is the keyframe or delta encoding from lora_codec.py,
+an ADR link request of type 0x7F, the schema version tag of type 0x7D,
+a log offload frame of type 0x7C (lora_offload.py writes those files) or
+a radio settings sweep announcement of type 0x7B.
+Packets are decoded by the schema in Core/Inc/lora_schema.h and refused
+while the car reports another schema version.
+Deltas are decoded against the last keyframe of their type, deltas whose
+keyframe was lost are reported and skipped. With FEC on, frames are held
+until their group is complete and a single lost frame per group is rebuilt
+from the parity frame (lora_fec.py).
+
+Reads one frame per line as hex, optionally after a prefix and a colon as
+the receiver role writes them (Core/Inc/lora_link.h), from a file or stdin,
+and prints one line per packet, numbered by data frame:
+
+    lora_deagg.py frames.txt
+    echo "0104812C3200..." | lora_deagg.py
+"""
+
+import sys
+
+from lora_codec import VERSION, Decoder, split
+from lora_fec import Rebuilder
+
+
+def show(decoder, number, frame):
+    try:
+        for kind, payload in split(frame):
+            name, values = decoder.decode(kind, payload)
+            if values is None:
+                print('%d %s undecodable %s' % (number, name, payload.hex().upper()))
+                continue
+            print('%d %s %s' % (number, name, ' '.join('%s=%s' % item for item in values.items())))
+    except ValueError as error:
+        print('warning: frame %d: %s' % (number, error), file=sys.stderr)
+
+
+def main():
+    source = open(sys.argv[1]) if len(sys.argv) > 1 else sys.stdin
+    decoder = Decoder()
+    rebuilder = Rebuilder()
+    number = 0
+    for line in source:
+        text = line.rsplit(':', 1)[-1].strip().replace(' ', '')
+        if not text:
+            continue
+        for frame in rebuilder.push(bytes.fromhex(text)):
+            number += 1
+            show(decoder, number, frame)
+    for frame in rebuilder.flush():
+        number += 1
+        show(decoder, number, frame)
+    if rebuilder.recovered or rebuilder.unrecoverable:
+        print('fec: %d frames rebuilt, %d lost' % (rebuilder.recovered, rebuilder.unrecoverable),
+              file=sys.stderr)
+    if decoder.refused:
+        print('warning: %d packets refused, car schema version %d, ground %d'
+              % (decoder.refused, decoder.version, VERSION), file=sys.stderr)
+    if decoder.lost:
+        print('warning: %d deltas lost their keyframe' % decoder.lost, file=sys.stderr)
+
+
+if __name__ == '__main__':
+    main()
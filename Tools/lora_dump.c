@@ -0,0 +1,115 @@
+/************************************************
+* @file    lora_dump.c 
+* @author  APBashara
+* @date    10/2026
+* 
+* @brief   Print Received LoRa Telemetry Frames as Packets
+* @note    Command line front end of the ground decoder (Tools/lora_ground.c),
+*          prints the same lines as lora_deagg.py for schema packets.
+* 
+*          Build from the repository root:
+* 
+*          gcc -O2 -ICore/Inc -ITools Tools/lora_dump.c Tools/lora_ground.c \
+*              Core/Src/lora_codec.c Core/Src/lora_schema.c -o lora_dump
+* 
+*          Usage: lora_dump [frames.txt]
+*          Reads one hex frame per line from the file or stdin, anything up
+*          to a colon is skipped, see Core/Inc/lora_link.h
+***********************************************/
+
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "lora_ground.h"
+
+#define DUMP_MAX_LINE               (2 * 255 + 64) // Hex of the largest frame and some spaces
+
+/* Static Functions ---------------------------------------------------------*/
+
+static long Field_Value(const LoRa_Field* field, const uint8_t* packet) {
+    const uint8_t* value = &packet[field->offset];
+    switch (field->type) {
+    case LORA_FIELD_U8: return *(const uint8_t*)value;
+    case LORA_FIELD_I8: return *(const int8_t*)value;
+    case LORA_FIELD_U16: return *(const uint16_t*)value;
+    case LORA_FIELD_I16: return *(const int16_t*)value;
+    case LORA_FIELD_U32:
+    case LORA_FIELD_T32: return *(const uint32_t*)value;
+    default: return *(const int32_t*)value;
+    }
+}
+
+static void Print_Packet(const LoRa_Schema_Packet* schema, const LoRa_Schema_Any* packet, void* ctx) {
+    printf("%lu %s", *(const unsigned long*)ctx, schema->name);
+    for (uint8_t i = 0; i < schema->fieldCount; i++) {
+        printf(" %s=%ld", schema->fieldNames[i], Field_Value(&schema->fields[i], (const uint8_t*)packet));
+    }
+    printf("\n");
+}
+
+static int Parse_Hex(const char* text, uint8_t* frame, uint16_t* length) {
+    *length = 0;
+    int high = -1;
+    for (; *text; text++) {
+        if (isspace((unsigned char)*text)) {
+            continue;
+        }
+        if (!isxdigit((unsigned char)*text) || *length == 255) {
+            return 0;
+        }
+        int nibble = isdigit((unsigned char)*text) ? *text - '0' : (tolower((unsigned char)*text) - 'a' + 10);
+        if (high < 0) {
+            high = nibble;
+        } else {
+            frame[(*length)++] = (high << 4) | nibble;
+            high = -1;
+        }
+    }
+    return high < 0;
+}
+
+/* Function Implementation --------------------------------------------------*/
+
+int main(int argc, char** argv) {
+    FILE* source = stdin;
+    if (argc > 1 && (source = fopen(argv[1], "r")) == NULL) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    static LoRa_Ground ground;
+    LoRa_Ground_Init(&ground);
+
+    char line[DUMP_MAX_LINE];
+    uint8_t frame[255];
+    uint16_t length;
+    unsigned long number = 0;
+    while (fgets(line, sizeof(line), source) != NULL) {
+        char* hex = strrchr(line, ':');
+        if (!Parse_Hex((hex != NULL) ? hex + 1 : line, frame, &length)) {
+            fprintf(stderr, "warning: frame %lu: not a hex frame\n", number + 1);
+            continue;
+        }
+        if (length == 0) {
+            continue;
+        }
+        number++;
+        if (LoRa_Ground_Frame(&ground, frame, length, Print_Packet, &number) != LORA_GROUND_OK) {
+            fprintf(stderr, "warning: frame %lu: truncated sub-packet\n", number);
+        }
+    }
+
+    if (ground.refused) {
+        fprintf(stderr, "warning: %lu packets refused, car schema version %d, ground %d\n",
+            (unsigned long)ground.refused, ground.version, LORA_SCHEMA_VERSION);
+    }
+    if (ground.noKey) {
+        fprintf(stderr, "warning: %lu deltas lost their keyframe\n", (unsigned long)ground.noKey);
+    }
+    if (ground.errors || ground.unknown) {
+        fprintf(stderr, "warning: %lu malformed, %lu unknown sub-packets\n", (unsigned long)ground.errors,
+            (unsigned long)ground.unknown);
+    }
+    return 0;
+}
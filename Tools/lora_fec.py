@@ -0,0 +1,178 @@
+#!/usr/bin/env python3
+"""
+XOR parity across LoRa frames, mirror of Core/Src/lora_fec.c.
+
+Every data frame starts with the tag [0x7E][2][group][index]. After each
+group of n data frames the car sends a parity frame
+
+    [0x7E][3 + m][group][n][xor of the lengths][xor of the frames]
+
+where the frames are taken without their tag and zero padded to the
+longest, m bytes. Any single lost frame of a group, data or parity, is
+rebuilt from the others without a return channel.
+
+Run as a script to simulate the goodput of each code rate under frame loss:
+
+    lora_fec.py --loss 0.1 --burst 2 --length 40
+"""
+
+import argparse
+import math
+import random
+
+TYPE = 0x7E
+HEADER_LEN = 4
+PARITY_LEN = 5
+
+# Bandwidth in Hz by kHz setting, as loraBandwidthHz in Core/Src/lora.c
+BANDWIDTH = {7.8: 7812, 10.4: 10417, 15.6: 15625, 20.8: 20833, 31.25: 31250,
+             41.7: 41667, 62.5: 62500, 125: 125000, 250: 250000, 500: 500000}
+
+
+def airtime(length, sf=7, bw=500, cr=1, preamble=8, crc=False):
+    """Time on air in us, same formula as Lora_Get_Airtime."""
+    bits = 8 * length - 4 * sf + 28 + (16 if crc else 0)
+    symbols = 8 + (math.ceil(bits / (4 * sf)) * (cr + 4) if bits > 0 else 0)
+    return (4 * preamble + 17 + 4 * symbols) * (1 << sf) * 1e6 / (4 * BANDWIDTH[bw])
+
+
+class Encoder:
+    """Parity state for one stream, same steps as LoRa_FEC_State."""
+
+    def __init__(self, size):
+        self.size = size
+        self.group = 0
+        self.index = 0
+        self.parity = bytearray()
+        self.length_xor = 0
+
+    def frame(self, data):
+        """Tag data as the next frame of the group and fold it into the parity."""
+        frame = bytes([TYPE, HEADER_LEN - 2, self.group & 0xFF, self.index]) + data
+        self.parity += bytes(max(0, len(data) - len(self.parity)))
+        for i, byte in enumerate(data):
+            self.parity[i] ^= byte
+        self.length_xor ^= len(data)
+        self.index += 1
+        return frame
+
+    def parity_frame(self):
+        """Parity frame once the group is complete, else None."""
+        if self.index < self.size:
+            return None
+        frame = bytes([TYPE, PARITY_LEN - 2 + len(self.parity), self.group & 0xFF, self.size,
+                       self.length_xor]) + bytes(self.parity)
+        self.group += 1
+        self.index = 0
+        self.parity = bytearray()
+        self.length_xor = 0
+        return frame
+
+
+class Rebuilder:
+    """Strip the tags and rebuild lost frames, releasing one group at a time."""
+
+    def __init__(self):
+        self.group = None
+        self.frames = {}
+        self.recovered = 0
+        self.unrecoverable = 0  # Data frames lost with more than one loss in their group
+
+    def _flush(self):
+        frames = [self.frames[i] for i in sorted(self.frames)]
+        self.group = None
+        self.frames = {}
+        return frames
+
+    def push(self, frame):
+        """Feed one received frame, return the data frames now ready in order."""
+        if len(frame) < HEADER_LEN or frame[0] != TYPE:
+            return [frame]  # FEC off
+        group, index = frame[2], frame[3]
+        out = []
+        if group != self.group:
+            out = self._flush()
+            self.group = group
+
+        if frame[1] == HEADER_LEN - 2:
+            self.frames[index] = bytes(frame[HEADER_LEN:])
+            return out
+
+        # Parity, index is the group size
+        missing = [i for i in range(index) if i not in self.frames]
+        if len(missing) == 1:
+            rebuilt = bytearray(frame[PARITY_LEN:])
+            length = frame[4]
+            for data in self.frames.values():
+                length ^= len(data)
+                for i, byte in enumerate(data):
+                    rebuilt[i] ^= byte
+            self.frames[missing[0]] = bytes(rebuilt[:length])
+            self.recovered += 1
+        else:
+            self.unrecoverable += len(missing)
+        return out + self._flush()
+
+    def flush(self):
+        """Release a group whose parity never came."""
+        return self._flush()
+
+
+def simulate(size, loss, burst, frames, length, rng, **radio):
+    """Send frames of random bytes through a Gilbert loss channel, return delivery and goodput."""
+    encoder = Encoder(size) if size else None
+    rebuilder = Rebuilder()
+    sent = []
+    delivered = []
+    air = 0.0
+    bad = False
+    # Mean burst length burst, long run loss rate loss
+    leave_bad = 1 / burst
+    enter_bad = loss / (burst * (1 - loss)) if loss < 1 else 1
+
+    def channel(frame):
+        nonlocal air, bad
+        air += airtime(len(frame), **radio)
+        bad = (rng.random() >= leave_bad) if bad else (rng.random() < enter_bad)
+        if not bad:
+            delivered.extend(rebuilder.push(frame) if encoder else [frame])
+
+    for _ in range(frames):
+        data = bytes(rng.randrange(256) for _ in range(rng.randrange(length // 2, length + 1)))
+        sent.append(data)
+        channel(encoder.frame(data) if encoder else data)
+        parity = encoder.parity_frame() if encoder else None
+        if parity:
+            channel(parity)
+    delivered.extend(rebuilder.flush())
+
+    # Every delivered frame must be one that was sent
+    pool = set(sent)
+    if any(frame not in pool for frame in delivered):
+        raise ValueError('rebuilt frame does not match any sent frame')
+    good = sum(len(frame) for frame in delivered)
+    return len(delivered) / frames, rebuilder.recovered, good * 1e6 / air
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Simulate LoRa FEC goodput under frame loss')
+    parser.add_argument('--loss', type=float, default=0.1, help='long run frame loss rate')
+    parser.add_argument('--burst', type=float, default=1, help='mean frames per loss burst')
+    parser.add_argument('--frames', type=int, default=20000, help='data frames to send')
+    parser.add_argument('--length', type=int, default=40, help='largest data frame in bytes')
+    parser.add_argument('--sf', type=int, default=7)
+    parser.add_argument('--bw', type=float, default=500, help='kHz')
+    parser.add_argument('--seed', type=int, default=1)
+    args = parser.parse_args()
+
+    bw = int(args.bw) if args.bw == int(args.bw) else args.bw
+    print('%-6s %10s %10s %14s' % ('group', 'delivered', 'rebuilt', 'goodput B/s'))
+    for size in (0, 2, 4, 8, 16):
+        rng = random.Random(args.seed)
+        ratio, rebuilt, goodput = simulate(size, args.loss, args.burst, args.frames, args.length,
+                                           rng, sf=args.sf, bw=bw)
+        print('%-6s %9.2f%% %10d %14.0f' % (size or 'off', 100 * ratio, rebuilt, goodput))
+
+
+if __name__ == '__main__':
+    main()
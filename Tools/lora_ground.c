@@ -0,0 +1,82 @@
+/************************************************
+* @file    lora_ground.c 
+* @author  APBashara
+* @date    10/2026
+* 
+* @brief   Ground Side Decoder for LoRa Telemetry Frames Implementation
+* @note    Built with Core/Src/lora_codec.c and Core/Src/lora_schema.c,
+*          see Tools/lora_dump.c
+***********************************************/
+
+#include <string.h>
+
+#include "lora_ground.h"
+
+/* Macros -------------------------------------------------------------------*/
+#define GROUND_LINK_TYPE            (0x7F) // Core/Inc/lora_adr.h, pulls in the radio driver
+#define GROUND_FEC_TYPE             (0x7E) // Core/Inc/lora_fec.h
+#define GROUND_OFFLOAD_TYPE         (0x7C) // Core/Inc/lora_offload.h, Tools/lora_offload.py writes the files
+#define GROUND_SWEEP_TYPE           (0x7B) // Core/Inc/lora_sweep.h, the car prints the results
+
+/* Function Implementation --------------------------------------------------*/
+
+void LoRa_Ground_Init(LoRa_Ground* ground) {
+    memset(ground, 0, sizeof(LoRa_Ground));
+    ground->version = -1;
+}
+
+LoRa_Ground_Status LoRa_Ground_Frame(LoRa_Ground* ground, const uint8_t* frame, uint16_t length,
+    LoRa_Ground_Callback callback, void* ctx) {
+    ground->frames++;
+
+    uint16_t pos = 0;
+    while (pos < length) {
+        if (pos + 2 > length || pos + 2 + frame[pos + 1] > length) {
+            ground->errors++;
+            return LORA_GROUND_ERROR;
+        }
+        uint8_t type = frame[pos];
+        uint8_t size = frame[pos + 1];
+        const uint8_t* payload = &frame[pos + 2];
+        pos += 2 + size;
+
+        if (type == LORA_SCHEMA_TYPE && size == LORA_SCHEMA_TAG_LEN - 2) {
+            ground->version = payload[0];
+            continue;
+        }
+        if (type == GROUND_LINK_TYPE || type == GROUND_FEC_TYPE || type == GROUND_OFFLOAD_TYPE ||
+            type == GROUND_SWEEP_TYPE) {
+            continue;
+        }
+
+        const LoRa_Schema_Packet* schema = LoRa_Schema_Find(type);
+        if (schema == NULL) {
+            ground->unknown++;
+            continue;
+        }
+        if (ground->version >= 0 && ground->version != LORA_SCHEMA_VERSION) {
+            ground->refused++;
+            continue;
+        }
+
+        uint8_t index = schema - loraSchema;
+        LoRa_Schema_Any* packet = &ground->packets[index];
+        memcpy((uint8_t*)packet, &type, 1); // The ID is const in the structs
+        switch (LoRa_Codec_Decode(schema->fields, schema->fieldCount, &ground->codec[index], payload, size,
+            (uint8_t*)packet)) {
+        case LORA_CODEC_OK:
+            ground->decoded++;
+            if (callback != NULL) {
+                callback(schema, packet, ctx);
+            }
+            break;
+        case LORA_CODEC_NO_KEY:
+            ground->noKey++;
+            break;
+        default:
+            ground->errors++;
+            break;
+        }
+    }
+    return LORA_GROUND_OK;
+}
@@ -0,0 +1,76 @@
+/************************************************
+* @file    lora_ground.h 
+* @author  APBashara
+* @date    10/2026
+* 
+* @brief   Ground Side Decoder for LoRa Telemetry Frames
+* @note    Host C library for Linux, decodes the frames built by
+*          Core/Src/lora_sched.c into the packet structs of
+*          Core/Inc/lora_schema.h with the firmware codec itself
+* @note    FEC groups are rebuilt by Tools/lora_fec.py, frames given here
+*          are decoded as they arrive and their FEC tags skipped
+***********************************************/
+
+#ifndef LORA_GROUND_H
+#define LORA_GROUND_H
+
+#include <stdint.h>
+
+#include "lora_codec.h"
+#include "lora_schema.h"
+
+/* Structs and Enums --------------------------------------------------------*/
+typedef enum {
+    LORA_GROUND_OK,
+    LORA_GROUND_ERROR, // Truncated frame, the packets before the error were delivered
+} LoRa_Ground_Status;
+
+/**
+ * @brief Called for each decoded packet
+ * 
+ * @param schema [const LoRa_Schema_Packet*] Packet type
+ * @param packet [const LoRa_Schema_Any*] Decoded packet, the member named by the schema
+ * @param ctx [void*] Caller context
+ */
+typedef void (*LoRa_Ground_Callback)(const LoRa_Schema_Packet* schema, const LoRa_Schema_Any* packet,
+    void* ctx);
+
+/**
+ * @brief Decoder state for one link
+ */
+typedef struct {
+    LoRa_Codec_State codec[LORA_SCHEMA_PACKETS]; // Last keyframe of each type
+    LoRa_Schema_Any packets[LORA_SCHEMA_PACKETS]; // Last decoded packet of each type
+    int16_t version; // Last schema version tag, -1 before the first
+    uint32_t frames; // Frames given
+    uint32_t decoded; // Packets delivered
+    uint32_t noKey; // Deltas whose keyframe never arrived
+    uint32_t refused; // Packets dropped under another schema version
+    uint32_t unknown; // Sub-packets of a type outside the schema
+    uint32_t errors; // Malformed frames or payloads
+} LoRa_Ground;
+
+/* Function Prototypes ------------------------------------------------------*/
+
+/**
+ * @brief Reset the decoder, e.g. when a new session starts
+ * 
+ * @param ground [LoRa_Ground*] Decoder state
+ */
+void LoRa_Ground_Init(LoRa_Ground* ground);
+
+/**
+ * @brief Decode every packet of one received frame
+ * @note Link requests and reports are skipped, see Tools/lora_codec.py
+ * 
+ * @param ground [LoRa_Ground*] Decoder state
+ * @param frame [const uint8_t*] Frame as received
+ * @param length [uint16_t] Frame length
+ * @param callback [LoRa_Ground_Callback] Called for each decoded packet, in frame order
+ * @param ctx [void*] Passed to callback
+ * @return LoRa_Ground_Status
+ */
+LoRa_Ground_Status LoRa_Ground_Frame(LoRa_Ground* ground, const uint8_t* frame, uint16_t length,
+    LoRa_Ground_Callback callback, void* ctx);
+
+#endif /* LORA_GROUND_H */
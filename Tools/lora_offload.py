@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+"""
+Write the SD card files the car offloaded over the radio.
+
+In the pit lane, or when asked with isotp_pull.py --radio, the car sends a
+capture file to the LoRa receiver in an FSK burst (Core/Inc/lora_offload.h).
+The receiver role writes every frame it accepted as a sub-packet of type
+0x7C among its usual lines, the payload is the FSK frame
+
+    0x01 start  u32 size, 8.3 name
+    0x02 data   u32 offset, file bytes
+    0x03 end    u32 size
+
+The receiver only accepts data in order, so each file is written front to
+back. A file is complete once its end frame arrived, an unfinished one is
+kept with a .part suffix and a warning.
+
+Reads the receiver's lines from a file or stdin, anything up to a colon is
+skipped:
+
+    lora_offload.py --dest logs/ link.txt
+"""
+
+import argparse
+import os
+import struct
+import sys
+
+from lora_codec import split
+
+TYPE = 0x7C
+START, DATA, END = 0x01, 0x02, 0x03
+HEADER = struct.Struct('<BI')
+
+
+class Offload:
+    """Reassemble the files of one receiver session into a directory."""
+
+    def __init__(self, dest):
+        self.dest = dest
+        self.name = None
+        self.size = 0
+        self.file = None
+        self.written = 0
+        self.files = []  # (name, size) completed
+        self.errors = 0
+
+    def _path(self, suffix=''):
+        return os.path.join(self.dest, os.path.basename(self.name) + suffix)
+
+    def _abandon(self):
+        if self.file:
+            self.file.close()
+            print('warning: %s stopped at %d/%d bytes' % (self.name, self.written, self.size), file=sys.stderr)
+        self.file = None
+
+    def frame(self, payload):
+        if len(payload) < HEADER.size:
+            return  # The announcement, the transfer follows in FSK
+        op, value = HEADER.unpack_from(payload)
+        data = payload[HEADER.size:]
+        if op == START:
+            # Sent again while the car waits for the ack, restart the file
+            self._abandon()
+            self.name = data.decode(errors='replace') or 'OFFLOAD.BIN'
+            self.size = value
+            self.written = 0
+            self.file = open(self._path('.part'), 'wb')
+        elif self.file is None:
+            self.errors += 1
+        elif op == DATA:
+            if value != self.written:
+                self.errors += 1
+                return
+            self.file.write(data)
+            self.written += len(data)
+        elif op == END:
+            if value != self.written or value != self.size:
+                self.errors += 1
+                self._abandon()
+                return
+            self.file.close()
+            self.file = None
+            os.replace(self._path('.part'), self._path())
+            self.files.append((self.name, self.size))
+            print('%s %d bytes' % (self.name, self.size))
+
+    def push(self, frame):
+        for kind, payload in split(frame):
+            if kind == TYPE:
+                self.frame(payload)
+
+    def close(self):
+        self._abandon()
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Write the files offloaded over the LoRa receiver')
+    parser.add_argument('lines', nargs='?', help='receiver lines, stdin if left out')
+    parser.add_argument('--dest', default='.', help='directory to write the files to')
+    args = parser.parse_args()
+
+    source = open(args.lines) if args.lines else sys.stdin
+    offload = Offload(args.dest)
+    for line in source:
+        text = line.rsplit(':', 1)[-1].strip().replace(' ', '')
+        if not text:
+            continue
+        try:
+            offload.push(bytes.fromhex(text))
+        except ValueError:
+            offload.errors += 1
+    offload.close()
+    if offload.errors:
+        print('warning: %d malformed or out of order frames' % offload.errors, file=sys.stderr)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,633 @@
+/************************************************
+* @file    lora_sim.c 
+* @author  APBashara
+* @date    10/2026
+* 
+* @brief   Register Level RFM95 Simulator for Host Tests of the LoRa Driver
+* @note    Core/Src/lora.c runs unchanged against a simulated module behind
+*          SPI2_Transfer and the reset pin. The register file, FIFO and
+*          pointers, mode changes, IRQ flags, DIO0, airtime and continuous
+*          receive of queued arrivals are modelled, with time advanced by the SPI clock and by the task notification
+*          waits the driver sleeps in. Every chip select is counted, per
+*          driver call, so SPI savings can be measured and kept.
+* 
+*          Build from the repository root:
+* 
+*          gcc -O2 -DLORA_HOST -DSTM32F415xx -ICore/Inc -IDrivers/CMSIS/Include \
+*              -IDrivers/CMSIS/Device/ST/STM32F4xx/Include \
+*              -IMiddlewares/Third_Party/FreeRTOS/Source/include \
+*              -IMiddlewares/Third_Party/FreeRTOS/Source/CMSIS_RTOS_V2 \
+*              -IMiddlewares/Third_Party/FreeRTOS/Source/portable/GCC/ARM_CM4F \
+*              Tools/lora_sim.c Core/Src/lora.c -lm -o lora_sim
+* 
+*          Usage: lora_sim [-n packets] [-v]
+*          -v traces every SPI transaction. Exits 1 if the driver breaks a
+*          register rule, a check fails or a packet costs more transactions
+*          than SIM_TX_BUDGET.
+***********************************************/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lora.h"
+
+#define SIM_SPI_HZ                  (2625000) // SPI2 at APB1 / 16, see SPI2_Init
+#define SIM_FIFO_SIZE               (256)
+#define SIM_REGS                    (0x80)
+#define SIM_TX_BUDGET               (6) // Transactions per packet once configured
+#define SIM_RST_PIN                 (8) // PA8, held high the module is in reset
+#define SIM_RX_QUEUE                (512) // Arrivals that can be queued
+#define SIM_RX_RATE                 (50) // Packets per second the receive stream must keep up with
+#define SIM_NEVER                   (UINT64_MAX)
+
+/**
+ * @brief SPI traffic, totals or for one driver call
+ */
+typedef struct {
+    uint32_t transactions; // Chip selects
+    uint32_t bytes; // Including address bytes
+    uint32_t reads;
+    uint32_t writes;
+    uint64_t spiNs; // Time the bus was clocking
+} Sim_Count;
+
+/**
+ * @brief Packet arriving from another radio
+ */
+typedef struct {
+    uint8_t data[LORA_MAX_PAYLOAD_LEN];
+    uint8_t length;
+    int8_t snr; // Quarter dB
+    uint8_t rssi; // RegPktRssiValue
+    uint64_t at; // ns the last symbol is received
+} Sim_Arrival;
+
+typedef struct {
+    uint8_t regs[SIM_REGS];
+    uint8_t fifo[SIM_FIFO_SIZE];
+    uint64_t now; // ns
+    uint64_t txDone; // Time TxDone fires, SIM_NEVER when idle
+    bool inReset;
+
+    // Packets waiting to arrive, in time order
+    Sim_Arrival rx[SIM_RX_QUEUE];
+    uint16_t rxHead;
+    uint16_t rxCount;
+    uint64_t rxSince; // ns the module entered receive
+    uint32_t rxLost; // Arrivals the module was not listening for
+
+    // SPI transaction in progress
+    bool selected;
+    bool addressed;
+    bool writing;
+    uint8_t first; // Address the transaction started at
+    uint8_t address;
+
+    // Last frame on air
+    uint8_t sent[SIM_FIFO_SIZE];
+    uint8_t sentLength;
+    uint32_t sentCount;
+    uint64_t lastAirtime; // ns
+
+    Sim_Count count;
+    uint32_t violations;
+    uint32_t failures;
+    bool trace;
+} Sim_Radio;
+
+static Sim_Radio sim;
+static uint32_t simNotify; // Task notification value of the only task
+
+/* Static Functions ---------------------------------------------------------*/
+
+static void Violation(const char* what) {
+    sim.violations++;
+    fprintf(stderr, "violation at %.3f ms: %s\n", sim.now / 1e6, what);
+}
+
+static void Check(bool ok, const char* what) {
+    if (!ok) {
+        sim.failures++;
+        fprintf(stderr, "check failed: %s\n", what);
+    }
+}
+
+/**
+ * @brief Register values after power on or reset, SX1276 datasheet table 41
+ */
+static void Reset_Module() {
+    memset(sim.regs, 0, sizeof(sim.regs));
+    memset(sim.fifo, 0, sizeof(sim.fifo));
+    sim.regs[RegOpMode] = 0x09; // FSK, low frequency, standby
+    sim.regs[RegFrfMsb] = 0x6C;
+    sim.regs[RegFrfMid] = 0x80;
+    sim.regs[RegPaConfig] = 0x4F;
+    sim.regs[RegPaRamp] = 0x09;
+    sim.regs[RegOcp] = 0x2B;
+    sim.regs[RegLna] = 0x20;
+    sim.regs[RegFifoTxBaseAddr] = 0x80;
+    sim.regs[RegModemConfig1] = 0x72;
+    sim.regs[RegModemConfig2] = 0x70;
+    sim.regs[RegSymbTimeoutLsb] = 0x64;
+    sim.regs[RegPreambleLsb] = 0x08;
+    sim.regs[RegPayloadLength] = 0x01;
+    sim.regs[RegMaxPayloadLength] = 0xFF;
+    sim.regs[RegModemConfig3] = 0x04;
+    sim.regs[RegSyncWord] = 0x12;
+    sim.regs[RegVersion] = 0x12;
+    sim.regs[RegPaDac] = 0x84;
+    sim.txDone = SIM_NEVER;
+    sim.rxHead = 0;
+    sim.rxCount = 0;
+}
+
+static uint8_t Mode() {
+    return sim.regs[RegOpMode] & RegOpMode_Mode;
+}
+
+/**
+ * @brief Time on air from the registers, independent of the driver's mirror
+ * 
+ * @param length [uint8_t] Payload bytes
+ * @return [uint64_t] ns
+ */
+static uint64_t Register_Airtime(uint8_t length) {
+    static const double bandwidth[] = { 7812.5, 10417, 15625, 20833, 31250, 41667, 62500, 125000,
+        250000, 500000 };
+    uint8_t bw = sim.regs[RegModemConfig1] >> RegModemConfig1_Bw_Pos;
+    int sf = sim.regs[RegModemConfig2] >> RegModemConfig2_SpreadingFactor_Pos;
+    int cr = (sim.regs[RegModemConfig1] >> RegModemConfig1_CodingRate_Pos) & 0x7;
+    int implicit = sim.regs[RegModemConfig1] & RegModemConfig1_ImplicitHeaderModeOn ? 1 : 0;
+    int crc = sim.regs[RegModemConfig2] & RegModemConfig2_RxPayloadCrcOn ? 1 : 0;
+    int de = sim.regs[RegModemConfig3] & RegModemConfig3_LowDataRateOpt ? 1 : 0;
+    int preamble = (sim.regs[RegPreambleMsb] << 8) | sim.regs[RegPreambleLsb];
+
+    double symbol = (1 << sf) / bandwidth[bw < 10 ? bw : 9];
+    double payload = ceil((8.0 * length - 4 * sf + 28 + 16 * crc - 20 * implicit) / (4 * (sf - 2 * de)));
+    double symbols = preamble + 4.25 + 8 + (payload > 0 ? payload * (cr + 4) : 0);
+    return (uint64_t)(symbols * symbol * 1e9);
+}
+
+static void Raise_DIO0(uint8_t mapping) {
+    if ((sim.regs[RegDioMapping1] & RegDioMapping1_Dio0Mapping) == mapping) {
+        Lora_DIO0_IRQHandler();
+    }
+}
+
+static void Fire_TxDone() {
+    uint8_t length = sim.regs[RegPayloadLength];
+    for (uint16_t i = 0; i < length; i++) {
+        sim.sent[i] = sim.fifo[(uint8_t)(sim.regs[RegFifoTxBaseAddr] + i)];
+    }
+    sim.sentLength = length;
+    sim.sentCount++;
+    sim.txDone = SIM_NEVER;
+    sim.regs[RegIrqFlags] |= RegIrqFlags_TxDone;
+    sim.regs[RegOpMode] = (sim.regs[RegOpMode] & ~RegOpMode_Mode) | LORA_STANDBY;
+    Raise_DIO0(RegDioMapping1_Dio0_TxDone);
+}
+
+static void Queue_Rx(uint64_t at, const uint8_t* data, uint8_t length, int8_t snr, uint8_t rssi) {
+    if (sim.rxCount == SIM_RX_QUEUE) {
+        fprintf(stderr, "receive queue full\n");
+        exit(1);
+    }
+    Sim_Arrival* arrival = &sim.rx[(sim.rxHead + sim.rxCount++) % SIM_RX_QUEUE];
+    memcpy(arrival->data, data, length);
+    arrival->length = length;
+    arrival->snr = snr;
+    arrival->rssi = rssi;
+    arrival->at = at;
+}
+
+static uint64_t Next_Rx() {
+    return sim.rxCount ? sim.rx[sim.rxHead].at : SIM_NEVER;
+}
+
+/**
+ * @brief Land the next arrival in the FIFO where the last one ended
+ * @note Lost unless the module listened through its whole airtime
+ */
+static void Fire_Rx() {
+    Sim_Arrival* arrival = &sim.rx[sim.rxHead];
+    sim.rxHead = (sim.rxHead + 1) % SIM_RX_QUEUE;
+    sim.rxCount--;
+    if (Mode() != LORA_RX_CONTINUOUS || sim.rxSince + Register_Airtime(arrival->length) > arrival->at) {
+        sim.rxLost++;
+        return;
+    }
+
+    uint8_t start = sim.regs[RegFifoRxByteAddr];
+    for (uint16_t i = 0; i < arrival->length; i++) {
+        sim.fifo[(uint8_t)(start + i)] = arrival->data[i];
+    }
+    uint16_t packets = ((sim.regs[RegRxPacketCntValueMsb] << 8) | sim.regs[RegRxPacketCntValueLsb]) + 1;
+    sim.regs[RegRxPacketCntValueMsb] = packets >> 8;
+    sim.regs[RegRxPacketCntValueLsb] = packets;
+    sim.regs[RegFifoRxCurrentAddr] = start;
+    sim.regs[RegFifoRxByteAddr] = start + arrival->length;
+    sim.regs[RegRxNbBytes] = arrival->length;
+    sim.regs[RegPktSnrValue] = (uint8_t)arrival->snr;
+    sim.regs[RegPktRssiValue] = arrival->rssi;
+    sim.regs[RegIrqFlags] |= RegIrqFlags_RxDone | RegIrqFlags_ValidHeader;
+    Raise_DIO0(RegDioMapping1_Dio0_RxDone);
+}
+
+/**
+ * @brief Run the module up to a time, stops early once the task is notified
+ * 
+ * @param until [uint64_t] ns, SIM_NEVER to run to the next event
+ */
+static void Advance(uint64_t until) {
+    while (!simNotify) {
+        uint64_t rx = Next_Rx();
+        uint64_t next = (sim.txDone < rx) ? sim.txDone : rx;
+        if (next > until) {
+            if (until != SIM_NEVER) {
+                sim.now = until;
+            }
+            return;
+        }
+        sim.now = (next > sim.now) ? next : sim.now;
+        if (next == sim.txDone) {
+            Fire_TxDone();
+        }
+        else {
+            Fire_Rx();
+        }
+    }
+}
+
+static void Write_Register(uint8_t reg, uint8_t value) {
+    uint8_t mode = Mode();
+    sim.count.writes++;
+
+    switch (reg) {
+    case RegFifo:
+        if (mode == LORA_SLEEP) {
+            Violation("FIFO written in sleep");
+        }
+        sim.fifo[sim.regs[RegFifoAddrPtr]++] = value;
+        return;
+    case RegOpMode:
+        if (((value ^ sim.regs[RegOpMode]) & RegOpMode_LongRangeMode) && mode != LORA_SLEEP) {
+            Violation("LongRangeMode changed outside sleep");
+            value = (value & ~RegOpMode_LongRangeMode) | (sim.regs[RegOpMode] & RegOpMode_LongRangeMode);
+        }
+        sim.regs[RegOpMode] = value;
+        if ((value & RegOpMode_Mode) == LORA_SLEEP && mode != LORA_SLEEP) {
+            memset(sim.fifo, 0, sizeof(sim.fifo)); // Lost in sleep
+        }
+        if ((value & RegOpMode_Mode) == LORA_TX && mode != LORA_TX) {
+            sim.lastAirtime = Register_Airtime(sim.regs[RegPayloadLength]);
+            sim.txDone = sim.now + sim.lastAirtime;
+        }
+        else if ((value & RegOpMode_Mode) != LORA_TX) {
+            sim.txDone = SIM_NEVER;
+        }
+        if ((value & RegOpMode_Mode) == LORA_RX_CONTINUOUS && mode != LORA_RX_CONTINUOUS) {
+            // Datasheet 4.1.2.3, the receiver starts over at the base address
+            sim.rxSince = sim.now;
+            sim.regs[RegFifoRxByteAddr] = sim.regs[RegFifoRxBaseAddr];
+            sim.regs[RegRxPacketCntValueMsb] = 0;
+            sim.regs[RegRxPacketCntValueLsb] = 0;
+        }
+        return;
+    case RegIrqFlags:
+        sim.regs[RegIrqFlags] &= ~value; // Write one to clear
+        return;
+    case RegFifoRxCurrentAddr:
+    case RegRxNbBytes:
+    case RegRxPacketCntValueMsb:
+    case RegRxPacketCntValueLsb:
+    case RegModemStat:
+    case RegPktSnrValue:
+    case RegPktRssiValue:
+    case RegRssiValue:
+    case RegFifoRxByteAddr:
+    case RegVersion:
+        Violation("read only register written");
+        return;
+    case RegFrfMsb:
+    case RegFrfMid:
+    case RegFrfLsb:
+    case RegModemConfig1:
+    case RegModemConfig2:
+    case RegModemConfig3:
+        if (mode != LORA_SLEEP && mode != LORA_STANDBY) {
+            Violation("modem configured outside sleep and standby");
+        }
+        break;
+    default:
+        break;
+    }
+    sim.regs[reg] = value;
+}
+
+static uint8_t Read_Register(uint8_t reg) {
+    sim.count.reads++;
+    if (reg == RegFifo) {
+        return sim.fifo[sim.regs[RegFifoAddrPtr]++];
+    }
+    return sim.regs[reg];
+}
+
+/**
+ * @brief Reference value of a register for a config, to check the driver's mirror
+ */
+static void Check_Config() {
+    LoRa_Config config;
+    Lora_Get_Config(&config);
+    Check((sim.regs[RegModemConfig2] >> RegModemConfig2_SpreadingFactor_Pos) == config.sf, "SF matches the config");
+    Check((sim.regs[RegModemConfig1] >> RegModemConfig1_Bw_Pos) == config.bw, "bandwidth matches the config");
+    Check(((sim.regs[RegModemConfig1] >> RegModemConfig1_CodingRate_Pos) & 0x7) == config.cr,
+        "coding rate matches the config");
+    Check(((sim.regs[RegPreambleMsb] << 8) | sim.regs[RegPreambleLsb]) == config.preamble,
+        "preamble matches the config");
+    Check(!!(sim.regs[RegModemConfig2] & RegModemConfig2_RxPayloadCrcOn) == config.crc, "CRC matches the config");
+    Check(!!(sim.regs[RegModemConfig3] & RegModemConfig3_LowDataRateOpt) == config.lowDataRate,
+        "low data rate matches the config");
+}
+
+static Sim_Count Delta(Sim_Count before) {
+    return (Sim_Count){
+        .transactions = sim.count.transactions - before.transactions,
+        .bytes = sim.count.bytes - before.bytes,
+        .reads = sim.count.reads - before.reads,
+        .writes = sim.count.writes - before.writes,
+        .spiNs = sim.count.spiNs - before.spiNs,
+    };
+}
+
+static void Report(const char* operation, Sim_Count count, uint32_t runs) {
+    printf("%-28s %8.1f %8.1f %8.1f %8.1f %10.1f\n", operation, (double)count.transactions / runs,
+        (double)count.bytes / runs, (double)count.reads / runs, (double)count.writes / runs,
+        count.spiNs / 1e3 / runs);
+}
+
+/* SPI, GPIO and RTOS Hooks -------------------------------------------------*/
+
+SPI_Status SPI2_Transfer(const uint8_t* tx, uint8_t* rx, size_t len, uint8_t flags) {
+    if (!sim.selected) {
+        sim.selected = true;
+        sim.addressed = false;
+        sim.count.transactions++;
+    }
+    if (sim.inReset) {
+        Violation("SPI while the module is held in reset");
+    }
+
+    for (size_t i = 0; i < len; i++) {
+        uint8_t out = (tx != NULL) ? tx[i] : 0;
+        uint8_t in = 0;
+        if (!sim.addressed) {
+            sim.address = out & ~LORA_WRITE;
+            sim.first = sim.address;
+            sim.writing = out & LORA_WRITE;
+            sim.addressed = true;
+        }
+        else if (!sim.inReset) {
+            if (sim.writing) {
+                Write_Register(sim.address, out);
+            }
+            else {
+                in = Read_Register(sim.address);
+            }
+            if (sim.address != RegFifo) {
+                sim.address = (sim.address + 1) & (SIM_REGS - 1); // Burst auto-increment
+            }
+        }
+        if (rx != NULL) {
+            rx[i] = in;
+        }
+    }
+
+    uint64_t ns = (uint64_t)len * 8 * 1000000000ULL / SIM_SPI_HZ;
+    sim.count.bytes += len;
+    sim.count.spiNs += ns;
+    Advance(sim.now + ns);
+
+    if (!(flags & SPI_CS_HOLD)) {
+        sim.selected = false;
+        if (sim.trace) {
+            printf("  %10.3f ms %s 0x%02X\n", sim.now / 1e6, sim.writing ? "write" : "read ", sim.first);
+        }
+    }
+    return SPI_OK;
+}
+
+void Set_Pin(GPIO_TypeDef* GPIO, uint8_t pin) {
+    (void)GPIO;
+    if (pin == SIM_RST_PIN) {
+        sim.inReset = true;
+        Reset_Module();
+    }
+}
+
+void Clear_Pin(GPIO_TypeDef* GPIO, uint8_t pin) {
+    (void)GPIO;
+    if (pin == SIM_RST_PIN) {
+        sim.inReset = false;
+    }
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    return (TaskHandle_t)&simNotify;
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return sim.now / (1000000000ULL / configTICK_RATE_HZ);
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t* pxHigherPriorityTaskWoken) {
+    (void)xTaskToNotify;
+    simNotify++;
+    *pxHigherPriorityTaskWoken = pdFALSE; // Nothing to switch to on the host
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait) {
+    if (!simNotify && xTicksToWait > 0) {
+        if (xTicksToWait == portMAX_DELAY) {
+            Advance(SIM_NEVER);
+            if (!simNotify) {
+                Violation("driver waits forever with no event due");
+            }
+        }
+        else {
+            Advance(sim.now + (uint64_t)xTicksToWait * (1000000000ULL / configTICK_RATE_HZ));
+        }
+    }
+    uint32_t value = simNotify;
+    simNotify = (xClearCountOnExit || value == 0) ? 0 : value - 1;
+    return value;
+}
+
+/* Function Implementation --------------------------------------------------*/
+
+int main(int argc, char** argv) {
+    uint32_t packets = 1000;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            packets = strtoul(argv[++i], NULL, 0);
+        }
+        else if (strcmp(argv[i], "-v") == 0) {
+            sim.trace = true;
+        }
+        else {
+            fprintf(stderr, "usage: %s [-n packets] [-v]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (packets == 0) {
+        packets = 1;
+    }
+
+    uint8_t frame[LORA_MAX_PAYLOAD_LEN];
+    uint8_t length;
+    Sim_Count before;
+    LoRa_SPI_Stats driver;
+    srand(1);
+    Reset_Module();
+
+    printf("%-28s %8s %8s %8s %8s %10s\n", "operation", "cs", "bytes", "reads", "writes", "spi us");
+
+    // Cold start
+    before = sim.count;
+    Check(Lora_Init() == LORA_OK, "init");
+    Report("init", Delta(before), 1);
+    Check(sim.regs[RegOpMode] == (RegOpMode_LongRangeMode | LORA_STANDBY), "LoRa standby after init");
+    Check(((sim.regs[RegFrfMsb] << 16) | (sim.regs[RegFrfMid] << 8) | sim.regs[RegFrfLsb]) ==
+        (uint32_t)RFM95_Frf, "carrier frequency");
+    Check(sim.regs[RegPaDac] == RegPaDac_20dBm && sim.regs[RegPaConfig] == RegPaConfig_20dBm, "20 dBm");
+    Check_Config();
+
+    // Setters are deferred to the next mode change
+    before = sim.count;
+    Lora_Set_SF(LORA_SF_8);
+    Lora_Set_BW(LORA_BW_250);
+    Lora_Set_CodingRate(LORA_CR_4_6);
+    Report("set sf, bw, cr", Delta(before), 1);
+
+    // First packet carries the new settings
+    for (uint8_t i = 0; i < 40; i++) {
+        frame[i] = rand();
+    }
+    before = sim.count;
+    Check(Lora_Transmit(frame, 40) == LORA_OK, "first transmit");
+    Report("transmit, new settings", Delta(before), 1);
+    Check_Config();
+
+    // Steady state, random lengths
+    Sim_Count total = { 0 };
+    uint32_t worst = 0;
+    for (uint32_t n = 0; n < packets; n++) {
+        length = 1 + rand() % LORA_MAX_PAYLOAD_LEN;
+        for (uint8_t i = 0; i < length; i++) {
+            frame[i] = rand();
+        }
+        uint64_t start = sim.now;
+        before = sim.count;
+        LoRa_Status status = Lora_Transmit(frame, length);
+        Sim_Count count = Delta(before);
+        Lora_Get_SPI_Stats(&driver);
+
+        Check(status == LORA_OK, "transmit");
+        Check(sim.sentLength == length && memcmp(sim.sent, frame, length) == 0, "frame on air matches");
+        Check(Mode() == LORA_STANDBY && !(sim.regs[RegIrqFlags] & RegIrqFlags_TxDone), "standby, TxDone cleared");
+        Check(driver.lastPacket == count.transactions, "driver counts every chip select");
+        Check(llabs((int64_t)Lora_Get_Airtime(length) * 1000 - (int64_t)sim.lastAirtime) < 1000,
+            "driver airtime matches the registers");
+        Check(sim.now - start >= sim.lastAirtime, "transmit waits out the airtime");
+
+        total.transactions += count.transactions;
+        total.bytes += count.bytes;
+        total.reads += count.reads;
+        total.writes += count.writes;
+        total.spiNs += count.spiNs;
+        if (count.transactions > worst) {
+            worst = count.transactions;
+        }
+    }
+    Report("transmit, steady", total, packets);
+    Check(worst <= SIM_TX_BUDGET, "transactions per packet within SIM_TX_BUDGET");
+
+    // A packet arriving 50 ms into a receive
+    Queue_Rx(sim.now + 50000000ULL, (const uint8_t*)"\x7F\x03\x02\xF4\x62", 5, -10, 60);
+    before = sim.count;
+    Check(Lora_Receive_Timeout(frame, sizeof(frame), &length, 100) == LORA_OK, "receive");
+    Report("receive", Delta(before), 1);
+    Check(length == 5 && memcmp(frame, "\x7F\x03\x02\xF4\x62", 5) == 0, "received frame matches");
+    Check(Lora_Get_Packet_SNR() == -10 && Lora_Get_Packet_RSSI() == -157 + 60 - 2, "SNR and RSSI");
+    Check(Mode() == LORA_STANDBY, "standby after receive");
+
+    // Nothing arrives
+    uint64_t start = sim.now;
+    before = sim.count;
+    Check(Lora_Receive_Timeout(frame, sizeof(frame), &length, 20) == LORA_RX_TIMEOUT, "receive timeout");
+    Report("receive, timeout", Delta(before), 1);
+    Check(sim.now - start >= 20000000ULL && Mode() == LORA_STANDBY, "timeout after 20 ms in standby");
+
+    // Receiver role, packets back to back on air, read one by one without leaving receive
+    static LoRa_RX_Frame rx;
+    static uint8_t sentData[SIM_RX_QUEUE][LORA_MAX_PAYLOAD_LEN];
+    static uint8_t sentLengths[SIM_RX_QUEUE];
+    uint32_t streamed = (packets < SIM_RX_QUEUE) ? packets : SIM_RX_QUEUE;
+    Lora_Set_SF(LORA_SF_7);
+    Lora_Set_BW(LORA_BW_500);
+    Lora_Set_CodingRate(LORA_CR_4_5);
+    Check(Lora_RX_Start() == LORA_OK && Mode() == LORA_RX_CONTINUOUS, "receive continuous");
+    uint64_t at = sim.now;
+    for (uint32_t n = 0; n < streamed; n++) {
+        sentLengths[n] = 1 + rand() % 64;
+        for (uint8_t i = 0; i < sentLengths[n]; i++) {
+            sentData[n][i] = rand();
+        }
+        at += Register_Airtime(sentLengths[n]);
+        Queue_Rx(at, sentData[n], sentLengths[n], 20, 100);
+    }
+    start = sim.now;
+    before = sim.count;
+    uint32_t received = 0;
+    uint32_t missed = 0;
+    while (received < streamed && Lora_RX_Read(&rx, 100) == LORA_OK) {
+        Check(rx.length == sentLengths[received] && memcmp(rx.data, sentData[received], rx.length) == 0,
+            "streamed frame matches");
+        missed += rx.missed;
+        received++;
+    }
+    Report("receive, continuous", Delta(before), received ? received : 1);
+    double rate = received / ((sim.now - start) / 1e9);
+    printf("%lu frames streamed at %.0f per second, %lu missed\n", (unsigned long)received, rate,
+        (unsigned long)missed);
+    Check(received == streamed && missed == 0 && sim.rxLost == 0, "every streamed frame read");
+    Check(rate >= SIM_RX_RATE, "stream faster than SIM_RX_RATE");
+    Check(Mode() == LORA_RX_CONTINUOUS, "still receiving");
+
+    // A reader that falls behind is told how many frames it lost
+    at = sim.now;
+    for (uint8_t n = 0; n < 3; n++) {
+        at += Register_Airtime(8);
+        Queue_Rx(at, sentData[n], 8, 20, 100);
+    }
+    while (Next_Rx() <= at) {
+        simNotify = 0;
+        Advance(at);
+    }
+    Check(Lora_RX_Read(&rx, 100) == LORA_OK && rx.missed == 2 && memcmp(rx.data, sentData[2], 8) == 0,
+        "missed frames counted, the newest read");
+
+    // Module reset behind the driver's back, init must restore it
+    Set_Pin(GPIOA, SIM_RST_PIN);
+    Clear_Pin(GPIOA, SIM_RST_PIN);
+    before = sim.count;
+    Check(Lora_Init() == LORA_OK, "init after reset");
+    Report("init after reset", Delta(before), 1);
+    Check_Config();
+    Check(Lora_Transmit(frame, 10) == LORA_OK && sim.sentLength == 10, "transmit after reset");
+
+    printf("%lu packets, %lu violations, %lu failed checks, %.3f s simulated\n", (unsigned long)sim.sentCount,
+        (unsigned long)sim.violations, (unsigned long)sim.failures, sim.now / 1e9);
+    return (sim.violations || sim.failures) ? 1 : 0;
+}
@@ -0,0 +1,194 @@
+#!/usr/bin/env python3
+"""
+Link statistics of a LoRa telemetry session, for tuning the radio schedule.
+
+Core/Src/lora_sched.c stamps every packet with a rolling 8-bit Sequence per
+packet type and the SampleTime of its snapshot in us since the session
+epoch (Core/Inc/lora_schema.h). From those this reports per packet type
+
+    loss        packets never received, and received but undecodable
+                because their keyframe was lost
+    bursts      lengths of the runs of consecutive packets not delivered
+    interval    sample time between delivered packets, how stale the
+                ground's value gets
+    age         receive time minus sample time, needs receive times
+
+The car and ground clocks are not synchronised, so ages are measured above
+the freshest packet of the last minute, which also absorbs crystal drift.
+With FEC on a rebuilt frame is counted at the time its group was released.
+
+Reads one frame per line as hex, optionally after the receive time in
+seconds and a colon, from a file or stdin. Words after the time are
+ignored, so the receiver role's lines (Core/Inc/lora_link.h) read as is:
+
+    lora_stats.py frames.txt
+    1697040000.123456: 0104812C3200...
+    812.004211 -64 38: 0104812C3200...
+"""
+
+import collections
+import sys
+
+from lora_codec import SCHEMA, Decoder, split
+from lora_fec import Rebuilder
+
+SEQUENCE_MOD = 256
+TIME_MOD = 1 << 32
+AGE_WINDOW = 60.0  # Seconds of packets the clock offset is taken from
+PERIOD_HISTORY = 32  # Intervals the nominal period is the median of
+
+
+def _percentile(values, fraction):
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(fraction * len(ordered)))]
+
+
+class TypeStats:
+    """Loss, burst, interval and age tracking for one packet type."""
+
+    def __init__(self, name):
+        self.name = name
+        self.delivered = 0
+        self.lost = 0
+        self.undecodable = 0
+        self.sessions = 1
+        self.bursts = collections.Counter()
+        self.intervals = []  # ms
+        self.ages = []  # ms
+        self._last = None  # (sequence, sample time) of the last delivered packet
+        self._time = 0  # Sample time of the last delivered packet unwrapped past TIME_MOD, us
+        self._pending = 0  # Undecodable since the last delivered packet
+        self._periods = collections.deque(maxlen=PERIOD_HISTORY)
+
+    def undecoded(self):
+        self._pending += 1
+
+    def delivered_packet(self, sequence, sample_time):
+        """Account one decoded packet, return its sample time in us for the age."""
+        if self._last is not None:
+            last_sequence, last_time = self._last
+            elapsed = (sample_time - last_time) % TIME_MOD
+            if elapsed >= TIME_MOD // 2:
+                # Sample time went backwards, the car restarted its session
+                self.sessions += 1
+                self._last = None
+                self._pending = 0
+        if self._last is not None:
+            gap = (sequence - last_sequence - 1) % SEQUENCE_MOD
+            if gap == 0:
+                self._periods.append(elapsed)
+            elif self._periods:
+                # The sequence aliases after 256 packets, the sample time does not
+                period = sorted(self._periods)[len(self._periods) // 2]
+                wraps = round((elapsed / period - 1 - gap) / SEQUENCE_MOD) if period else 0
+                gap += SEQUENCE_MOD * max(0, wraps)
+            if gap:
+                self.bursts[gap] += 1
+                self.lost += max(0, gap - self._pending)
+            self.intervals.append(elapsed / 1000)
+        self.undecodable += self._pending
+        self._pending = 0
+        self.delivered += 1
+        self._time = self._time + elapsed if self._last is not None else sample_time
+        self._last = (sequence, sample_time)
+        return self._time
+
+    def row(self):
+        total = self.delivered + self.lost + self.undecodable
+        loss = 100 * (self.lost + self.undecodable) / total if total else 0
+        bursts = sum(self.bursts.values())
+        mean_burst = sum(k * n for k, n in self.bursts.items()) / bursts if bursts else 0
+        interval = sum(self.intervals) / len(self.intervals) if self.intervals else 0
+        row = '%-14s %8d %7d %7d %6.2f%% %6d %6.1f %6d %8.1f %8.1f' % (
+            self.name, self.delivered, self.lost, self.undecodable, loss, bursts, mean_burst,
+            max(self.bursts) if bursts else 0, interval, max(self.intervals, default=0))
+        if self.ages:
+            row += ' %8.1f %8.1f %8.1f' % (_percentile(self.ages, 0.5), _percentile(self.ages, 0.95),
+                                           max(self.ages))
+        return row
+
+
+class LinkStats:
+    """Feed received frames, collect TypeStats per packet type."""
+
+    def __init__(self):
+        self.decoder = Decoder()
+        self.rebuilder = Rebuilder()
+        self.types = {kind: TypeStats(name) for kind, (name, _, _) in SCHEMA.items()}
+        self.errors = 0
+        self._offsets = collections.deque()  # (receive time, receive minus sample time) in s
+        self._unaged = []  # (type, sample time) of packets waiting for their receive time
+
+    def _age(self, stats, received, sample_time):
+        offset = received - sample_time / 1e6
+        # Keep the offsets of the last AGE_WINDOW as a monotonic queue, the front is the minimum
+        while self._offsets and self._offsets[-1][1] >= offset:
+            self._offsets.pop()
+        self._offsets.append((received, offset))
+        while self._offsets[0][0] < received - AGE_WINDOW:
+            self._offsets.popleft()
+        stats.ages.append(1000 * (offset - self._offsets[0][1]))
+
+    def _frame(self, frame, received):
+        try:
+            for kind, payload in split(frame):
+                name, values = self.decoder.decode(kind, payload)
+                if kind not in self.types:
+                    continue
+                stats = self.types[kind]
+                if values is None:
+                    stats.undecoded()
+                    continue
+                sessions = stats.sessions
+                sample_time = stats.delivered_packet(values['Sequence'], values['SampleTime'])
+                if sessions != stats.sessions:
+                    # Offsets against the old session's clock mean nothing now
+                    self._offsets.clear()
+                if received is not None:
+                    self._age(stats, received, sample_time)
+        except ValueError:
+            self.errors += 1
+
+    def push(self, frame, received=None):
+        """Feed one received frame, received is its receive time in seconds if known."""
+        for data in self.rebuilder.push(frame):
+            self._frame(data, received)
+
+    def flush(self):
+        for data in self.rebuilder.flush():
+            self._frame(data, None)
+
+    def report(self):
+        aged = any(stats.ages for stats in self.types.values())
+        print('%-14s %8s %7s %7s %7s %6s %6s %6s %8s %8s' % (
+            'packet', 'received', 'lost', 'nokey', 'loss', 'bursts', 'mean', 'max', 'int ms', 'max ms')
+            + (' %8s %8s %8s' % ('age p50', 'p95', 'max') if aged else ''))
+        for stats in self.types.values():
+            if stats.delivered:
+                print(stats.row())
+        if self.rebuilder.recovered or self.rebuilder.unrecoverable:
+            print('fec: %d frames rebuilt, %d lost' % (self.rebuilder.recovered, self.rebuilder.unrecoverable))
+        restarts = max(stats.sessions for stats in self.types.values()) - 1
+        if restarts:
+            print('car restarted its session %d times' % restarts)
+        if self.errors:
+            print('warning: %d malformed frames' % self.errors, file=sys.stderr)
+
+
+def main():
+    source = open(sys.argv[1]) if len(sys.argv) > 1 else sys.stdin
+    link = LinkStats()
+    for line in source:
+        received = None
+        if ':' in line:
+            stamp, line = line.split(':', 1)
+            received = float(stamp.split()[0])
+        text = line.strip().replace(' ', '')
+        if text:
+            link.push(bytes.fromhex(text), received)
+    link.flush()
+    link.report()
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,289 @@
+/************************************************
+* @file    lora_tdma_sim.c 
+* @author  APBashara
+* @date    10/2026
+* 
+* @brief   Fleet Simulation of LoRa Cars Sharing One Channel
+* @note    Runs Core/Src/lora_tdma.c once per node, each with its own
+*          crystal offset and drift, polling NAV-PVT at 25 Hz with the
+*          solution age and reply latency of a real poll. Every node sends
+*          one full frame per superframe, in its TDMA slot or, for
+*          comparison, whenever its own timer says so as the firmware did
+*          before TDMA. Frames overlapping on air are counted as collided,
+*          no capture effect.
+* 
+*          Build from the repository root:
+* 
+*          gcc -O2 -ICore/Inc Tools/lora_tdma_sim.c Core/Src/lora_tdma.c -lm -o lora_tdma_sim
+* 
+*          Usage: lora_tdma_sim [-n max nodes] [-t seconds]
+*          Exits 1 if a TDMA fleet collides. Fleets whose slot is too short
+*          for even a 1 byte frame are marked overlong and not counted, the
+*          superframe has to grow for them.
+***********************************************/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lora_tdma.h"
+
+#define SIM_MAX_NODES               (16)
+#define SIM_MAX_FRAMES              (1 << 20)
+#define SIM_TICK                    (1000) // us, configTICK_RATE_HZ
+#define SIM_GPS_PERIOD              (40000) // us between solutions on GPS time, CFG-RATE-MEAS
+#define SIM_POLL_PERIOD             (41000) // us of the node's timer between polls, GPS_Task
+#define SIM_GPS_LATENCY             (1500) // us from a solution to it being readable
+#define SIM_DRIFT_PPM               (20.0) // Crystal tolerance
+#define SIM_TX_OVERRUN              (300) // us TxDone may come after the airtime, DIO0 and wakeup
+#define SIM_SF                      (7)
+#define SIM_BW                      (500000.0)
+#define SIM_CR                      (1) // 4/5
+#define SIM_PREAMBLE                (8)
+
+typedef struct {
+    LoRa_TDMA_State tdma;
+    uint32_t offset; // Timer when GPS time was 0 in us
+    double drift; // Timer rate error
+    int64_t nextCheck; // GPS time in us of the next scheduler wakeup
+    int64_t nextPoll; // GPS time in us of the next NAV-PVT poll
+    int64_t busyUntil; // GPS time in us the radio is free
+    double error; // us the node's GPS clock was off at its last poll
+} Sim_Node;
+
+typedef struct {
+    int64_t start;
+    int64_t end;
+    uint8_t node;
+    bool collided;
+} Sim_Frame;
+
+static Sim_Node nodes[SIM_MAX_NODES];
+static Sim_Frame frames[SIM_MAX_FRAMES];
+static uint32_t frameCount;
+
+/* Static Functions ---------------------------------------------------------*/
+
+/**
+ * @brief Time on air, SX1276 datasheet 4.1.1.7, explicit header and CRC on
+ * 
+ * @param length [uint8_t] Payload bytes
+ * @return [uint32_t] us
+ */
+static uint32_t Airtime(uint8_t length) {
+    double symbol = (1 << SIM_SF) / SIM_BW;
+    double payload = ceil((8.0 * length - 4 * SIM_SF + 28 + 16) / (4.0 * SIM_SF));
+    double symbols = SIM_PREAMBLE + 4.25 + 8 + (payload > 0 ? payload * (SIM_CR + 4) : 0);
+    return (uint32_t)(symbols * symbol * 1e6);
+}
+
+static uint32_t Timer(const Sim_Node* node, int64_t gps) {
+    return node->offset + (uint32_t)(int64_t)llround(gps * (1.0 + node->drift));
+}
+
+static double Uniform(double low, double high) {
+    return low + (high - low) * rand() / ((double)RAND_MAX + 1);
+}
+
+/**
+ * @brief Poll NAV-PVT, the reply is the last solution already readable
+ */
+static void Poll(Sim_Node* node, int64_t gps) {
+    int64_t solution = (gps - SIM_GPS_LATENCY - (int64_t)Uniform(0, 500)) / SIM_GPS_PERIOD * SIM_GPS_PERIOD;
+    uint32_t iTOW = (uint32_t)((solution / 1000) % (LORA_TDMA_WEEK / 1000));
+    LoRa_TDMA_Sync(&node->tdma, iTOW, Timer(node, gps));
+}
+
+/**
+ * @brief Error of a node's GPS clock estimate
+ * 
+ * @return [double] us, positive when the node runs late
+ */
+static double Clock_Error(const Sim_Node* node, int64_t gps) {
+    if (!node->tdma.synced) {
+        return 0;
+    }
+    double estimate = node->tdma.syncTOW * 1000.0 + (uint32_t)(Timer(node, gps) - node->tdma.syncTimer);
+    double actual = (double)(gps % LORA_TDMA_WEEK);
+    return actual - estimate;
+}
+
+static void Transmit(Sim_Node* node, uint8_t index, int64_t gps, uint32_t airtime) {
+    uint32_t overrun = (uint32_t)Uniform(50, SIM_TX_OVERRUN);
+    if (frameCount < SIM_MAX_FRAMES) {
+        frames[frameCount++] = (Sim_Frame){ gps, gps + airtime, index, false };
+    }
+    node->busyUntil = gps + airtime + overrun;
+    LoRa_TDMA_Sent(&node->tdma, airtime, airtime + overrun);
+}
+
+static int Compare_Start(const void* a, const void* b) {
+    int64_t d = ((const Sim_Frame*)a)->start - ((const Sim_Frame*)b)->start;
+    return (d > 0) - (d < 0);
+}
+
+/**
+ * @brief Run a fleet and print one table row
+ * 
+ * @param count [uint8_t] Nodes
+ * @param tdma [bool] Slots, else free running transmits
+ * @param seconds [uint32_t] Simulated time
+ * @return [uint32_t] Collided frames, 0 if the frames do not fit the slot
+ */
+static uint32_t Run(uint8_t count, bool tdma, uint32_t seconds) {
+    int64_t end = (int64_t)seconds * 1000000;
+    int64_t start = (int64_t)Uniform(0, 1e6) * 1000000; // Somewhere in the GPS week
+    uint32_t frameAirtime = 0;
+    uint8_t frameLength = 0;
+    double worstSpread = 0;
+
+    frameCount = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        Sim_Node* node = &nodes[i];
+        LoRa_TDMA_Init(&node->tdma, i, count);
+        node->offset = (uint32_t)rand() * 2654435761u;
+        node->drift = Uniform(-SIM_DRIFT_PPM, SIM_DRIFT_PPM) * 1e-6;
+        node->nextCheck = start + (int64_t)Uniform(0, LORA_TDMA_SUPERFRAME * 1000);
+        node->nextPoll = start + (int64_t)Uniform(0, SIM_GPS_PERIOD);
+        node->busyUntil = start;
+        node->error = 0;
+        Poll(node, start);
+    }
+
+    // The scheduler's frame limit for the slot, the same frames go out free running
+    uint32_t budget = LoRa_TDMA_Budget(&nodes[0].tdma);
+    for (uint16_t length = 255; length > 0; length--) {
+        if (Airtime(length) <= budget || length == 1) {
+            frameLength = length;
+            frameAirtime = Airtime(length);
+            break;
+        }
+    }
+
+    while (1) {
+        // Next event of any node
+        Sim_Node* node = NULL;
+        uint8_t index = 0;
+        int64_t gps = INT64_MAX;
+        bool poll = false;
+        for (uint8_t i = 0; i < count; i++) {
+            if (nodes[i].nextPoll < gps) {
+                node = &nodes[i], index = i, gps = nodes[i].nextPoll, poll = true;
+            }
+            if (nodes[i].nextCheck < gps) {
+                node = &nodes[i], index = i, gps = nodes[i].nextCheck, poll = false;
+            }
+        }
+        if (gps >= start + end) {
+            break;
+        }
+
+        if (poll) {
+            Poll(node, gps);
+            node->nextPoll += (int64_t)(SIM_POLL_PERIOD / (1.0 + node->drift));
+            node->error = Clock_Error(node, gps);
+
+            // Worst disagreement between two nodes, once every clock has seen a full window
+            double low = node->error;
+            double high = node->error;
+            for (uint8_t i = 0; i < count; i++) {
+                low = fmin(low, nodes[i].error);
+                high = fmax(high, nodes[i].error);
+            }
+            if (gps > start + 3000000 && high - low > worstSpread) {
+                worstSpread = high - low;
+            }
+            continue;
+        }
+
+        if (!tdma) {
+            // Wakes once per superframe of its own timer, a tick of jitter
+            Transmit(node, index, gps, frameAirtime);
+            node->nextCheck = gps + (int64_t)(LORA_TDMA_SUPERFRAME * 1000 / (1.0 + node->drift)) +
+                (int64_t)Uniform(-SIM_TICK / 2, SIM_TICK / 2);
+            continue;
+        }
+
+        if (gps < node->busyUntil) {
+            node->nextCheck = node->busyUntil;
+            continue;
+        }
+        uint32_t wait = LoRa_TDMA_Wait(&node->tdma, frameAirtime, Timer(node, gps));
+        if (wait == 0) {
+            Transmit(node, index, gps, frameAirtime);
+            node->nextCheck = node->busyUntil;
+        }
+        else {
+            // vTaskDelay rounds up to whole ticks of the node's own timer
+            node->nextCheck = gps + (int64_t)(((wait + SIM_TICK - 1) / SIM_TICK * SIM_TICK) / (1.0 + node->drift));
+        }
+        // The task wakes on its tick, not on the exact microsecond
+        node->nextCheck += (int64_t)Uniform(0, 50);
+    }
+
+    qsort(frames, frameCount, sizeof(Sim_Frame), Compare_Start);
+    int64_t reach = INT64_MIN;
+    int32_t last = -1; // Frame reaching furthest so far
+    for (uint32_t i = 0; i < frameCount; i++) {
+        if (last >= 0 && frames[i].start < reach) {
+            frames[i].collided = true;
+            frames[last].collided = true;
+        }
+        if (frames[i].end > reach) {
+            reach = frames[i].end;
+            last = i;
+        }
+    }
+    uint32_t collided = 0;
+    for (uint32_t i = 0; i < frameCount; i++) {
+        collided += frames[i].collided;
+    }
+
+    double time = seconds;
+    bool overlong = frameAirtime > budget;
+    printf("%5u %-6s %5u %8.1f %8.1f %7.2f%% %9.0f %8.0f %8u%s\n", count, tdma ? "tdma" : "free", frameLength,
+        frameCount / time, (frameCount - collided) / time, frameCount ? 100.0 * collided / frameCount : 0,
+        (frameCount - collided) * frameLength / time, worstSpread, nodes[0].tdma.stats.guard,
+        overlong ? " overlong" : "");
+    return overlong ? 0 : collided;
+}
+
+/* Function Implementation --------------------------------------------------*/
+
+int main(int argc, char** argv) {
+    uint8_t maxNodes = 8;
+    uint32_t seconds = 120;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            maxNodes = strtoul(argv[++i], NULL, 0);
+        }
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            seconds = strtoul(argv[++i], NULL, 0);
+        }
+        else {
+            fprintf(stderr, "usage: %s [-n max nodes] [-t seconds]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (maxNodes < 1 || maxNodes > SIM_MAX_NODES || seconds == 0) {
+        fprintf(stderr, "1 to %d nodes, at least a second\n", SIM_MAX_NODES);
+        return 1;
+    }
+
+    srand(1);
+    printf("superframe %d ms, SF%d %.0f kHz, one full frame per node per superframe\n", LORA_TDMA_SUPERFRAME, SIM_SF,
+        SIM_BW / 1000);
+    printf("%5s %-6s %5s %8s %8s %8s %9s %8s %8s\n", "nodes", "mode", "bytes", "sent/s", "good/s", "collided",
+        "goodput", "spread us", "guard us");
+
+    uint32_t tdmaCollisions = 0;
+    for (uint8_t count = 1; count <= maxNodes; count++) {
+        Run(count, false, seconds);
+        tdmaCollisions += Run(count, true, seconds);
+    }
+    if (tdmaCollisions) {
+        fprintf(stderr, "%lu TDMA frames collided\n", (unsigned long)tdmaCollisions);
+    }
+    return tdmaCollisions ? 1 : 0;
+}